@@ -36,6 +36,11 @@ unittests {
     # Include the test source files.
     include(tests/tests.pri)
 
+    CONFIG -= qml_debug
+} else:benchmarks {
+    # Include the benchmark source files.  (They provide their own 'main'.)
+    include(benchmarks/benchmarks.pri)
+
     CONFIG -= qml_debug
 } else {
     # Use our 'normal' main.cpp in the build.
@@ -68,24 +73,37 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 SOURCES += \
     container/bytearray.cpp \
+    container/securearena.cpp \
+    container/workstealingpool.cpp \
     keystorage/keyentry.cpp \
     keystorage/keystorage.cpp \
     keystorage/keystoragebase.cpp \
     logger.cpp \
     keystorage/database/databasekeystorage.cpp \
+    otp/otpbatchengine.cpp \
     otp/otphandler.cpp \
     uiclipboard.cpp \
     utils.cpp \
     otpimpl/hotp.cpp \
+    otpimpl/hotpresync.cpp \
+    otpimpl/otpcode.cpp \
+    otpimpl/replaycache.cpp \
+    otpimpl/hmacalgorithm.cpp \
     otpimpl/hmac.cpp \
+    otpimpl/hmackey.cpp \
     otpimpl/sha1impl.c \
     otpimpl/sha1hash.cpp \
+    otpimpl/sha1multibuffer.cpp \
+    otpimpl/sha512avx2.c \
+    otpimpl/sha512multibuffer.cpp \
     otpimpl/totp.cpp \
+    otpimpl/totpverifier.cpp \
     otpimpl/base32coder.cpp \
     otpimpl/hexdecoder.cpp \
     otpimpl/sha256hash.cpp \
     otpimpl/sha512hash.cpp \
     otpimpl/sha2.c \
+    otpimpl/shaext.c \
     settingshandler.cpp \
     keystorage/database/secretdatabase.cpp \
     generalinfosingleton.cpp \
@@ -93,26 +111,43 @@ SOURCES += \
 
 HEADERS += \
     container/bytearray.h \
+    container/securearena.h \
+    container/workstealingpool.h \
     keystorage/database/secretdatabase.h \
     keystorage/keystoragebase.h \
     keystorage/keyentry.h \
     keystorage/keystorage.h \
     logger.h \
     keystorage/database/databasekeystorage.h \
+    otp/otpbatchengine.h \
     otp/otphandler.h \
     uiclipboard.h \
     utils.h \
+    otpimpl/hashcontext.h \
+    otpimpl/hashpolicies.h \
+    otpimpl/hmact.h \
     otpimpl/hotp.h \
+    otpimpl/hotpresync.h \
+    otpimpl/hotpt.h \
+    otpimpl/otpcode.h \
+    otpimpl/replaycache.h \
+    otpimpl/hmacalgorithm.h \
     otpimpl/hmac.h \
+    otpimpl/hmackey.h \
     otpimpl/sha1impl.h \
     otpimpl/hashtypebase.h \
     otpimpl/sha1hash.h \
+    otpimpl/sha1multibuffer.h \
+    otpimpl/sha512avx2.h \
+    otpimpl/sha512multibuffer.h \
     otpimpl/totp.h \
+    otpimpl/totpverifier.h \
     otpimpl/base32coder.h \
     otpimpl/hexdecoder.h \
     otpimpl/sha256hash.h \
     otpimpl/sha512hash.h \
     otpimpl/sha2.h \
+    otpimpl/shaext.h \
     settingshandler.h \
     generalinfosingleton.h \
     keyentriessingleton.h
@@ -0,0 +1,114 @@
+#include "benchmarkutils.h"
+
+#include "otpimpl/base32coder.h"
+#include "otpimpl/hmackey.h"
+#include "otpimpl/sha1hash.h"
+#include "otpimpl/sha256hash.h"
+#include "otpimpl/sha512hash.h"
+
+/**
+ * @brief BenchmarkUtils::hashForAlgorithm - Get a hash object for one of the HMACKEY_ALG_*
+ *      values.
+ *
+ * @param algorithm - The HMACKEY_ALG_* value for the hash to create.
+ *
+ * @return std::shared_ptr<HashTypeBase> containing the hash object.  On error, nullptr will be
+ *      returned.
+ */
+std::shared_ptr<HashTypeBase> BenchmarkUtils::hashForAlgorithm(unsigned int algorithm)
+{
+    switch (algorithm) {
+    case HMACKEY_ALG_SHA1:
+        return std::shared_ptr<HashTypeBase>(new Sha1Hash());
+
+    case HMACKEY_ALG_SHA256:
+        return std::shared_ptr<HashTypeBase>(new Sha256Hash());
+
+    case HMACKEY_ALG_SHA512:
+        return std::shared_ptr<HashTypeBase>(new Sha512Hash());
+
+    default:
+        return nullptr;
+    }
+}
+
+/**
+ * @brief BenchmarkUtils::algorithmName - Get a printable name for one of the HMACKEY_ALG_*
+ *      values.  Used to label the benchmark results.
+ *
+ * @param algorithm - The HMACKEY_ALG_* value to get the name of.
+ *
+ * @return std::string containing the name of the algorithm.
+ */
+std::string BenchmarkUtils::algorithmName(unsigned int algorithm)
+{
+    switch (algorithm) {
+    case HMACKEY_ALG_SHA1:
+        return "SHA1";
+
+    case HMACKEY_ALG_SHA256:
+        return "SHA256";
+
+    case HMACKEY_ALG_SHA512:
+        return "SHA512";
+
+    default:
+        return "Unknown";
+    }
+}
+
+/**
+ * @brief BenchmarkUtils::patternData - Create a buffer of the requested size that is filled with
+ *      a repeating pattern.
+ *
+ * @param length - The number of bytes to create.
+ *
+ * @return ByteArray containing the pattern data.
+ */
+ByteArray BenchmarkUtils::patternData(size_t length)
+{
+    ByteArray result;
+
+    for (size_t i = 0; i < length; i++) {
+        result.append(static_cast<char>((i * 13) & 0xff));
+    }
+
+    return result;
+}
+
+/**
+ * @brief BenchmarkUtils::base32Data - Create the base32 encoding of a pattern buffer of the
+ *      requested size.
+ *
+ * @param length - The number of bytes to encode.
+ *
+ * @return ByteArray containing the base32 encoded data.
+ */
+ByteArray BenchmarkUtils::base32Data(size_t length)
+{
+    Base32Coder coder;
+
+    return coder.encode(patternData(length));
+}
+
+/**
+ * @brief BenchmarkUtils::hexData - Create the hex encoding of a pattern buffer of the requested
+ *      size.
+ *
+ * @param length - The number of bytes to encode.
+ *
+ * @return ByteArray containing the hex encoded data.
+ */
+ByteArray BenchmarkUtils::hexData(size_t length)
+{
+    const char hexChars[] = "0123456789abcdef";
+    ByteArray data = patternData(length);
+    ByteArray result;
+
+    for (size_t i = 0; i < data.size(); i++) {
+        result.append(hexChars[(data.at(i) >> 4) & 0x0f]);
+        result.append(hexChars[data.at(i) & 0x0f]);
+    }
+
+    return result;
+}
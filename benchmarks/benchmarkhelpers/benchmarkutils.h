@@ -0,0 +1,30 @@
+#ifndef BENCHMARKUTILS_H
+#define BENCHMARKUTILS_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "container/bytearray.h"
+#include "otpimpl/hashtypebase.h"
+#include "otpimpl/hmackey.h"
+
+// Argument lists shared by the benchmarks, so that the different layers can be compared with
+// each other.
+const std::vector<int64_t> BENCHMARK_ALGORITHMS = { HMACKEY_ALG_SHA1, HMACKEY_ALG_SHA256, HMACKEY_ALG_SHA512 };
+const std::vector<int64_t> BENCHMARK_KEY_LENGTHS = { 10, 20, 32, 64, 200 };      // 200 is longer than any block, so the key gets hashed.
+const std::vector<int64_t> BENCHMARK_DIGITS = { 6, 7, 8 };
+const std::vector<int64_t> BENCHMARK_BATCH_SIZES = { 1, 4, 8, 32, 128 };
+
+class BenchmarkUtils
+{
+public:
+    static std::shared_ptr<HashTypeBase> hashForAlgorithm(unsigned int algorithm);
+    static std::string algorithmName(unsigned int algorithm);
+
+    static ByteArray patternData(size_t length);
+    static ByteArray base32Data(size_t length);
+    static ByteArray hexData(size_t length);
+};
+
+#endif // BENCHMARKUTILS_H
@@ -0,0 +1,37 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief main - Run the benchmarks.  Unless the caller asked for a specific output format, the
+ *      results are written as JSON so they can be saved and compared between builds.
+ */
+int main(int argc, char *argv[])
+{
+    char jsonFormat[] = "--benchmark_format=json";
+    std::vector<char *> args;
+    int argCount;
+
+    args.push_back(argv[0]);
+
+    // Put our default first, so that anything on the command line overrides it.
+    args.push_back(jsonFormat);
+
+    for (int i = 1; i < argc; i++) {
+        args.push_back(argv[i]);
+    }
+
+    argCount = static_cast<int>(args.size());
+    args.push_back(nullptr);
+
+    benchmark::Initialize(&argCount, args.data());
+    if (benchmark::ReportUnrecognizedArguments(argCount, args.data())) {
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,28 @@
+# This file adds the necessary source files for building the benchmark binary, and tweaks the
+# build to reach that end.
+#
+# The benchmarks use Google Benchmark, which needs to be installed on the build machine.  Build
+# with "qmake CONFIG+=benchmarks", and run the resulting binary.  The results are written to
+# stdout as JSON, unless another --benchmark_format is provided on the command line.  Any of the
+# usual Google Benchmark options (--benchmark_filter, --benchmark_out, etc.) can be used.
+
+message(Building benchmark binary...)
+
+INCLUDEPATH += $$PWD/benchmarkhelpers
+
+LIBS += -lbenchmark -lpthread
+
+HEADERS += \
+    $$PWD/benchmarkhelpers/benchmarkutils.h
+
+SOURCES += \
+    $$PWD/benchmarkhelpers/benchmarkutils.cpp \
+    $$PWD/benchmarkmain.cpp \
+    $$PWD/keystorage/database/secretdatabasebenchmarks.cpp \
+    $$PWD/otpimpl/base32coderbenchmarks.cpp \
+    $$PWD/otpimpl/hashbenchmarks.cpp \
+    $$PWD/otpimpl/hexdecoderbenchmarks.cpp \
+    $$PWD/otpimpl/hmacbenchmarks.cpp \
+    $$PWD/otpimpl/hotpbenchmarks.cpp \
+    $$PWD/otpimpl/hotpresyncbenchmarks.cpp \
+    $$PWD/otpimpl/totpbenchmarks.cpp
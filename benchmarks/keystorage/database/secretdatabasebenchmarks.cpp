@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+
+#include <QFile>
+
+#include "keystorage/database/secretdatabase.h"
+#include "keystorage/keyentry.h"
+
+#define BENCHMARK_DB "benchmark.db"
+
+// Remove the database, and any journal or write-ahead log files that were left behind.
+static void removeBenchmarkDatabase()
+{
+    QFile::remove(BENCHMARK_DB);
+    QFile::remove(BENCHMARK_DB "-journal");
+    QFile::remove(BENCHMARK_DB "-wal");
+    QFile::remove(BENCHMARK_DB "-shm");
+}
+
+/**
+ * @brief BM_SecretDatabaseUpdate - Time how long it takes to write a new HOTP counter value for a
+ *      key, which is what happens each time the user asks for the next HOTP code.  Run with the
+ *      rollback journal (wal=0) and with the write-ahead log (wal=1) to compare them.
+ */
+static void BM_SecretDatabaseUpdate(benchmark::State &state)
+{
+    bool writeAheadLog = (state.range(0) != 0);
+    KeyEntry current;
+    KeyEntry updated;
+
+    removeBenchmarkDatabase();
+
+    {
+        SecretDatabase database;
+
+        database.setStorageOptions(writeAheadLog, SECRETDATABASE_DEFAULT_CACHE_SIZE_KB, SECRETDATABASE_DEFAULT_MMAP_SIZE_KB);
+
+        if (!database.open(BENCHMARK_DB)) {
+            state.SkipWithError("Unable to open the benchmark database!");
+            return;
+        }
+
+        current.setIdentifier("Benchmark Key");
+        current.setSecret("3132333435363738393031323334353637383930");
+        current.setKeyType(KEYENTRY_KEYTYPE_HEX);
+        current.setOtpType(KEYENTRY_OTPTYPE_HOTP);
+        current.setOutNumberCount(6);
+        current.setHotpCounter(0);
+
+        if (!database.add(current)) {
+            state.SkipWithError("Unable to add the benchmark key!");
+            return;
+        }
+
+        updated = current;
+
+        for (auto _ : state) {
+            updated.setHotpCounter(current.hotpCounter() + 1);
+
+            if (!database.update(current, updated)) {
+                state.SkipWithError("Unable to update the HOTP counter!");
+                break;
+            }
+
+            current.setHotpCounter(updated.hotpCounter());
+        }
+
+        state.SetLabel(database.writeAheadLogActive() ? "wal" : "rollback journal");
+
+        database.close();
+    }
+
+    removeBenchmarkDatabase();
+}
+BENCHMARK(BM_SecretDatabaseUpdate)->ArgNames({"wal"})->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+
+#include "benchmarkutils.h"
+#include "otpimpl/base32coder.h"
+
+// Sizes are the number of decoded bytes.  Most OTP secrets are 10 to 64 bytes long.
+
+static void BM_Base32Encode(benchmark::State &state)
+{
+    ByteArray toEncode = BenchmarkUtils::patternData(static_cast<size_t>(state.range(0)));
+    Base32Coder coder;
+
+    for (auto _ : state) {
+        ByteArray result = coder.encode(toEncode);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(toEncode.size()));
+}
+BENCHMARK(BM_Base32Encode)->ArgName("bytes")->Arg(10)->Arg(20)->Arg(32)->Arg(64)->Arg(4096);
+
+static void BM_Base32Decode(benchmark::State &state)
+{
+    ByteArray toDecode = BenchmarkUtils::base32Data(static_cast<size_t>(state.range(0)));
+    Base32Coder coder;
+
+    for (auto _ : state) {
+        ByteArray result = coder.decode(toDecode);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(toDecode.size()));
+}
+BENCHMARK(BM_Base32Decode)->ArgName("bytes")->Arg(10)->Arg(20)->Arg(32)->Arg(64)->Arg(4096);
+
+static void BM_Base32DecodeBackend(benchmark::State &state)
+{
+    ByteArray toDecode = BenchmarkUtils::base32Data(static_cast<size_t>(state.range(1)));
+    unsigned int backend = static_cast<unsigned int>(state.range(0));
+    Base32Coder coder;
+
+    if (!Base32Coder::backendSupported(backend)) {
+        state.SkipWithError("Backend not supported on this CPU.");
+        return;
+    }
+
+    for (auto _ : state) {
+        ByteArray result = coder.decode(toDecode, backend);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(toDecode.size()));
+}
+BENCHMARK(BM_Base32DecodeBackend)->ArgNames({"backend", "bytes"})->ArgsProduct({{BASE32CODER_BACKEND_SCALAR, BASE32CODER_BACKEND_SSSE3, BASE32CODER_BACKEND_AVX2}, {20, 64, 4096}});
+
+// The decoder as it was before the lookup table, kept here so the two can be compared.  Each
+// character is found with a linear search of the alphabet, and read through ByteArray::at().
+static unsigned char referenceDecodeChar(unsigned char toDecode)
+{
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+
+    for (unsigned char i = 0; i < strlen(alphabet); i++) {
+        if (toDecode == alphabet[i]) {
+            return i;
+        }
+    }
+
+    return 0xff;
+}
+
+static ByteArray referenceDecode(const ByteArray &toDecode)
+{
+    ByteArray result;
+    unsigned char v[8];
+
+    if ((toDecode.empty()) || ((toDecode.size() % 8) != 0)) {
+        return ByteArray();
+    }
+
+    result.reserve((toDecode.size() / 8) * 5);
+
+    for (size_t offset = 0; offset < toDecode.size(); offset += 8) {
+        for (size_t i = 0; i < 8; i++) {
+            v[i] = (toDecode.at(offset + i) == '=') ? 0 : referenceDecodeChar(toDecode.at(offset + i));
+            if (v[i] == 0xff) {
+                return ByteArray();
+            }
+        }
+
+        result.append(static_cast<char>((v[0] << 3) | (v[1] >> 2)));
+        if (toDecode.at(offset + 2) != '=') {
+            result.append(static_cast<char>((v[1] << 6) | (v[2] << 1) | (v[3] >> 4)));
+        }
+        if (toDecode.at(offset + 4) != '=') {
+            result.append(static_cast<char>((v[3] << 4) | (v[4] >> 1)));
+        }
+        if (toDecode.at(offset + 5) != '=') {
+            result.append(static_cast<char>((v[4] << 7) | (v[5] << 2) | (v[6] >> 3)));
+        }
+        if (toDecode.at(offset + 7) != '=') {
+            result.append(static_cast<char>((v[6] << 5) | v[7]));
+        }
+    }
+
+    return result;
+}
+
+static void BM_Base32DecodeReference(benchmark::State &state)
+{
+    ByteArray toDecode = BenchmarkUtils::base32Data(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        ByteArray result = referenceDecode(toDecode);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(toDecode.size()));
+}
+BENCHMARK(BM_Base32DecodeReference)->ArgName("bytes")->Arg(10)->Arg(20)->Arg(32)->Arg(64)->Arg(4096);
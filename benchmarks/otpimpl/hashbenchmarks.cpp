@@ -0,0 +1,36 @@
+#include <benchmark/benchmark.h>
+
+#include "benchmarkutils.h"
+#include "otpimpl/hmackey.h"
+
+extern "C" {
+#include "otpimpl/sha512avx2.h"         //NOSONAR
+#include "otpimpl/shaext.h"             //NOSONAR
+}
+
+// Hash throughput for each algorithm, over a range of message sizes.  The second argument turns
+// the hardware backends (SHA extensions, AVX2) off (0) or on (1), so the portable code can be
+// compared against them.
+
+static void BM_Hash(benchmark::State &state)
+{
+    unsigned int algorithm = static_cast<unsigned int>(state.range(0));
+    std::shared_ptr<HashTypeBase> hashObj = BenchmarkUtils::hashForAlgorithm(algorithm);
+    ByteArray toHash = BenchmarkUtils::patternData(static_cast<size_t>(state.range(1)));
+    int hardware = static_cast<int>(state.range(2));
+
+    sha_ext_set_enabled(hardware);
+    sha512_avx2_set_enabled(hardware);
+
+    for (auto _ : state) {
+        ByteArray result = hashObj->hash(toHash);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(toHash.size()));
+    state.SetLabel(BenchmarkUtils::algorithmName(algorithm) + ((hardware != 0) ? " hardware" : " portable"));
+
+    sha_ext_set_enabled(1);
+    sha512_avx2_set_enabled(1);
+}
+BENCHMARK(BM_Hash)->ArgNames({"alg", "bytes", "hw"})->ArgsProduct({BENCHMARK_ALGORITHMS, {8, 64, 1024, 65536}, {0, 1}});
@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+
+#include "benchmarkutils.h"
+#include "otpimpl/hexdecoder.h"
+
+// Sizes are the number of decoded bytes.  Most OTP secrets are 10 to 64 bytes long.
+
+static void BM_HexDecode(benchmark::State &state)
+{
+    ByteArray toDecode = BenchmarkUtils::hexData(static_cast<size_t>(state.range(0)));
+    HexDecoder decoder;
+
+    for (auto _ : state) {
+        ByteArray result = decoder.decode(toDecode);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(toDecode.size()));
+}
+BENCHMARK(BM_HexDecode)->ArgName("bytes")->Arg(10)->Arg(20)->Arg(32)->Arg(64)->Arg(4096);
+
+static void BM_HexDecodeBackend(benchmark::State &state)
+{
+    ByteArray toDecode = BenchmarkUtils::hexData(static_cast<size_t>(state.range(1)));
+    unsigned int backend = static_cast<unsigned int>(state.range(0));
+    HexDecoder decoder;
+
+    if (!HexDecoder::backendSupported(backend)) {
+        state.SkipWithError("Backend not supported on this CPU.");
+        return;
+    }
+
+    for (auto _ : state) {
+        ByteArray result = decoder.decode(toDecode, backend);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(toDecode.size()));
+}
+BENCHMARK(BM_HexDecodeBackend)->ArgNames({"backend", "bytes"})->ArgsProduct({{HEXDECODER_BACKEND_SCALAR, HEXDECODER_BACKEND_SSSE3, HEXDECODER_BACKEND_AVX2}, {20, 64, 4096}});
+
+// Hex with a colon between every octet, like a key copied out of a certificate viewer.
+static void BM_HexDecodeSeparated(benchmark::State &state)
+{
+    ByteArray plain = BenchmarkUtils::hexData(static_cast<size_t>(state.range(0)));
+    ByteArray toDecode;
+    HexDecoder decoder;
+
+    for (size_t i = 0; i < plain.size(); i += 2) {
+        if (i != 0) {
+            toDecode.append(':');
+        }
+
+        toDecode.append(plain.toCharArrayPtr() + i, 2);
+    }
+
+    for (auto _ : state) {
+        ByteArray result = decoder.decode(toDecode);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(toDecode.size()));
+}
+BENCHMARK(BM_HexDecodeSeparated)->ArgName("bytes")->Arg(20)->Arg(64)->Arg(4096);
@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+
+#include "benchmarkutils.h"
+#include "otpimpl/hmac.h"
+#include "otpimpl/hmackey.h"
+
+// The HMAC of an 8 byte counter is what every OTP calculation boils down to, so that is the
+// message used here.
+
+const size_t HMACBENCHMARKS_MESSAGE_LENGTH=8;
+
+static void BM_HmacCalculate(benchmark::State &state)
+{
+    unsigned int algorithm = static_cast<unsigned int>(state.range(0));
+    ByteArray key = BenchmarkUtils::patternData(static_cast<size_t>(state.range(1)));
+    ByteArray data = BenchmarkUtils::patternData(HMACBENCHMARKS_MESSAGE_LENGTH);
+    Hmac hmac(BenchmarkUtils::hashForAlgorithm(algorithm));
+
+    for (auto _ : state) {
+        std::shared_ptr<ByteArray> result = hmac.calculate(key, data);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetLabel(BenchmarkUtils::algorithmName(algorithm));
+}
+BENCHMARK(BM_HmacCalculate)->ArgNames({"alg", "keylen"})->ArgsProduct({BENCHMARK_ALGORITHMS, BENCHMARK_KEY_LENGTHS});
+
+static void BM_HmacKeyCalculate(benchmark::State &state)
+{
+    unsigned int algorithm = static_cast<unsigned int>(state.range(0));
+    ByteArray data = BenchmarkUtils::patternData(HMACBENCHMARKS_MESSAGE_LENGTH);
+    unsigned char result[HMACKEY_MAX_RESULT_LENGTH];
+    HmacKey key;
+
+    if (!key.setKey(algorithm, BenchmarkUtils::patternData(static_cast<size_t>(state.range(1))))) {
+        state.SkipWithError("Unable to set the HMAC key!");
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(key.calculate(data.toUCharArrayPtr(), data.size(), result, sizeof(result)));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetLabel(BenchmarkUtils::algorithmName(algorithm));
+}
+BENCHMARK(BM_HmacKeyCalculate)->ArgNames({"alg", "keylen"})->ArgsProduct({BENCHMARK_ALGORITHMS, BENCHMARK_KEY_LENGTHS});
+
+static void BM_HmacKeyCalculateMany(benchmark::State &state)
+{
+    unsigned int algorithm = static_cast<unsigned int>(state.range(0));
+    size_t count = static_cast<size_t>(state.range(1));
+    ByteArray data = BenchmarkUtils::patternData(HMACBENCHMARKS_MESSAGE_LENGTH);
+    std::vector<HmacKey> keys(count);
+    std::vector<const HmacKey *> keyPtrs(count);
+    std::vector<const unsigned char *> dataPtrs(count);
+    std::vector<unsigned char> results(count * HMACKEY_MAX_RESULT_LENGTH);
+    std::vector<unsigned char *> resultPtrs(count);
+
+    for (size_t i = 0; i < count; i++) {
+        if (!keys[i].setKey(algorithm, BenchmarkUtils::patternData(20 + i))) {
+            state.SkipWithError("Unable to set the HMAC key!");
+            return;
+        }
+
+        keyPtrs[i] = &keys[i];
+        dataPtrs[i] = data.toUCharArrayPtr();
+        resultPtrs[i] = &results[i * HMACKEY_MAX_RESULT_LENGTH];
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HmacKey::calculateMany(keyPtrs.data(), dataPtrs.data(), data.size(), count, resultPtrs.data()));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(count));
+    state.SetLabel(BenchmarkUtils::algorithmName(algorithm));
+}
+BENCHMARK(BM_HmacKeyCalculateMany)->ArgNames({"alg", "batch"})->ArgsProduct({BENCHMARK_ALGORITHMS, BENCHMARK_BATCH_SIZES});
@@ -0,0 +1,105 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "benchmarkutils.h"
+#include "otpimpl/hotp.h"
+#include "otpimpl/hotpt.h"
+#include "otpimpl/otpcode.h"
+
+static void BM_HotpCalculate(benchmark::State &state)
+{
+    unsigned int algorithm = static_cast<unsigned int>(state.range(0));
+    size_t digits = static_cast<size_t>(state.range(1));
+    ByteArray key = BenchmarkUtils::patternData(static_cast<size_t>(state.range(2)));
+    std::shared_ptr<Hmac> hmac = std::shared_ptr<Hmac>(new Hmac(BenchmarkUtils::hashForAlgorithm(algorithm)));
+    Hotp hotp(hmac);
+    uint64_t counter = 0;
+
+    for (auto _ : state) {
+        std::string result = hotp.calculate(key, counter++, digits);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetLabel(BenchmarkUtils::algorithmName(algorithm));
+}
+BENCHMARK(BM_HotpCalculate)->ArgNames({"alg", "digits", "keylen"})->ArgsProduct({BENCHMARK_ALGORITHMS, BENCHMARK_DIGITS, BENCHMARK_KEY_LENGTHS});
+
+static void BM_HotpCalculateHmacKey(benchmark::State &state)
+{
+    unsigned int algorithm = static_cast<unsigned int>(state.range(0));
+    size_t digits = static_cast<size_t>(state.range(1));
+    HmacKey key;
+    Hotp hotp;
+    uint64_t counter = 0;
+
+    if (!key.setKey(algorithm, BenchmarkUtils::patternData(static_cast<size_t>(state.range(2))))) {
+        state.SkipWithError("Unable to set the HMAC key!");
+        return;
+    }
+
+    for (auto _ : state) {
+        std::string result = hotp.calculate(key, counter++, digits);
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetLabel(BenchmarkUtils::algorithmName(algorithm));
+}
+BENCHMARK(BM_HotpCalculateHmacKey)->ArgNames({"alg", "digits", "keylen"})->ArgsProduct({BENCHMARK_ALGORITHMS, BENCHMARK_DIGITS, BENCHMARK_KEY_LENGTHS});
+
+template <typename HashPolicy>
+static void BM_HotpT(benchmark::State &state)
+{
+    HmacKey key;
+    char result[OTPCODE_BUFFER_SIZE];
+    uint64_t counter = 0;
+
+    if (!key.setKey(HashPolicy::ALGORITHM, BenchmarkUtils::patternData(static_cast<size_t>(state.range(0))))) {
+        state.SkipWithError("Unable to set the HMAC key!");
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HotpT<HashPolicy, 6>::calculate(key, counter++, result));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetLabel(BenchmarkUtils::algorithmName(HashPolicy::ALGORITHM));
+}
+BENCHMARK_TEMPLATE(BM_HotpT, Sha1Policy)->ArgNames({"keylen"})->ArgsProduct({BENCHMARK_KEY_LENGTHS});
+BENCHMARK_TEMPLATE(BM_HotpT, Sha256Policy)->ArgNames({"keylen"})->ArgsProduct({BENCHMARK_KEY_LENGTHS});
+BENCHMARK_TEMPLATE(BM_HotpT, Sha512Policy)->ArgNames({"keylen"})->ArgsProduct({BENCHMARK_KEY_LENGTHS});
+
+static void BM_OtpCodeHotpMany(benchmark::State &state)
+{
+    unsigned int algorithm = static_cast<unsigned int>(state.range(0));
+    size_t count = static_cast<size_t>(state.range(1));
+    std::vector<HmacKey> keys(count);
+    std::vector<const HmacKey *> keyPtrs(count);
+    std::vector<uint64_t> counters(count);
+    std::vector<char> results(count * OTPCODE_BUFFER_SIZE);
+    std::vector<char *> resultPtrs(count);
+
+    for (size_t i = 0; i < count; i++) {
+        if (!keys[i].setKey(algorithm, BenchmarkUtils::patternData(20 + i))) {
+            state.SkipWithError("Unable to set the HMAC key!");
+            return;
+        }
+
+        keyPtrs[i] = &keys[i];
+        counters[i] = i;
+        resultPtrs[i] = &results[i * OTPCODE_BUFFER_SIZE];
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(OtpCode::hotpMany(keyPtrs.data(), counters.data(), count, 6, resultPtrs.data()));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(count));
+    state.SetLabel(BenchmarkUtils::algorithmName(algorithm));
+}
+BENCHMARK(BM_OtpCodeHotpMany)->ArgNames({"alg", "batch"})->ArgsProduct({BENCHMARK_ALGORITHMS, BENCHMARK_BATCH_SIZES});
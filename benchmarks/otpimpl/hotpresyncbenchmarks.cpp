@@ -0,0 +1,36 @@
+#include <benchmark/benchmark.h>
+
+#include "benchmarkutils.h"
+#include "otpimpl/hotpresync.h"
+#include "otpimpl/otpcode.h"
+
+static void BM_HotpResyncSearch(benchmark::State &state)
+{
+    unsigned int algorithm = static_cast<unsigned int>(state.range(0));
+    uint64_t window = static_cast<uint64_t>(state.range(1));
+    size_t threads = static_cast<size_t>(state.range(2));
+    char first[OTPCODE_BUFFER_SIZE];
+    char second[OTPCODE_BUFFER_SIZE];
+    const char *codes[2] = { first, second };
+    HmacKey key;
+    uint64_t matched;
+
+    if (!key.setKey(algorithm, BenchmarkUtils::patternData(20))) {
+        state.SkipWithError("Unable to set the HMAC key!");
+        return;
+    }
+
+    // Put the codes at the very end of the window, so the whole window is searched.
+    if ((!OtpCode::hotp(key, window, 6, first)) || (!OtpCode::hotp(key, window + 1, 6, second))) {
+        state.SkipWithError("Unable to calculate the HOTP codes!");
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HotpResync::search(key, 6, codes, 2, 0, window, matched, threads));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(window + 1));
+    state.SetLabel(BenchmarkUtils::algorithmName(algorithm));
+}
+BENCHMARK(BM_HotpResyncSearch)->ArgNames({"alg", "window", "threads"})->ArgsProduct({BENCHMARK_ALGORITHMS, {10000, 100000}, {1, 2, 4, 8}})->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,96 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "benchmarkutils.h"
+#include "otpimpl/otpcode.h"
+#include "otpimpl/totp.h"
+#include "otpimpl/totpverifier.h"
+
+static void BM_TotpCalculate(benchmark::State &state)
+{
+    unsigned int algorithm = static_cast<unsigned int>(state.range(0));
+    size_t digits = static_cast<size_t>(state.range(1));
+    ByteArray key = BenchmarkUtils::patternData(static_cast<size_t>(state.range(2)));
+    Totp totp(std::shared_ptr<Hmac>(new Hmac(BenchmarkUtils::hashForAlgorithm(algorithm))));
+    time_t now = 1111111109;
+
+    for (auto _ : state) {
+        std::string result = totp.calculate(key, now, 30, digits);
+        benchmark::DoNotOptimize(result);
+        now += 30;
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetLabel(BenchmarkUtils::algorithmName(algorithm));
+}
+BENCHMARK(BM_TotpCalculate)->ArgNames({"alg", "digits", "keylen"})->ArgsProduct({BENCHMARK_ALGORITHMS, BENCHMARK_DIGITS, BENCHMARK_KEY_LENGTHS});
+
+static void BM_TotpCalculateHmacKey(benchmark::State &state)
+{
+    unsigned int algorithm = static_cast<unsigned int>(state.range(0));
+    size_t digits = static_cast<size_t>(state.range(1));
+    HmacKey key;
+    Totp totp;
+    time_t now = 1111111109;
+
+    if (!key.setKey(algorithm, BenchmarkUtils::patternData(static_cast<size_t>(state.range(2))))) {
+        state.SkipWithError("Unable to set the HMAC key!");
+        return;
+    }
+
+    for (auto _ : state) {
+        std::string result = totp.calculate(key, now, 30, digits);
+        benchmark::DoNotOptimize(result);
+        now += 30;
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetLabel(BenchmarkUtils::algorithmName(algorithm));
+}
+BENCHMARK(BM_TotpCalculateHmacKey)->ArgNames({"alg", "digits", "keylen"})->ArgsProduct({BENCHMARK_ALGORITHMS, BENCHMARK_DIGITS, BENCHMARK_KEY_LENGTHS});
+
+static void BM_TotpVerifierVerifyMany(benchmark::State &state)
+{
+    unsigned int algorithm = static_cast<unsigned int>(state.range(0));
+    size_t window = static_cast<size_t>(state.range(1));
+    size_t count = static_cast<size_t>(state.range(2));
+    std::vector<HmacKey> keys(count);
+    std::vector<const HmacKey *> keyPtrs(count);
+    std::vector<char> codes(count * OTPCODE_BUFFER_SIZE);
+    std::vector<const char *> codePtrs(count);
+    std::unique_ptr<bool[]> matched(new bool[count]);
+    std::vector<int> offsets(count);
+    TotpVerifier verifier(window, 30, 6);
+    time_t now = 1111111109;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!keys[i].setKey(algorithm, BenchmarkUtils::patternData(20 + i))) {
+            state.SkipWithError("Unable to set the HMAC key!");
+            return;
+        }
+
+        // Half of the codes are from the previous time step, the rest don't match at all.
+        if (!OtpCode::totp(keys[i], now - 30, 30, 6, &codes[i * OTPCODE_BUFFER_SIZE])) {
+            state.SkipWithError("Unable to calculate the TOTP code!");
+            return;
+        }
+
+        if (0 != (i % 2)) {
+            codes[i * OTPCODE_BUFFER_SIZE] = (codes[i * OTPCODE_BUFFER_SIZE] == '0') ? '1' : '0';
+        }
+
+        keyPtrs[i] = &keys[i];
+        codePtrs[i] = &codes[i * OTPCODE_BUFFER_SIZE];
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(verifier.verifyMany(keyPtrs.data(), codePtrs.data(), count, now, matched.get(), offsets.data()));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(count));
+    state.SetLabel(BenchmarkUtils::algorithmName(algorithm));
+}
+BENCHMARK(BM_TotpVerifierVerifyMany)->ArgNames({"alg", "window", "batch"})->ArgsProduct({BENCHMARK_ALGORITHMS, {0, 1, 2}, BENCHMARK_BATCH_SIZES});
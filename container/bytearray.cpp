@@ -1,6 +1,9 @@
 #include "bytearray.h"
 
 #include <cstring>
+#include <new>
+
+#include "securearena.h"
 
 #ifdef _WIN32
 #define strdup  _strdup
@@ -13,6 +16,7 @@ ByteArray::ByteArray(bool zeroOnFree) :
     mByteArrayLength = 0;
     mBufferAllocated = 0;
     mExtraAllocationSize = 0;
+    mSecureBuffer = false;
 }
 
 ByteArray::ByteArray(size_t extraAllocationSize, bool zeroOnFree) :
@@ -21,6 +25,7 @@ ByteArray::ByteArray(size_t extraAllocationSize, bool zeroOnFree) :
     mByteArray = nullptr;
     mByteArrayLength = 0;
     mBufferAllocated = 0;
+    mSecureBuffer = false;
 }
 
 /**
@@ -40,6 +45,7 @@ ByteArray::ByteArray(const char *arrayToCopy, size_t length, bool zeroOnFree) :
     mByteArrayLength = 0;
     mBufferAllocated = 0;
     mExtraAllocationSize = 0;
+    mSecureBuffer = false;
 
     fromCharArray(arrayToCopy, length);
 }
@@ -51,6 +57,7 @@ ByteArray::ByteArray(const std::string &stringToCopy, bool zeroOnFree) :
     mByteArrayLength = 0;
     mBufferAllocated = 0;
     mExtraAllocationSize = 0;
+    mSecureBuffer = false;
 
     // Copy the data, and length from the string.
     fromStdString(stringToCopy);
@@ -63,10 +70,30 @@ ByteArray::ByteArray(const ByteArray &toCopy)
     mBufferAllocated = 0;
     mZeroOnFree = false;
     mExtraAllocationSize = 0;
+    mSecureBuffer = false;
 
     (*this) = toCopy;
 }
 
+/**
+ * @brief ByteArray::ByteArray - Create a new ByteArray object by taking the data from
+ *      another one.  If the data is on the heap, the buffer is handed over without being
+ *      copied.
+ *
+ * @param toMove - The object to take the data from.  It will be empty when this returns.
+ */
+ByteArray::ByteArray(ByteArray &&toMove) noexcept
+{
+    mByteArray = nullptr;
+    mByteArrayLength = 0;
+    mBufferAllocated = 0;
+    mZeroOnFree = false;
+    mExtraAllocationSize = 0;
+    mSecureBuffer = false;
+
+    takeBuffer(toMove);
+}
+
 ByteArray::~ByteArray()
 {
     clear();
@@ -79,18 +106,22 @@ ByteArray::~ByteArray()
 void ByteArray::clear()
 {
     if (nullptr != mByteArray) {
-        // If we are told to zero the memory on free, zero it.
+        // If we are told to zero the memory on free, zero it.  (All of it, since a
+        // truncate can leave data past the current length.)
         if (mZeroOnFree) {
-            memset(mByteArray, 0x00, mByteArrayLength);
+            memset(mByteArray, 0x00, mBufferAllocated + 1);
         }
 
-        // Free the memory.
-        delete mByteArray;
+        // Free the memory, if it isn't our inline buffer.
+        if (mInlineBuffer != mByteArray) {
+            freeBuffer(mByteArray, mSecureBuffer);
+        }
     }
 
     mByteArray = nullptr;
     mByteArrayLength = 0;
     mBufferAllocated = 0;
+    mSecureBuffer = false;
 }
 
 /**
@@ -100,18 +131,26 @@ void ByteArray::clear()
  */
 bool ByteArray::empty() const
 {
-    return (nullptr == mByteArray);
+    // A buffer may have been reserved without any data in it yet.
+    return ((nullptr == mByteArray) || (0 == mByteArrayLength));
 }
 
 /**
  * @brief ByteArray::setZeroOnFree - Change the behavior of freeing memory to either
- *      just free it, or zero out the current memory and then freeing it.
+ *      just free it, or zero out the current memory and then freeing it.  Turning it on
+ *      also moves any existing data in to the SecureArena.
  *
  * @param newValue - The new value for the setting.
  */
 void ByteArray::setZeroOnFree(bool newValue)
 {
     mZeroOnFree = newValue;
+
+    if ((mZeroOnFree) && (nullptr != mByteArray) && (!mSecureBuffer)) {
+        // Move the data.  The old copy is wiped as part of the move.  (If the move fails,
+        // the data stays where it is, and is still zeroed when freed.)
+        reallocateBuffer(mBufferAllocated);
+    }
 }
 
 /**
@@ -179,6 +218,101 @@ size_t ByteArray::size() const
     return mByteArrayLength;
 }
 
+/**
+ * @brief ByteArray::capacity - Return the number of bytes that can be stored in this object
+ *      before it needs to allocate more memory.
+ *
+ * @return size_t containing the capacity of the current buffer.
+ */
+size_t ByteArray::capacity() const
+{
+    return mBufferAllocated;
+}
+
+/**
+ * @brief ByteArray::usingInlineBuffer - Check if the data is stored in the buffer inside
+ *      this object, instead of on the heap.
+ *
+ * @return true if the inline buffer is being used.  false if the data is on the heap, or
+ *      there is no data.
+ */
+bool ByteArray::usingInlineBuffer() const
+{
+    return (mInlineBuffer == mByteArray);
+}
+
+/**
+ * @brief ByteArray::usingSecureBuffer - Check if the data is stored in the SecureArena.
+ *
+ * @return true if the data is in locked memory.  false if it is inline, on the heap, or
+ *      there is no data.
+ */
+bool ByteArray::usingSecureBuffer() const
+{
+    return mSecureBuffer;
+}
+
+/**
+ * @brief ByteArray::reserve - Make sure the buffer can hold at least the specified number of
+ *      bytes without needing to allocate again.  The data in the buffer is kept.
+ *
+ * @param newCapacity - The number of bytes the buffer should be able to hold.
+ *
+ * @return true if the buffer is big enough.  false on error.
+ */
+bool ByteArray::reserve(size_t newCapacity)
+{
+    if ((nullptr != mByteArray) && (newCapacity <= mBufferAllocated)) {
+        // Already big enough.
+        return true;
+    }
+
+    return reallocateBuffer(newCapacity);
+}
+
+/**
+ * @brief ByteArray::resize - Change the length of the data stored in this object.  If the
+ *      new length is longer, the new bytes will be set to \c fillValue.  If it is shorter, the
+ *      data is truncated, but the buffer is kept.
+ *
+ * @param newLength - The new length of the data.
+ * @param fillValue - The value to set any new bytes to.
+ *
+ * @return true if the data was resized.  false on error.
+ */
+bool ByteArray::resize(size_t newLength, unsigned char fillValue)
+{
+    if (((nullptr == mByteArray) || (newLength > mBufferAllocated)) && (!expandBuffer(newLength))) {
+        // Couldn't expand the buffer.
+        return false;
+    }
+
+    if (newLength > mByteArrayLength) {
+        memset(&mByteArray[mByteArrayLength], fillValue, (newLength - mByteArrayLength));
+    }
+
+    mByteArrayLength = newLength;
+    mByteArray[mByteArrayLength] = 0x00;
+
+    return true;
+}
+
+/**
+ * @brief ByteArray::fill - Set every byte of the data stored in this object to the same
+ *      value.  The length of the data doesn't change.
+ *
+ * @param value - The value to set each byte to.
+ */
+void ByteArray::fill(unsigned char value)
+{
+    if (nullptr == mByteArray) {
+        // Nothing to fill.
+        return;
+    }
+
+    memset(mByteArray, value, mByteArrayLength);
+}
+
 /**
  * @brief ByteArray::fromStdString - Convert a standard string to a byte array.
  *
@@ -236,6 +370,7 @@ bool ByteArray::fromCharArray(const char *arrayToCopy, size_t length)
     // Copy in our data.
     memcpy(mByteArray, arrayToCopy, length);
     mByteArrayLength = length;
+    mByteArray[mByteArrayLength] = 0x00;
 
     return true;
 }
@@ -296,7 +431,7 @@ bool ByteArray::append(const char *arrayToAppend, size_t length)
     }
 
     // See if we need to expand the buffer..
-    if (((0 == mBufferAllocated) || ((mByteArrayLength + length) >= (mBufferAllocated - 1))) &&
+    if (((nullptr == mByteArray) || ((mByteArrayLength + length) > mBufferAllocated)) &&
         (!expandBuffer(mByteArrayLength + length))) {
         // Couldn't expand the buffer.
         return false;
@@ -305,6 +440,7 @@ bool ByteArray::append(const char *arrayToAppend, size_t length)
     // Copy the data to the buffer.
     memcpy(&mByteArray[mByteArrayLength], arrayToAppend, length);
     mByteArrayLength += length;
+    mByteArray[mByteArrayLength] = 0x00;
 
     return true;
 }
@@ -350,6 +486,19 @@ bool ByteArray::append(const ByteArray &toAppend)
     return append(toAppend.toUCharArrayPtr(), toAppend.size());
 }
 
+/**
+ * @brief ByteArray::appendZeros - Append a number of zero bytes to the end of our byte
+ *      array.
+ *
+ * @param count - The number of zero bytes to append.
+ *
+ * @return true if the bytes were appended.  false on error.
+ */
+bool ByteArray::appendZeros(size_t count)
+{
+    return resize(mByteArrayLength + count);
+}
+
 /**
  * @brief ByteArray::truncate - Truncate the data in our byte array.
  *
@@ -430,14 +579,51 @@ ByteArray &ByteArray::operator=(const ByteArray &toCopy)
         return (*this);
     }
 
+    // Once an object is holding secrets, copying something else in to it shouldn't stop it
+    // from being treated as a secret.
     mExtraAllocationSize = toCopy.mExtraAllocationSize;
-    mZeroOnFree = toCopy.mZeroOnFree;
+    mZeroOnFree = (mZeroOnFree || toCopy.mZeroOnFree);
 
     fromUCharArray(toCopy.mByteArray, toCopy.mByteArrayLength);
 
     return (*this);
 }
 
+/**
+ * @brief ByteArray::operator = - Take the contents of another ByteArray object.  Any data
+ *      already in this object is freed (and zeroed, if needed) first.  If this object holds
+ *      secrets, and the other one doesn't, the data is copied in to our secure buffer
+ *      instead, and the original wiped.
+ *
+ * @param toMove - The object to take the contents from.  It will be empty when this
+ *      returns.
+ *
+ * @return ByteArray with the contents moved in.
+ */
+ByteArray &ByteArray::operator=(ByteArray &&toMove) noexcept
+{
+    if (this == &toMove) {
+        return (*this);
+    }
+
+    if ((mZeroOnFree) && (!toMove.mZeroOnFree)) {
+        // We hold secrets, but the other object doesn't, so its buffer isn't somewhere we
+        // want to keep secrets.  Copy the data in to our own buffer, and wipe the original.
+        (*this) = static_cast<const ByteArray &>(toMove);
+
+        toMove.mZeroOnFree = true;
+        toMove.clear();
+        toMove.mZeroOnFree = false;
+
+        return (*this);
+    }
+
+    clear();
+    takeBuffer(toMove);
+
+    return (*this);
+}
+
 /**
  * @brief ByteArray::operator = - Copy the contents of a standard string to this ByteArray
  *      object.
@@ -494,7 +680,8 @@ bool ByteArray::operator!=(const ByteArray &toCompare)
 
 /**
  * @brief ByteArray::allocateBuffer - Free any existing buffer, and allocate a new one
- *      with the specified size, plus any extra allocation size.
+ *      with the specified size, plus any extra allocation size.  If it fits, the inline
+ *      buffer is used instead of allocating memory.
  *
  * @param newSize - The new base size for the buffer.
  *
@@ -505,64 +692,190 @@ bool ByteArray::allocateBuffer(size_t newSize)
     // Clear out the old buffer.
     clear();
 
-    // Allocate the new buffer.
     mBufferAllocated = newSize + mExtraAllocationSize;
-    mByteArray = new unsigned char[mBufferAllocated + 1];
-    if (nullptr == mByteArray) {
-        // Failed to allocate the memory.
-        return false;
+    if ((!mZeroOnFree) && (mBufferAllocated <= BYTEARRAY_INLINE_SIZE)) {
+        // Use the inline buffer.  It may have the length of the inline buffer, instead of
+        // what was asked for.
+        mBufferAllocated = BYTEARRAY_INLINE_SIZE;
+        mByteArray = mInlineBuffer;
+    } else {
+        // Allocate the new buffer.
+        mByteArray = newBuffer(mBufferAllocated + 1, mSecureBuffer);
+        if (nullptr == mByteArray) {
+            // Failed to allocate the memory.
+            mBufferAllocated = 0;
+            return false;
+        }
     }
 
-    // Zero out the (whole) array.
-    memset(mByteArray, 0x00, (mBufferAllocated + 1));
+    // The callers copy their data in, so we only need to make sure the buffer reads as an
+    // empty, null terminated string.
+    mByteArray[0] = 0x00;
 
     // We are good.
     return true;
 }
 
 /**
- * @brief ByteArray::expandBuffer - Expand the existing buffer to a larger size by
- *      allocating a new buffer, and copying the existing data to it.
+ * @brief ByteArray::expandBuffer - Expand the existing buffer so that it can hold at least
+ *      \c newSize bytes.  The buffer at least doubles in size each time, so building up data
+ *      with a lot of small appends only needs a few allocations.
  *
- * @param newSize - The size of the new buffer.  (The extra allocation size will be
- *      added to this value.
+ * @param newSize - The number of bytes the buffer needs to hold.  (The extra allocation size
+ *      will be added to this value.)
  *
  * @return true if the buffer was expanded, and data copied.  false on error.
  */
 bool ByteArray::expandBuffer(size_t newSize)
 {
-    unsigned char *oldBuffer = nullptr;
-    size_t oldBufferSize = 0;
+    size_t newAllocation = newSize + mExtraAllocationSize;
 
-    if (nullptr != mByteArray) {
-        // Store the pointer for later use.
-        oldBuffer = mByteArray;
-        oldBufferSize = mByteArrayLength;
+    if ((nullptr != mByteArray) && (newAllocation < (mBufferAllocated * 2))) {
+        newAllocation = mBufferAllocated * 2;
+    }
+
+    return reallocateBuffer(newAllocation);
+}
+
+/**
+ * @brief ByteArray::reallocateBuffer - Move the data in to a new buffer that has exactly
+ *      the requested size.  If there isn't any buffer yet, and the size fits in the inline
+ *      buffer, no memory is allocated.
+ *
+ * @param newAllocation - The number of bytes the new buffer should be able to hold.  Must be
+ *      at least the length of the current data.
+ *
+ * @return true if the buffer was reallocated, and data copied.  false on error.
+ */
+bool ByteArray::reallocateBuffer(size_t newAllocation)
+{
+    unsigned char *oldBuffer = mByteArray;
+    size_t oldBufferAllocated = mBufferAllocated;
+    bool oldSecure = mSecureBuffer;
+    unsigned char *buffer = nullptr;
+    bool secure = false;
+
+    if ((nullptr == oldBuffer) && (!mZeroOnFree) && (newAllocation <= BYTEARRAY_INLINE_SIZE)) {
+        // There isn't any data yet, and it will fit in the inline buffer.
+        mBufferAllocated = BYTEARRAY_INLINE_SIZE;
+        mByteArray = mInlineBuffer;
+        mByteArrayLength = 0;
+        mByteArray[0] = 0x00;
+        return true;
     }
 
     // Allocate the new buffer.
-    mBufferAllocated = newSize + mExtraAllocationSize;
-    mByteArray = new unsigned char[mBufferAllocated + 1];
-    if (nullptr == mByteArray) {
+    buffer = newBuffer(newAllocation + 1, secure);
+    if (nullptr == buffer) {
         // Failed to allocate the memory.
         return false;
     }
 
-    // If we have an old buffer, copy the data to our new buffer, and update our
-    // data buffer size.
+    // If we have an old buffer, copy the data to our new buffer.
     if (nullptr != oldBuffer) {
-        memcpy(mByteArray, oldBuffer, oldBufferSize);
-        mByteArrayLength = oldBufferSize;
+        memcpy(buffer, oldBuffer, mByteArrayLength);
 
         // If we are told to zero on free, do it.
         if (mZeroOnFree) {
-            memset(oldBuffer, 0x00, oldBufferSize);
+            memset(oldBuffer, 0x00, oldBufferAllocated + 1);
         }
 
         // Free the old memory.
-        delete oldBuffer;
+        if (mInlineBuffer != oldBuffer) {
+            freeBuffer(oldBuffer, oldSecure);
+        }
         oldBuffer = nullptr;
+    } else {
+        mByteArrayLength = 0;
     }
 
+    mByteArray = buffer;
+    mSecureBuffer = secure;
+    mBufferAllocated = newAllocation;
+    mByteArray[mByteArrayLength] = 0x00;
+
     return true;
 }
+
+/**
+ * @brief ByteArray::takeBuffer - Take the data, and settings, from another ByteArray
+ *      object, leaving it empty.  This object must already be empty.
+ *
+ * @param toMove - The object to take the data from.
+ */
+void ByteArray::takeBuffer(ByteArray &toMove)
+{
+    mExtraAllocationSize = toMove.mExtraAllocationSize;
+    mZeroOnFree = toMove.mZeroOnFree;
+
+    if (nullptr == toMove.mByteArray) {
+        // Nothing to take.
+        return;
+    }
+
+    if (toMove.usingInlineBuffer()) {
+        // The data lives inside the other object, so it has to be copied.  Clearing the
+        // other object will zero its copy, if needed.
+        memcpy(mInlineBuffer, toMove.mInlineBuffer, toMove.mByteArrayLength + 1);
+        mByteArray = mInlineBuffer;
+        mBufferAllocated = BYTEARRAY_INLINE_SIZE;
+        mByteArrayLength = toMove.mByteArrayLength;
+
+        toMove.clear();
+        return;
+    }
+
+    // The data is on the heap, so we can just take the pointer.
+    mByteArray = toMove.mByteArray;
+    mBufferAllocated = toMove.mBufferAllocated;
+    mByteArrayLength = toMove.mByteArrayLength;
+    mSecureBuffer = toMove.mSecureBuffer;
+
+    toMove.mByteArray = nullptr;
+    toMove.mBufferAllocated = 0;
+    toMove.mByteArrayLength = 0;
+    toMove.mSecureBuffer = false;
+}
+
+/**
+ * @brief ByteArray::newBuffer - Allocate a buffer.  If this object holds secrets, the buffer
+ *      comes from the SecureArena.  Otherwise (or if the arena is out of memory) it comes from
+ *      the heap.
+ *
+ * @param allocation - The number of bytes to allocate.
+ * @param secure[OUT] - Set to true if the buffer came from the SecureArena.
+ *
+ * @return unsigned char pointer to the new buffer.  On error, nullptr will be returned.
+ */
+unsigned char *ByteArray::newBuffer(size_t allocation, bool &secure)
+{
+    unsigned char *result = nullptr;
+
+    secure = false;
+
+    if (mZeroOnFree) {
+        result = static_cast<unsigned char *>(SecureArena::getInstance()->allocate(allocation));
+        if (nullptr != result) {
+            secure = true;
+            return result;
+        }
+    }
+
+    return new (std::nothrow) unsigned char[allocation];
+}
+
+/**
+ * @brief ByteArray::freeBuffer - Free a buffer that was allocated with newBuffer().
+ *
+ * @param toFree - The buffer to free.
+ * @param secure - true if the buffer came from the SecureArena.
+ */
+void ByteArray::freeBuffer(unsigned char *toFree, bool secure)
+{
+    if (secure) {
+        SecureArena::getInstance()->release(toFree);
+        return;
+    }
+
+    delete[] toFree;
+}
@@ -3,9 +3,16 @@
 
 #include <string>
 
+const size_t BYTEARRAY_INLINE_SIZE=64;      // Big enough for any digest, counter, or typical secret.
+
 /**
  * @brief The ByteArray class is a container/memory management class for holding
  *          arrays of bytes (basically, char * arrays used in C as strings).
+ *
+ *          Data that fits in BYTEARRAY_INLINE_SIZE bytes is stored in a buffer inside
+ *          the object, so it never touches the heap.  Objects that are flagged to zero
+ *          on free hold secrets, so their data is always stored in the SecureArena
+ *          instead, where it can't be swapped to disk.
  */
 class ByteArray
 {
@@ -15,6 +22,7 @@ public:
     ByteArray(const char *arrayToCopy, size_t length = 0, bool zeroOnFree = false);
     ByteArray(const std::string &stringToCopy, bool zeroOnFree = false);
     ByteArray(const ByteArray &toCopy);
+    ByteArray(ByteArray &&toMove) noexcept;
     ~ByteArray();
 
     void clear();
@@ -27,6 +35,13 @@ public:
     bool setAt(size_t idx, unsigned char newValue);
 
     size_t size() const;
+    size_t capacity() const;
+    bool usingInlineBuffer() const;
+    bool usingSecureBuffer() const;
+
+    bool reserve(size_t newCapacity);
+    bool resize(size_t newLength, unsigned char fillValue = 0x00);
+    void fill(unsigned char value);
 
     bool fromStdString(const std::string &stringToCopy);
     bool fromCharArray(const char *arrayToCopy, size_t length = 0);
@@ -37,6 +52,7 @@ public:
     bool append(const unsigned char *arrayToAppend, size_t length = 0);
     bool append(const char charToAppend);
     bool append(const ByteArray &toAppend);
+    bool appendZeros(size_t count);
 
     bool truncate(size_t newLength);
 
@@ -46,6 +62,7 @@ public:
 
     // Assignment operators.
     ByteArray &operator=(const ByteArray &toCopy);
+    ByteArray &operator=(ByteArray &&toMove) noexcept;
     ByteArray &operator=(const std::string &toCopy);
 
     // Comparison operators.
@@ -55,12 +72,18 @@ public:
 private:
     bool allocateBuffer(size_t newSize);
     bool expandBuffer(size_t newSize);
+    bool reallocateBuffer(size_t newAllocation);
+    void takeBuffer(ByteArray &toMove);
+    unsigned char *newBuffer(size_t allocation, bool &secure);
+    static void freeBuffer(unsigned char *toFree, bool secure);
 
     unsigned char *mByteArray;
+    unsigned char mInlineBuffer[BYTEARRAY_INLINE_SIZE + 1];     // +1 for the null terminator.
     size_t mBufferAllocated;
     size_t mByteArrayLength;
     size_t mExtraAllocationSize;
     bool mZeroOnFree;
+    bool mSecureBuffer;                 // true if mByteArray came from the SecureArena.
 };
 
 #endif // BYTEARRAY_H
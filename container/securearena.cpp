@@ -0,0 +1,342 @@
+#include "securearena.h"
+
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif // _WIN32
+
+/**
+ * @brief alignSize - Round a size up to the arena alignment.
+ *
+ * @param size - The size to round up.
+ *
+ * @return size_t containing the aligned size.
+ */
+static inline size_t alignSize(size_t size)
+{
+    return ((size + (SECUREARENA_ALIGNMENT - 1)) / SECUREARENA_ALIGNMENT) * SECUREARENA_ALIGNMENT;
+}
+
+/**
+ * @brief mapPages - Get a block of pages from the OS, and try to lock them in to RAM, and
+ *      keep them out of core dumps.
+ *
+ * @param size - The number of bytes to map.
+ * @param locked[OUT] - Set to true if the pages were locked.
+ *
+ * @return unsigned char pointer to the pages.  On error, nullptr will be returned.
+ */
+static unsigned char *mapPages(size_t size, bool &locked)
+{
+    void *result;
+
+    locked = false;
+
+#ifdef _WIN32
+    result = VirtualAlloc(nullptr, size, (MEM_COMMIT | MEM_RESERVE), PAGE_READWRITE);
+    if (nullptr == result) {
+        return nullptr;
+    }
+
+    locked = (VirtualLock(result, size) != 0);
+#else
+    result = mmap(nullptr, size, (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+    if (MAP_FAILED == result) {
+        return nullptr;
+    }
+
+    // If we are over the lock limit, we still use the pages.  They just might be swapped.
+    locked = (mlock(result, size) == 0);
+
+#ifdef MADV_DONTDUMP
+    madvise(result, size, MADV_DONTDUMP);
+#endif // MADV_DONTDUMP
+#endif // _WIN32
+
+    return static_cast<unsigned char *>(result);
+}
+
+/**
+ * @brief unmapPages - Wipe, unlock, and give a block of pages back to the OS.
+ *
+ * @param pages - The pages to give back.
+ * @param size - The number of bytes that were mapped.
+ * @param locked - true if the pages were locked.
+ */
+static void unmapPages(unsigned char *pages, size_t size, bool locked)
+{
+    memset(pages, 0x00, size);
+
+#ifdef _WIN32
+    if (locked) {
+        VirtualUnlock(pages, size);
+    }
+
+    VirtualFree(pages, 0, MEM_RELEASE);
+#else
+    if (locked) {
+        munlock(pages, size);
+    }
+
+    munmap(pages, size);
+#endif // _WIN32
+}
+
+/**
+ * @brief SecureArena::getInstance - Return the process wide secure arena.
+ *
+ *      The arena is intentionally never destroyed.  ByteArray objects that live in other
+ *      static objects may be destroyed after it would have been, and they still need to be
+ *      able to release their memory.
+ *
+ * @return SecureArena pointer to the arena.
+ */
+SecureArena *SecureArena::getInstance()
+{
+    static SecureArena *singleton = new SecureArena();        //NOSONAR
+
+    return singleton;
+}
+
+/**
+ * @brief SecureArena::allocate - Allocate a block of locked memory.
+ *
+ * @param size - The number of bytes to allocate.
+ *
+ * @return void pointer to the memory, aligned to SECUREARENA_ALIGNMENT bytes.  On error,
+ *      nullptr will be returned.
+ */
+void *SecureArena::allocate(size_t size)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    size_t allocation;
+    Chunk *chunk;
+    AllocationHeader *header;
+
+    allocation = alignSize(sizeof(AllocationHeader)) + alignSize(size);
+
+    chunk = findChunk(allocation);
+    if (nullptr == chunk) {
+        chunk = newChunk(allocation);
+        if (nullptr == chunk) {
+            // Couldn't get any more pages.
+            return nullptr;
+        }
+    }
+
+    header = reinterpret_cast<AllocationHeader *>(&chunk->base[chunk->used]);
+    header->chunk = chunk;
+    header->allocated = allocation;
+
+    chunk->used += allocation;
+    chunk->liveAllocations++;
+
+    return reinterpret_cast<unsigned char *>(header) + alignSize(sizeof(AllocationHeader));
+}
+
+/**
+ * @brief SecureArena::release - Give back a block of memory that was returned by allocate().
+ *      Once every block in a chunk has been given back, the chunk is wiped.
+ *
+ * @param toRelease - The memory to give back.
+ *
+ * @return true if the memory was released.  false if it didn't come from this arena.
+ */
+bool SecureArena::release(void *toRelease)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    AllocationHeader *header;
+    Chunk *chunk;
+
+    if (nullptr == toRelease) {
+        return false;
+    }
+
+    header = reinterpret_cast<AllocationHeader *>(static_cast<unsigned char *>(toRelease) - alignSize(sizeof(AllocationHeader)));
+    chunk = header->chunk;
+
+    if ((nullptr == chunk) || (0 == chunk->liveAllocations) ||
+        (reinterpret_cast<unsigned char *>(header) < chunk->base) ||
+        (reinterpret_cast<unsigned char *>(header) >= (chunk->base + chunk->used))) {
+        // Not one of ours.
+        return false;
+    }
+
+    chunk->liveAllocations--;
+
+    if (0 == chunk->liveAllocations) {
+        // Nothing left in the chunk, so wipe it, and start over.
+        memset(chunk->base, 0x00, chunk->used);
+        chunk->used = 0;
+
+        // Hang on to one chunk, so we aren't constantly mapping and unmapping.
+        if (mChunks.size() > 1) {
+            freeChunk(chunk);
+        }
+
+        return true;
+    }
+
+    // If this was the most recent allocation in the chunk, we can reuse the space right away.
+    if ((reinterpret_cast<unsigned char *>(header) + header->allocated) == (chunk->base + chunk->used)) {
+        chunk->used -= header->allocated;
+        memset(header, 0x00, header->allocated);
+    }
+
+    return true;
+}
+
+/**
+ * @brief SecureArena::owns - Check if a pointer points in to memory owned by this arena.
+ *
+ * @param toCheck - The pointer to check.
+ *
+ * @return true if the pointer is in one of our chunks.  false otherwise.
+ */
+bool SecureArena::owns(const void *toCheck)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    const unsigned char *ptr = static_cast<const unsigned char *>(toCheck);
+
+    for (size_t i = 0; i < mChunks.size(); i++) {
+        if ((ptr >= mChunks.at(i)->base) && (ptr < (mChunks.at(i)->base + mChunks.at(i)->size))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief SecureArena::chunkCount - Get the number of chunks currently mapped.
+ *
+ * @return size_t containing the number of chunks.
+ */
+size_t SecureArena::chunkCount()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    return mChunks.size();
+}
+
+/**
+ * @brief SecureArena::bytesInUse - Get the number of bytes that are currently handed out, or
+ *      waiting for their chunk to be wiped.
+ *
+ * @return size_t containing the number of bytes in use.
+ */
+size_t SecureArena::bytesInUse()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    size_t result = 0;
+
+    for (size_t i = 0; i < mChunks.size(); i++) {
+        result += mChunks.at(i)->used;
+    }
+
+    return result;
+}
+
+/**
+ * @brief SecureArena::allLocked - Check if all of the chunks were locked in to RAM.  Locking
+ *      can fail if the process is over its locked memory limit.
+ *
+ * @return true if all of the chunks are locked.  false otherwise.
+ */
+bool SecureArena::allLocked()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    for (size_t i = 0; i < mChunks.size(); i++) {
+        if (!mChunks.at(i)->locked) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief SecureArena::findChunk - Find a chunk with enough room left for an allocation.
+ *      The lock must be held by the caller.
+ *
+ * @param allocation - The number of bytes needed, including the header.
+ *
+ * @return Chunk pointer to a chunk with room.  If none have enough room, nullptr will be
+ *      returned.
+ */
+SecureArena::Chunk *SecureArena::findChunk(size_t allocation)
+{
+    // Search from the newest chunk, since it is the most likely to have room.
+    for (size_t i = mChunks.size(); i > 0; i--) {
+        Chunk *chunk = mChunks.at(i - 1);
+
+        if ((chunk->size - chunk->used) >= allocation) {
+            return chunk;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief SecureArena::newChunk - Map a new chunk of pages.  The lock must be held by the
+ *      caller.
+ *
+ * @param minimumSize - The smallest the chunk can be.  Chunks are at least
+ *      SECUREARENA_CHUNK_SIZE bytes.
+ *
+ * @return Chunk pointer to the new chunk.  On error, nullptr will be returned.
+ */
+SecureArena::Chunk *SecureArena::newChunk(size_t minimumSize)
+{
+    Chunk *result;
+    size_t size = SECUREARENA_CHUNK_SIZE;
+
+    if (minimumSize > size) {
+        // Round up to a whole number of chunks.
+        size = ((minimumSize + (SECUREARENA_CHUNK_SIZE - 1)) / SECUREARENA_CHUNK_SIZE) * SECUREARENA_CHUNK_SIZE;
+    }
+
+    result = new (std::nothrow) Chunk();
+    if (nullptr == result) {
+        return nullptr;
+    }
+
+    result->base = mapPages(size, result->locked);
+    if (nullptr == result->base) {
+        delete result;
+        return nullptr;
+    }
+
+    result->size = size;
+    result->used = 0;
+    result->liveAllocations = 0;
+
+    mChunks.push_back(result);
+
+    return result;
+}
+
+/**
+ * @brief SecureArena::freeChunk - Give a chunk back to the OS.  The lock must be held by the
+ *      caller.
+ *
+ * @param toFree - The chunk to free.
+ */
+void SecureArena::freeChunk(Chunk *toFree)
+{
+    for (size_t i = 0; i < mChunks.size(); i++) {
+        if (mChunks.at(i) == toFree) {
+            mChunks.erase(mChunks.begin() + static_cast<long>(i));
+            break;
+        }
+    }
+
+    unmapPages(toFree->base, toFree->size, toFree->locked);
+    delete toFree;
+}
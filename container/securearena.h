@@ -0,0 +1,61 @@
+#ifndef SECUREARENA_H
+#define SECUREARENA_H
+
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+const size_t SECUREARENA_CHUNK_SIZE=65536;     // The size of each block of pages we lock.
+const size_t SECUREARENA_ALIGNMENT=16;         // Every allocation is aligned to this many bytes.
+
+/**
+ * @brief The SecureArena class hands out memory for secret material (decoded secrets, HMAC
+ *      pads, intermediate hashes) from pages that are locked in to RAM, so they are never
+ *      written to swap, and are excluded from core dumps.
+ *
+ *      Memory is handed out with a simple bump allocator.  Freed memory isn't reused right
+ *      away.  Instead, once every allocation in a chunk has been released, the whole chunk is
+ *      wiped in one go and starts over.  The most recent allocation in a chunk can be given
+ *      back immediately, which covers the common case of short lived temporaries.
+ */
+class SecureArena
+{
+public:
+    static SecureArena *getInstance();
+
+    void *allocate(size_t size);
+    bool release(void *toRelease);
+
+    bool owns(const void *toCheck);
+
+    size_t chunkCount();
+    size_t bytesInUse();
+    bool allLocked();
+
+private:
+    struct Chunk {
+        unsigned char *base;
+        size_t size;
+        size_t used;
+        size_t liveAllocations;
+        bool locked;
+    };
+
+    // Stored just before each allocation, so we can find our way back to the chunk.
+    struct AllocationHeader {
+        Chunk *chunk;
+        size_t allocated;
+    };
+
+    SecureArena() = default;
+    ~SecureArena() = default;
+
+    Chunk *findChunk(size_t allocation);
+    Chunk *newChunk(size_t minimumSize);
+    void freeChunk(Chunk *toFree);
+
+    std::mutex mLock;
+    std::vector<Chunk *> mChunks;
+};
+
+#endif // SECUREARENA_H
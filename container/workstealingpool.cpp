@@ -0,0 +1,304 @@
+#include "workstealingpool.h"
+
+#include "../logger.h"
+
+WorkStealingPool::WorkStealingPool(size_t threads) :
+    mPending(0)
+{
+    mTask = nullptr;
+    mGeneration = 0;
+    mBusyWorkers = 0;
+    mStopping = false;
+
+    startWorkers((0 == threads) ? defaultThreadCount() : threads);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    std::lock_guard<std::mutex> job(mJobLock);
+
+    stopWorkers();
+}
+
+/**
+ * @brief WorkStealingPool::setThreadCount - Change the number of threads that work on each
+ *      parallelFor().
+ *
+ * @param threads - The number of threads to use, including the thread that calls parallelFor().
+ *      0 uses one per CPU core.
+ *
+ * @return true if the thread count was changed.  false on error.
+ */
+bool WorkStealingPool::setThreadCount(size_t threads)
+{
+    std::lock_guard<std::mutex> job(mJobLock);
+
+    if (0 == threads) {
+        threads = defaultThreadCount();
+    }
+
+    if (threads == (mWorkers.size() + 1)) {
+        // Nothing to change.
+        return true;
+    }
+
+    stopWorkers();
+    startWorkers(threads);
+
+    return true;
+}
+
+/**
+ * @brief WorkStealingPool::threadCount - Get the number of threads that work on each
+ *      parallelFor().
+ *
+ * @return size_t containing the number of threads, including the calling thread.
+ */
+size_t WorkStealingPool::threadCount()
+{
+    std::lock_guard<std::mutex> job(mJobLock);
+
+    return mWorkers.size() + 1;
+}
+
+/**
+ * @brief WorkStealingPool::parallelFor - Call \c task for every piece of [0, count), spread
+ *      over the pool, and wait for all of them to finish.
+ *
+ * @param count - The number of indexes in the range.
+ * @param grain - The number of indexes in each piece.  (0 is treated as 1.)
+ * @param task - The function to call with each [begin, end) piece.  It will be called from
+ *      several threads at once, so it must only touch data that belongs to its piece.
+ *
+ * @return true if the whole range was run.  false on error.
+ */
+bool WorkStealingPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)> &task)
+{
+    std::lock_guard<std::mutex> job(mJobLock);
+    size_t pieces;
+    size_t queue;
+    Range range;
+
+    if (!task) {
+        LOG_ERROR("No task was provided to run on the thread pool!");
+        return false;
+    }
+
+    if (0 == count) {
+        return true;
+    }
+
+    if (0 == grain) {
+        grain = 1;
+    }
+
+    pieces = (count + (grain - 1)) / grain;
+
+    // If there is only one piece, or nobody to share with, waking the workers is a waste.
+    if ((1 == pieces) || (mWorkers.empty())) {
+        for (size_t i = 0; i < count; i += grain) {
+            task(i, ((count - i) < grain) ? count : (i + grain));
+        }
+
+        return true;
+    }
+
+    // Deal the pieces out to the queues, so each thread starts on its own part of the range.
+    queue = 0;
+    for (size_t i = 0; i < count; i += grain) {
+        range.begin = i;
+        range.end = ((count - i) < grain) ? count : (i + grain);
+
+        {
+            std::lock_guard<std::mutex> lock(mQueues[queue]->lock);
+
+            mQueues[queue]->ranges.push_back(range);
+        }
+
+        queue = (queue + 1) % mQueues.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> state(mStateLock);
+
+        mTask = &task;
+        mPending = pieces;
+        mBusyWorkers = mWorkers.size();
+        mGeneration++;
+    }
+
+    mWake.notify_all();
+
+    // The calling thread uses the last queue.
+    runRanges(mQueues.size() - 1, task);
+
+    {
+        std::unique_lock<std::mutex> state(mStateLock);
+
+        mDone.wait(state, [this]() { return ((0 == mPending) && (0 == mBusyWorkers)); });
+        mTask = nullptr;
+    }
+
+    return true;
+}
+
+/**
+ * @brief WorkStealingPool::defaultThreadCount - Get the number of threads to use when none is
+ *      specified.
+ *
+ * @return size_t containing the number of CPU cores.  (At least 1.)
+ */
+size_t WorkStealingPool::defaultThreadCount()
+{
+    unsigned int cores = std::thread::hardware_concurrency();
+
+    return (0 == cores) ? 1 : cores;
+}
+
+/**
+ * @brief WorkStealingPool::startWorkers - Create the queues and start the worker threads.  The
+ *      caller must hold mJobLock.
+ *
+ * @param threads - The total number of threads, including the calling thread.
+ */
+void WorkStealingPool::startWorkers(size_t threads)
+{
+    uint64_t generation;
+
+    {
+        std::lock_guard<std::mutex> state(mStateLock);
+
+        mStopping = false;
+
+        // New workers must only wake for the next parallelFor(), not the ones that already ran.
+        generation = mGeneration;
+    }
+
+    mQueues.clear();
+    for (size_t i = 0; i < threads; i++) {
+        mQueues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    }
+
+    for (size_t i = 0; (i + 1) < threads; i++) {
+        mWorkers.push_back(std::thread(&WorkStealingPool::workerLoop, this, i, generation));
+    }
+}
+
+/**
+ * @brief WorkStealingPool::stopWorkers - Tell the worker threads to exit, and wait for them.
+ *      The caller must hold mJobLock.
+ */
+void WorkStealingPool::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> state(mStateLock);
+
+        mStopping = true;
+    }
+
+    mWake.notify_all();
+
+    for (size_t i = 0; i < mWorkers.size(); i++) {
+        mWorkers[i].join();
+    }
+
+    mWorkers.clear();
+}
+
+/**
+ * @brief WorkStealingPool::workerLoop - The body of each worker thread.  Waits for a new
+ *      parallelFor() to start, helps run it, and goes back to waiting.
+ *
+ * @param index - The index of the worker's own queue.
+ * @param generation - The value of mGeneration when the worker was started.  The worker waits
+ *      for it to change before doing anything.
+ */
+void WorkStealingPool::workerLoop(size_t index, uint64_t generation)
+{
+    const std::function<void(size_t, size_t)> *task;
+    uint64_t seen = generation;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> state(mStateLock);
+
+            mWake.wait(state, [this, &seen]() { return ((mStopping) || (mGeneration != seen)); });
+            if (mStopping) {
+                return;
+            }
+
+            seen = mGeneration;
+            task = mTask;
+        }
+
+        if (nullptr != task) {
+            runRanges(index, *task);
+        }
+
+        {
+            std::lock_guard<std::mutex> state(mStateLock);
+
+            mBusyWorkers--;
+        }
+
+        mDone.notify_all();
+    }
+}
+
+/**
+ * @brief WorkStealingPool::runRanges - Run pieces of the range until there are none left in any
+ *      of the queues.
+ *
+ * @param index - The index of the calling thread's own queue.
+ * @param task - The function to call with each piece.
+ */
+void WorkStealingPool::runRanges(size_t index, const std::function<void(size_t, size_t)> &task)
+{
+    Range range;
+
+    while (takeRange(index, range)) {
+        task(range.begin, range.end);
+
+        if (1 == mPending.fetch_sub(1)) {
+            // That was the last one.  Take the lock so the waiting thread can't miss the wakeup.
+            {
+                std::lock_guard<std::mutex> state(mStateLock);
+            }
+
+            mDone.notify_all();
+        }
+    }
+}
+
+/**
+ * @brief WorkStealingPool::takeRange - Get the next piece to run.  Pieces come from the back of
+ *      our own queue first, and then from the front of the other queues.
+ *
+ * @param index - The index of the calling thread's own queue.
+ * @param range[OUT] - If this method returns true, the piece to run.
+ *
+ * @return true if a piece was found.  false if all of the queues are empty.
+ */
+bool WorkStealingPool::takeRange(size_t index, Range &range)
+{
+    for (size_t i = 0; i < mQueues.size(); i++) {
+        WorkQueue &queue = *mQueues[(index + i) % mQueues.size()];
+        std::lock_guard<std::mutex> lock(queue.lock);
+
+        if (queue.ranges.empty()) {
+            continue;
+        }
+
+        if (0 == i) {
+            range = queue.ranges.back();
+            queue.ranges.pop_back();
+        } else {
+            range = queue.ranges.front();
+            queue.ranges.pop_front();
+        }
+
+        return true;
+    }
+
+    return false;
+}
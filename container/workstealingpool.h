@@ -0,0 +1,73 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The WorkStealingPool class runs a loop over a range of indexes on a set of worker
+ *      threads.  The range is cut in to pieces that are dealt out to a queue per thread.  Each
+ *      thread works through its own queue first, and then steals from the other end of the
+ *      other queues, so a thread that gets the cheap pieces doesn't sit idle while another is
+ *      still busy.
+ *
+ *      The thread that calls parallelFor() works on the range too, and doesn't return until the
+ *      whole range is done, so the results can be used (or handed to the GUI) in one go.  Only
+ *      one parallelFor() runs at a time.
+ */
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(size_t threads = 0);
+    ~WorkStealingPool();
+
+    bool setThreadCount(size_t threads);
+    size_t threadCount();
+
+    bool parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)> &task);
+
+    static size_t defaultThreadCount();
+
+private:
+    // A piece of the range.  [begin, end)
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<Range> ranges;
+    };
+
+    void startWorkers(size_t threads);
+    void stopWorkers();
+
+    void workerLoop(size_t index, uint64_t generation);
+    void runRanges(size_t index, const std::function<void(size_t, size_t)> &task);
+    bool takeRange(size_t index, Range &range);
+
+    std::mutex mJobLock;                    // Held for the whole of a parallelFor(), or a resize.
+    std::mutex mStateLock;                  // Protects the fields below, and the condition variables.
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+
+    std::vector<std::thread> mWorkers;
+    std::vector<std::unique_ptr<WorkQueue> > mQueues;     // One per worker, plus one for the calling thread.
+
+    const std::function<void(size_t, size_t)> *mTask;
+    uint64_t mGeneration;
+    size_t mBusyWorkers;
+    bool mStopping;
+    std::atomic<size_t> mPending;           // Ranges that haven't finished running yet.
+};
+
+#endif // WORKSTEALINGPOOL_H
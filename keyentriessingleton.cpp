@@ -1,8 +1,11 @@
 #include "keyentriessingleton.h"
 
 #include <QTimer>
+#include <climits>
 #include "logger.h"
 #include "otp/otphandler.h"
+#include "otpimpl/hotpresync.h"
+#include "settingshandler.h"
 
 KeyEntriesSingleton::KeyEntriesSingleton(QObject *parent) :
     QObject(parent)
@@ -86,11 +89,18 @@ bool KeyEntriesSingleton::open()
         return false;
     }
 
+    // Use the number of threads the user asked for, to calculate the codes.
+    setMaxCalculationThreads(SettingsHandler::getInstance()->maxCalculationThreads());
+
     // Configure our timer as a single shot timer.
     mUpdateTimer.setSingleShot(true);
 
     // Connect the QTimer slots and signals.
     connect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(slotUpdateOtpValues()));
+    connect(&mCheckpointTimer, SIGNAL(timeout()), this, SLOT(slotCheckpointDatabase()));
+
+    // Start moving the database changes out of the write-ahead log every so often.
+    setCheckpointInterval(SettingsHandler::getInstance()->databaseCheckpointInterval());
 
     populateEntries();
 
@@ -113,6 +123,10 @@ bool KeyEntriesSingleton::close()
     // Disconnect the QTimer slots and signals.
     disconnect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(slotUpdateOtpValues()));
 
+    // Closing the database runs a final checkpoint.
+    mCheckpointTimer.stop();
+    disconnect(&mCheckpointTimer, SIGNAL(timeout()), this, SLOT(slotCheckpointDatabase()));
+
     clear();
 
     if (!mKeyStorage.freeStorage()) {
@@ -179,24 +193,19 @@ bool KeyEntriesSingleton::entryParametersAreValid(const QString &addUpdate, QStr
  */
 bool KeyEntriesSingleton::populateEntries()
 {
-    QList<KeyEntry> allKeys;
-    KeyEntry *temp;
-
-    allKeys.clear();
-
-    if (!mKeyStorage.getAllKeys(allKeys)) {
+    // Each KeyEntry is copied straight from the row that was read in to its dynamic allocation,
+    // so there is never a second copy of all of the keys in memory.
+    if (!mKeyStorage.forEachKey([this](const KeyEntry &keyEntry) {
+                                    KeyEntry *temp = new KeyEntry(keyEntry);
+                                    QQmlEngine::setObjectOwnership(temp, QQmlEngine::CppOwnership);
+
+                                    mEntryList.push_back(temp);
+                                    return true;
+                                })) {
         LOG_ERROR("Unable to get all of the keys stored in key storage!");
         return false;
     }
 
-    // We need to convert all of the KeyEntries in to dynamic allocations.
-    for (auto &keyEntry : allKeys) {
-        temp = new KeyEntry(keyEntry);
-        QQmlEngine::setObjectOwnership(temp, QQmlEngine::CppOwnership);
-
-        mEntryList.push_back(temp);
-    }
-
     // Calculate the codes to show.
     //result = calculateEntries();
 
@@ -215,17 +224,74 @@ bool KeyEntriesSingleton::populateEntries()
 }
 
 /**
- * @brief KeyEntriesSingleton::calculateEntries - Iterate the list of KeyEntries, and calculate
- *      the OTP value for each one.
+ * @brief KeyEntriesSingleton::calculateEntries - Calculate the OTP values for all of the KeyEntries
+ *      in a single batch.
  *
  * @return true if the entries were calculated.  false on a horrible, unrecoverable error.
  */
 bool KeyEntriesSingleton::calculateEntries()
 {
-    for (int i = 0; i < mEntryList.size(); i++) {
-        OtpHandler::calculateOtpForKeyEntry(mEntryList.at(i));
+    time_t now = time(nullptr);
+
+    if (!mBatchEngine.calculate(mEntryList, now)) {
+        return false;
+    }
+
+    // Get the codes for the next period ready too, so the rollover doesn't need to calculate
+    // anything.
+    if (!mBatchEngine.calculateNext(mEntryList, now)) {
+        LOG_WARNING("Unable to calculate the look-ahead OTP values.  They will be calculated at the rollover.");
+    }
+
+    return true;
+}
+
+/**
+ * @brief KeyEntriesSingleton::setMaxCalculationThreads - Set the most threads that will be used
+ *      to calculate the OTP values for all of the KeyEntries.  The results are always written
+ *      back to the KeyEntries on this thread.
+ *
+ * @param threads - The maximum number of threads to use, including this one.  0 uses one per
+ *      CPU core.
+ *
+ * @return true if the thread count was changed.  false on error.
+ */
+bool KeyEntriesSingleton::setMaxCalculationThreads(unsigned int threads)
+{
+    if (!mBatchEngine.setThreadCount(threads)) {
+        LOG_ERROR("Unable to set the number of threads used to calculate the OTP values to " + QString::number(threads) + "!");
+        return false;
+    }
+
+    LOG_DEBUG("Calculating the OTP values using " + QString::number(mBatchEngine.threadCount()) + " thread(s).");
+    return true;
+}
+
+/**
+ * @brief KeyEntriesSingleton::setCheckpointInterval - Set how often the key storage is asked to
+ *      move the changes it has buffered (such as the database's write-ahead log) to their final
+ *      location.
+ *
+ * @param seconds - The number of seconds between checkpoints.  0 turns the timer off.
+ *
+ * @return true if the interval was changed.  false on error.
+ */
+bool KeyEntriesSingleton::setCheckpointInterval(unsigned int seconds)
+{
+    if (seconds > static_cast<unsigned int>(INT_MAX / 1000)) {
+        LOG_ERROR("The checkpoint interval of " + QString::number(seconds) + " seconds is too long!");
+        return false;
     }
 
+    if ((0 == seconds) || (!isOpen())) {
+        // If we aren't open, the timer will be started by open().
+        mCheckpointTimer.stop();
+        return true;
+    }
+
+    mCheckpointTimer.start(static_cast<int>(seconds * 1000));
+
+    LOG_DEBUG("Checkpointing the key storage every " + QString::number(seconds) + " second(s).");
     return true;
 }
 
@@ -309,6 +375,64 @@ bool KeyEntriesSingleton::addKeyEntry(const KeyEntry &toAdd)
     return true;
 }
 
+/**
+ * @brief KeyEntriesSingleton::addKeyEntries - Add a set of key entries to the KeyStorage object
+ *      in one go, and then add the ones that were stored to the in-memory list.  The codes for
+ *      the new entries are calculated as a single batch, and the fullRefresh() signal is only
+ *      emitted once, at the end.
+ *
+ * @param toAdd - The KeyEntry objects that we want to add.
+ * @param failed[OUT] - If this method returns true, this vector will contain the indexes (in to
+ *      \c toAdd, in ascending order) of the entries that weren't added.
+ *
+ * @return true if the entries were processed, even if some of them weren't added.  false on error.
+ */
+bool KeyEntriesSingleton::addKeyEntries(const std::vector<KeyEntry> &toAdd, std::vector<size_t> &failed)
+{
+    QList<KeyEntry *> added;
+    KeyEntry *temp;
+    size_t nextFailed = 0;
+    time_t now = time(nullptr);
+
+    if (!mKeyStorage.addKeys(toAdd, failed)) {
+        LOG_ERROR("Unable to add the new KeyEntries to the key storage!");
+        return false;
+    }
+
+    for (size_t i = 0; i < toAdd.size(); i++) {
+        // The failed indexes are in order, so we only need to look at the next one.
+        if ((nextFailed < failed.size()) && (failed.at(nextFailed) == i)) {
+            nextFailed++;
+            continue;
+        }
+
+        temp = new KeyEntry(toAdd.at(i));
+        QQmlEngine::setObjectOwnership(temp, QQmlEngine::CppOwnership);
+
+        mEntryList.push_back(temp);
+        added.push_back(temp);
+    }
+
+    LOG_DEBUG(QString::number(added.size()) + " of " + QString::number(toAdd.size()) + " new keys were added!");
+
+    if (added.isEmpty()) {
+        // Nothing changed.
+        return true;
+    }
+
+    // Calculate the codes for only the new entries.
+    if (!mBatchEngine.calculate(added, now)) {
+        LOG_ERROR("Unable to calculate the OTP values for the new key entries!");
+    } else if (!mBatchEngine.calculateNext(added, now)) {
+        LOG_WARNING("Unable to calculate the look-ahead OTP values.  They will be calculated at the rollover.");
+    }
+
+    // Emit the update signal.
+    emit fullRefresh();
+
+    return true;
+}
+
 /**
  * @brief KeyEntrySingleton::updateKeyEntry - Update an existing key entry.
  *
@@ -357,11 +481,17 @@ bool KeyEntriesSingleton::updateKeyEntry(KeyEntry *currentEntry, QString identif
  */
 bool KeyEntriesSingleton::updateKeyEntry(const KeyEntry &original, const KeyEntry &updated)
 {
+    // Update the key storage first, so the in-memory copy never shows something that wasn't
+    // stored.
+    if (!mKeyStorage.updateKey(original, updated)) {
+        return false;
+    }
+
     if (!updateKeyEntryInMemory(original, updated)) {
-        LOG_DEBUG("The key entry for the original identifier '" + original.identifier() + "' is not in memory.  Will attempt to update in the key storage.");
+        LOG_DEBUG("The key entry for the original identifier '" + original.identifier() + "' is not in memory.  It was only updated in the key storage.");
     }
 
-    return mKeyStorage.updateKey(original, updated);
+    return true;
 }
 
 /**
@@ -409,7 +539,6 @@ bool KeyEntriesSingleton::deleteKeyEntry(const QString &toDelete)
  */
 bool KeyEntriesSingleton::incrementHotpCounter(const QString &identifier)
 {
-    KeyEntry toIncrement;
     KeyEntry *original;
 
     if (identifier.isEmpty()) {
@@ -432,15 +561,87 @@ bool KeyEntriesSingleton::incrementHotpCounter(const QString &identifier)
         return false;
     }
 
-    // Make a copy to edit.
-    toIncrement = (*original);
-
     // It is an HOTP type, so increment the counter.
-    toIncrement.setHotpCounter(toIncrement.hotpCounter()+1);
+    if (!storeHotpCounter(original, original->hotpCounter() + 1)) {
+        LOG_ERROR("Failed to increment the HOTP counter!  The displayed value won't be updated.");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief KeyEntriesSingleton::resyncHotpCounter - Find the counter an HOTP token has drifted
+ *      to, using one or two consecutive codes from the token, and store the counter that
+ *      follows them.
+ *
+ * @param identifier - The identifier of the HOTP key to resync.
+ * @param firstCode - The first code from the token.
+ * @param secondCode - The code the token generated after \c firstCode.  Optional, but over a
+ *      large window a single code can match the wrong counter by chance.
+ * @param window - The number of counters past the stored one to search.  (Up to
+ *      HOTPRESYNC_MAX_WINDOW.)
+ *
+ * @return true if the counter was found and stored.  false if it wasn't found, or on error.
+ */
+bool KeyEntriesSingleton::resyncHotpCounter(const QString &identifier, const QString &firstCode, const QString &secondCode, unsigned int window)
+{
+    KeyEntry *original;
+    QByteArray codeData[HOTPRESYNC_MAX_CODES];
+    const char *codes[HOTPRESYNC_MAX_CODES];
+    size_t codeCount = 0;
+    uint64_t matchedCounter;
+
+    if ((identifier.isEmpty()) || (firstCode.isEmpty())) {
+        LOG_ERROR("Cannot resync the HOTP counter without an identifier and a code!");
+        return false;
+    }
+
+    LOG_DEBUG("Resyncing HOTP counter for : " + identifier);
+
+    // Find the KeyEntry to use.
+    original = fromIdentifier(identifier);
+    if (original == nullptr) {
+        LOG_ERROR("Unable to locate the key entry for identifier : " + identifier);
+        return false;
+    }
+
+    // Make sure the KeyEntry is an HOTP entry.
+    if (original->otpType() != KEYENTRY_OTPTYPE_HOTP) {
+        LOG_ERROR("Cannot resync the HOTP counter for non-HOTP key with the identifier : " + identifier);
+        return false;
+    }
+
+    // Make sure the HMAC key is cached, so the search doesn't need to decode the secret.
+    if (!OtpHandler::prepareKeyEntry(original)) {
+        LOG_ERROR("Unable to prepare the key for identifier '" + identifier + "' to resync the HOTP counter!");
+        return false;
+    }
+
+    codeData[codeCount++] = firstCode.trimmed().toLatin1();
+    if (!secondCode.isEmpty()) {
+        codeData[codeCount++] = secondCode.trimmed().toLatin1();
+    }
+
+    for (size_t i = 0; i < codeCount; i++) {
+        codes[i] = codeData[i].constData();
+    }
+
+    if (!HotpResync::search(original->hmacKey(), original->outNumberCount(), codes, codeCount, original->hotpCounter(), window, matchedCounter)) {
+        LOG_ERROR("Unable to find the HOTP counter for identifier '" + identifier + "' within " + QString::number(window) + " steps!");
+        return false;
+    }
+
+    // The stored counter is the next one that hasn't been used.
+    if ((matchedCounter + codeCount) > UINT_MAX) {
+        LOG_ERROR("The resynced HOTP counter for identifier '" + identifier + "' is too large to store!");
+        return false;
+    }
 
     // Then, update the database entry.
-    if (updateKeyEntry((*original), toIncrement) == false) {
-        LOG_ERROR("Failed to increment the HOTP counter!  The displayed value won't be updated.");
+    if (!storeHotpCounter(original, static_cast<unsigned int>(matchedCounter + codeCount))) {
+        LOG_ERROR("Failed to store the resynced HOTP counter for identifier : " + identifier);
+        return false;
     }
 
     return true;
@@ -510,9 +711,13 @@ KeyEntry *KeyEntriesSingleton::fromIdentifier(const QString &identifier)
  */
 void KeyEntriesSingleton::slotUpdateOtpValues()
 {
+    time_t now = time(nullptr);
+
     LOG_DEBUG("Update timer fired!");
 
-    if (!calculateEntries()) {
+    // Swap in the codes that were calculated ahead of time.  Only if some of them weren't ready
+    // do we need to calculate the current codes here.
+    if ((!mBatchEngine.rollover(mEntryList, now)) && (!mBatchEngine.calculate(mEntryList, now))) {
         LOG_ERROR("Unable to calculate new OTP values.  Will try again in 10 seconds!");
 
         // Set the timer to fire again in 10 seconds.
@@ -520,6 +725,9 @@ void KeyEntriesSingleton::slotUpdateOtpValues()
         return;
     }
 
+    // Once the UI has the new codes, work out the ones for the period after this one.
+    QTimer::singleShot(0, this, SLOT(slotCalculateNextCodes()));
+
     // Call updateTimer() to reset the timer for the next time we need to update.
     if (!updateTimer()) {
         LOG_ERROR("Unable to calculate the next time interval to use!  Will try again in 10 seconds!");
@@ -529,6 +737,29 @@ void KeyEntriesSingleton::slotUpdateOtpValues()
     }
 }
 
+/**
+ * @brief KeyEntriesSingleton::slotCalculateNextCodes - Calculate the look-ahead codes for the
+ *      next time period.  This is queued after each rollover, so it runs well before the codes
+ *      are needed, and never delays showing the current codes.
+ */
+void KeyEntriesSingleton::slotCalculateNextCodes()
+{
+    if (!mBatchEngine.calculateNext(mEntryList, time(nullptr))) {
+        LOG_WARNING("Unable to calculate the look-ahead OTP values.  They will be calculated at the rollover.");
+    }
+}
+
+/**
+ * @brief KeyEntriesSingleton::slotCheckpointDatabase - Have the key storage write out any changes
+ *      it has buffered.  Nothing is lost if this fails, so we just try again next time.
+ */
+void KeyEntriesSingleton::slotCheckpointDatabase()
+{
+    if (!mKeyStorage.checkpoint()) {
+        LOG_WARNING("Unable to checkpoint the key storage.  Will try again later.");
+    }
+}
+
 /**
  * @brief KeyEntriesSingleton::indexFromIdentifierInMemory - Find the index for the KeyEntry that
  *      matches the provided identifier.
@@ -676,6 +907,41 @@ bool KeyEntriesSingleton::addKeyEntryInMemory(const KeyEntry &toAdd)
     return true;
 }
 
+/**
+ * @brief KeyEntriesSingleton::storeHotpCounter - Write a new HOTP counter for an entry to the key
+ *      storage, and then to the in-memory entry.  The counter is only written if the stored
+ *      counter is still the one the in-memory entry has, so a counter that was moved on by
+ *      something else is never moved back.  If that happens, the in-memory entry is given the
+ *      stored counter instead.
+ *
+ * @param original - The in-memory KeyEntry to update.
+ * @param newCounter - The HOTP counter to store.
+ *
+ * @return true if the new counter was stored.  false on error.
+ */
+bool KeyEntriesSingleton::storeHotpCounter(KeyEntry *original, unsigned int newCounter)
+{
+    KeyEntry updated;
+    KeyEntry stored;
+
+    updated = (*original);
+    updated.setHotpCounter(newCounter);
+
+    if (!mKeyStorage.updateKeyIf((*original), updated, original->hotpCounter())) {
+        // Pick up whatever the counter is now, so the next attempt starts from the right place.
+        if ((mKeyStorage.keyByIdentifier(original->identifier(), stored)) && (stored.hotpCounter() != original->hotpCounter())) {
+            LOG_WARNING("The HOTP counter for identifier '" + original->identifier() + "' was changed to " + QString::number(stored.hotpCounter()) + " by something else.");
+            original->setHotpCounter(stored.hotpCounter());
+        }
+
+        return false;
+    }
+
+    original->setHotpCounter(newCounter);
+
+    return true;
+}
+
 /**
  * @brief KeyEntriesSingleton::updateTimer - Figure out how long we need to wait before calculating the
  *      new value for an OTP, and set a timer to do the update at that time.
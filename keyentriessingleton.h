@@ -8,6 +8,9 @@
 
 #include "keystorage/keyentry.h"
 #include "keystorage/keystorage.h"
+#include "otp/otpbatchengine.h"
+
+const unsigned int KEYENTRIESSINGLETON_HOTP_RESYNC_WINDOW=1000;     // The default number of counters to search when resyncing an HOTP key.
 
 class KeyEntriesSingleton : public QObject
 {
@@ -27,8 +30,12 @@ public:
 
     bool calculateEntries();
 
+    bool setMaxCalculationThreads(unsigned int threads);
+    bool setCheckpointInterval(unsigned int seconds);
+
     Q_INVOKABLE bool addKeyEntry(const QString &identifier, const QString &issuer, const QString &secret, unsigned int keyType, unsigned int otpType, unsigned int numberCount, unsigned int algorithm, unsigned int period, unsigned int offset);
     bool addKeyEntry(const KeyEntry &toAdd);
+    bool addKeyEntries(const std::vector<KeyEntry> &toAdd, std::vector<size_t> &failed);
 
     Q_INVOKABLE bool updateKeyEntry(KeyEntry *currentEntry, QString identifier, QString secret, unsigned int keyType, unsigned int otpType, unsigned int numberCount, unsigned int algorithm, unsigned int period, unsigned int offset);
     bool updateKeyEntry(const KeyEntry &original, const KeyEntry &updated);
@@ -36,6 +43,7 @@ public:
     Q_INVOKABLE bool deleteKeyEntry(const QString &toDelete);
 
     Q_INVOKABLE bool incrementHotpCounter(const QString &identifier);
+    Q_INVOKABLE bool resyncHotpCounter(const QString &identifier, const QString &firstCode, const QString &secondCode = QString(), unsigned int window = KEYENTRIESSINGLETON_HOTP_RESYNC_WINDOW);
 
     Q_INVOKABLE int count();
     Q_INVOKABLE KeyEntry *at(int i);
@@ -46,6 +54,8 @@ signals:                                //NOSONAR
 
 private slots:
     void slotUpdateOtpValues();
+    void slotCalculateNextCodes();
+    void slotCheckpointDatabase();
 
 private:                                //NOSONAR
     explicit KeyEntriesSingleton(QObject *parent = nullptr);
@@ -58,6 +68,7 @@ private:                                //NOSONAR
     bool deleteKeyEntryFromMemory(const QString &toDelete);
     bool updateKeyEntryInMemory(const KeyEntry &original, const KeyEntry &updated);
     bool addKeyEntryInMemory(const KeyEntry &toAdd);
+    bool storeHotpCounter(KeyEntry *original, unsigned int newCounter);
 
     bool updateTimer();
     unsigned int shortestUpdatePeriod();
@@ -65,6 +76,9 @@ private:                                //NOSONAR
     QList<KeyEntry *> mEntryList;
 
     QTimer mUpdateTimer;
+    QTimer mCheckpointTimer;
+
+    OtpBatchEngine mBatchEngine;
 
     KeyStorage mKeyStorage;
 };
@@ -59,6 +59,11 @@ bool DatabaseKeyStorage::initKeyStorage()
         return false;
     }
 
+    // Set up how SQLite stores the data, before the file is opened.
+    mSecretDatabase->setStorageOptions(SettingsHandler::getInstance()->databaseWriteAheadLog(),
+                                       SettingsHandler::getInstance()->databaseCacheSizeKb(),
+                                       SettingsHandler::getInstance()->databaseMmapSizeKb());
+
     // Open/create the SecretDatabase file.
     return mSecretDatabase->open(SettingsHandler::getInstance()->fullDatabasePathAndFilename());
 }
@@ -103,6 +108,24 @@ bool DatabaseKeyStorage::getAllKeys(std::vector<KeyEntry> &result)
     return mSecretDatabase->getAll(result);
 }
 
+/**
+ * @brief DatabaseKeyStorage::forEachKey - Read the key entries from the database one at a time,
+ *      and hand each one to \c visitor.
+ *
+ * @param visitor - Called with each KeyEntry.  Return true to keep going, or false to stop.
+ *
+ * @return true if the key entries were read.  false otherwise.
+ */
+bool DatabaseKeyStorage::forEachKey(const std::function<bool(const KeyEntry &entry)> &visitor)
+{
+    if (nullptr == mSecretDatabase) {
+        LOG_ERROR("The secret database isn't open while attempting to read the key entries!");
+        return false;
+    }
+
+    return mSecretDatabase->forEach(visitor);
+}
+
 /**
  * @brief DatabaseKeyStorage::addKey - Add a new key entry to the database.
  *
@@ -120,6 +143,27 @@ bool DatabaseKeyStorage::addKey(const KeyEntry &entry)
     return mSecretDatabase->add(entry);
 }
 
+/**
+ * @brief DatabaseKeyStorage::addKeys - Add a set of new key entries to the database, using a
+ *      single transaction.
+ *
+ * @param entries - The new key entries to add to the database.
+ * @param failed[OUT] - If this method returns true, this vector will contain the indexes (in to
+ *      \c entries, in ascending order) of the entries that weren't added.
+ *
+ * @return true if the transaction was committed, even if some of the entries weren't added.
+ *      false otherwise, in which case none of them were added.
+ */
+bool DatabaseKeyStorage::addKeys(const std::vector<KeyEntry> &entries, std::vector<size_t> &failed)
+{
+    if (nullptr == mSecretDatabase) {
+        LOG_ERROR("The secret database isn't open while attempting to add key entries!");
+        return false;
+    }
+
+    return mSecretDatabase->addMany(entries, failed);
+}
+
 /**
  * @brief DatabaseKeyStorage::updateKey - Update a key entry that exists in the database.
  *
@@ -138,6 +182,44 @@ bool DatabaseKeyStorage::updateKey(const KeyEntry &currentEntry, const KeyEntry
     return mSecretDatabase->update(currentEntry, newEntry);
 }
 
+/**
+ * @brief DatabaseKeyStorage::updateKeyIf - Update a key entry that exists in the database, but
+ *      only if its HOTP counter is still the value we expect.
+ *
+ * @param currentEntry - The current entry that is in the database.
+ * @param newEntry - The entry that should replace the current entry.
+ * @param expectedHotpCounter - The HOTP counter the entry must have in the database.
+ *
+ * @return true if the entry was updated in the database.  false otherwise.
+ */
+bool DatabaseKeyStorage::updateKeyIf(const KeyEntry &currentEntry, const KeyEntry &newEntry, unsigned int expectedHotpCounter)
+{
+    if (nullptr == mSecretDatabase) {
+        LOG_ERROR("The secret database isn't open while attempting to update a key entry!");
+        return false;
+    }
+
+    return mSecretDatabase->updateIf(currentEntry, newEntry, expectedHotpCounter);
+}
+
+/**
+ * @brief DatabaseKeyStorage::upsertKey - Add a key entry to the database, or replace the one
+ *      with the same identifier.
+ *
+ * @param entry - The key entry to write to the database.
+ *
+ * @return true if the key entry was written to the database.  false otherwise.
+ */
+bool DatabaseKeyStorage::upsertKey(const KeyEntry &entry)
+{
+    if (nullptr == mSecretDatabase) {
+        LOG_ERROR("The secret database isn't open while attempting to write a key entry!");
+        return false;
+    }
+
+    return mSecretDatabase->upsert(entry);
+}
+
 /**
  * @brief DatabaseKeyStorage::deleteKeyByIdentifier - Delete a key from key storage, based
  *      on the identifier for the key.
@@ -161,6 +243,22 @@ bool DatabaseKeyStorage::deleteKeyByIdentifier(const QString &identifier)
     return mSecretDatabase->deleteByIdentifier(identifier);
 }
 
+/**
+ * @brief DatabaseKeyStorage::checkpoint - Move the changes in the database's write-ahead log
+ *      in to the database file.
+ *
+ * @return true if the checkpoint was run, or wasn't needed.  false on error.
+ */
+bool DatabaseKeyStorage::checkpoint()
+{
+    if (nullptr == mSecretDatabase) {
+        LOG_ERROR("The secret database isn't open while attempting to checkpoint it!");
+        return false;
+    }
+
+    return mSecretDatabase->checkpoint();
+}
+
 /**
  * @brief DatabaseKeyStorage::freeKeyStorage - "Free" the key storage database by closing
  *      the database itself.
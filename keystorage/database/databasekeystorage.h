@@ -18,9 +18,14 @@ public:
     bool initKeyStorage();
     bool keyByIdentifier(const QString &identifier, KeyEntry &result);
     bool getAllKeys(std::vector<KeyEntry> &result);
+    bool forEachKey(const std::function<bool(const KeyEntry &entry)> &visitor);
     bool addKey(const KeyEntry &entry);
+    bool addKeys(const std::vector<KeyEntry> &entries, std::vector<size_t> &failed);
     bool updateKey(const KeyEntry &currentEntry, const KeyEntry &newEntry);
+    bool updateKeyIf(const KeyEntry &currentEntry, const KeyEntry &newEntry, unsigned int expectedHotpCounter);
+    bool upsertKey(const KeyEntry &entry);
     bool deleteKeyByIdentifier(const QString &identifier);
+    bool checkpoint();
     bool freeKeyStorage();
 
 private:
@@ -12,14 +12,28 @@
 // The schema version expected/used by this implementation of the app.
 const size_t SECRETDATABASE_SCHEMA_VERSION = 1;
 
+// The SQLite result code for a constraint violation, such as a duplicate identifier.
+const int SECRETDATABASE_SQLITE_CONSTRAINT = 19;
+
 SecretDatabase::SecretDatabase()
 {
+    mStatementsPrepared = false;
+    mUpsertPrepared = false;
+
+    mWriteAheadLog = SECRETDATABASE_DEFAULT_WRITE_AHEAD_LOG;
+    mCacheSizeKb = SECRETDATABASE_DEFAULT_CACHE_SIZE_KB;
+    mMmapSizeKb = SECRETDATABASE_DEFAULT_MMAP_SIZE_KB;
+    mWriteAheadLogActive = false;
+
     // Set up the database object to use SQLITE.
     mDatabase = QSqlDatabase::addDatabase("QSQLITE");
 }
 
 SecretDatabase::SecretDatabase(SecretDatabase &toCopy)
 {
+    mStatementsPrepared = false;
+    mUpsertPrepared = false;
+
     copy(toCopy);
 }
 
@@ -52,15 +66,22 @@ bool SecretDatabase::open(const QString &path)
         return false;
     }
 
+    // Set up the journal and caches before anything is read or written.
+    if (!applyStorageOptions()) {
+        // Already logged an error.
+        mDatabase.close();
+        return false;
+    }
+
     // See if we need to create or update the schema.
     sVer = schemaVersion(false);
-    if (sVer != SECRETDATABASE_SCHEMA_VERSION) {
-        // Attempt to create the schema for the database.
-        return upgradeSchema(sVer);
+    if ((sVer != SECRETDATABASE_SCHEMA_VERSION) && (!upgradeSchema(sVer))) {
+        // Already logged an error.
+        return false;
     }
 
-    // Otherwise, things are good.
-    return true;
+    // The tables exist now, so the statements we use can be prepared.
+    return prepareStatements();
 }
 
 /**
@@ -75,6 +96,17 @@ bool SecretDatabase::close()
         return true;
     }
 
+    // The prepared statements can't outlive the connection they were prepared on.
+    clearStatements();
+
+    // Move everything from the write-ahead log in to the database file, so the file can be
+    // copied or moved on its own once it is closed.
+    if ((mWriteAheadLogActive) && (!checkpoint(true))) {
+        LOG_WARNING("Unable to checkpoint the database before closing it.  SQLite will try again when it is closed.");
+    }
+
+    mWriteAheadLogActive = false;
+
     mDatabase.close();
     mDatabase.setDatabaseName("");
 
@@ -91,6 +123,85 @@ bool SecretDatabase::isOpen()
     return mDatabase.isOpen();
 }
 
+/**
+ * @brief SecretDatabase::setStorageOptions - Set the options for how SQLite stores the database.
+ *      If the database is open, they are applied right away.  Otherwise, they are applied the
+ *      next time it is opened.
+ *
+ * @param writeAheadLog - true if changes should be written to a write-ahead log, and moved in to
+ *      the database at each checkpoint.  false to use a rollback journal.
+ * @param cacheSizeKb - The size of the page cache, in KiB.
+ * @param mmapSizeKb - The most of the database file to read through a memory map, in KiB.  0 turns
+ *      the memory map off.
+ *
+ * @return true if the options were set.  false on error.
+ */
+bool SecretDatabase::setStorageOptions(bool writeAheadLog, unsigned int cacheSizeKb, unsigned int mmapSizeKb)
+{
+    mWriteAheadLog = writeAheadLog;
+    mCacheSizeKb = cacheSizeKb;
+    mMmapSizeKb = mmapSizeKb;
+
+    if (!isOpen()) {
+        // They will be applied when the database is opened.
+        return true;
+    }
+
+    return applyStorageOptions();
+}
+
+/**
+ * @brief SecretDatabase::writeAheadLogActive - Check to see if the open database is using a
+ *      write-ahead log.  (If the file system doesn't support it, SQLite will keep using the
+ *      rollback journal, even if we asked for a write-ahead log.)
+ *
+ * @return true if the database is using a write-ahead log.  false otherwise.
+ */
+bool SecretDatabase::writeAheadLogActive()
+{
+    return mWriteAheadLogActive;
+}
+
+/**
+ * @brief SecretDatabase::checkpoint - Move the changes in the write-ahead log in to the database
+ *      file.  SQLite does this on its own once the log gets big enough, but the key entries
+ *      change so rarely that it might not happen for a long time, so we do it on a timer too.
+ *
+ * @param truncate - If true, wait for any readers to finish, and then empty the log file.  If
+ *      false, only copy what can be copied without waiting.
+ *
+ * @return true if the checkpoint was run, or there was no write-ahead log to checkpoint.
+ *      false on error.
+ */
+bool SecretDatabase::checkpoint(bool truncate)
+{
+    if (!isOpen()) {
+        LOG_ERROR("The database isn't open while attempting to checkpoint it!");
+        return false;
+    }
+
+    if (!mWriteAheadLogActive) {
+        // The rollback journal writes straight to the database, so there is nothing to do.
+        return true;
+    }
+
+    QSqlQuery query(mDatabase);
+
+    if (!query.exec(truncate ? "PRAGMA wal_checkpoint(TRUNCATE)" : "PRAGMA wal_checkpoint(PASSIVE)")) {
+        LOG_ERROR("Unable to checkpoint the database!");
+        LOG_ERROR("     Detailed Error : " + query.lastError().text());
+        return false;
+    }
+
+    // The first column is non-zero if something else was using the database, and the checkpoint
+    // couldn't finish.  Whatever is left will be picked up by the next one.
+    if ((query.next()) && (query.value(0).toInt() != 0)) {
+        LOG_DEBUG("The database checkpoint didn't complete.  It will be finished by the next one.");
+    }
+
+    return true;
+}
+
 /**
  * @brief SecretDatabase::add - Add a new KeyEntry to the database.
  *
@@ -106,9 +217,7 @@ bool SecretDatabase::add(const KeyEntry &entry)
         return false;
     }
 
-    QSqlQuery query;
-    KeyEntry foundEntry;
-
+    int rowsAffected;
 
     // Make sure the entry we are going to write is valid.
     if (!entry.valid()) {
@@ -116,25 +225,29 @@ bool SecretDatabase::add(const KeyEntry &entry)
         return false;
     }
 
-    // Make sure it doesn't already exist.
-    if ((getByIdentifier(entry.identifier(), foundEntry)) && (foundEntry.valid()) &&
-            (foundEntry.identifier() == entry.identifier())) {
-        LOG_ERROR("The entry for identifier '" + entry.identifier() + "' already exists!  Please use update()!");
-        return false;
-    }
-
-    if (!createBoundQuery("INSERT into secretData (identifier, secret, keyType, otpType, outNumberCount, timeStep, timeOffset, algorithm, hotpCounter, issuer) VALUES (:identifier, :secret, :keyType, :otpType, :outNumberCount, :timeStep, :timeOffset, :algorithm, :hotpCounter, :issuer)", entry, query)) {
+    if ((!prepareStatements()) || (!bindKeyEntry(entry, mInsertQuery))) {
         // Already logged an error.  Just return.
         return false;
     }
 
-    // Execute the query.
-    if (!query.exec()) {
+    // Execute the query.  If the identifier already exists, the primary key constraint will
+    // stop it from being added again.
+    if (!mInsertQuery.exec()) {
+        if (isConstraintError(mInsertQuery.lastError())) {
+            LOG_ERROR("The entry for identifier '" + entry.identifier() + "' already exists!  Please use update()!");
+            mInsertQuery.finish();
+            return false;
+        }
+
         LOG_ERROR("Failed to write the data to the database!");
+        LOG_ERROR("     Detailed Error : " + mInsertQuery.lastError().text());
         return false;
     }
 
-    if (query.numRowsAffected() != 1) {
+    rowsAffected = mInsertQuery.numRowsAffected();
+    mInsertQuery.finish();
+
+    if (rowsAffected != 1) {
         LOG_ERROR("Failed to write a new key entry to the database!");
         return false;
     }
@@ -142,6 +255,85 @@ bool SecretDatabase::add(const KeyEntry &entry)
     return true;
 }
 
+/**
+ * @brief SecretDatabase::addMany - Add a set of new KeyEntry objects to the database, in a
+ *      single transaction.  Entries that can't be added (because they are invalid, or the
+ *      identifier is already in use) are skipped, and the rest are still added.
+ *
+ * @param entries - The KeyEntry objects to write to the database.
+ * @param failed[OUT] - If this method returns true, this vector will contain the indexes
+ *      (in to \c entries, in ascending order) of the entries that weren't added.
+ *
+ * @return true if the transaction was committed, even if some of the entries were skipped.
+ *      false on error, in which case none of the entries were added.
+ */
+bool SecretDatabase::addMany(const std::vector<KeyEntry> &entries, std::vector<size_t> &failed)
+{
+    failed.clear();
+
+    // Make sure the database is open.
+    if (!isOpen()) {
+        LOG_ERROR("The database isn't open while attempting to add new key entries!");
+        return false;
+    }
+
+    if (!prepareStatements()) {
+        // Already logged an error.
+        return false;
+    }
+
+    // Everything goes in one transaction, so there is only one commit (and sync to disk) for
+    // the whole set, rather than one for each entry.
+    if (!mDatabase.transaction()) {
+        LOG_ERROR("Unable to start a transaction to add the key entries!");
+        LOG_ERROR("     Detailed Error : " + mDatabase.lastError().text());
+        return false;
+    }
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        const KeyEntry &entry = entries.at(i);
+
+        if (!entry.valid()) {
+            LOG_ERROR("The KeyEntry at index " + QString::number(i) + " is invalid!  Skipping it.");
+            failed.push_back(i);
+            continue;
+        }
+
+        bindKeyEntry(entry, mInsertQuery);
+
+        // We don't look for the identifier first.  If it already exists, the primary key
+        // constraint fails the insert, and only this row is undone.
+        if (!mInsertQuery.exec()) {
+            if (!isConstraintError(mInsertQuery.lastError())) {
+                // Anything else means the database is in trouble, so give up on all of them.
+                LOG_ERROR("Failed to write the data to the database!  Rolling back the new key entries.");
+                LOG_ERROR("     Detailed Error : " + mInsertQuery.lastError().text());
+
+                mInsertQuery.finish();
+                mDatabase.rollback();
+                failed.clear();
+                return false;
+            }
+
+            LOG_ERROR("The entry for identifier '" + entry.identifier() + "' already exists!  Skipping it.");
+            failed.push_back(i);
+        }
+
+        mInsertQuery.finish();
+    }
+
+    if (!mDatabase.commit()) {
+        LOG_ERROR("Failed to commit the new key entries to the database!");
+        LOG_ERROR("     Detailed Error : " + mDatabase.lastError().text());
+
+        mDatabase.rollback();
+        failed.clear();
+        return false;
+    }
+
+    return true;
+}
+
 /**
  * @brief SecretDatabase::update - Update the database entry with the new KeyEntry data.
  *
@@ -152,8 +344,7 @@ bool SecretDatabase::add(const KeyEntry &entry)
  */
 bool SecretDatabase::update(const KeyEntry &currentEntry, const KeyEntry &newEntry)
 {
-    QSqlQuery query;
-    KeyEntry foundEntry;
+    int rowsAffected;
 
     // Make sure that the data provided is valid.
     if ((!currentEntry.valid()) || (!newEntry.valid())) {
@@ -161,24 +352,112 @@ bool SecretDatabase::update(const KeyEntry &currentEntry, const KeyEntry &newEnt
         return false;
     }
 
-    // Make sure the currentEntry *DOES* exist in the database.
-    if (!getByIdentifier(currentEntry.identifier(), foundEntry)) {
+    if ((!prepareStatements()) || (!bindKeyEntry(newEntry, mUpdateQuery))) {
+        // Already logged an error.  Just return.
+        return false;
+    }
+
+    mUpdateQuery.bindValue(":currentIdentifier", currentEntry.identifier());
+
+    // Execute the query.
+    if (!mUpdateQuery.exec()) {
+        LOG_ERROR("Failed to update the key entry data in the database!");
+        LOG_ERROR("     Detailed Error : " + mUpdateQuery.lastError().text());
+        return false;
+    }
+
+    rowsAffected = mUpdateQuery.numRowsAffected();
+    mUpdateQuery.finish();
+
+    // If nothing was changed, the currentEntry wasn't in the database.
+    if (rowsAffected == 0) {
         LOG_WARNING("The current entry doesn't exist.  Did you mean to use add()?");
         return false;
     }
 
-    if (!createBoundQuery("UPDATE secretData set identifier=:identifier, secret=:secret, keyType=:keyType, otpType=:otpType, outNumberCount=:outNumberCount, timeStep=:timeStep, timeOffset=:timeOffset, algorithm=:algorithm, hotpCounter=:hotpCounter, issuer=:issuer where identifier='" + currentEntry.identifier() + "'", newEntry, query)) {
+    return true;
+}
+
+/**
+ * @brief SecretDatabase::updateIf - Update the database entry with the new KeyEntry data, but
+ *      only if its HOTP counter is still the value we expect.  The check and the update are a
+ *      single statement, so if something else changed the counter first, this update won't
+ *      overwrite it.
+ *
+ * @param currentEntry - The current entry in the database that we will look for to update.
+ * @param newEntry - How the entry should look after being updated in the database.
+ * @param expectedHotpCounter - The HOTP counter the entry must have in the database for it to be
+ *      updated.
+ *
+ * @return true if the entry was updated.  false if the entry doesn't exist, the HOTP counter
+ *      didn't match, or on error.
+ */
+bool SecretDatabase::updateIf(const KeyEntry &currentEntry, const KeyEntry &newEntry, unsigned int expectedHotpCounter)
+{
+    int rowsAffected;
+
+    // Make sure that the data provided is valid.
+    if ((!currentEntry.valid()) || (!newEntry.valid())) {
+        LOG_ERROR("One of the KeyEntry values provided was invalid while trying to update the database!");
+        return false;
+    }
+
+    if ((!prepareStatements()) || (!bindKeyEntry(newEntry, mUpdateIfQuery))) {
         // Already logged an error.  Just return.
         return false;
     }
 
+    mUpdateIfQuery.bindValue(":currentIdentifier", currentEntry.identifier());
+    mUpdateIfQuery.bindValue(":expectedHotpCounter", static_cast<qulonglong>(expectedHotpCounter));
+
     // Execute the query.
-    if (!query.exec()) {
+    if (!mUpdateIfQuery.exec()) {
         LOG_ERROR("Failed to update the key entry data in the database!");
-        LOG_ERROR("     Detailed Error : " + query.lastError().text());
+        LOG_ERROR("     Detailed Error : " + mUpdateIfQuery.lastError().text());
+        return false;
+    }
+
+    rowsAffected = mUpdateIfQuery.numRowsAffected();
+    mUpdateIfQuery.finish();
+
+    if (rowsAffected == 0) {
+        LOG_WARNING("The entry for identifier '" + currentEntry.identifier() + "' doesn't exist, or its HOTP counter isn't " + QString::number(expectedHotpCounter) + ".  It wasn't updated.");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief SecretDatabase::upsert - Write a KeyEntry to the database, replacing the entry with the
+ *      same identifier if there is one, or adding it if there isn't.
+ *
+ * @param entry - The KeyEntry to write to the database.
+ *
+ * @return true if the entry was written to the database.  false on error.
+ */
+bool SecretDatabase::upsert(const KeyEntry &entry)
+{
+    // Make sure the entry we are going to write is valid.
+    if (!entry.valid()) {
+        LOG_ERROR("The KeyEntry provided is invalid!");
+        return false;
+    }
+
+    if ((!prepareUpsertStatement()) || (!bindKeyEntry(entry, mUpsertQuery))) {
+        // Already logged an error.  Just return.
+        return false;
+    }
+
+    // Execute the query.
+    if (!mUpsertQuery.exec()) {
+        LOG_ERROR("Failed to write the data for identifier '" + entry.identifier() + "' to the database!");
+        LOG_ERROR("     Detailed Error : " + mUpsertQuery.lastError().text());
         return false;
     }
 
+    mUpsertQuery.finish();
+
     return true;
 }
 
@@ -193,27 +472,40 @@ bool SecretDatabase::update(const KeyEntry &currentEntry, const KeyEntry &newEnt
  */
 bool SecretDatabase::getByIdentifier(const QString &identifier, KeyEntry &result)
 {
-    QSqlQuery query;
+    bool success;
 
     if (identifier.isEmpty()) {
         LOG_ERROR("Cannot search with an empty identifier!");
         return false;
     }
 
+    if (!prepareStatements()) {
+        // Already logged an error.
+        return false;
+    }
+
     // Make the query.
-    if (!query.exec("SELECT * from secretData where identifier='" + identifier + "'")) {
+    mSelectByIdentifierQuery.bindValue(":identifier", identifier);
+
+    if (!mSelectByIdentifierQuery.exec()) {
         LOG_ERROR("Unable to query the database by identifier!");
-        LOG_ERROR("     Detailed Error : " + query.lastError().text());
+        LOG_ERROR("     Detailed Error : " + mSelectByIdentifierQuery.lastError().text());
         return false;
     }
 
-    if (!query.next()) {
+    if (!mSelectByIdentifierQuery.next()) {
         LOG_DEBUG("No entries returned when searching for the identifier '" + identifier + "'.");
+        mSelectByIdentifierQuery.finish();
         return false;
     }
 
     // Convert the query data to the resulting KeyEntry object.
-    return queryToKeyEntry(query, result);
+    success = queryToKeyEntry(mSelectByIdentifierQuery, result);
+
+    // Reset the statement, so it doesn't hold a read lock on the table until the next call.
+    mSelectByIdentifierQuery.finish();
+
+    return success;
 }
 
 /**
@@ -228,30 +520,64 @@ bool SecretDatabase::getByIdentifier(const QString &identifier, KeyEntry &result
  */
 bool SecretDatabase::getAll(std::vector<KeyEntry> &result)
 {
-    QSqlQuery query;
-    KeyEntry entry;
-
     // Clear out the result vector.
     result.clear();
 
-    if (!query.exec("SELECT * from secretData")) {
+    return forEach([&result](const KeyEntry &entry) {
+        // Add it to the result list.
+        result.push_back(entry);
+        return true;
+    });
+}
+
+/**
+ * @brief SecretDatabase::forEach - Read the entries in the database one row at a time, and hand
+ *      each one to \c visitor as it is read.  Only one row is held in memory here, so the
+ *      visitor can put each entry straight in to wherever it is going.
+ *
+ * @note The visitor must not call forEach() or getAll() itself.  The other methods are fine.
+ *
+ * @param visitor - Called with each KeyEntry.  (Which may be marked as invalid, so the UI can
+ *      show as much as possible about it.)  The entry is only valid during the call.  Return
+ *      true to keep reading, or false to stop.
+ *
+ * @return true if the rows were read (even if they contained errors, or the visitor stopped
+ *      early).  false on severe error, such as the database not being available.
+ */
+bool SecretDatabase::forEach(const std::function<bool(const KeyEntry &entry)> &visitor)
+{
+    KeyEntry entry;
+
+    if (!prepareStatements()) {
+        // Already logged an error.
+        return false;
+    }
+
+    if (!mSelectAllQuery.exec()) {
         LOG_ERROR("Unable to query the database for all of the secret entries!");
-        LOG_ERROR("     Detailed Error : " + query.lastError().text());
+        LOG_ERROR("     Detailed Error : " + mSelectAllQuery.lastError().text());
         return false;
     }
 
-    // Iterate each row, convert it to a KeyEntry, and stuff it in the result vector.
-    while (query.next()) {
-        if (!queryToKeyEntry(query, entry)) {
+    // Iterate each row, convert it to a KeyEntry, and hand it to the visitor.
+    while (mSelectAllQuery.next()) {
+        // Don't let anything from the last row (like an invalid reason) carry over.
+        entry.clear();
+
+        if (!queryToKeyEntry(mSelectAllQuery, entry)) {
             LOG_WARNING("Unable to convert a database result to a KeyEntry.");
             // Continue anyway.  We want to include invalid key entries in the
             // resulting data.
         }
 
-        // Add it to the result list.
-        result.push_back(entry);
+        if (!visitor(entry)) {
+            LOG_DEBUG("Stopped reading the key entries before the end of the database.");
+            break;
+        }
     }
 
+    mSelectAllQuery.finish();
+
     return true;
 }
 
@@ -265,16 +591,25 @@ bool SecretDatabase::getAll(std::vector<KeyEntry> &result)
  */
 bool SecretDatabase::deleteByIdentifier(const QString &identifier)
 {
-    KeyEntry testEntry;
-    QSqlQuery query;
+    int rowsAffected;
+
+    if (!prepareStatements()) {
+        // Already logged an error.
+        return false;
+    }
+
+    mDeleteQuery.bindValue(":identifier", identifier);
 
-    if (!query.exec("DELETE from secretData where identifier=\"" + identifier + "\"")) {
+    if (!mDeleteQuery.exec()) {
         LOG_ERROR("Failed to delete the key with identifier : " + identifier);
-        LOG_ERROR("     Detailed Error : " + query.lastError().text());
+        LOG_ERROR("     Detailed Error : " + mDeleteQuery.lastError().text());
         return false;
     }
 
-    if (query.numRowsAffected() == 0) {
+    rowsAffected = mDeleteQuery.numRowsAffected();
+    mDeleteQuery.finish();
+
+    if (rowsAffected == 0) {
         LOG_ERROR("No key entry named '" + identifier + "' was available to delete!");
         return false;
     }
@@ -358,26 +693,196 @@ SecretDatabase &SecretDatabase::operator=(const SecretDatabase &toCopy)
 }
 
 /**
- * @brief SecretDatabase::createBoundQuery - Update a QSqlQuery object using the provided
- *      query string, and bound with the values from the provided KeyEntry.
+ * @brief SecretDatabase::applyStorageOptions - Set the journal mode, sync level, cache size, and
+ *      memory map size on the open database.
+ *
+ * @return true if the options were applied.  false on error.
+ */
+bool SecretDatabase::applyStorageOptions()
+{
+    QSqlQuery query(mDatabase);
+    QString journalMode;
+
+    // SQLite returns the journal mode that is actually in use, since it won't switch to a
+    // write-ahead log on a file system that can't support one.
+    if ((!query.exec(mWriteAheadLog ? "PRAGMA journal_mode=WAL" : "PRAGMA journal_mode=DELETE")) || (!query.next())) {
+        LOG_ERROR("Unable to set the journal mode for the database!");
+        LOG_ERROR("     Detailed Error : " + query.lastError().text());
+        return false;
+    }
+
+    journalMode = query.value(0).toString();
+    query.finish();
+
+    mWriteAheadLogActive = (journalMode.compare("wal", Qt::CaseInsensitive) == 0);
+
+    if ((mWriteAheadLog) && (!mWriteAheadLogActive)) {
+        LOG_WARNING("Unable to use a write-ahead log for the database.  Using the '" + journalMode + "' journal instead.");
+    }
+
+    // With a write-ahead log, a commit only has to be appended to the log, and the log is synced
+    // at each checkpoint.  A power loss can lose the last few commits, but can't corrupt the
+    // database.  The rollback journal needs a full sync to be safe.
+    if (!execPragma(mWriteAheadLogActive ? "PRAGMA synchronous=NORMAL" : "PRAGMA synchronous=FULL")) {
+        return false;
+    }
+
+    // A negative cache size is in KiB, rather than in pages.
+    if (!execPragma("PRAGMA cache_size=-" + QString::number(mCacheSizeKb))) {
+        return false;
+    }
+
+    if (!execPragma("PRAGMA mmap_size=" + QString::number(static_cast<qulonglong>(mMmapSizeKb) * 1024))) {
+        return false;
+    }
+
+    LOG_DEBUG("Database journal mode is '" + journalMode + "', with a " + QString::number(mCacheSizeKb) + " KiB cache and a " + QString::number(mMmapSizeKb) + " KiB memory map.");
+
+    return true;
+}
+
+/**
+ * @brief SecretDatabase::execPragma - Run a PRAGMA statement that we don't need the result from.
  *
- * @param query - The SQL query to execute using the data in the 'toBind' variable.
- * @param toBind - A KeyEntry that contains the data we want to bind using the
- *      query defined in 'query'.
- * @param sqlQuery[OUT] - If this method returns true, this variable will be updated with
- *      the query and binding data provided.
+ * @param pragma - The PRAGMA statement to run.
  *
- * @return true if the QSqlQuery was updated with the query and binding data.  false on
- *      error.
+ * @return true if the statement was run.  false on error.
  */
-bool SecretDatabase::createBoundQuery(const QString &query, const KeyEntry &toBind, QSqlQuery &sqlQuery)
+bool SecretDatabase::execPragma(const QString &pragma)
 {
+    QSqlQuery query(mDatabase);
+
+    if (!query.exec(pragma)) {
+        LOG_ERROR("Unable to run '" + pragma + "' on the database!");
+        LOG_ERROR("     Detailed Error : " + query.lastError().text());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief SecretDatabase::prepareStatements - Prepare the statements used to read and write
+ *      the key entries, if they haven't already been prepared for the open database.
+ *
+ * @return true if the statements are ready to be used.  false on error.
+ */
+bool SecretDatabase::prepareStatements()
+{
+    if (mStatementsPrepared) {
+        // Nothing to do.
+        return true;
+    }
+
+    if (!isOpen()) {
+        LOG_ERROR("The database isn't open while attempting to prepare the SQL statements!");
+        return false;
+    }
+
+    if ((!prepareStatement(mSelectByIdentifierQuery, "SELECT * from secretData where identifier=:identifier")) ||
+            (!prepareStatement(mSelectAllQuery, "SELECT * from secretData")) ||
+            (!prepareStatement(mInsertQuery, "INSERT into secretData (identifier, secret, keyType, otpType, outNumberCount, timeStep, timeOffset, algorithm, hotpCounter, issuer) VALUES (:identifier, :secret, :keyType, :otpType, :outNumberCount, :timeStep, :timeOffset, :algorithm, :hotpCounter, :issuer)")) ||
+            (!prepareStatement(mUpdateQuery, "UPDATE secretData set identifier=:identifier, secret=:secret, keyType=:keyType, otpType=:otpType, outNumberCount=:outNumberCount, timeStep=:timeStep, timeOffset=:timeOffset, algorithm=:algorithm, hotpCounter=:hotpCounter, issuer=:issuer where identifier=:currentIdentifier")) ||
+            (!prepareStatement(mUpdateIfQuery, "UPDATE secretData set identifier=:identifier, secret=:secret, keyType=:keyType, otpType=:otpType, outNumberCount=:outNumberCount, timeStep=:timeStep, timeOffset=:timeOffset, algorithm=:algorithm, hotpCounter=:hotpCounter, issuer=:issuer where identifier=:currentIdentifier and hotpCounter=:expectedHotpCounter")) ||
+            (!prepareStatement(mDeleteQuery, "DELETE from secretData where identifier=:identifier"))) {
+        // Already logged an error.  Don't leave some of the statements half set up.
+        clearStatements();
+        return false;
+    }
+
+    mStatementsPrepared = true;
+
+    return true;
+}
+
+/**
+ * @brief SecretDatabase::prepareUpsertStatement - Prepare the statement used by upsert(), if it
+ *      hasn't already been prepared for the open database.  This is kept apart from the other
+ *      statements because it needs SQLite 3.24 or newer.  On an older SQLite only upsert() fails,
+ *      and the rest of the database keeps working.
+ *
+ * @return true if the statement is ready to be used.  false on error.
+ */
+bool SecretDatabase::prepareUpsertStatement()
+{
+    if (mUpsertPrepared) {
+        // Nothing to do.
+        return true;
+    }
+
+    if (!isOpen()) {
+        LOG_ERROR("The database isn't open while attempting to prepare the upsert statement!");
+        return false;
+    }
+
+    if (!prepareStatement(mUpsertQuery, "INSERT into secretData (identifier, secret, keyType, otpType, outNumberCount, timeStep, timeOffset, algorithm, hotpCounter, issuer) VALUES (:identifier, :secret, :keyType, :otpType, :outNumberCount, :timeStep, :timeOffset, :algorithm, :hotpCounter, :issuer) "
+                                        "ON CONFLICT(identifier) DO UPDATE set secret=excluded.secret, keyType=excluded.keyType, otpType=excluded.otpType, outNumberCount=excluded.outNumberCount, timeStep=excluded.timeStep, timeOffset=excluded.timeOffset, algorithm=excluded.algorithm, hotpCounter=excluded.hotpCounter, issuer=excluded.issuer")) {
+        // Already logged an error.
+        mUpsertQuery.clear();
+        return false;
+    }
+
+    mUpsertPrepared = true;
+
+    return true;
+}
+
+/**
+ * @brief SecretDatabase::prepareStatement - Prepare a single statement against the database
+ *      connection this object owns.
+ *
+ * @param sqlQuery[OUT] - If this method returns true, this variable will contain the prepared
+ *      statement.
+ * @param query - The SQL for the statement.
+ *
+ * @return true if the statement was prepared.  false on error.
+ */
+bool SecretDatabase::prepareStatement(QSqlQuery &sqlQuery, const QString &query)
+{
+    sqlQuery = QSqlQuery(mDatabase);
+
+    // None of our statements need to step backwards, so don't let Qt keep a copy of every row
+    // that has been read.
+    sqlQuery.setForwardOnly(true);
+
     if (!sqlQuery.prepare(query)) {
         LOG_ERROR("Unable to prepare the query : " + query);
         LOG_ERROR("     Detailed Error : " + sqlQuery.lastError().text());
         return false;
     }
 
+    return true;
+}
+
+/**
+ * @brief SecretDatabase::clearStatements - Release the prepared statements.  They will be
+ *      prepared again the next time they are needed.
+ */
+void SecretDatabase::clearStatements()
+{
+    mSelectByIdentifierQuery.clear();
+    mSelectAllQuery.clear();
+    mInsertQuery.clear();
+    mUpdateQuery.clear();
+    mUpdateIfQuery.clear();
+    mUpsertQuery.clear();
+    mDeleteQuery.clear();
+
+    mStatementsPrepared = false;
+    mUpsertPrepared = false;
+}
+
+/**
+ * @brief SecretDatabase::bindKeyEntry - Bind the values from the provided KeyEntry to a
+ *      prepared statement.
+ *
+ * @param toBind - A KeyEntry that contains the data we want to bind to the statement.
+ * @param sqlQuery[OUT] - The prepared statement to bind the values to.
+ *
+ * @return true if the values were bound.  false on error.
+ */
+bool SecretDatabase::bindKeyEntry(const KeyEntry &toBind, QSqlQuery &sqlQuery)
+{
     // Bind the values provided.
     sqlQuery.bindValue(":identifier", toBind.identifier());
     sqlQuery.bindValue(":secret", QString::fromStdString(toBind.secret().toString()));
@@ -393,6 +898,28 @@ bool SecretDatabase::createBoundQuery(const QString &query, const KeyEntry &toBi
     return true;
 }
 
+/**
+ * @brief SecretDatabase::isConstraintError - Check to see if an error from a statement was
+ *      caused by a constraint violation, such as adding an identifier that already exists.
+ *
+ * @param error - The error returned by the statement.
+ *
+ * @return true if the error was a constraint violation.  false if it was anything else.
+ */
+bool SecretDatabase::isConstraintError(const QSqlError &error)
+{
+    bool ok;
+    int code;
+
+    code = error.nativeErrorCode().toInt(&ok);
+    if (!ok) {
+        return false;
+    }
+
+    // Extended result codes keep the primary result code in the low byte.
+    return ((code & 0xff) == SECRETDATABASE_SQLITE_CONSTRAINT);
+}
+
 /**
  * @brief SecretDatabase::queryToKeyEntry - Read the KeyEntry values from the provided
  *      QSqlQuery object, and store them in to a KeyEntry object.
@@ -613,5 +1140,14 @@ bool SecretDatabase::upgradeToVersion1()
  */
 void SecretDatabase::copy(const SecretDatabase &toCopy)
 {
+    // The prepared statements belong to the object that prepared them, so this one will
+    // prepare its own when it needs them.
+    clearStatements();
+
     mDatabase = toCopy.mDatabase;
+
+    mWriteAheadLog = toCopy.mWriteAheadLog;
+    mCacheSizeKb = toCopy.mCacheSizeKb;
+    mMmapSizeKb = toCopy.mMmapSizeKb;
+    mWriteAheadLogActive = toCopy.mWriteAheadLogActive;
 }
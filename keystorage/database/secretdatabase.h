@@ -4,10 +4,17 @@
 #include <QString>
 #include <QSqlDatabase>
 #include <QSqlQuery>
+#include <QSqlError>
 #include <vector>
+#include <functional>
 
 #include "../keyentry.h"
 
+// The storage options used until setStorageOptions() is called.
+const bool SECRETDATABASE_DEFAULT_WRITE_AHEAD_LOG=true;            // Use a write-ahead log, rather than a rollback journal.
+const unsigned int SECRETDATABASE_DEFAULT_CACHE_SIZE_KB=2048;      // The same as the SQLite default.
+const unsigned int SECRETDATABASE_DEFAULT_MMAP_SIZE_KB=4096;       // Plenty for any reasonable number of keys.
+
 class SecretDatabase
 {
 public:
@@ -19,13 +26,21 @@ public:
     bool close();
     bool isOpen();
 
+    bool setStorageOptions(bool writeAheadLog, unsigned int cacheSizeKb, unsigned int mmapSizeKb);
+    bool writeAheadLogActive();
+    bool checkpoint(bool truncate = false);
+
     bool add(const KeyEntry &entry);
+    bool addMany(const std::vector<KeyEntry> &entries, std::vector<size_t> &failed);
 
     bool update(const KeyEntry &currentEntry, const KeyEntry &newEntry);
+    bool updateIf(const KeyEntry &currentEntry, const KeyEntry &newEntry, unsigned int expectedHotpCounter);
+    bool upsert(const KeyEntry &entry);
 
     bool getByIdentifier(const QString &identifier, KeyEntry &result);
 
     bool getAll(std::vector<KeyEntry> &result);
+    bool forEach(const std::function<bool(const KeyEntry &entry)> &visitor);
 
     bool deleteByIdentifier(const QString &identifier);
 
@@ -34,7 +49,16 @@ public:
     SecretDatabase& operator=(const SecretDatabase& toCopy);
 
 private:
-    bool createBoundQuery(const QString &query, const KeyEntry &toBind, QSqlQuery &sqlQuery);
+    bool applyStorageOptions();
+    bool execPragma(const QString &pragma);
+
+    bool prepareStatements();
+    bool prepareUpsertStatement();
+    bool prepareStatement(QSqlQuery &sqlQuery, const QString &query);
+    void clearStatements();
+
+    bool bindKeyEntry(const KeyEntry &toBind, QSqlQuery &sqlQuery);
+    bool isConstraintError(const QSqlError &error);
     bool queryToKeyEntry(const QSqlQuery &query, KeyEntry &result);
     bool queryEntryToString(const QSqlQuery &query, const QString &column, QString &result);
     bool queryEntryToInt(const QSqlQuery &query, const QString &column, int &result);
@@ -48,6 +72,23 @@ private:
     void copy(const SecretDatabase &toCopy);
 
     QSqlDatabase mDatabase;
+
+    // Statements that are prepared once, the first time they are needed after the database
+    // is opened, and then reused with new bound values on every call.
+    QSqlQuery mSelectByIdentifierQuery;
+    QSqlQuery mSelectAllQuery;
+    QSqlQuery mInsertQuery;
+    QSqlQuery mUpdateQuery;
+    QSqlQuery mUpdateIfQuery;
+    QSqlQuery mUpsertQuery;
+    QSqlQuery mDeleteQuery;
+    bool mStatementsPrepared;
+    bool mUpsertPrepared;                   // Prepared separately.  See prepareUpsertStatement().
+
+    bool mWriteAheadLog;
+    unsigned int mCacheSizeKb;
+    unsigned int mMmapSizeKb;
+    bool mWriteAheadLogActive;
 };
 
 #endif // SECRETDATABASE_H
@@ -6,12 +6,23 @@
 KeyEntry::KeyEntry() :
     QObject(nullptr)
 {
+    // Keep the secrets in the secure arena.
+    mSecret.setZeroOnFree(true);
+    mDecodedSecret.setZeroOnFree(true);
+
     clear();
 }
 
 KeyEntry::KeyEntry(const KeyEntry &toCopy) :
     QObject(nullptr)
 {
+    // Keep the secrets in the secure arena.
+    mSecret.setZeroOnFree(true);
+    mDecodedSecret.setZeroOnFree(true);
+
+    // The setters compare against the current values, so they need to be set to something first.
+    clear();
+
     copyFromObject(toCopy);
 }
 
@@ -25,6 +36,7 @@ void KeyEntry::clear()
     // Set default values.
     mIdentifier.clear();
     mSecret.clear();
+    clearCachedSecrets();
     mKeyType = 0;
     mOtpType = 0;
     mOutNumberCount = 0;
@@ -38,6 +50,7 @@ void KeyEntry::clear()
     mPrintableCurrentCode.clear();
     mStartTime = 0;
     mCodeValid = false;
+    mCodeCounter = 0;
 }
 
 /**
@@ -100,6 +113,11 @@ const ByteArray &KeyEntry::secret() const
 
 void KeyEntry::setSecret(const ByteArray &newvalue)
 {
+    if (mSecret != newvalue) {
+        // The cached values were calculated from the old secret.
+        clearCachedSecrets();
+    }
+
     mSecret = newvalue;
     emit secretChanged();
 }
@@ -112,9 +130,36 @@ const ByteArray &KeyEntry::decodedSecret() const
 void KeyEntry::setDecodedSecret(const ByteArray &newvalue)
 {
     mDecodedSecret = newvalue;
+
+    // The HMAC key (and look-ahead code) were calculated from the old decoded secret.
+    mHmacKey.clear();
+    clearNextCode();
+
     emit decodedSecretChanged();
 }
 
+/**
+ * @brief KeyEntry::hmacKey - Return the cached HMAC pad states for the decoded secret.
+ *
+ * @return HmacKey reference.  If the pad states haven't been calculated yet, the HmacKey
+ *      won't be valid.
+ */
+const HmacKey &KeyEntry::hmacKey() const
+{
+    return mHmacKey;
+}
+
+/**
+ * @brief KeyEntry::setHmacKey - Cache the HMAC pad states calculated from the decoded secret
+ *      so they don't need to be calculated for every OTP.
+ *
+ * @param newvalue - The HmacKey to cache.
+ */
+void KeyEntry::setHmacKey(const HmacKey &newvalue)
+{
+    mHmacKey = newvalue;
+}
+
 unsigned int KeyEntry::keyType() const
 {
     return mKeyType;
@@ -127,6 +172,11 @@ void KeyEntry::keyType(unsigned int &value)
 
 void KeyEntry::setKeyType(unsigned int newvalue)
 {
+    if (mKeyType != newvalue) {
+        // The secret will need to be decoded differently.
+        clearCachedSecrets();
+    }
+
     mKeyType = newvalue;
     emit keyTypeChanged();
 }
@@ -143,6 +193,10 @@ void KeyEntry::otpType(unsigned int &value)
 
 void KeyEntry::setOtpType(unsigned int newvalue)
 {
+    if (mOtpType != newvalue) {
+        clearNextCode();
+    }
+
     mOtpType = newvalue;
     emit otpTypeChanged();
 }
@@ -159,6 +213,10 @@ void KeyEntry::outNumberCount(unsigned int &value)
 
 void KeyEntry::setOutNumberCount(unsigned int newvalue)
 {
+    if (mOutNumberCount != newvalue) {
+        clearNextCode();
+    }
+
     mOutNumberCount = newvalue;
     emit outNumberCountChanged();
 }
@@ -175,6 +233,11 @@ void KeyEntry::timeStep(unsigned int &value)
 
 void KeyEntry::setTimeStep(unsigned int newvalue)
 {
+    if (mTimeStep != newvalue) {
+        // The look-ahead code is for a period that no longer exists.
+        clearNextCode();
+    }
+
     mTimeStep = newvalue;
     emit timeStepChanged();
 }
@@ -202,6 +265,12 @@ unsigned int KeyEntry::algorithm() const
 
 void KeyEntry::setAlgorithm(unsigned int newvalue)
 {
+    if (mAlgorithm != newvalue) {
+        // The pad states are specific to the hash algorithm.
+        mHmacKey.clear();
+        clearNextCode();
+    }
+
     mAlgorithm = newvalue;
     emit algorithmChanged();
 }
@@ -322,6 +391,89 @@ void KeyEntry::setCodeValid(bool newvalue)
     emit codeValidChanged();
 }
 
+/**
+ * @brief KeyEntry::codeCounter - Get the counter (time step for TOTP) that the current code was
+ *      calculated from.
+ *
+ * @return uint64_t containing the counter.
+ */
+uint64_t KeyEntry::codeCounter() const
+{
+    return mCodeCounter;
+}
+
+void KeyEntry::setCodeCounter(uint64_t newvalue)
+{
+    mCodeCounter = newvalue;
+}
+
+/**
+ * @brief KeyEntry::nextCode - Get the code that was calculated ahead of time for the next time
+ *      period.
+ *
+ * @return QString containing the code.  If nextCodeValid() is false, the value is meaningless.
+ */
+QString KeyEntry::nextCode() const
+{
+    return mNextCode;
+}
+
+uint64_t KeyEntry::nextCodeCounter() const
+{
+    return mNextCodeCounter;
+}
+
+bool KeyEntry::nextCodeValid() const
+{
+    return mNextCodeValid;
+}
+
+/**
+ * @brief KeyEntry::setNextCode - Store the code for the next time period, so that it can be
+ *      swapped in when the period rolls over, without calculating anything.
+ *
+ * @param newvalue - The code for the next period.
+ * @param counter - The counter the code was calculated from.
+ */
+void KeyEntry::setNextCode(const QString &newvalue, uint64_t counter)
+{
+    mNextCode = newvalue;
+    mNextCodeCounter = counter;
+    mNextCodeValid = true;
+}
+
+/**
+ * @brief KeyEntry::clearNextCode - Throw away the look-ahead code.
+ */
+void KeyEntry::clearNextCode()
+{
+    mNextCode.clear();
+    mNextCodeCounter = 0;
+    mNextCodeValid = false;
+}
+
+/**
+ * @brief KeyEntry::swapToNextCode - Make the look-ahead code the current code, if it was
+ *      calculated for the provided counter.
+ *
+ * @param counter - The counter for the period that is starting.
+ *
+ * @return true if the look-ahead code is now the current code.  false if there wasn't a
+ *      look-ahead code for that counter.  (In which case, nothing is changed.)
+ */
+bool KeyEntry::swapToNextCode(uint64_t counter)
+{
+    if ((!mNextCodeValid) || (mNextCodeCounter != counter)) {
+        return false;
+    }
+
+    setCurrentCode(mNextCode);
+    mCodeCounter = counter;
+    clearNextCode();
+
+    return true;
+}
+
 std::string KeyEntry::toString()
 {
     std::stringstream result;
@@ -367,6 +519,17 @@ std::string KeyEntry::boolToString(bool value)
     return "false";
 }
 
+/**
+ * @brief KeyEntry::clearCachedSecrets - Throw away the values that are calculated from the
+ *      secret, so that they will be calculated again the next time they are needed.
+ */
+void KeyEntry::clearCachedSecrets()
+{
+    mDecodedSecret.clear();
+    mHmacKey.clear();
+    clearNextCode();
+}
+
 /**
  * @brief KeyEntry::copyFromObject - Copy all of the values from the provided object in
  *      to the current one.
@@ -390,4 +553,11 @@ void KeyEntry::copyFromObject(const KeyEntry &toCopy)
     setPrintableCurrentCode(toCopy.printableCurrentCode());
     setStartTime(toCopy.startTime());
     setCodeValid(toCopy.codeValid());
+    setCodeCounter(toCopy.codeCounter());
+
+    if (toCopy.nextCodeValid()) {
+        setNextCode(toCopy.nextCode(), toCopy.nextCodeCounter());
+    } else {
+        clearNextCode();
+    }
 }
@@ -3,7 +3,9 @@
 
 #include <QObject>
 #include <QString>
+#include <cstdint>
 #include "container/bytearray.h"
+#include "otpimpl/hmackey.h"
 
 const unsigned int KEYENTRY_KEYTYPE_HEX=0;
 const unsigned int KEYENTRY_KEYTYPE_BASE32=1;
@@ -66,6 +68,9 @@ public:
     const ByteArray &decodedSecret() const;
     void setDecodedSecret(const ByteArray &newvalue);
 
+    const HmacKey &hmacKey() const;
+    void setHmacKey(const HmacKey &newvalue);
+
     unsigned int keyType() const;
     void keyType(unsigned int &value);
     void setKeyType(unsigned int newvalue);
@@ -112,6 +117,17 @@ public:
     bool codeValid() const;
     void setCodeValid(bool newvalue);
 
+    uint64_t codeCounter() const;
+    void setCodeCounter(uint64_t newvalue);
+
+    // Get/set the look-ahead code for the next time period.
+    QString nextCode() const;
+    uint64_t nextCodeCounter() const;
+    bool nextCodeValid() const;
+    void setNextCode(const QString &newvalue, uint64_t counter);
+    void clearNextCode();
+    bool swapToNextCode(uint64_t counter);
+
     // Utility calls.
     std::string toString();
 
@@ -140,11 +156,13 @@ signals:                    //NOSONAR
 
 private:
     std::string boolToString(bool value);
+    void clearCachedSecrets();
 
     bool mValid;
     QString mIdentifier;
     ByteArray mSecret;
     ByteArray mDecodedSecret;
+    HmacKey mHmacKey;                   // Cached HMAC pad states calculated from mDecodedSecret.
     unsigned int mKeyType;
     unsigned int mOtpType;
     unsigned int mOutNumberCount;
@@ -158,6 +176,10 @@ private:
     QString mPrintableCurrentCode;
     unsigned int mStartTime;
     bool mCodeValid;
+    uint64_t mCodeCounter;              // The counter mCurrentCode was calculated from.
+    QString mNextCode;                  // The code for the time period after mCurrentCode.
+    uint64_t mNextCodeCounter;
+    bool mNextCodeValid;
 };
 
 #endif // KEYENTRY_H
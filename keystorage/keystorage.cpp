@@ -1,5 +1,6 @@
 #include "keystorage.h"
 
+#include <algorithm>
 #include <logger.h>
 
 #include "database/databasekeystorage.h"
@@ -84,21 +85,42 @@ bool KeyStorage::keyByIdentifier(const QString &identifier, KeyEntry &result)
  */
 bool KeyStorage::getAllKeys(QList<KeyEntry> &result)
 {
-    std::vector<KeyEntry> readKeys;
-
     // Make sure the return vector is empty to start with.
     result.clear();
 
-    for (size_t i = 0; i < mKeyStorageDrivers.size(); i++) {
-        if (!mKeyStorageDrivers.at(i)->getAllKeys(readKeys)) {
+    return forEachKey([&result](const KeyEntry &entry) {
+        result.push_back(entry);
+        return true;
+    });
+}
+
+/**
+ * @brief KeyStorage::forEachKey - Hand each key entry stored in all storage methods to \c visitor,
+ *      as it is read.  The entries aren't collected anywhere first, so the visitor can put them
+ *      straight in to wherever they are going.
+ *
+ * @note The entries may include key entries that are marked as 'invalid'.  This is to allow the
+ *      UI to display as much information about the invalid keys as possible.
+ *
+ * @param visitor - Called with each KeyEntry.  The entry is only valid during the call.  Return
+ *      true to keep going, or false to stop.  (Which will also skip any remaining storage
+ *      methods.)
+ *
+ * @return true if all of the key entries were visited, or the visitor stopped early.  false if
+ *      the entries couldn't all be read.
+ */
+bool KeyStorage::forEachKey(const std::function<bool(const KeyEntry &entry)> &visitor)
+{
+    bool stopped = false;
+
+    for (size_t i = 0; (i < mKeyStorageDrivers.size()) && (!stopped); i++) {
+        if (!mKeyStorageDrivers.at(i)->forEachKey([&visitor, &stopped](const KeyEntry &entry) {
+                                                      stopped = (!visitor(entry));
+                                                      return (!stopped);
+                                                  })) {
             LOG_ERROR("Failed to read all keys from the key storage driver with an id of " + QString::number(mKeyStorageDrivers.at(i)->storageId()) + ".");
             return false;
         }
-
-        // Iterate the latest results, and add them to the result variable.
-        for (size_t x = 0; x < readKeys.size(); x++) {
-            result.push_back(readKeys.at(x));
-        }
     }
 
     return true;
@@ -115,6 +137,7 @@ bool KeyStorage::getAllKeys(QList<KeyEntry> &result)
  */
 bool KeyStorage::addKey(const KeyEntry &entry, int keyStorageMethod)
 {
+    std::shared_ptr<KeyStorageBase> driver;
     KeyEntry temp;
 
     if (!entry.valid()) {
@@ -122,27 +145,98 @@ bool KeyStorage::addKey(const KeyEntry &entry, int keyStorageMethod)
         return false;
     }
 
-    // See if the entry already exists somewhere.
-    if (keyByIdentifier(entry.identifier(), temp)) {
-        LOG_ERROR("Cannot add a key entry that already exists in a key provider!  Did you mean to update?");
+    driver = driverForMethod(keyStorageMethod);
+    if (nullptr == driver) {
+        // Already logged an error.
         return false;
     }
 
-    if (keyStorageMethod == KEYSTORAGE_METHOD_DEFAULT) {
-        // Just use the first one in the list.
-        return mKeyStorageDrivers.at(0)->addKey(entry);
+    // See if the entry already exists in one of the other key providers.  (The one we are adding
+    // to will refuse a duplicate by itself.)
+    for (size_t i = 0; i < mKeyStorageDrivers.size(); i++) {
+        if ((mKeyStorageDrivers.at(i) != driver) && (mKeyStorageDrivers.at(i)->keyByIdentifier(entry.identifier(), temp))) {
+            LOG_ERROR("Cannot add a key entry that already exists in a key provider!  Did you mean to update?");
+            return false;
+        }
     }
 
-    // Otherwise, search for the driver we want to use.
-    for (size_t i = 0; i < mKeyStorageDrivers.size(); i++) {
-        if (mKeyStorageDrivers.at(i)->storageId() == keyStorageMethod) {
-            // Found it.  Add it to this storage method.
-            return mKeyStorageDrivers.at(i)->addKey(entry);
+    return driver->addKey(entry);
+}
+
+/**
+ * @brief KeyStorage::addKeys - Add a set of new key entries to the named key storage method, in one
+ *      go.  If the key storage method is 0 then the key entries will be written to whichever key
+ *      storage method is the first in the list.  Entries that are invalid, or that already exist,
+ *      are skipped and reported in \c failed.  The rest are still added.
+ *
+ * @param entries - The KeyEntry objects to write to the specified key storage method.
+ * @param failed[OUT] - If this method returns true, this vector will contain the indexes (in to
+ *      \c entries, in ascending order) of the entries that weren't added.
+ * @param keyStorageMethod - One of the KEYSTORAGE_METHOD_* values in keystorage.h.
+ *
+ * @return true if the entries were processed, even if some of them weren't added.  false on error.
+ */
+bool KeyStorage::addKeys(const std::vector<KeyEntry> &entries, std::vector<size_t> &failed, int keyStorageMethod)
+{
+    std::shared_ptr<KeyStorageBase> driver;
+    std::vector<KeyEntry> toAdd;
+    std::vector<size_t> toAddIndexes;
+    std::vector<size_t> driverFailed;
+    KeyEntry temp;
+    bool exists;
+
+    failed.clear();
+
+    driver = driverForMethod(keyStorageMethod);
+    if (nullptr == driver) {
+        // Already logged an error.
+        return false;
+    }
+
+    toAdd.reserve(entries.size());
+    toAddIndexes.reserve(entries.size());
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!entries.at(i).valid()) {
+            LOG_ERROR("Refusing to add an invalid key entry to key storage.");
+            failed.push_back(i);
+            continue;
+        }
+
+        // The driver we are adding to will catch its own duplicates, so only the others need to be
+        // searched.
+        exists = false;
+        for (size_t d = 0; d < mKeyStorageDrivers.size(); d++) {
+            if ((mKeyStorageDrivers.at(d) != driver) && (mKeyStorageDrivers.at(d)->keyByIdentifier(entries.at(i).identifier(), temp))) {
+                exists = true;
+                break;
+            }
         }
+
+        if (exists) {
+            LOG_ERROR("Cannot add the key entry for '" + entries.at(i).identifier() + "', it already exists in another key provider!");
+            failed.push_back(i);
+            continue;
+        }
+
+        toAdd.push_back(entries.at(i));
+        toAddIndexes.push_back(i);
     }
 
-    LOG_ERROR("Unable to locate a key storage method for id " + QString::number(keyStorageMethod) + ".");
-    return false;
+    if (!driver->addKeys(toAdd, driverFailed)) {
+        LOG_ERROR("Failed to add the key entries to the key storage driver with an id of " + QString::number(driver->storageId()) + ".");
+        failed.clear();
+        return false;
+    }
+
+    // Convert the driver's failures back to indexes in to the entries we were given.
+    for (size_t i = 0; i < driverFailed.size(); i++) {
+        failed.push_back(toAddIndexes.at(driverFailed.at(i)));
+    }
+
+    std::sort(failed.begin(), failed.end());
+
+    return true;
 }
 
 /**
@@ -151,30 +245,85 @@ bool KeyStorage::addKey(const KeyEntry &entry, int keyStorageMethod)
  *
  * @param currentEntry - The entry that we want to update the data for.
  * @param newEntry - How the entry should look after it is updated.
+ * @param keyStorageMethod - One of the KEYSTORAGE_METHOD_* values in keystorage.h.
  *
- * @return true if the key entry was updated.  false on error.
+ * @return true if the key entry was updated.  false on error, or if there is no key storage
+ *      driver for \c keyStorageMethod.
  */
 bool KeyStorage::updateKey(const KeyEntry &currentEntry, const KeyEntry &newEntry, int keyStorageMethod)
 {
+    std::shared_ptr<KeyStorageBase> driver;
+
     if ((!currentEntry.valid()) || (!newEntry.valid())) {
         LOG_ERROR("Refusing to update in invalid key entry in the key storage!");
         return false;
     }
 
-    if (keyStorageMethod == KEYSTORAGE_METHOD_DEFAULT) {
-        // Just use the first one in the list.
-        return mKeyStorageDrivers.at(0)->updateKey(currentEntry, newEntry);
+    driver = driverForMethod(keyStorageMethod);
+    if (nullptr == driver) {
+        // Already logged an error.
+        return false;
     }
 
-    // Otherwise, search for the driver we want to use.
-    for (size_t i = 0; i < mKeyStorageDrivers.size(); i++) {
-        if (mKeyStorageDrivers.at(i)->storageId() == keyStorageMethod) {
-            // Found it.  Update it in this storage method.
-            return mKeyStorageDrivers.at(i)->updateKey(currentEntry, newEntry);
-        }
+    return driver->updateKey(currentEntry, newEntry);
+}
+
+/**
+ * @brief KeyStorage::updateKeyIf - Update a key entry in the named key storage method, but only if
+ *      the HOTP counter stored for it is still \c expectedHotpCounter.  This is used to change
+ *      the counter without losing an increment that something else made at the same time.
+ *
+ * @param currentEntry - The entry that we want to update the data for.
+ * @param newEntry - How the entry should look after it is updated.
+ * @param expectedHotpCounter - The HOTP counter the stored entry must have for it to be updated.
+ * @param keyStorageMethod - One of the KEYSTORAGE_METHOD_* values in keystorage.h.
+ *
+ * @return true if the key entry was updated.  false if the HOTP counter didn't match, or on
+ *      error.
+ */
+bool KeyStorage::updateKeyIf(const KeyEntry &currentEntry, const KeyEntry &newEntry, unsigned int expectedHotpCounter, int keyStorageMethod)
+{
+    std::shared_ptr<KeyStorageBase> driver;
+
+    if ((!currentEntry.valid()) || (!newEntry.valid())) {
+        LOG_ERROR("Refusing to update in invalid key entry in the key storage!");
+        return false;
     }
 
-    return true;
+    driver = driverForMethod(keyStorageMethod);
+    if (nullptr == driver) {
+        // Already logged an error.
+        return false;
+    }
+
+    return driver->updateKeyIf(currentEntry, newEntry, expectedHotpCounter);
+}
+
+/**
+ * @brief KeyStorage::upsertKey - Write a key entry to the named key storage method, replacing the
+ *      entry with the same identifier if there is one, or adding it if there isn't.
+ *
+ * @param entry - The KeyEntry object to write.
+ * @param keyStorageMethod - One of the KEYSTORAGE_METHOD_* values in keystorage.h.
+ *
+ * @return true if the key entry was written.  false on error.
+ */
+bool KeyStorage::upsertKey(const KeyEntry &entry, int keyStorageMethod)
+{
+    std::shared_ptr<KeyStorageBase> driver;
+
+    if (!entry.valid()) {
+        LOG_ERROR("Refusing to write an invalid key entry to key storage.");
+        return false;
+    }
+
+    driver = driverForMethod(keyStorageMethod);
+    if (nullptr == driver) {
+        // Already logged an error.
+        return false;
+    }
+
+    return driver->upsertKey(entry);
 }
 
 /**
@@ -199,6 +348,26 @@ bool KeyStorage::deleteKeyByIdentifier(const QString &identifier)
     return deleted;
 }
 
+/**
+ * @brief KeyStorage::checkpoint - Iterate through the key storage methods, and have them write
+ *      any changes they have buffered to their final location.
+ *
+ * @return true if all of the key storage methods were checkpointed.  false otherwise.
+ */
+bool KeyStorage::checkpoint()
+{
+    bool success = true;
+
+    for (size_t i = 0; i < mKeyStorageDrivers.size(); i++) {
+        if (!mKeyStorageDrivers.at(i)->checkpoint()) {
+            LOG_ERROR("Failed to checkpoint the key storage driver with an id of " + QString::number(mKeyStorageDrivers.at(i)->storageId()) + ".");
+            success = false;
+        }
+    }
+
+    return success;
+}
+
 /**
  * @brief KeyStorage::freeStorage - Iterate through the key storage methods and free
  *      any resources they may have used.
@@ -243,3 +412,28 @@ bool KeyStorage::findKeyByIdentifier(const QString &identifier, KeyEntry &result
     LOG_DEBUG("Unable to locate the key with identifier '" + identifier + "'.");
     return false;
 }
+
+/**
+ * @brief KeyStorage::driverForMethod - Find the key storage driver for a key storage method.
+ *
+ * @param keyStorageMethod - One of the KEYSTORAGE_METHOD_* values in keystorage.h.  If it is
+ *      KEYSTORAGE_METHOD_DEFAULT, the first driver in the list is returned.
+ *
+ * @return std::shared_ptr to the driver.  nullptr if there isn't a driver for the method.
+ */
+std::shared_ptr<KeyStorageBase> KeyStorage::driverForMethod(int keyStorageMethod)
+{
+    if (keyStorageMethod == KEYSTORAGE_METHOD_DEFAULT) {
+        // Just use the first one in the list.
+        return mKeyStorageDrivers.at(0);
+    }
+
+    for (size_t i = 0; i < mKeyStorageDrivers.size(); i++) {
+        if (mKeyStorageDrivers.at(i)->storageId() == keyStorageMethod) {
+            return mKeyStorageDrivers.at(i);
+        }
+    }
+
+    LOG_ERROR("Unable to locate a key storage method for id " + QString::number(keyStorageMethod) + ".");
+    return nullptr;
+}
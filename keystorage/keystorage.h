@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <memory>
+#include <functional>
 #include "keystoragebase.h"
 #include "keyentry.h"
 
@@ -19,13 +20,19 @@ public:
     bool initStorage();
     bool keyByIdentifier(const QString &identifier, KeyEntry &result);
     bool getAllKeys(QList<KeyEntry> &result);
+    bool forEachKey(const std::function<bool(const KeyEntry &entry)> &visitor);
     bool addKey(const KeyEntry &entry, int keyStorageMethod = KEYSTORAGE_METHOD_DEFAULT);
+    bool addKeys(const std::vector<KeyEntry> &entries, std::vector<size_t> &failed, int keyStorageMethod = KEYSTORAGE_METHOD_DEFAULT);
     bool updateKey(const KeyEntry &currentEntry, const KeyEntry &newEntry, int keyStorageMethod = KEYSTORAGE_METHOD_DEFAULT);
+    bool updateKeyIf(const KeyEntry &currentEntry, const KeyEntry &newEntry, unsigned int expectedHotpCounter, int keyStorageMethod = KEYSTORAGE_METHOD_DEFAULT);
+    bool upsertKey(const KeyEntry &entry, int keyStorageMethod = KEYSTORAGE_METHOD_DEFAULT);
     bool deleteKeyByIdentifier(const QString &identifier);
+    bool checkpoint();
     bool freeStorage();
 
 private:
     bool findKeyByIdentifier(const QString &identifier, KeyEntry &result, int &storageDriverId);
+    std::shared_ptr<KeyStorageBase> driverForMethod(int keyStorageMethod);
 
     std::vector<std::shared_ptr<KeyStorageBase> > mKeyStorageDrivers;
     bool mAvailable;
@@ -1,5 +1,119 @@
 #include "keystorage.h"
 
+#include <logger.h>
+
+/**
+ * @brief KeyStorageBase::forEachKey - Hand each key entry in the key storage to \c visitor.
+ *      Drivers that can read their entries one at a time should override this, so the whole
+ *      set doesn't need to be in memory at once.
+ *
+ * @param visitor - Called with each KeyEntry.  Return true to keep going, or false to stop.
+ *
+ * @return true if the entries were read (even if the visitor stopped early).  false on error.
+ */
+bool KeyStorageBase::forEachKey(const std::function<bool(const KeyEntry &entry)> &visitor)
+{
+    std::vector<KeyEntry> allKeys;
+
+    // By default, read them all, and then visit them.
+    if (!getAllKeys(allKeys)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < allKeys.size(); i++) {
+        if (!visitor(allKeys.at(i))) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief KeyStorageBase::addKeys - Add a set of new key entries to the key storage.  Drivers
+ *      that can write several entries more efficiently than one at a time should override this.
+ *
+ * @param entries - The key entries to add.
+ * @param failed[OUT] - If this method returns true, this vector will contain the indexes (in to
+ *      \c entries, in ascending order) of the entries that weren't added.
+ *
+ * @return true if the entries were processed, even if some of them weren't added.  false on error.
+ */
+bool KeyStorageBase::addKeys(const std::vector<KeyEntry> &entries, std::vector<size_t> &failed)
+{
+    failed.clear();
+
+    // By default, add them one at a time.
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!addKey(entries.at(i))) {
+            failed.push_back(i);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief KeyStorageBase::updateKeyIf - Update a key entry, but only if its HOTP counter in the
+ *      key storage is still the value we expect.  Drivers that can check and update in a single
+ *      step should override this, since this version can't stop something else from changing the
+ *      entry between the check and the update.
+ *
+ * @param currentEntry - The current entry that is in the key storage.
+ * @param newEntry - The entry that should replace the current entry.
+ * @param expectedHotpCounter - The HOTP counter the stored entry must have for it to be updated.
+ *
+ * @return true if the entry was updated.  false if it wasn't found, the HOTP counter didn't
+ *      match, or on error.
+ */
+bool KeyStorageBase::updateKeyIf(const KeyEntry &currentEntry, const KeyEntry &newEntry, unsigned int expectedHotpCounter)
+{
+    KeyEntry found;
+
+    if (!keyByIdentifier(currentEntry.identifier(), found)) {
+        return false;
+    }
+
+    if (found.hotpCounter() != expectedHotpCounter) {
+        LOG_WARNING("The HOTP counter for identifier '" + currentEntry.identifier() + "' isn't " + QString::number(expectedHotpCounter) + ".  It wasn't updated.");
+        return false;
+    }
+
+    return updateKey(currentEntry, newEntry);
+}
+
+/**
+ * @brief KeyStorageBase::upsertKey - Write a key entry to the key storage, replacing the entry
+ *      with the same identifier if there is one, or adding it if there isn't.  Drivers that can
+ *      do this in a single step should override this.
+ *
+ * @param entry - The key entry to write.
+ *
+ * @return true if the key entry was written.  false on error.
+ */
+bool KeyStorageBase::upsertKey(const KeyEntry &entry)
+{
+    KeyEntry found;
+
+    if (keyByIdentifier(entry.identifier(), found)) {
+        return updateKey(found, entry);
+    }
+
+    return addKey(entry);
+}
+
+/**
+ * @brief KeyStorageBase::checkpoint - Make sure any changes that have been buffered by the
+ *      key storage method are written to their final location.
+ *
+ * @return true if the changes were written, or there was nothing to write.  false otherwise.
+ */
+bool KeyStorageBase::checkpoint()
+{
+    // By default, do nothing.
+    return true;
+}
+
 /**
  * @brief KeyStorageBase::freeKeyStorage - Take whatever steps are necessary to free
  *      the key storage method that is in use.
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 #include "keyentry.h"
 
 /****
@@ -27,9 +28,14 @@ public:
     virtual bool initKeyStorage() = 0;
     virtual bool keyByIdentifier(const QString &identifier, KeyEntry &result) = 0;
     virtual bool getAllKeys(std::vector<KeyEntry> &result) = 0;
+    virtual bool forEachKey(const std::function<bool(const KeyEntry &entry)> &visitor);
     virtual bool addKey(const KeyEntry &entry) = 0;
+    virtual bool addKeys(const std::vector<KeyEntry> &entries, std::vector<size_t> &failed);
     virtual bool updateKey(const KeyEntry &currentEntry, const KeyEntry &newEntry) = 0;
+    virtual bool updateKeyIf(const KeyEntry &currentEntry, const KeyEntry &newEntry, unsigned int expectedHotpCounter);
+    virtual bool upsertKey(const KeyEntry &entry);
     virtual bool deleteKeyByIdentifier(const QString &identifier) = 0;
+    virtual bool checkpoint();
     virtual bool freeKeyStorage();
 };
 
@@ -0,0 +1,345 @@
+#include "otpbatchengine.h"
+
+#include "logger.h"
+#include "otphandler.h"
+
+// The number of supported hash algorithms, and digit counts (6, 7, or 8) that we group by.
+const size_t OTPBATCHENGINE_ALGORITHM_COUNT = 3;
+const size_t OTPBATCHENGINE_DIGIT_COUNTS = 3;
+
+// The most items that go in to a single chunk of work for the thread pool.  Big enough that the
+// multi-buffer HMAC code has full lanes, small enough that a vault gets spread over the threads.
+const size_t OTPBATCHENGINE_CHUNK_SIZE = 64;
+
+OtpBatchEngine::OtpBatchEngine()
+{
+    mItems.clear();
+    mGroups.resize(OTPBATCHENGINE_ALGORITHM_COUNT * OTPBATCHENGINE_DIGIT_COUNTS);
+}
+
+/**
+ * @brief OtpBatchEngine::calculate - Calculate the OTP codes for all of the provided entries,
+ *      and update the entries with the results.
+ *
+ * @param entries - The KeyEntry objects to calculate the codes for.
+ * @param now - The UTC time to use when calculating the TOTP codes.
+ *
+ * @return true if the codes were calculated.  (Entries whose codes couldn't be calculated will
+ *      be flagged as invalid.)  false on a horrible, unrecoverable error.
+ */
+bool OtpBatchEngine::calculate(const QList<KeyEntry *> &entries, time_t now)
+{
+    if (!prepareItems(entries, now, false)) {
+        LOG_ERROR("Unable to prepare the key entries for the batch OTP calculation!");
+        return false;
+    }
+
+    calculateGroups();
+    writeResults(false);
+
+    // Don't hold on to the pointers after we are done with them.
+    mItems.clear();
+
+    return true;
+}
+
+/**
+ * @brief OtpBatchEngine::calculateNext - Calculate the codes for the time period after the one
+ *      that \c now is in, and store them as the look-ahead code in each TOTP entry.  HOTP
+ *      entries are skipped, since their next code depends on the counter being incremented.
+ *
+ * @param entries - The KeyEntry objects to calculate the look-ahead codes for.
+ * @param now - The UTC time to use when calculating the TOTP codes.
+ *
+ * @return true if the codes were calculated.  (Entries whose codes couldn't be calculated won't
+ *      have a look-ahead code.)  false on a horrible, unrecoverable error.
+ */
+bool OtpBatchEngine::calculateNext(const QList<KeyEntry *> &entries, time_t now)
+{
+    if (!prepareItems(entries, now, true)) {
+        LOG_ERROR("Unable to prepare the key entries for the look-ahead OTP calculation!");
+        return false;
+    }
+
+    calculateGroups();
+    writeResults(true);
+
+    // Don't hold on to the pointers after we are done with them.
+    mItems.clear();
+
+    return true;
+}
+
+/**
+ * @brief OtpBatchEngine::rollover - Bring every TOTP entry up to date for the time period that
+ *      \c now is in, by swapping in the look-ahead codes.  No codes are calculated, so this is
+ *      only a couple of assignments per entry, rather than an HMAC and a database lookup.
+ *
+ * @param entries - The KeyEntry objects to update.
+ * @param now - The current UTC time.
+ *
+ * @return true if every valid TOTP entry is now showing the code for the current period.
+ *      false if at least one of them didn't have the right look-ahead code, and calculate()
+ *      needs to be called.
+ */
+bool OtpBatchEngine::rollover(const QList<KeyEntry *> &entries, time_t now)
+{
+    KeyEntry *entry;
+    uint64_t counter;
+    bool success = true;
+
+    for (int i = 0; i < entries.size(); i++) {
+        entry = entries.at(i);
+
+        // HOTP entries only change when the counter does, and invalid entries are recalculated
+        // when they are fixed.
+        if ((KEYENTRY_OTPTYPE_TOTP != entry->otpType()) || (!entry->valid()) || (0 == entry->timeStep())) {
+            continue;
+        }
+
+        counter = OtpCode::timeToCounter(now, entry->timeStep());
+
+        if ((!entry->codeValid()) || (entry->codeCounter() != counter)) {
+            if (!entry->swapToNextCode(counter)) {
+                success = false;
+                continue;
+            }
+
+            entry->setCodeValid(true);
+        }
+
+        entry->setStartTime(static_cast<unsigned int>(now % entry->timeStep()));
+    }
+
+    return success;
+}
+
+/**
+ * @brief OtpBatchEngine::setThreadCount - Set the number of threads used to calculate the codes.
+ *
+ * @param threads - The number of threads to use, including the calling thread.  0 uses one per
+ *      CPU core.
+ *
+ * @return true if the thread count was set.  false on error.
+ */
+bool OtpBatchEngine::setThreadCount(size_t threads)
+{
+    return mPool.setThreadCount(threads);
+}
+
+/**
+ * @brief OtpBatchEngine::threadCount - Get the number of threads used to calculate the codes.
+ *
+ * @return size_t containing the number of threads, including the calling thread.
+ */
+size_t OtpBatchEngine::threadCount()
+{
+    return mPool.threadCount();
+}
+
+/**
+ * @brief OtpBatchEngine::prepareItems - Make sure each entry has its HMAC key cached, work out
+ *      the counter to use for each entry, and sort the entries in to their groups.
+ *
+ * @param entries - The KeyEntry objects to calculate the codes for.
+ * @param now - The UTC time to use when calculating the TOTP counters.
+ * @param nextPeriod - true if the items are for the look-ahead codes.
+ *
+ * @return true if the items were prepared.  false on error.
+ */
+bool OtpBatchEngine::prepareItems(const QList<KeyEntry *> &entries, time_t now, bool nextPeriod)
+{
+    BatchItem item;
+    KeyEntry *entry;
+
+    mItems.clear();
+    mItems.reserve(static_cast<size_t>(entries.size()));
+
+    for (size_t i = 0; i < mGroups.size(); i++) {
+        mGroups.at(i).clear();
+    }
+
+    for (int i = 0; i < entries.size(); i++) {
+        entry = entries.at(i);
+
+        // There is no look-ahead code for HOTP entries.
+        if ((nextPeriod) && (KEYENTRY_OTPTYPE_TOTP != entry->otpType())) {
+            continue;
+        }
+
+        // Make sure the HMAC key is cached.  If it can't be, the entry has already been flagged as
+        // invalid, and we can skip it.
+        if (!OtpHandler::prepareKeyEntry(entry)) {
+            continue;
+        }
+
+        if (0 == entry->timeStep()) {
+            LOG_ERROR("The time step for identifier '" + entry->identifier() + "' is 0!");
+
+            entry->setInvalidReason("The time step can't be 0!");
+            entry->setCodeValid(false);
+            continue;
+        }
+
+        item.entry = entry;
+        item.digits = entry->outNumberCount();
+        item.startTime = static_cast<unsigned int>(now % entry->timeStep());
+        item.codeValid = false;
+        item.code[0] = 0x00;
+
+        if (KEYENTRY_OTPTYPE_TOTP == entry->otpType()) {
+            item.counter = OtpCode::timeToCounter(now, entry->timeStep());
+            if (nextPeriod) {
+                item.counter++;
+            }
+        } else if (KEYENTRY_OTPTYPE_HOTP == entry->otpType()) {
+            item.counter = entry->hotpCounter();
+        } else {
+            LOG_ERROR("Unknown OTP type of '" + QString::number(entry->otpType()) + "' for identifier : " + entry->identifier());
+
+            entry->setInvalidReason("Unable to calculate the OTP value for identifier : " + entry->identifier());
+            entry->setCodeValid(false);
+            continue;
+        }
+
+        mGroups.at(groupIndex(entry->hmacKey().algorithm(), item.digits)).push_back(mItems.size());
+        mItems.push_back(item);
+    }
+
+    return true;
+}
+
+/**
+ * @brief OtpBatchEngine::calculateGroups - Calculate the codes for each group of entries that
+ *      share a hash algorithm and digit count.  The groups are cut in to chunks that are handed
+ *      to OtpCode::hotpMany() on the thread pool, so the HMACs are calculated several at a time,
+ *      on several cores.
+ */
+void OtpBatchEngine::calculateGroups()
+{
+    BatchItem *item;
+    BatchChunk chunk;
+
+    mKeys.clear();
+    mCounters.clear();
+    mResults.clear();
+    mItemIndexes.clear();
+    mChunks.clear();
+
+    for (size_t g = 0; g < mGroups.size(); g++) {
+        const std::vector<size_t> &group = mGroups.at(g);
+
+        for (size_t i = 0; i < group.size(); i += OTPBATCHENGINE_CHUNK_SIZE) {
+            chunk.first = mKeys.size() + i;
+            chunk.count = ((group.size() - i) < OTPBATCHENGINE_CHUNK_SIZE) ? (group.size() - i) : OTPBATCHENGINE_CHUNK_SIZE;
+            chunk.digits = mItems[group[0]].digits;
+
+            mChunks.push_back(chunk);
+        }
+
+        for (size_t i = 0; i < group.size(); i++) {
+            item = &mItems[group[i]];
+
+            mKeys.push_back(&item->entry->hmacKey());
+            mCounters.push_back(item->counter);
+            mResults.push_back(item->code);
+            mItemIndexes.push_back(group[i]);
+        }
+    }
+
+    mValid.assign(mKeys.size(), 0);
+
+    if (!mPool.parallelFor(mChunks.size(), 1, [this](size_t begin, size_t end) {
+                               for (size_t c = begin; c < end; c++) {
+                                   calculateChunk(mChunks[c]);
+                               }
+                           })) {
+        LOG_ERROR("Unable to run the OTP calculations on the thread pool!  Calculating them on this thread.");
+
+        for (size_t c = 0; c < mChunks.size(); c++) {
+            calculateChunk(mChunks[c]);
+        }
+    }
+
+    for (size_t i = 0; i < mItemIndexes.size(); i++) {
+        mItems[mItemIndexes[i]].codeValid = (0 != mValid[i]);
+    }
+
+    // Don't hold on to the pointers after we are done with them.
+    mKeys.clear();
+    mResults.clear();
+}
+
+/**
+ * @brief OtpBatchEngine::calculateChunk - Calculate the codes for one chunk of a group.  This is
+ *      called from the pool threads, so it must only touch the chunk's own part of the scratch
+ *      space.  (The HMAC keys are only read.)
+ *
+ * @param chunk - The chunk to calculate.
+ */
+void OtpBatchEngine::calculateChunk(const BatchChunk &chunk)
+{
+    if (OtpCode::hotpMany(&mKeys[chunk.first], &mCounters[chunk.first], chunk.count, chunk.digits, &mResults[chunk.first])) {
+        for (size_t i = 0; i < chunk.count; i++) {
+            mValid[chunk.first + i] = 1;
+        }
+        return;
+    }
+
+    // Something in the chunk failed, so calculate them one at a time to find out which.
+    for (size_t i = 0; i < chunk.count; i++) {
+        mValid[chunk.first + i] = OtpCode::hotp(*mKeys[chunk.first + i], mCounters[chunk.first + i], chunk.digits, mResults[chunk.first + i]) ? 1 : 0;
+    }
+}
+
+/**
+ * @brief OtpBatchEngine::writeResults - Copy the calculated codes back in to the KeyEntry
+ *      objects.
+ *
+ * @param nextPeriod - true if the codes are the look-ahead codes.
+ */
+void OtpBatchEngine::writeResults(bool nextPeriod)
+{
+    for (size_t i = 0; i < mItems.size(); i++) {
+        BatchItem &item = mItems[i];
+
+        if (nextPeriod) {
+            // The current code is still good, so a failure here only means that the code will be
+            // calculated at the rollover instead.
+            if (item.codeValid) {
+                item.entry->setNextCode(QString::fromLatin1(item.code), item.counter);
+            } else {
+                item.entry->clearNextCode();
+            }
+            continue;
+        }
+
+        if (!item.codeValid) {
+            LOG_ERROR("Unable to calculate the OTP value for identifier : " + item.entry->identifier());
+
+            // Set the invalid reason, and flag the code as invalid.
+            item.entry->setInvalidReason("Unable to calculate the OTP value for identifier : " + item.entry->identifier());
+            item.entry->setCodeValid(false);
+            continue;
+        }
+
+        item.entry->setStartTime(item.startTime);
+        item.entry->setCodeValid(true);
+        item.entry->setCodeCounter(item.counter);
+        item.entry->setCurrentCode(QString::fromLatin1(item.code));
+    }
+}
+
+/**
+ * @brief OtpBatchEngine::groupIndex - Get the index of the group that entries with the provided
+ *      algorithm and digit count belong to.
+ *
+ * @param algorithm - One of the HMACKEY_ALG_* values.
+ * @param digits - The number of digits in the code.  (6, 7, or 8)
+ *
+ * @return size_t containing the index of the group.
+ */
+size_t OtpBatchEngine::groupIndex(unsigned int algorithm, size_t digits)
+{
+    return (algorithm * OTPBATCHENGINE_DIGIT_COUNTS) + (digits - 6);
+}
@@ -0,0 +1,80 @@
+#ifndef OTPBATCHENGINE_H
+#define OTPBATCHENGINE_H
+
+#include <QList>
+#include <ctime>
+#include <vector>
+
+#include "container/workstealingpool.h"
+#include "keystorage/keyentry.h"
+#include "otpimpl/otpcode.h"
+
+/**
+ * @brief The OtpBatchEngine class calculates the OTP codes for a whole list of KeyEntry objects
+ *      using a single timestamp.  The entries are grouped by hash algorithm and digit count so
+ *      that the codes are calculated in tight loops, and the results are written back to the
+ *      KeyEntry objects once all of the codes have been calculated.
+ *
+ *      calculateNext() fills in the look-ahead code for the following time period of each TOTP
+ *      entry, so that rollover() can switch to the new codes at the period boundary without
+ *      doing any hashing.
+ *
+ *      The groups are cut in to chunks that are calculated on a WorkStealingPool.  The worker
+ *      threads only ever touch the HMAC keys and the scratch buffers, so all of the KeyEntry
+ *      updates still happen on the calling (GUI) thread, in one pass at the end.
+ */
+class OtpBatchEngine
+{
+public:
+    OtpBatchEngine();
+
+    bool calculate(const QList<KeyEntry *> &entries, time_t now);
+    bool calculateNext(const QList<KeyEntry *> &entries, time_t now);
+    bool rollover(const QList<KeyEntry *> &entries, time_t now);
+
+    bool setThreadCount(size_t threads);
+    size_t threadCount();
+
+private:
+    // The data needed to calculate, and store, the code for a single KeyEntry.
+    struct BatchItem {
+        KeyEntry *entry;
+        uint64_t counter;
+        size_t digits;
+        unsigned int startTime;
+        bool codeValid;
+        char code[OTPCODE_BUFFER_SIZE];
+    };
+
+    // A run of items from the same group, that one thread calculates in one go.  The indexes are
+    // in to mKeys, mCounters, and mResults.
+    struct BatchChunk {
+        size_t first;
+        size_t count;
+        size_t digits;
+    };
+
+    bool prepareItems(const QList<KeyEntry *> &entries, time_t now, bool nextPeriod);
+    void calculateGroups();
+    void calculateChunk(const BatchChunk &chunk);
+    void writeResults(bool nextPeriod);
+
+    static size_t groupIndex(unsigned int algorithm, size_t digits);
+
+    std::vector<BatchItem> mItems;
+    std::vector<std::vector<size_t> > mGroups;
+
+    // Scratch space for handing the chunks to OtpCode::hotpMany().  The groups are laid out one
+    // after another, and mValid is indexed the same way.  (It is a char rather than a bool, since
+    // std::vector<bool> packs the bits, and the threads would trample each other's chunks.)
+    std::vector<const HmacKey *> mKeys;
+    std::vector<uint64_t> mCounters;
+    std::vector<char *> mResults;
+    std::vector<char> mValid;
+    std::vector<size_t> mItemIndexes;
+    std::vector<BatchChunk> mChunks;
+
+    WorkStealingPool mPool;
+};
+
+#endif // OTPBATCHENGINE_H
@@ -3,14 +3,81 @@
 #include "logger.h"
 #include "../otpimpl/base32coder.h"
 #include "../otpimpl/hexdecoder.h"
-#include "../otpimpl/totp.h"
-#include "../otpimpl/hotp.h"
-#include "../otpimpl/sha1hash.h"
-#include "../otpimpl/sha256hash.h"
-#include "../otpimpl/sha512hash.h"
+#include "../otpimpl/hotpt.h"
+#include "../otpimpl/otpcode.h"
 
 #include <QDateTime>
 
+/**
+ * @brief calculateForPolicy - Calculate an HOTP code with the compile time HMAC code for a
+ *      single hash, picking the digit count once.
+ *
+ * @param key - The cached HMAC key to use.
+ * @param counter - The counter value to calculate the code for.
+ * @param digits - The number of digits in the code.  (6, 7, or 8)
+ * @param result[OUT] - If this function returns true, the null terminated code.
+ *
+ * @return true if the code was calculated.  false on error.
+ */
+template <typename HashPolicy>
+static bool calculateForPolicy(const HmacKey &key, uint64_t counter, size_t digits, char result[OTPCODE_BUFFER_SIZE])
+{
+    switch (digits) {
+    case 6:
+        return HotpT<HashPolicy, 6>::calculate(key, counter, result);
+
+    case 7:
+        return HotpT<HashPolicy, 7>::calculate(key, counter, result);
+
+    case 8:
+        return HotpT<HashPolicy, 8>::calculate(key, counter, result);
+
+    default:
+        LOG_ERROR("An invalid number of digits was requested!  It must be 6, 7, or 8!");
+        return false;
+    }
+}
+
+/**
+ * @brief calculateForKey - Calculate an HOTP code, picking the hash once, and then using the
+ *      compile time HMAC code for it.
+ *
+ * @param key - The cached HMAC key to use.
+ * @param counter - The counter value to calculate the code for.
+ * @param digits - The number of digits in the code.  (6, 7, or 8)
+ *
+ * @return QString containing the code.  On error, an empty string will be returned.
+ */
+static QString calculateForKey(const HmacKey &key, uint64_t counter, size_t digits)
+{
+    char code[OTPCODE_BUFFER_SIZE];
+    bool calculated;
+
+    switch (key.algorithm()) {
+    case HMACKEY_ALG_SHA1:
+        calculated = calculateForPolicy<Sha1Policy>(key, counter, digits, code);
+        break;
+
+    case HMACKEY_ALG_SHA256:
+        calculated = calculateForPolicy<Sha256Policy>(key, counter, digits, code);
+        break;
+
+    case HMACKEY_ALG_SHA512:
+        calculated = calculateForPolicy<Sha512Policy>(key, counter, digits, code);
+        break;
+
+    default:
+        LOG_ERROR("Unknown hash algorithm identifier of " + QString::number(key.algorithm()) + " while calculating an OTP!");
+        return "";
+    }
+
+    if (!calculated) {
+        LOG_ERROR("Unable to calculate the OTP!");
+        return "";
+    }
+
+    return QString::fromLatin1(code);
+}
 
 OtpHandler::OtpHandler()
 {
@@ -23,14 +90,52 @@ OtpHandler::OtpHandler()
  */
 void OtpHandler::calculateOtpForKeyEntry(KeyEntry *keydata)
 {
-    ByteArray dSecret;
     QString calculatedCode;
 
+    if (!prepareKeyEntry(keydata)) {
+        // Already logged, and flagged the key entry as needed.
+        return;
+    }
+
+    // Calculate the OTP code.
+    calculatedCode = calculateCode((*keydata));
+
+    if (calculatedCode.isEmpty()) {
+        LOG_ERROR("Unable to calculate the OTP value for identifier : " + keydata->identifier());
+
+        // Set the invalid reason, and flag the code as invalid.
+        keydata->setInvalidReason("Unable to calculate the OTP value for identifier : " + keydata->identifier());
+        keydata->setCodeValid(false);
+        return;
+    }
+
+    // Calculate the number of seconds in to the lifetime of the OTP that we are.
+    keydata->setStartTime(getStartTime(keydata->timeStep()));
+    LOG_DEBUG("New start time for '" + keydata->identifier() + "' is : " + QString::number(keydata->startTime()));
+
+    // The code should be valid.
+    keydata->setCodeValid(true);
+    keydata->setCurrentCode(calculatedCode);
+}
+
+/**
+ * @brief OtpHandler::prepareKeyEntry - Make sure the key entry is valid, and that the decoded
+ *      secret and HMAC pad states are cached in it, so that an OTP can be calculated.
+ *
+ * @param keydata - A pointer to the KeyEntry object to prepare.
+ *
+ * @return true if the key entry is ready to have an OTP calculated.  false on error, in which
+ *      case the invalid reason will be set on the key entry, and the code flagged as invalid.
+ */
+bool OtpHandler::prepareKeyEntry(KeyEntry *keydata)
+{
+    ByteArray dSecret(true);
+
     if (keydata == nullptr) {
         LOG_ERROR("No key data provided while attempting to calculate an OTP!");
 
         // Nothing we can do.
-        return;
+        return false;
     }
 
     // Make sure the key entry provided is valid.
@@ -41,7 +146,7 @@ void OtpHandler::calculateOtpForKeyEntry(KeyEntry *keydata)
         // Set the invalid reason, and flag the code as invalid.
         keydata->setInvalidReason("The key data provided to calculate the OTP from was invalid!");
         keydata->setCodeValid(false);
-        return;
+        return false;
     }
 
     // If we don't have a decoded secret already cached, decoded it.
@@ -52,34 +157,33 @@ void OtpHandler::calculateOtpForKeyEntry(KeyEntry *keydata)
             // Set the invalid reason, and flag the code as invalid.
             keydata->setInvalidReason("Unable to decode the key secret value!");
             keydata->setCodeValid(false);
-            return;
+            return false;
         }
 
         // Cache the decoded secret.
         keydata->setDecodedSecret(dSecret);
+        dSecret.clear();
     }
 
-    // Calculate the OTP code.
-    calculatedCode = calculateCode((*keydata));
+    // If we don't have the HMAC pad states cached, calculate them.
+    if (!keydata->hmacKey().valid()) {
+        unsigned int hmacAlgorithm;
+        HmacKey hmacKey;
 
-    dSecret.clear();
+        if ((!hmacAlgorithmForKeyData((*keydata), hmacAlgorithm)) || (!hmacKey.setKey(hmacAlgorithm, keydata->decodedSecret()))) {
+            LOG_ERROR("Unable to calculate the HMAC key for identifier : " + keydata->identifier());
 
-    if (calculatedCode.isEmpty()) {
-        LOG_ERROR("Unable to calculate the OTP value for identifier : " + keydata->identifier());
+            // Set the invalid reason, and flag the code as invalid.
+            keydata->setInvalidReason("Unable to calculate the HMAC key!");
+            keydata->setCodeValid(false);
+            return false;
+        }
 
-        // Set the invalid reason, and flag the code as invalid.
-        keydata->setInvalidReason("Unable to calculate the OTP value for identifier : " + keydata->identifier());
-        keydata->setCodeValid(false);
-        return;
+        // Cache the pad states.
+        keydata->setHmacKey(hmacKey);
     }
 
-    // Calculate the number of seconds in to the lifetime of the OTP that we are.
-    keydata->setStartTime(getStartTime(keydata->timeStep()));
-    LOG_DEBUG("New start time for '" + keydata->identifier() + "' is : " + QString::number(keydata->startTime()));
-
-    // The code should be valid.
-    keydata->setCodeValid(true);
-    keydata->setCurrentCode(calculatedCode);
+    return true;
 }
 
 /**
@@ -179,27 +283,17 @@ QString OtpHandler::calculateCode(const KeyEntry &keydata)
 QString OtpHandler::calculateTotp(const KeyEntry &keydata)
 {
     time_t now;
-    std::string otp;
-    Totp totp;
-    std::shared_ptr<Hmac> hmac;
 
-    hmac = getHmacForKeyData(keydata);
-    if (nullptr == hmac) {
-        // Couldn't get a valid HMAC object.
+    if (0 == keydata.timeStep()) {
+        LOG_ERROR("Unable to calculate the TOTP!  The time step can't be 0!");
         return "";
     }
 
-    // Then, set the HMAC object to use with the calculation.
-    totp.setHmac(hmac);
-
     // Get the current time, so we can calculate the OTP.
     now = time(nullptr);
 
-    // Calculate the TOTP with HMAC-SHA1
-    otp = totp.calculate(keydata.decodedSecret(), now, keydata.timeStep(), keydata.outNumberCount());
-
-    // Return the calculated value.
-    return QString::fromStdString(otp);
+    // Calculate the TOTP using the cached HMAC key.
+    return calculateForKey(keydata.hmacKey(), OtpCode::timeToCounter(now, keydata.timeStep()), keydata.outNumberCount());
 }
 
 /**
@@ -213,23 +307,8 @@ QString OtpHandler::calculateTotp(const KeyEntry &keydata)
  */
 QString OtpHandler::calculateHotp(const KeyEntry &keydata)
 {
-    std::string otp;
-    Hotp hotp;
-    std::shared_ptr<Hmac> hmac;
-
-    hmac = getHmacForKeyData(keydata);
-    if (nullptr == hmac) {
-        // Got an error getting the HMAC method.
-        return "";
-    }
-
-    // Then, set the HMAC object to use with the calculation.
-    hotp.setHmac(hmac);
-
-    // Calculate the HOTP value.
-    otp = hotp.calculate(keydata.decodedSecret(), keydata.hotpCounter(), keydata.outNumberCount());
-
-    return QString::fromStdString(otp);
+    // Calculate the HOTP value using the cached HMAC key.
+    return calculateForKey(keydata.hmacKey(), keydata.hotpCounter(), keydata.outNumberCount());
 }
 
 /**
@@ -247,37 +326,32 @@ unsigned int OtpHandler::getStartTime(unsigned int timeStep)
 }
 
 /**
- * @brief OtpHandler::getHmacForKeyData - Get an HMAC object for the algorithm specified in
- *      the KeyData object.
+ * @brief OtpHandler::hmacAlgorithmForKeyData - Get the HMACKEY_ALG_* value for the algorithm
+ *      specified in the KeyData object.
  *
- * @param keydata - The KeyData object to get the HMAC object for.
+ * @param keydata - The KeyData object to get the HMAC algorithm for.
+ * @param hmacAlgorithm[OUT] - If this method returns true, this will contain the HMACKEY_ALG_*
+ *      value to use.
  *
- * @return std::shared_ptr<Hmac> for the hash algorithm specified in the KeyData object.
+ * @return true if the algorithm is known.  false otherwise.
  */
-std::shared_ptr<Hmac> OtpHandler::getHmacForKeyData(const KeyEntry &keydata)
+bool OtpHandler::hmacAlgorithmForKeyData(const KeyEntry &keydata, unsigned int &hmacAlgorithm)
 {
-    std::shared_ptr<HashTypeBase> hashToUse;
-    std::shared_ptr<Hmac> hmac;
-
     // Figure out what type of hash we should be using.
     switch (keydata.algorithm()) {
     case KEYENTRY_ALG_SHA1:
-        hashToUse = std::shared_ptr<HashTypeBase>(new Sha1Hash());
+        hmacAlgorithm = HMACKEY_ALG_SHA1;
         break;
     case KEYENTRY_ALG_SHA256:
-        hashToUse = std::shared_ptr<HashTypeBase>(new Sha256Hash());
+        hmacAlgorithm = HMACKEY_ALG_SHA256;
         break;
     case KEYENTRY_ALG_SHA512:
-        hashToUse = std::shared_ptr<HashTypeBase>(new Sha512Hash());
+        hmacAlgorithm = HMACKEY_ALG_SHA512;
         break;
     default:
         LOG_ERROR("Unknown hash algorithm identifier of : " + QString::number(keydata.algorithm()));
-        return nullptr;
+        return false;
     }
 
-    hmac = std::shared_ptr<Hmac>(new Hmac());
-    // Set the hash in to our HMAC object, and transfer ownership to the HMAC object.
-    hmac->setHashType(hashToUse);
-
-    return hmac;
+    return true;
 }
@@ -3,8 +3,7 @@
 
 #include "keystorage/keyentry.h"
 #include "container/bytearray.h"
-#include "../otpimpl/hmac.h"
-#include <memory>
+#include "../otpimpl/hmackey.h"
 
 class OtpHandler
 {
@@ -12,6 +11,7 @@ public:
     OtpHandler();
 
     static void calculateOtpForKeyEntry(KeyEntry *keydata);
+    static bool prepareKeyEntry(KeyEntry *keydata);
 
 protected:
     static bool decodeSecret(const KeyEntry &keydata, ByteArray &decodedSecret);
@@ -25,7 +25,7 @@ protected:
     static unsigned int getStartTime(unsigned int timeStep);
 
 private:
-    static std::shared_ptr<Hmac> getHmacForKeyData(const KeyEntry &keydata);
+    static bool hmacAlgorithmForKeyData(const KeyEntry &keydata, unsigned int &hmacAlgorithm);
 };
 
 #endif // OTPHANDLER_H
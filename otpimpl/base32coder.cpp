@@ -4,8 +4,290 @@
 #include <stdint.h>
 #include <logger.h>
 
+// The SIMD decoders are only built for x86 with a compiler that understands the target
+// attribute, so that the rest of the program doesn't need to be built with -mavx2.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE32CODER_X86
+#include <immintrin.h>
+#endif
+
 const char base32chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
 
+// Flags in the decode table.  Anything with the high bit set can't be decoded.
+const unsigned char BASE32CODER_LOWER_CASE = 0x40;
+const unsigned char BASE32CODER_PAD = 0x80;
+const unsigned char BASE32CODER_INVALID = 0xff;
+
+// The number of 8 character blocks that are decoded (or encoded) in to the stack buffer before
+// it is appended to the result.
+const size_t BASE32CODER_CHUNK_BLOCKS = 64;
+
+// The SIMD decoders store a full register, which can run up to this far past the decoded data.
+const size_t BASE32CODER_SIMD_SLACK = 16;
+
+// The number of decoded bytes in a final block with 0 to 7 characters.  0 means that the
+// number of characters isn't valid.
+const size_t BASE32CODER_TAIL_BYTES[8] = { 0, 0, 1, 0, 2, 3, 0, 4 };
+
+// The number of characters needed to encode a final group of 0 to 4 bytes.
+const size_t BASE32CODER_TAIL_CHARS[5] = { 0, 2, 4, 5, 7 };
+
+// The 5 bit value for each character.  Lower case letters have BASE32CODER_LOWER_CASE set, '='
+// is BASE32CODER_PAD, and everything else is BASE32CODER_INVALID.
+const unsigned char BASE32CODER_DECODE_TABLE[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0xff, 0xff,
+    0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+    0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e,
+    0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+/**
+ * @brief decodeBlock - Decode a block of 8 characters in to 5 bytes.
+ *
+ * @param in - The 8 characters to decode.
+ * @param out[OUT] - The 5 decoded bytes.
+ *
+ * @return true if all of the characters were valid.  false otherwise.
+ */
+static inline bool decodeBlock(const unsigned char *in, unsigned char *out)
+{
+    uint64_t bits = 0;
+    unsigned char value;
+    unsigned char check = 0;
+
+    for (size_t i = 0; i < 8; i++) {
+        value = BASE32CODER_DECODE_TABLE[in[i]];
+        check |= value;
+
+        bits = (bits << 5) | (value & 0x1f);
+    }
+
+    if ((check & BASE32CODER_PAD) != 0) {
+        return false;
+    }
+
+    out[0] = static_cast<unsigned char>((bits >> 32) & 0xff);
+    out[1] = static_cast<unsigned char>((bits >> 24) & 0xff);
+    out[2] = static_cast<unsigned char>((bits >> 16) & 0xff);
+    out[3] = static_cast<unsigned char>((bits >> 8) & 0xff);
+    out[4] = static_cast<unsigned char>(bits & 0xff);
+
+    return true;
+}
+
+/**
+ * @brief decodeTail - Decode the characters of a final, short, block.
+ *
+ * @param in - The characters to decode.
+ * @param count - The number of characters.  (2, 4, 5, or 7)
+ * @param out[OUT] - The decoded bytes.  (BASE32CODER_TAIL_BYTES[count] of them.)
+ *
+ * @return true if the characters were decoded.  false if one of them was invalid, or the
+ *      count is wrong.
+ */
+static bool decodeTail(const unsigned char *in, size_t count, unsigned char *out)
+{
+    unsigned char block[8];
+    unsigned char decoded[5];
+
+    if ((count >= 8) || (0 == BASE32CODER_TAIL_BYTES[count])) {
+        return false;
+    }
+
+    // Fill the rest of the block with 'A' (a zero value), and decode it like a full block.
+    memset(&block, 'A', sizeof(block));
+    memcpy(&block, in, count);
+
+    if (!decodeBlock(block, decoded)) {
+        return false;
+    }
+
+    memcpy(out, &decoded, BASE32CODER_TAIL_BYTES[count]);
+
+    memset(&block, 0x00, sizeof(block));
+    memset(&decoded, 0x00, sizeof(decoded));
+
+    return true;
+}
+
+#ifdef BASE32CODER_X86
+
+/**
+ * @brief decodeSsse3 - Decode blocks 16 characters at a time.  The characters are range checked
+ *      and mapped to their 5 bit values with byte compares, packed together with multiply-adds,
+ *      and shuffled in to big endian byte order.
+ *
+ * @param in - The characters to decode.
+ * @param blocks - The number of 8 character blocks in \c in.
+ * @param out[OUT] - The decoded bytes.  There must be BASE32CODER_SIMD_SLACK bytes of extra
+ *      space after the decoded data.
+ *
+ * @return size_t containing the number of blocks decoded.  This stops short if an invalid
+ *      character is found, or there are fewer than two blocks left.
+ */
+__attribute__((target("ssse3")))
+static size_t decodeSsse3(const unsigned char *in, size_t blocks, unsigned char *out)
+{
+    const __m128i order = _mm_setr_epi8(4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1);
+    __m128i chars;
+    __m128i upper;
+    __m128i lower;
+    __m128i digit;
+    __m128i values;
+    size_t i;
+
+    for (i = 0; (i + 2) <= blocks; i += 2) {
+        chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&in[i * 8]));
+
+        // Bytes with the high bit set are negative, so they fail all of the range checks.
+        upper = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(0x40)), _mm_cmplt_epi8(chars, _mm_set1_epi8(0x5b)));
+        lower = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(0x60)), _mm_cmplt_epi8(chars, _mm_set1_epi8(0x7b)));
+        digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(0x31)), _mm_cmplt_epi8(chars, _mm_set1_epi8(0x38)));
+
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(upper, lower), digit)) != 0xffff) {
+            break;
+        }
+
+        values = _mm_or_si128(_mm_or_si128(_mm_and_si128(upper, _mm_sub_epi8(chars, _mm_set1_epi8('A'))),
+                                           _mm_and_si128(lower, _mm_sub_epi8(chars, _mm_set1_epi8('a')))),
+                              _mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('2' - 26))));
+
+        // 10 bits per 16 bit lane, then 20 bits per 32 bit lane, then 40 bits per 64 bit lane.
+        values = _mm_maddubs_epi16(values, _mm_set1_epi16(0x0120));
+        values = _mm_madd_epi16(values, _mm_set1_epi32(0x00010400));
+        values = _mm_or_si128(_mm_srli_epi64(_mm_slli_epi64(values, 32), 12), _mm_srli_epi64(values, 32));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&out[i * 5]), _mm_shuffle_epi8(values, order));
+    }
+
+    return i;
+}
+
+/**
+ * @brief decodeAvx2 - Decode blocks 32 characters at a time.  This works the same way as
+ *      decodeSsse3(), with each 128 bit half of the register decoding 16 characters.
+ *
+ * @param in - The characters to decode.
+ * @param blocks - The number of 8 character blocks in \c in.
+ * @param out[OUT] - The decoded bytes.  There must be BASE32CODER_SIMD_SLACK bytes of extra
+ *      space after the decoded data.
+ *
+ * @return size_t containing the number of blocks decoded.  This stops short if an invalid
+ *      character is found, or there are fewer than four blocks left.
+ */
+__attribute__((target("avx2")))
+static size_t decodeAvx2(const unsigned char *in, size_t blocks, unsigned char *out)
+{
+    const __m256i order = _mm256_setr_epi8(4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1,
+                                           4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1);
+    __m256i chars;
+    __m256i upper;
+    __m256i lower;
+    __m256i digit;
+    __m256i values;
+    size_t i;
+
+    for (i = 0; (i + 4) <= blocks; i += 4) {
+        chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&in[i * 8]));
+
+        // Bytes with the high bit set are negative, so they fail all of the range checks.
+        upper = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8(0x40)), _mm256_cmpgt_epi8(_mm256_set1_epi8(0x5b), chars));
+        lower = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8(0x60)), _mm256_cmpgt_epi8(_mm256_set1_epi8(0x7b), chars));
+        digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8(0x31)), _mm256_cmpgt_epi8(_mm256_set1_epi8(0x38), chars));
+
+        if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(upper, lower), digit)) != -1) {
+            break;
+        }
+
+        values = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(upper, _mm256_sub_epi8(chars, _mm256_set1_epi8('A'))),
+                                                 _mm256_and_si256(lower, _mm256_sub_epi8(chars, _mm256_set1_epi8('a')))),
+                                 _mm256_and_si256(digit, _mm256_sub_epi8(chars, _mm256_set1_epi8('2' - 26))));
+
+        // 10 bits per 16 bit lane, then 20 bits per 32 bit lane, then 40 bits per 64 bit lane.
+        values = _mm256_maddubs_epi16(values, _mm256_set1_epi16(0x0120));
+        values = _mm256_madd_epi16(values, _mm256_set1_epi32(0x00010400));
+        values = _mm256_or_si256(_mm256_srli_epi64(_mm256_slli_epi64(values, 32), 12), _mm256_srli_epi64(values, 32));
+        values = _mm256_shuffle_epi8(values, order);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&out[i * 5]), _mm256_castsi256_si128(values));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&out[(i * 5) + 10]), _mm256_extracti128_si256(values, 1));
+    }
+
+    return i;
+}
+
+#endif // BASE32CODER_X86
+
+/**
+ * @brief decodeBlocks - Decode a run of full 8 character blocks, using the requested backend for
+ *      as much of the run as it can handle, and the lookup table for the rest.
+ *
+ * @param backend - One of the BASE32CODER_BACKEND_* values.
+ * @param in - The characters to decode.
+ * @param blocks - The number of 8 character blocks in \c in.
+ * @param out[OUT] - The decoded bytes.  There must be BASE32CODER_SIMD_SLACK bytes of extra
+ *      space after the decoded data.
+ *
+ * @return true if all of the blocks were decoded.  false if there was an invalid character.
+ */
+static bool decodeBlocks(unsigned int backend, const unsigned char *in, size_t blocks, unsigned char *out)
+{
+    size_t done = 0;
+
+    switch (backend) {
+#ifdef BASE32CODER_X86
+    case BASE32CODER_BACKEND_AVX2:
+        done = decodeAvx2(in, blocks, out);
+        break;
+
+    case BASE32CODER_BACKEND_SSSE3:
+        done = decodeSsse3(in, blocks, out);
+        break;
+#endif // BASE32CODER_X86
+
+    default:
+        break;
+    }
+
+    // Whatever is left (or whatever the SIMD code stopped on) goes through the table.
+    for (size_t i = done; i < blocks; i++) {
+        if (!decodeBlock(&in[i * 8], &out[i * 5])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief encodeGroup - Encode 5 bytes in to 8 base32 characters.
+ *
+ * @param in - The 5 bytes to encode.
+ * @param out[OUT] - The 8 encoded characters.
+ */
+static inline void encodeGroup(const unsigned char *in, char *out)
+{
+    uint64_t bits;
+
+    bits = (static_cast<uint64_t>(in[0]) << 32) | (static_cast<uint64_t>(in[1]) << 24) | (static_cast<uint64_t>(in[2]) << 16) |
+            (static_cast<uint64_t>(in[3]) << 8) | static_cast<uint64_t>(in[4]);
+
+    for (size_t i = 0; i < 8; i++) {
+        out[i] = base32chars[(bits >> (35 - (i * 5))) & 0x1f];
+    }
+}
 
 Base32Coder::Base32Coder()
 {
@@ -23,77 +305,158 @@ Base32Coder::Base32Coder()
 ByteArray Base32Coder::encode(const ByteArray &toEncode)
 {
     ByteArray result;
-    ByteArray encoded;
-    size_t blocks;
+    char buffer[BASE32CODER_CHUNK_BLOCKS * 8];
+    unsigned char lastGroup[5];
+    const unsigned char *data;
+    size_t groups;
+    size_t tail;
+    size_t used = 0;
+    bool success = true;
 
     // If we have nothing to encode, return an empty string.
     if (toEncode.empty()) {
         return ByteArray();
     }
 
-    result.clear();
+    // Allocate enough space for all of the encoded data up front.  (8 characters per block.)
+    if (!result.reserve(getBlocksFromSize(toEncode.size()) * 8)) {
+        LOG_ERROR("Unable to allocate memory for the base 32 encoded data!");
+        return ByteArray();
+    }
 
-    blocks = getBlocksFromSize(toEncode.size());
+    data = toEncode.toUCharArrayPtr();
+    groups = toEncode.size() / 5;
+    tail = toEncode.size() % 5;
 
-    // Set the result to pre-allocate enough space for our data.
-    result.setExtraAllocation(blocks * 10);
+    for (size_t i = 0; (success) && (i < groups); i++) {
+        if (used == sizeof(buffer)) {
+            success = result.append(buffer, used);
+            used = 0;
+        }
 
-    for (size_t i = 0; i < blocks; i++) {
-        encoded = encodeOneBlock(i, toEncode);
+        encodeGroup(&data[i * 5], &buffer[used]);
+        used += 8;
+    }
 
-        // Make sure it is valid.
-        if (encoded.size() == 0) {
-            LOG_ERROR("Failed to base 32 encode the data at block " + QString::number(i) + "!");
-            return ByteArray();     // Return an empty byte array.
+    if ((success) && (tail != 0)) {
+        if (used == sizeof(buffer)) {
+            success = result.append(buffer, used);
+            used = 0;
         }
 
-        // Everything looks good.  Append it to our result data.
-        result.append(encoded);
+        // Encode the last few bytes as if they were followed by zeros, then pad out the block.
+        memset(&lastGroup, 0x00, sizeof(lastGroup));
+        memcpy(&lastGroup, &data[groups * 5], tail);
+
+        encodeGroup(lastGroup, &buffer[used]);
+        memset(&buffer[used + BASE32CODER_TAIL_CHARS[tail]], '=', 8 - BASE32CODER_TAIL_CHARS[tail]);
+        used += 8;
+
+        memset(&lastGroup, 0x00, sizeof(lastGroup));
+    }
+
+    if ((success) && (used > 0)) {
+        success = result.append(buffer, used);
+    }
+
+    memset(&buffer, 0x00, sizeof(buffer));
+
+    if (!success) {
+        LOG_ERROR("Failed to append the base 32 encoded data!");
+        return ByteArray();     // Return an empty byte array.
     }
 
     return result;
 }
 
 /**
- * @brief Base32Coder::decode - Decode a base 32 encoded string.
+ * @brief Base32Coder::decode - Decode a base 32 encoded string, using the fastest backend
+ *      the CPU supports.
  *
- * @param toDecode - The string that we want to decode.
+ * @param toDecode - The string that we want to decode.  Lower case characters are allowed, and
+ *      the '=' padding at the end is optional.
  *
- * @return unsigned char pointer to the decoded data.
+ * @return ByteArray containing the decoded data.  An empty ByteArray on error.
  */
 ByteArray Base32Coder::decode(const ByteArray &toDecode)
+{
+    return decode(toDecode, bestBackend());
+}
+
+/**
+ * @brief Base32Coder::decode - Decode a base 32 encoded string, using the requested backend.
+ *      The characters are validated as they are decoded, so an invalid string is found without
+ *      a separate pass over it.
+ *
+ * @param toDecode - The string that we want to decode.  Lower case characters are allowed, and
+ *      the '=' padding at the end is optional.
+ * @param backend - One of the BASE32CODER_BACKEND_* values.
+ *
+ * @return ByteArray containing the decoded data.  An empty ByteArray on error, or if the
+ *      backend isn't supported on this CPU.
+ */
+ByteArray Base32Coder::decode(const ByteArray &toDecode, unsigned int backend)
 {
     ByteArray result;
+    unsigned char buffer[(BASE32CODER_CHUNK_BLOCKS * 5) + BASE32CODER_SIMD_SLACK];
+    const unsigned char *data;
+    size_t length;
     size_t blocks;
+    size_t chunk;
+    size_t tail;
+    bool success = true;
 
     if (toDecode.empty()) {
         // Return an empty ByteArray.
         return ByteArray();
     }
 
-    result.clear();
+    if (!backendSupported(backend)) {
+        LOG_ERROR("The base 32 backend " + QString::number(backend) + " isn't supported on this CPU!");
+        return ByteArray();
+    }
+
+    data = toDecode.toUCharArrayPtr();
+    length = toDecode.size();
+
+    // Drop the padding.  (There is never more than 6 characters of it.)
+    for (size_t i = 0; (i < 6) && (length > 0) && ('=' == data[length - 1]); i++) {
+        length--;
+    }
+
+    blocks = length / 8;
+    tail = length % 8;
+
+    // A final block of 1, 3, or 6 characters can't come from any number of bytes.
+    if ((0 == length) || ((0 != tail) && (0 == BASE32CODER_TAIL_BYTES[tail]))) {
+        LOG_ERROR("The length of the base 32 data isn't valid!");
+        return ByteArray();
+    }
 
-    // It should be evenly divisible by 8, if not, it isn't a valid string.
-    if ((toDecode.size() % 8) != 0) {
-        // Return a null pointer.
+    // Allocate enough memory to store everything decoded up front.  (5 bytes per 8 characters.)
+    if (!result.reserve((blocks * 5) + BASE32CODER_TAIL_BYTES[tail])) {
+        LOG_ERROR("Unable to allocate memory for the base 32 decoded data!");
         return ByteArray();
     }
 
-    // Set our result to pre-allocate enough memory to store everything decoded, and then some.
-    result.setExtraAllocation(toDecode.size());
+    for (size_t i = 0; (success) && (i < blocks); i += chunk) {
+        chunk = ((blocks - i) < BASE32CODER_CHUNK_BLOCKS) ? (blocks - i) : BASE32CODER_CHUNK_BLOCKS;
 
-    // Figure out how many blocks we have.
-    blocks = toDecode.size() / 8;
+        success = ((decodeBlocks(backend, &data[i * 8], chunk, buffer)) && (result.append(buffer, chunk * 5)));
+    }
 
-    // Iterate each block, converting it.
-    for (size_t i = 0; i < blocks; i++) {
-        if (decode8Chars(toDecode, (i * 8), result) == false) {
-            LOG_ERROR("Failed to decode 8 bytes!");
-            return ByteArray();     // Return an empty object.
-        }
+    if ((success) && (0 != tail)) {
+        success = ((decodeTail(&data[blocks * 8], tail, buffer)) && (result.append(buffer, BASE32CODER_TAIL_BYTES[tail])));
+    }
+
+    memset(&buffer, 0x00, sizeof(buffer));
+
+    if (!success) {
+        LOG_ERROR("Failed to decode the base 32 data!");
+        return ByteArray();     // Return an empty object.
     }
 
-   return result;
+    return result;
 }
 
 /**
@@ -106,6 +469,8 @@ ByteArray Base32Coder::decode(const ByteArray &toDecode)
  */
 bool Base32Coder::isBase32Encoded(const ByteArray &toValidate)
 {
+    const unsigned char *data;
+    unsigned char entry;
     QString temp;
 
     if (toValidate.empty()) {
@@ -119,15 +484,18 @@ bool Base32Coder::isBase32Encoded(const ByteArray &toValidate)
         return false;
     }
 
-    // And, each character needs to be one of the characters allowed in the
-    // array above.
+    data = toValidate.toUCharArrayPtr();
+
+    // And, each character needs to be an upper case base32 character, or padding.  (The decoder
+    // is more forgiving, but this is used to check what the user typed in, and we store the
+    // canonical form.)
     for (size_t i = 0; i < toValidate.size(); i++) {
-        if (((toValidate.at(i) < 'A') || (toValidate.at(i) > 'Z')) &&
-                ((toValidate.at(i) < '2') || (toValidate.at(i) > '7')) &&
-                (toValidate.at(i) != '=')) {
+        entry = BASE32CODER_DECODE_TABLE[data[i]];
+
+        if ((entry >= BASE32CODER_LOWER_CASE) && (entry != BASE32CODER_PAD)) {
             // The character is invalid.
             temp.clear();
-            temp = toValidate.at(i);
+            temp = data[i];
             LOG_DEBUG("The character '" + temp + "' at index " + QString::number(i) + " is not a valid base32 encoded character!");
             return false;
         }
@@ -137,6 +505,48 @@ bool Base32Coder::isBase32Encoded(const ByteArray &toValidate)
     return true;
 }
 
+/**
+ * @brief Base32Coder::bestBackend - Return the fastest decoder backend that this CPU supports.
+ *
+ * @return unsigned int containing one of the BASE32CODER_BACKEND_* values.
+ */
+unsigned int Base32Coder::bestBackend()
+{
+    // Only check the CPU the first time through.
+    static const unsigned int backend = detectBackend();
+
+    return backend;
+}
+
+/**
+ * @brief Base32Coder::backendSupported - Check to see if the CPU we are running on supports
+ *      the requested decoder backend.
+ *
+ * @param backend - One of the BASE32CODER_BACKEND_* values.
+ *
+ * @return true if the backend can be used.  false otherwise.
+ */
+bool Base32Coder::backendSupported(unsigned int backend)
+{
+    switch (backend) {
+    case BASE32CODER_BACKEND_SCALAR:
+        return true;
+
+#ifdef BASE32CODER_X86
+    case BASE32CODER_BACKEND_SSSE3:
+        __builtin_cpu_init();
+        return (__builtin_cpu_supports("ssse3") != 0);
+
+    case BASE32CODER_BACKEND_AVX2:
+        __builtin_cpu_init();
+        return (__builtin_cpu_supports("avx2") != 0);
+#endif // BASE32CODER_X86
+
+    default:
+        return false;
+    }
+}
+
 /**
  * @brief Base32Coder::getBlocksFromSize - Given the size of a blob of data,
  *      calculate the number of blocks that it represents.
@@ -168,104 +578,8 @@ size_t Base32Coder::getBlocksFromSize(size_t dataSize)
 }
 
 /**
- * @brief Base32Coder::encodeOneBlock - Encode a single blocks worth of data.
- *
- * @param blockCount - The block number that we should be encoding.
- * @param toEncode - A ByteArray that contains ALL of the data that we should
- *      be encoding.  'blockCount' will be used to index into the data to
- *      calculate the block.
- *
- * @return ByteArray containing a single blocks worth of encoded data.
- */
-ByteArray Base32Coder::encodeOneBlock(size_t blockCount, const ByteArray &toEncode)
-{
-    size_t offset;
-    unsigned char b;
-    ByteArray result;
-
-    // Calculate our offset.
-    offset = (blockCount * 5);
-
-    // Make sure our offset isn't beyond the end of the available data.
-    if (offset > toEncode.size()) {
-        // Return an empty block as an error.
-        return ByteArray();
-    }
-
-    result.clear();
-
-    // Make sure our first allocation is enough to cover all of the encoded data.
-    result.setExtraAllocation(10);
-
-    // Pull out the values that we need to look up.
-
-    // Take the first 5 bits.
-    result.append(base32chars[toEncode.at(offset) >> 3]);
-
-    // Take the last 3 bits in the first byte, and the first 2 of the 2nd byte.
-    b = ((toEncode.at(offset) & 0x07)  << 2);
-    if ((offset + 1) < toEncode.size()) {
-        b |= (toEncode.at(offset+1) >> 6);
-    }
-    result.append(base32chars[b]);
-
-    // If this is the end, pad out the block with = characters.
-    if ((offset + 1) >= toEncode.size()) {
-        result.append("======");
-        return result;
-    }
-
-    // Then, the 5 bits in the middle of the 2nd byte.
-    result.append(base32chars[(toEncode.at(offset+1) & 0x3f) >> 1]);
-
-    // Then, the last bit of the 2nd byte, and the high nibble of the 3rd.
-    b = ((toEncode.at(offset+1) & 0x01) << 4);
-    if ((offset + 2) < toEncode.size()) {
-        b |= (toEncode.at(offset+2) >> 4);
-    }
-    result.append(base32chars[b]);
-
-    // If this is the end, pad out the block with = characters.
-    if ((offset + 2) >= toEncode.size()) {
-        result.append("====");
-        return result;
-    }
-
-    // Then, the low nibble of the 3rd byte, and 1 bit from the 4th.
-    b = ((toEncode.at(offset+2) & 0x0f) << 1);
-    if ((offset + 3) < toEncode.size()) {
-        b |= (toEncode.at(offset+3) >> 7);
-    }
-    result.append(base32chars[b]);
-
-    // If this is the end, pad out the block with = characters.
-    if ((offset + 3) >= toEncode.size()) {
-        result.append("===");
-        return result;
-    }
-
-    // Then the 5 middle-ish bits from the 4th byte.
-    result.append(base32chars[(toEncode.at(offset+3) & 0x7f) >> 2]);
-
-    // Then the low 2 bits of the 4th byte and the high 3 of the 5th.
-    b = ((toEncode.at(offset+3) & 0x03) << 3);
-    if ((offset + 4) < toEncode.size()) {
-        b |= (toEncode.at(offset+4) >> 5);
-    }
-    result.append(base32chars[b]);
-
-    if ((offset + 4) >= toEncode.size()) {
-        result.append('=');
-    } else {
-        // Then, the last 5 bits of the 5th byte.
-        result.append(base32chars[toEncode.at(offset+4) & 0x1f]);
-    }
-
-    return result;
-}
-
-/**
- * @brief Base32Coder::decode8Chars - Base32 decode a black of 8 characters.
+ * @brief Base32Coder::decode8Chars - Base32 decode a block of 8 characters, which may end with
+ *      padding.
  *
  * @param data - The ByteArray object that contains the data that we want to decode.
  * @param dataOffset - The offset in to the ByteArray that we want to decode.
@@ -275,9 +589,10 @@ ByteArray Base32Coder::encodeOneBlock(size_t blockCount, const ByteArray &toEnco
  */
 bool Base32Coder::decode8Chars(const ByteArray &data, size_t dataOffset, ByteArray &target)
 {
-    unsigned char decoded1;
-    unsigned char decoded2;
-    unsigned char decoded3;
+    const unsigned char *block;
+    unsigned char decoded[5];
+    size_t count;
+    bool success;
 
     // If the data is empty, or we don't have 8 bytes to decode, it is a failure.
     if ((data.empty()) || ((dataOffset + 8) > data.size())) {
@@ -285,90 +600,72 @@ bool Base32Coder::decode8Chars(const ByteArray &data, size_t dataOffset, ByteArr
         return false;
     }
 
-    // Decode the first byte.
-    decoded1 = decodeChar(data.at(dataOffset));
-    decoded2 = decodeChar(data.at(dataOffset + 1));
-    if ((decoded1 == 0xff) || (decoded2 == 0xff)) {
-        LOG_ERROR("Unable to decode the 1st set of bytes!");
-        return false;
-    }
+    block = &data.toUCharArrayPtr()[dataOffset];
 
-    if (!target.append(static_cast<char>((decoded1 << 3) | (decoded2 >> 2)))) {
-        return false;
-    }
-
-    if (data.at(dataOffset + 2) != '=') {
-            decoded1 = decodeChar(data.at(dataOffset + 1));
-            decoded2 = decodeChar(data.at(dataOffset + 2));
-            decoded3 = decodeChar(data.at(dataOffset + 3));
-            if ((decoded1 == 0xff) || (decoded2 == 0xff) || (decoded3 == 0xff)) {
-                LOG_ERROR("Unable to decode the 2nd set of bytes!");
-                return false;
-            }
-
-            if (!target.append(static_cast<char>((decoded1 << 6) | (decoded2 << 1) | (decoded3 >> 4)))) {
-                return false;
-            }
+    // Count the characters before the padding, and make sure there is nothing but padding after
+    // them.
+    for (count = 0; (count < 8) && ('=' != block[count]); count++) {
     }
 
-    if (data.at(dataOffset + 4) != '=') {
-        decoded1 = decodeChar(data.at(dataOffset + 3));
-        decoded2 = decodeChar(data.at(dataOffset + 4));
-        if ((decoded1 == 0xff) || (decoded2 == 0xff)) {
-            LOG_ERROR("Unable to decode the 3rd set of bytes!");
-            return false;
-        }
-
-        if (!target.append(static_cast<char>((decoded1 << 4) | (decoded2 >> 1)))) {
+    for (size_t i = count; i < 8; i++) {
+        if ('=' != block[i]) {
+            LOG_ERROR("Found data after the padding in a base 32 block!");
             return false;
         }
     }
 
-    if (data.at(dataOffset + 5) != '=') {
-        decoded1 = decodeChar(data.at(dataOffset + 4));
-        decoded2 = decodeChar(data.at(dataOffset + 5));
-        decoded3 = decodeChar(data.at(dataOffset + 6));
-        if ((decoded1 == 0xff) || (decoded2 == 0xff) || (decoded3 == 0xff)) {
-            LOG_ERROR("Unable to decode the 4th set of bytes!");
-            return false;
-        }
-
-        if (!target.append(static_cast<char>((decoded1 << 7) | (decoded2 << 2) | (decoded3 >> 3)))) {
-            return false;
-        }
+    if (8 == count) {
+        success = decodeBlock(block, decoded);
+        count = 5;
+    } else {
+        success = decodeTail(block, count, decoded);
+        count = BASE32CODER_TAIL_BYTES[count];
     }
 
-    if (data.at(dataOffset + 7) != '=') {
-        decoded1 = decodeChar(data.at(dataOffset + 6));
-        decoded2 = decodeChar(data.at(dataOffset + 7));
-        if ((decoded1 == 0xff) || (decoded2 == 0xff)) {
-            LOG_ERROR("Unable to decode the 5th set of bytes!");
-            return false;
-        }
-
-        if (!target.append(static_cast<char>((decoded1 << 5) | (decoded2)))) {
-            return false;
-        }
+    if (!success) {
+        LOG_ERROR("Unable to decode the base 32 block!");
+        return false;
     }
 
-    return true;
+    success = target.append(decoded, count);
+    memset(&decoded, 0x00, sizeof(decoded));
+
+    return success;
 }
 
 /**
  * @brief Base32Coder::decodeChar - Convert a character to a 5 bit value.
  *
- * @param toDecode - The character to decode.
+ * @param toDecode - The character to decode.  (Upper or lower case.)
  *
- * @return unsigned char containing the 5 bit value.
+ * @return unsigned char containing the 5 bit value.  0xff if the character isn't valid.
  */
 unsigned char Base32Coder::decodeChar(unsigned char toDecode)
 {
-    for (unsigned char i = 0; i < strlen(base32chars); i++) {
-        if (toDecode == base32chars[i]) {
-            return i;
-        }
+    unsigned char entry = BASE32CODER_DECODE_TABLE[toDecode];
+
+    if ((entry & BASE32CODER_PAD) != 0) {
+        return BASE32CODER_INVALID;
+    }
+
+    return (entry & 0x1f);
+}
+
+/**
+ * @brief Base32Coder::detectBackend - Work out which decoder backend is the fastest one the CPU
+ *      supports.
+ *
+ * @return unsigned int containing one of the BASE32CODER_BACKEND_* values.
+ */
+unsigned int Base32Coder::detectBackend()
+{
+    if (backendSupported(BASE32CODER_BACKEND_AVX2)) {
+        return BASE32CODER_BACKEND_AVX2;
+    }
+
+    if (backendSupported(BASE32CODER_BACKEND_SSSE3)) {
+        return BASE32CODER_BACKEND_SSSE3;
     }
 
-    // Didn't find it.
-    return 0xff;
+    return BASE32CODER_BACKEND_SCALAR;
 }
@@ -4,6 +4,19 @@
 #include <string>
 #include "container/bytearray.h"
 
+const unsigned int BASE32CODER_BACKEND_SCALAR=0;      // One 8 character block at a time, using the lookup table.
+const unsigned int BASE32CODER_BACKEND_SSSE3=1;       // Two blocks (16 characters) at a time.
+const unsigned int BASE32CODER_BACKEND_AVX2=2;        // Four blocks (32 characters) at a time.
+
+/**
+ * @brief The Base32Coder class encodes and decodes RFC 4648 base32.
+ *
+ *      Characters are mapped through a 256 entry table, so checking that a character is valid
+ *      and finding its value is a single lookup, and the decoder validates while it decodes.
+ *      The decoder accepts lower case characters, and doesn't require the '=' padding at the
+ *      end.  Long strings (like the ones from a bulk import) are decoded 16 or 32 characters
+ *      at a time with SSSE3 or AVX2, when the CPU has them.
+ */
 class Base32Coder
 {
 public:
@@ -11,14 +24,20 @@ public:
 
     ByteArray encode(const ByteArray &toEncode);
     ByteArray decode(const ByteArray &toDecode);
+    ByteArray decode(const ByteArray &toDecode, unsigned int backend);
 
     static bool isBase32Encoded(const ByteArray &toValidate);
 
+    static unsigned int bestBackend();
+    static bool backendSupported(unsigned int backend);
+
 protected:
     size_t getBlocksFromSize(size_t dataSize);
-    ByteArray encodeOneBlock(size_t blockCount, const ByteArray &toEncode);
     bool decode8Chars(const ByteArray &data, size_t dataOffset, ByteArray &target);
     unsigned char decodeChar(unsigned char toDecode);
+
+private:
+    static unsigned int detectBackend();
 };
 
 #endif // BASE32CODER_H
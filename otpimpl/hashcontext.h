@@ -0,0 +1,106 @@
+#ifndef HASHCONTEXT_H
+#define HASHCONTEXT_H
+
+#include <cstring>
+
+#include "hashpolicies.h"
+#include "hashtypebase.h"
+
+/**
+ * @brief The HashContextT class implements HashContextBase for any of the hash policies in
+ *      hashpolicies.h, so Sha1Hash, Sha256Hash, and Sha512Hash can share one streaming
+ *      implementation over the C hash functions.
+ */
+template <typename HashPolicy>
+class HashContextT : public HashContextBase
+{
+public:
+    HashContextT()
+    {
+        HashPolicy::init(mContext);
+        mFinished = false;
+    }
+
+    HashContextT(const HashContextT &toCopy) :
+        HashContextBase()
+    {
+        memcpy(&mContext, &toCopy.mContext, sizeof(mContext));
+        mFinished = toCopy.mFinished;
+    }
+
+    ~HashContextT()
+    {
+        // The midstate can be derived from key material, so don't leave it behind.
+        memset(&mContext, 0x00, sizeof(mContext));
+    }
+
+    HashContextT &operator=(const HashContextT &) = delete;
+
+    /**
+     * @brief HashContextT::update - Add more data to the hash.
+     *
+     * @param data - The data to add.
+     * @param dataLength - The length of \c data.
+     *
+     * @return true if the data was added.  false if the hash has already been finished, or
+     *      \c data is nullptr.
+     */
+    bool update(const unsigned char *data, size_t dataLength) override
+    {
+        if (mFinished) {
+            return false;
+        }
+
+        if (0 == dataLength) {
+            return true;
+        }
+
+        if (nullptr == data) {
+            return false;
+        }
+
+        HashPolicy::update(mContext, data, dataLength);
+        return true;
+    }
+
+    /**
+     * @brief HashContextT::finish - Finish the hash, and get the result.  Once this has been
+     *      called, the context can't be updated any more.
+     *
+     * @param result[OUT] - If this method returns true, the hash value.
+     *
+     * @return true if the hash was finished.  false if it had already been finished.
+     */
+    bool finish(ByteArray &result) override
+    {
+        unsigned char digest[HashPolicy::DIGEST_LENGTH];
+
+        if (mFinished) {
+            return false;
+        }
+
+        HashPolicy::final(mContext, digest);
+        mFinished = true;
+
+        result.fromUCharArray(digest, HashPolicy::DIGEST_LENGTH);
+        memset(&digest, 0x00, sizeof(digest));
+
+        return true;
+    }
+
+    /**
+     * @brief HashContextT::clone - Copy the current state of the hash in to a new context.
+     *
+     * @return std::unique_ptr containing the copy.
+     */
+    std::unique_ptr<HashContextBase> clone() const override
+    {
+        return std::unique_ptr<HashContextBase>(new HashContextT<HashPolicy>(*this));
+    }
+
+private:
+    typename HashPolicy::Context mContext;
+    bool mFinished;
+};
+
+#endif // HASHCONTEXT_H
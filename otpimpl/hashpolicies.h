@@ -0,0 +1,76 @@
+#ifndef HASHPOLICIES_H
+#define HASHPOLICIES_H
+
+#include <cstdlib>
+#include <cstdint>
+
+#include "hmackey.h"
+
+extern "C" {
+#include "sha1impl.h"                   //NOSONAR
+#include "sha2.h"                       //NOSONAR
+}
+
+/**
+ * The hash policies give HmacT and HotpT everything they need to know about a hash at compile
+ * time : the context type, the block and digest sizes, and the functions to run the hash.
+ * Since nothing is virtual, the compiler can inline the whole HMAC calculation for each hash.
+ *
+ * Each policy has to provide :
+ *      Context - The type that holds the hash state.
+ *      ALGORITHM - The matching HMACKEY_ALG_* value.
+ *      BLOCK_LENGTH - The block size of the hash, in bytes.
+ *      DIGEST_LENGTH - The size of the hash result, in bytes.
+ *      init(), update(), final() - The streaming hash functions.
+ *      padState() - Get the matching context out of an HmacKey::HashState.
+ */
+
+struct Sha1Policy
+{
+    typedef SHA1_CTX Context;
+
+    static constexpr unsigned int ALGORITHM = HMACKEY_ALG_SHA1;
+    static constexpr size_t BLOCK_LENGTH = 64;
+    static constexpr size_t DIGEST_LENGTH = 20;
+
+    static inline void init(Context &ctx) { SHA1Init(&ctx); }
+    static inline void update(Context &ctx, const unsigned char *data, size_t dataLength) { SHA1Update(&ctx, data, static_cast<uint32_t>(dataLength)); }
+    static inline void final(Context &ctx, unsigned char *digest) { SHA1Final(digest, &ctx); }
+
+    static inline const Context &padState(const HmacKey::HashState &state) { return state.sha1; }
+    static inline Context &padState(HmacKey::HashState &state) { return state.sha1; }
+};
+
+struct Sha256Policy
+{
+    typedef sha256_ctx Context;
+
+    static constexpr unsigned int ALGORITHM = HMACKEY_ALG_SHA256;
+    static constexpr size_t BLOCK_LENGTH = SHA256_BLOCK_SIZE;
+    static constexpr size_t DIGEST_LENGTH = SHA256_DIGEST_SIZE;
+
+    static inline void init(Context &ctx) { sha256_init(&ctx); }
+    static inline void update(Context &ctx, const unsigned char *data, size_t dataLength) { sha256_update(&ctx, data, static_cast<unsigned int>(dataLength)); }
+    static inline void final(Context &ctx, unsigned char *digest) { sha256_final(&ctx, digest); }
+
+    static inline const Context &padState(const HmacKey::HashState &state) { return state.sha256; }
+    static inline Context &padState(HmacKey::HashState &state) { return state.sha256; }
+};
+
+struct Sha512Policy
+{
+    typedef sha512_ctx Context;
+
+    static constexpr unsigned int ALGORITHM = HMACKEY_ALG_SHA512;
+    static constexpr size_t BLOCK_LENGTH = SHA512_BLOCK_SIZE;
+    static constexpr size_t DIGEST_LENGTH = SHA512_DIGEST_SIZE;
+
+    static inline void init(Context &ctx) { sha512_init(&ctx); }
+    static inline void update(Context &ctx, const unsigned char *data, size_t dataLength) { sha512_update(&ctx, data, static_cast<unsigned int>(dataLength)); }
+    static inline void final(Context &ctx, unsigned char *digest) { sha512_final(&ctx, digest); }
+
+    static inline const Context &padState(const HmacKey::HashState &state) { return state.sha512; }
+    static inline Context &padState(HmacKey::HashState &state) { return state.sha512; }
+};
+
+#endif // HASHPOLICIES_H
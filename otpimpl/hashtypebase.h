@@ -2,8 +2,28 @@
 #define HASHTYPEBASE_H
 
 #include <cstdlib>
+#include <memory>
 #include "container/bytearray.h"
 
+/**
+ * @brief The HashContextBase class holds the state of a hash that is being calculated a piece
+ *      at a time.  Data can be fed to it with update() without having to collect it all in one
+ *      buffer first, and clone() copies the midstate so that a common prefix (like an HMAC
+ *      pad block) only needs to be hashed once.
+ */
+class HashContextBase
+{
+public:
+    HashContextBase() = default;
+    virtual ~HashContextBase() = default;
+
+    virtual bool update(const unsigned char *data, size_t dataLength) = 0;
+    virtual bool finish(ByteArray &result) = 0;
+    virtual std::unique_ptr<HashContextBase> clone() const = 0;
+
+    bool update(const ByteArray &data) { return update(data.toUCharArrayPtr(), data.size()); }
+};
+
 /**
  * @brief The HashTypeBase class provides the template for implementing hashing methods
  *      that can be used with the associated HMAC implementation.
@@ -15,6 +35,7 @@ public:
     virtual ~HashTypeBase() = default;
 
     virtual ByteArray hash(const ByteArray &toHash) = 0;
+    virtual std::unique_ptr<HashContextBase> begin() = 0;
     virtual size_t hashResultLength() { return 0; }
     virtual size_t hashBlockLength() { return 0; }
 };
@@ -1,8 +1,170 @@
 #include "hexdecoder.h"
 
-#include <cctype>
+#include <cstring>
+#include <stdint.h>
 #include <logger.h>
-#include <sstream>
+
+// The SIMD decoders are only built for x86 with a compiler that understands the target
+// attribute, so that the rest of the program doesn't need to be built with -mavx2.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEXDECODER_X86
+#include <immintrin.h>
+#endif
+
+// Flags in the nibble table.
+const unsigned char HEXDECODER_SEPARATOR = 0x80;
+const unsigned char HEXDECODER_INVALID = 0xff;
+
+// The number of decoded bytes that are collected on the stack before they are appended to the
+// result.
+const size_t HEXDECODER_CHUNK_SIZE = 256;
+
+// When the SIMD code finds a separator (or anything else) in the next register full, wait this
+// many characters before trying it again, so that strings with a separator between every octet
+// don't pay for a failed SIMD check on every octet.
+const size_t HEXDECODER_SIMD_RETRY = 32;
+
+// The value of each hex character (upper or lower case).  Spaces, colons, dashes, and periods
+// are HEXDECODER_SEPARATOR, and everything else is HEXDECODER_INVALID.
+const unsigned char HEXDECODER_NIBBLE_TABLE[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x80, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x80, 0x80, 0xff,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x80, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+#ifdef HEXDECODER_X86
+
+/**
+ * @brief decodeSsse3 - Decode a run of plain hex digits 16 characters at a time.
+ *
+ * @param in - The characters to decode.
+ * @param length - The number of characters available in \c in.
+ * @param out[OUT] - The decoded bytes.
+ *
+ * @return size_t containing the number of characters decoded.  This stops at the first group of
+ *      16 that has anything other than a hex digit in it.
+ */
+__attribute__((target("ssse3")))
+static size_t decodeSsse3(const unsigned char *in, size_t length, unsigned char *out)
+{
+    __m128i chars;
+    __m128i folded;
+    __m128i digit;
+    __m128i letter;
+    __m128i values;
+    size_t i;
+
+    for (i = 0; (i + 16) <= length; i += 16) {
+        chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&in[i]));
+
+        // Setting the 0x20 bit folds upper case letters on to lower case.  (Digits are checked
+        // before folding, since other characters can fold on to them.)
+        folded = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+        digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+        letter = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(folded, _mm_set1_epi8('f' + 1)));
+
+        if (_mm_movemask_epi8(_mm_or_si128(digit, letter)) != 0xffff) {
+            break;
+        }
+
+        values = _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+                              _mm_and_si128(letter, _mm_sub_epi8(folded, _mm_set1_epi8('a' - 10))));
+
+        // Combine the nibble pairs, then pack the 16 bit lanes down to bytes.
+        values = _mm_maddubs_epi16(values, _mm_set1_epi16(0x0110));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(&out[i / 2]), _mm_packus_epi16(values, values));
+    }
+
+    return i;
+}
+
+/**
+ * @brief decodeAvx2 - Decode a run of plain hex digits 32 characters at a time.
+ *
+ * @param in - The characters to decode.
+ * @param length - The number of characters available in \c in.
+ * @param out[OUT] - The decoded bytes.
+ *
+ * @return size_t containing the number of characters decoded.  This stops at the first group of
+ *      32 that has anything other than a hex digit in it.
+ */
+__attribute__((target("avx2")))
+static size_t decodeAvx2(const unsigned char *in, size_t length, unsigned char *out)
+{
+    __m256i chars;
+    __m256i folded;
+    __m256i digit;
+    __m256i letter;
+    __m256i values;
+    size_t i;
+
+    for (i = 0; (i + 32) <= length; i += 32) {
+        chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&in[i]));
+
+        // Setting the 0x20 bit folds upper case letters on to lower case.  (Digits are checked
+        // before folding, since other characters can fold on to them.)
+        folded = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+        digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+        letter = _mm256_and_si256(_mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), folded));
+
+        if (_mm256_movemask_epi8(_mm256_or_si256(digit, letter)) != -1) {
+            break;
+        }
+
+        values = _mm256_or_si256(_mm256_and_si256(digit, _mm256_sub_epi8(chars, _mm256_set1_epi8('0'))),
+                                 _mm256_and_si256(letter, _mm256_sub_epi8(folded, _mm256_set1_epi8('a' - 10))));
+
+        // Combine the nibble pairs, pack the 16 bit lanes down to bytes, then pull the two
+        // halves together.
+        values = _mm256_maddubs_epi16(values, _mm256_set1_epi16(0x0110));
+        values = _mm256_permute4x64_epi64(_mm256_packus_epi16(values, values), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&out[i / 2]), _mm256_castsi256_si128(values));
+    }
+
+    return i;
+}
+
+#endif // HEXDECODER_X86
+
+/**
+ * @brief decodeRun - Decode as many plain hex digits as the backend can handle in one go.
+ *
+ * @param backend - One of the HEXDECODER_BACKEND_* values.
+ * @param in - The characters to decode.
+ * @param length - The number of characters available in \c in.  (The decoded bytes must fit
+ *      in \c out.)
+ * @param out[OUT] - The decoded bytes.
+ *
+ * @return size_t containing the number of characters decoded.  (Always even.)
+ */
+static size_t decodeRun(unsigned int backend, const unsigned char *in, size_t length, unsigned char *out)
+{
+    switch (backend) {
+#ifdef HEXDECODER_X86
+    case HEXDECODER_BACKEND_AVX2:
+        return decodeAvx2(in, length, out);
+
+    case HEXDECODER_BACKEND_SSSE3:
+        return decodeSsse3(in, length, out);
+#endif // HEXDECODER_X86
+
+    default:
+        return 0;
+    }
+}
 
 HexDecoder::HexDecoder()
 {
@@ -11,7 +173,7 @@ HexDecoder::HexDecoder()
 
 /**
  * @brief HexDecoder::decode - Decode a hex string that may contain spaces, colons, dashes, periods, or a 0x prefix
- *      between the octets.
+ *      between the octets, using the fastest backend the CPU supports.
  *
  * @param hexData - A string that contains the string representation of the hex we want to convert.
  *
@@ -19,39 +181,43 @@ HexDecoder::HexDecoder()
  */
 ByteArray HexDecoder::decode(const ByteArray &hexData)
 {
-    std::string smashed;
+    return decode(hexData, bestBackend());
+}
+
+/**
+ * @brief HexDecoder::decode - Decode a hex string that may contain spaces, colons, dashes, periods, or a 0x prefix
+ *      between the octets, using the requested backend.
+ *
+ * @param hexData - A string that contains the string representation of the hex we want to convert.
+ * @param backend - One of the HEXDECODER_BACKEND_* values.
+ *
+ * @return ByteArray containing the decoded value.  On error, or if the backend isn't supported on this CPU,
+ *      the ByteArray will be empty.
+ */
+ByteArray HexDecoder::decode(const ByteArray &hexData, unsigned int backend)
+{
     ByteArray result;
-    size_t resultSize;
 
-    // If the string is empty, return nullptr.
+    // If the string is empty, return an empty ByteArray.
     if (hexData.empty()) {
         return ByteArray();
     }
 
-    // Start clean.
-    result.clear();
-
-    // Need to replace the spaces, colons, dashes, or periods in the string to get a single, undecorated, hex
-    // string.
-    smashed = cleanup(hexData.toString());
-
-    // We should now have a string that is all hex characters.  So, the length should be divisible by 2.  Make
-    // sure it is.
-    if ((smashed.length() % 2) != 0) {
-        LOG_ERROR("HEX string to decode wasn't an even number of characters!");
+    if (!backendSupported(backend)) {
+        LOG_ERROR("The hex decoder backend " + QString::number(backend) + " isn't supported on this CPU!");
         return ByteArray();
     }
 
-    // Calculate our result length.
-    resultSize = (smashed.length() / 2);
-
-    // Have our result buffer allocate extra space to speed things up.
-    result.setExtraAllocation(resultSize + 2);
+    // Allocate the whole result buffer up front to speed things up.  (Separators make the result
+    // smaller than this, never bigger.)
+    if (!result.reserve(hexData.size() / 2)) {
+        LOG_ERROR("Unable to allocate memory for the decoded HEX data!");
+        return ByteArray();
+    }
 
-    // Iterate the string passing 2 characters at a time in to decodeOneByte, and stashing the
-    // result in our return buffer.
-    for (size_t i = 0; i < resultSize; i++) {
-        result.append(decodeOneByte(smashed.substr((i * 2), 2)));
+    if (!decodeStream(backend, hexData.toUCharArrayPtr(), hexData.size(), &result)) {
+        LOG_ERROR("Unable to decode the HEX string!");
+        return ByteArray();
     }
 
     return result;
@@ -67,38 +233,55 @@ ByteArray HexDecoder::decode(const ByteArray &hexData)
  */
 bool HexDecoder::isHexEncoded(const std::string &toTest)
 {
-    QString temp;
-    std::string toValidate;
-
     if (toTest.empty()) {
         LOG_ERROR("The string to validate for hex encoding was empty!");
         return false;
     }
 
-    // Strip any excess, but allowed, characters from the string.
-    toValidate = cleanup(toTest);
+    // Run the decoder without keeping the result.
+    return decodeStream(bestBackend(), reinterpret_cast<const unsigned char *>(toTest.c_str()), toTest.length(), nullptr);
+}
 
-    // The string length needs to be evenly divisible by 2.
-    if ((toValidate.length() % 2) != 0) {
-        LOG_ERROR("The string provided isn't hex encoded.  The length is incorrect!");
-        return false;
-    }
+/**
+ * @brief HexDecoder::bestBackend - Return the fastest backend that this CPU supports.
+ *
+ * @return unsigned int containing one of the HEXDECODER_BACKEND_* values.
+ */
+unsigned int HexDecoder::bestBackend()
+{
+    // Only check the CPU the first time through.
+    static const unsigned int backend = detectBackend();
 
-    // And, each character needs to be one of the characters allowed in the
-    // array above.
-    for (size_t i = 0; i < toValidate.length(); i++) {
-        if (((toValidate.at(i) < '0') || (toValidate.at(i) > '9')) &&
-                ((toValidate.at(i) < 'A') || (toValidate.at(i) > 'F'))) {
-            // The character is invalid.
-            temp.clear();
-            temp = toValidate.at(i);
-            LOG_DEBUG("The character '" + temp + "' at index " + QString::number(i) + " is not a valid hex encoded character!");
-            return false;
-        }
-    }
+    return backend;
+}
 
-    // If we get here, then the string appears to be a valid hex string.
-    return true;
+/**
+ * @brief HexDecoder::backendSupported - Check to see if the CPU we are running on supports
+ *      the requested backend.
+ *
+ * @param backend - One of the HEXDECODER_BACKEND_* values.
+ *
+ * @return true if the backend can be used.  false otherwise.
+ */
+bool HexDecoder::backendSupported(unsigned int backend)
+{
+    switch (backend) {
+    case HEXDECODER_BACKEND_SCALAR:
+        return true;
+
+#ifdef HEXDECODER_X86
+    case HEXDECODER_BACKEND_SSSE3:
+        __builtin_cpu_init();
+        return (__builtin_cpu_supports("ssse3") != 0);
+
+    case HEXDECODER_BACKEND_AVX2:
+        __builtin_cpu_init();
+        return (__builtin_cpu_supports("avx2") != 0);
+#endif // HEXDECODER_X86
+
+    default:
+        return false;
+    }
 }
 
 /**
@@ -131,106 +314,146 @@ unsigned char HexDecoder::decodeOneByte(const std::string &oneByte)
  */
 unsigned char HexDecoder::decodeOneNibble(char oneNibble)
 {
-    const char nibbles[] = "0123456789ABCDEF";
-    char upperCharToSearch;
-    std::stringstream errorMessage;
+    unsigned char entry = HEXDECODER_NIBBLE_TABLE[static_cast<unsigned char>(oneNibble)];
 
-    // First, convert the character to upper case (in case if it A-F, and in lower case).
-    upperCharToSearch = toupper(oneNibble);
-
-    // Then, search for the character in our list of known characters.
-    for (unsigned char i = 0; i < strlen(nibbles); i++) {
-        if (upperCharToSearch == nibbles[i]) {
-            return i;
-        }
+    if ((entry & HEXDECODER_SEPARATOR) != 0) {
+        LOG_ERROR("Unable to convert '" + QString(QChar(oneNibble)) + "' to a hex nibble!");
+        return HEXDECODER_INVALID;
     }
 
-    // If we didn't find it, log an error, and return 0xff.
-    errorMessage << "Unable to convert '" << oneNibble << "' to a hex nibble!";
-
-    LOG_ERROR(QString::fromStdString(errorMessage.str()));
-    return 0xff;
+    return entry;
 }
 
 /**
- * @brief HexDecoder::cleanup - Strip the hex encoded string of spaces, colons, dashes, periods of a 0x prefix
- *      and make sure all letters are upper case, then return the result.
+ * @brief HexDecoder::decodeStream - Walk a hex string once, skipping spaces, colons, dashes, periods,
+ *      and 0x prefixes, and decoding everything else.
  *
- * @param toClean - The string that we want to strip of extra characters.
+ * @param backend - One of the HEXDECODER_BACKEND_* values.
+ * @param data - The characters to decode.
+ * @param length - The number of characters in \c data.
+ * @param target[OUT] - The ByteArray to append the decoded bytes to.  If this is nullptr, the string is
+ *      only validated.
  *
- * @return std::string stripped of extra characters allowed in a hex string.
+ * @return true if the string was valid hex (and was decoded).  false otherwise.
  */
-std::string HexDecoder::cleanup(const std::string &toClean)
+bool HexDecoder::decodeStream(unsigned int backend, const unsigned char *data, size_t length, ByteArray *target)
 {
-    std::string smashed;
+    unsigned char buffer[HEXDECODER_CHUNK_SIZE];
+    unsigned char entry;
+    unsigned char high = 0;
+    bool haveHigh = false;
+    bool success = true;
+    size_t used = 0;
+    size_t run;
+    size_t nextRun = 0;
+    size_t i = 0;
+
+    while ((success) && (i < length)) {
+        // Long runs of plain hex digits are handed to the SIMD code, as long as we are between
+        // octets.
+        if ((!haveHigh) && (HEXDECODER_BACKEND_SCALAR != backend) && (i >= nextRun)) {
+            run = length - i;
+            if (run > ((sizeof(buffer) - used) * 2)) {
+                run = (sizeof(buffer) - used) * 2;
+            }
+
+            run = decodeRun(backend, &data[i], run, &buffer[used]);
+
+            // If the last digit is the start of a 0x prefix, leave the last octet for the code
+            // below.
+            if ((run > 0) && ((i + run) < length) && ('x' == data[i + run]) && ('0' == data[i + run - 1])) {
+                run -= 2;
+            }
+
+            if (0 == run) {
+                nextRun = i + HEXDECODER_SIMD_RETRY;
+            }
+
+            i += run;
+            used += (run / 2);
+
+            if (used == sizeof(buffer)) {
+                if (target != nullptr) {
+                    success = target->append(buffer, used);
+                }
+                used = 0;
+                continue;
+            }
+
+            if (i >= length) {
+                break;
+            }
+        }
 
-    // Need to replace the spaces, colons, dashes, or periods in the string to get a single, undecorated, hex
-    // string.
-    smashed = replaceInString(toClean, " ", "");
-    smashed = replaceInString(smashed, ":", "");
-    smashed = replaceInString(smashed, "-", "");
-    smashed = replaceInString(smashed, ".", "");
-    smashed = replaceInString(smashed, "0x", "");
+        // Skip any 0x prefix.
+        if (('0' == data[i]) && ((i + 1) < length) && ('x' == data[i + 1])) {
+            i += 2;
+            continue;
+        }
 
-    // Iterate the newly stripped string, making sure everything is in upper case.
-    for (size_t i = 0; i < smashed.length(); i++) {
-        smashed[i] = toupper(smashed.at(i));
-    }
+        entry = HEXDECODER_NIBBLE_TABLE[data[i]];
 
-    return smashed;
-}
+        if (HEXDECODER_SEPARATOR == entry) {
+            i++;
+            continue;
+        }
 
-/**
- * @brief HexDecoder::replaceInString - Replace 'toReplace', if it is found in 'sourceString', with
- *      the 'replaceWith' value.
- *
- * @param sourceString - The string to search for 'toReplace' in.
- * @param toReplace - The string that we want to replace.
- * @param replaceWith - The string to replace 'toReplace' with.
- *
- * @return
- */
-std::string HexDecoder::replaceInString(const std::string &sourceString, const std::string &toReplace, const std::string &replaceWith)
-{
-    std::string result;
+        if (HEXDECODER_INVALID == entry) {
+            LOG_DEBUG("The character '" + QString(QChar(data[i])) + "' at index " + QString::number(i) + " is not a valid hex encoded character!");
+            success = false;
+            break;
+        }
 
-    // Replace all instances.
-    result = sourceString;
+        if (!haveHigh) {
+            high = entry;
+            haveHigh = true;
+        } else {
+            buffer[used++] = static_cast<unsigned char>((high << 4) | entry);
+            haveHigh = false;
+
+            if (used == sizeof(buffer)) {
+                if (target != nullptr) {
+                    success = target->append(buffer, used);
+                }
+                used = 0;
+            }
+        }
 
-    // Replace all of the instances.
-    while (replaceSingleInstance(result, toReplace, replaceWith, result));
+        i++;
+    }
 
-    // Return the updated string.
-    return result;
+    // Every octet needs two characters.
+    if ((success) && (haveHigh)) {
+        LOG_ERROR("HEX string to decode wasn't an even number of characters!");
+        success = false;
+    }
+
+    if ((success) && (used > 0) && (target != nullptr)) {
+        success = target->append(buffer, used);
+    }
+
+    // The decoded data is usually a secret, so don't leave it on the stack.
+    memset(&buffer, 0x00, sizeof(buffer));
+    high = 0;
+
+    return success;
 }
 
 /**
- * @brief HexDecoder::replaceSingleInstance - Replace a single instance of 'toReplace' with 'replaceWith' when it
- *      is found in 'sourceString'.
- *
- * @param sourceString - The string to replace an instance of 'toReplace' in.
- * @param toReplace - The string to search for in 'sourceString'.
- * @param replaceWith - The string that will replace 'toReplace' in the resulting string.
- * @param result[OUT] - The result string with 0 or 1 replacements in it.
+ * @brief HexDecoder::detectBackend - Work out which backend is the fastest one the CPU
+ *      supports.
  *
- * @return true if an instance of 'toReplace' was replaced.  false otherwise.
+ * @return unsigned int containing one of the HEXDECODER_BACKEND_* values.
  */
-bool HexDecoder::replaceSingleInstance(const std::string &sourceString, const std::string &toReplace, const std::string &replaceWith, std::string &result)
+unsigned int HexDecoder::detectBackend()
 {
-    size_t index = 0;
-
-    // Copy the source to our result, then operate on the result string.
-    result = sourceString;
-
-    // Find an instance of substring in the string.
-    index = sourceString.find(toReplace, index);
-    if (index == std::string::npos) {
-        // Didn't find anything to replace.
-        return false;
+    if (backendSupported(HEXDECODER_BACKEND_AVX2)) {
+        return HEXDECODER_BACKEND_AVX2;
     }
 
-    // Found an instance, so replace it.
-    result = result.replace(index, toReplace.length(), replaceWith);
+    if (backendSupported(HEXDECODER_BACKEND_SSSE3)) {
+        return HEXDECODER_BACKEND_SSSE3;
+    }
 
-    return true;
+    return HEXDECODER_BACKEND_SCALAR;
 }
@@ -4,23 +4,39 @@
 #include <string>
 #include "container/bytearray.h"
 
+const unsigned int HEXDECODER_BACKEND_SCALAR=0;       // One character at a time, using the lookup table.
+const unsigned int HEXDECODER_BACKEND_SSSE3=1;        // 16 characters at a time.
+const unsigned int HEXDECODER_BACKEND_AVX2=2;         // 32 characters at a time.
+
+/**
+ * @brief The HexDecoder class decodes hex strings that may have spaces, colons, dashes, periods,
+ *      or 0x prefixes between the octets.
+ *
+ *      The string is decoded in a single pass, with the separators skipped as they are found,
+ *      and each character mapped through a 256 entry table.  Runs of plain hex digits in long
+ *      strings are decoded 16 or 32 characters at a time with SSSE3 or AVX2, when the CPU has
+ *      them.
+ */
 class HexDecoder
 {
 public:
     HexDecoder();
 
     ByteArray decode(const ByteArray &hexData);
+    ByteArray decode(const ByteArray &hexData, unsigned int backend);
 
     static bool isHexEncoded(const std::string &toTest);
 
+    static unsigned int bestBackend();
+    static bool backendSupported(unsigned int backend);
+
 protected:
     unsigned char decodeOneByte(const std::string &oneByte);
     unsigned char decodeOneNibble(char oneNibble);
 
 private:
-    static std::string cleanup(const std::string &toClean);
-    static std::string replaceInString(const std::string &sourceString, const std::string &toReplace, const std::string &replaceWith);
-    static bool replaceSingleInstance(const std::string &sourceString, const std::string &toReplace, const std::string &replaceWith, std::string &result);
+    static bool decodeStream(unsigned int backend, const unsigned char *data, size_t length, ByteArray *target);
+    static unsigned int detectBackend();
 };
 
 #endif // HEXDECODER_H
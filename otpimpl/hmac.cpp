@@ -10,7 +10,7 @@ Hmac::Hmac()
     mHashResult = nullptr;
 }
 
-Hmac::Hmac(std::shared_ptr<HashTypeBase> hashType) :
+Hmac::Hmac(const std::shared_ptr<HashTypeBase> &hashType) :
     mHashType(hashType)
 {
     mHashResult = nullptr;
@@ -46,10 +46,12 @@ void Hmac::setHashType(const std::shared_ptr<HashTypeBase> &hashType)
  */
 std::shared_ptr<ByteArray> Hmac::calculate(const ByteArray &key, const ByteArray &data)
 {
-    ByteArray keyIpad;
-    ByteArray keyOpad;
-    ByteArray iPadHashed;
-    ByteArray keyToUse;
+    // These all hold key material, so keep them in the secure arena.
+    ByteArray keyPad(true);
+    ByteArray keyToUse(true);
+    ByteArray iPadHashed(true);
+    std::unique_ptr<HashContextBase> ctx;
+    size_t blockLength;
 
     // Validate inputs.
     if (key.empty() || data.empty()) {
@@ -65,6 +67,9 @@ std::shared_ptr<ByteArray> Hmac::calculate(const ByteArray &key, const ByteArray
         return nullptr;
     }
 
+    // The block length doesn't change, so only ask for it once.
+    blockLength = mHashType->hashBlockLength();
+
     // Make a copy of our key data.
     keyToUse = key;
 
@@ -73,59 +78,51 @@ std::shared_ptr<ByteArray> Hmac::calculate(const ByteArray &key, const ByteArray
 
     // If the key length is larger than one block, we need to hash the key to come up
     // with a key of decreased size.
-    if (keyToUse.size() > mHashType->hashBlockLength()) {
+    if (keyToUse.size() > blockLength) {
         // Create a hash of the key to use.
         keyToUse = mHashType->hash(keyToUse);
     }
 
-    // Copy the data from our keyToUse to the Ipad and Opad.
-    keyIpad = keyToUse;
-    keyOpad = keyToUse;
-
-    // Pre-allocate a full block on the next reallocation.
-    keyIpad.setExtraAllocation(mHashType->hashBlockLength());
-    keyOpad.setExtraAllocation(mHashType->hashBlockLength());
-
-    // Padd the ipad and opad to the proper block size.
-    for (size_t i = keyIpad.size(); i < mHashType->hashBlockLength(); i++) {
-        if (!keyIpad.append(static_cast<char>(0x00))) {
-            LOG_ERROR("Failed to append a zero byte to the key ipad!");
-            return nullptr;
-        }
+    // Pad the key to the proper block size.
+    keyPad = keyToUse;
+    if ((keyPad.size() < blockLength) && (!keyPad.appendZeros(blockLength - keyPad.size()))) {
+        LOG_ERROR("Failed to pad the key!");
+        return nullptr;
     }
 
-    for (size_t i = keyOpad.size(); i < mHashType->hashBlockLength(); i++) {
-        if (!keyOpad.append(static_cast<char>(0x00))) {
-            LOG_ERROR("Failed to append a zero byte to the key opad!");
+    // XOR the key with 0x36 for the ipad.
+    for (size_t i = 0; i < blockLength; i++) {
+        if (!keyPad.setAt(i, (keyPad.at(i) ^ 0x36))) {
+            LOG_ERROR("Unable to set the ipad value at index " + QString::number(i) + "!");
             return nullptr;
         }
     }
 
-    // Iterate the two values, XORing them with 0x36 for the ipad, and
-    // 0x5c for the opad.
-    for (size_t i = 0; i < mHashType->hashBlockLength(); i++) {
-        if (!keyIpad.setAt(i, (keyIpad.at(i) ^ 0x36))) {
-            LOG_ERROR("Unable to set the ipad value at index " + QString::number(i) + "!");
-            return nullptr;
-        }
+    // Perform the inner hash, feeding the ipad and data straight in to the hash, rather than
+    // concatenating them first.
+    ctx = mHashType->begin();
+    if ((nullptr == ctx) || (!ctx->update(keyPad)) || (!ctx->update(data)) || (!ctx->finish(iPadHashed))) {
+        LOG_ERROR("Unable to calculate the inner hash!");
+        return nullptr;
+    }
 
-        if (!keyOpad.setAt(i, (keyOpad.at(i) ^ 0x5c))) {
+    // Then, flip the ipad over to the opad.  (XORing with 0x36 again undoes the ipad.)
+    for (size_t i = 0; i < blockLength; i++) {
+        if (!keyPad.setAt(i, (keyPad.at(i) ^ (0x36 ^ 0x5c)))) {
             LOG_ERROR("Unable to set the opad value at index " + QString::number(i) + "!");
             return nullptr;
         }
     }
 
-    // Then, concatenate the data on to the inner hash value.
-    keyIpad.append(data);
+    // And hash the opad followed by the inner hash.
+    mHashResult.reset(new ByteArray());
 
-    // Then, perform the inner hash on the data provided.
-    iPadHashed = mHashType->hash(keyIpad);
-
-    // Then, concatenate the iPadHashed value to the keyOpad value.
-    keyOpad.append(iPadHashed);
-
-    // And hash that.
-    mHashResult.reset(new ByteArray(mHashType->hash(keyOpad)));
+    ctx = mHashType->begin();
+    if ((nullptr == ctx) || (!ctx->update(keyPad)) || (!ctx->update(iPadHashed)) || (!ctx->finish(*mHashResult))) {
+        LOG_ERROR("Unable to calculate the outer hash!");
+        mHashResult.reset();
+        return nullptr;
+    }
 
     // And, return the result.
     return mHashResult;
@@ -9,7 +9,7 @@ class Hmac
 {
 public:
     Hmac();
-    explicit Hmac(std::shared_ptr<HashTypeBase> hashType);
+    explicit Hmac(const std::shared_ptr<HashTypeBase> &hashType);
     Hmac(Hmac &toCopy);
     ~Hmac() = default;
 
@@ -0,0 +1,115 @@
+#include "hmacalgorithm.h"
+
+#include <cstring>
+#include "hashpolicies.h"
+
+/**
+ * @brief policyInit - Start a new hash in the policy's part of the hash state.
+ *
+ * @param state[OUT] - The hash state to initialize.
+ */
+template <typename HashPolicy>
+static void policyInit(HmacKey::HashState &state)
+{
+    HashPolicy::init(HashPolicy::padState(state));
+}
+
+/**
+ * @brief policyUpdate - Hash more data in to the policy's part of the hash state.
+ *
+ * @param state[IN/OUT] - The hash state to update.
+ * @param data - The data to hash.
+ * @param dataLength - The length of \c data.
+ */
+template <typename HashPolicy>
+static void policyUpdate(HmacKey::HashState &state, const unsigned char *data, size_t dataLength)
+{
+    HashPolicy::update(HashPolicy::padState(state), data, dataLength);
+}
+
+/**
+ * @brief policyFinal - Finish the hash in the policy's part of the hash state.
+ *
+ * @param state[IN/OUT] - The hash state to finish.
+ * @param result[OUT] - The hash result.  Must be able to hold the policy's DIGEST_LENGTH.
+ */
+template <typename HashPolicy>
+static void policyFinal(HmacKey::HashState &state, unsigned char *result)
+{
+    HashPolicy::final(HashPolicy::padState(state), result);
+}
+
+/**
+ * @brief policyDigest - Hash a buffer in one go.
+ *
+ * @param data - The data to hash.
+ * @param dataLength - The length of \c data.
+ * @param result[OUT] - The hash result.  Must be able to hold the policy's DIGEST_LENGTH.
+ */
+template <typename HashPolicy>
+static void policyDigest(const unsigned char *data, size_t dataLength, unsigned char *result)
+{
+    typename HashPolicy::Context ctx;
+
+    HashPolicy::init(ctx);
+    HashPolicy::update(ctx, data, dataLength);
+    HashPolicy::final(ctx, result);
+
+    memset(&ctx, 0x00, sizeof(ctx));
+}
+
+// The descriptors, in HMACKEY_ALG_* order.  This is constant initialized, so it is ready before
+// any code runs, and never needs a lock.
+static const HmacAlgorithm HMACALGORITHM_REGISTRY[] = {
+    { HMACKEY_ALG_SHA1, "SHA1", Sha1Policy::BLOCK_LENGTH, Sha1Policy::DIGEST_LENGTH,
+      &policyInit<Sha1Policy>, &policyUpdate<Sha1Policy>, &policyFinal<Sha1Policy>, &policyDigest<Sha1Policy> },
+    { HMACKEY_ALG_SHA256, "SHA256", Sha256Policy::BLOCK_LENGTH, Sha256Policy::DIGEST_LENGTH,
+      &policyInit<Sha256Policy>, &policyUpdate<Sha256Policy>, &policyFinal<Sha256Policy>, &policyDigest<Sha256Policy> },
+    { HMACKEY_ALG_SHA512, "SHA512", Sha512Policy::BLOCK_LENGTH, Sha512Policy::DIGEST_LENGTH,
+      &policyInit<Sha512Policy>, &policyUpdate<Sha512Policy>, &policyFinal<Sha512Policy>, &policyDigest<Sha512Policy> }
+};
+
+const size_t HMACALGORITHM_COUNT = sizeof(HMACALGORITHM_REGISTRY) / sizeof(HMACALGORITHM_REGISTRY[0]);
+
+/**
+ * @brief HmacAlgorithm::find - Get the descriptor for a hash algorithm.
+ *
+ * @param algorithm - One of the HMACKEY_ALG_* values.
+ *
+ * @return HmacAlgorithm pointer to the descriptor.  nullptr if the algorithm isn't known.
+ */
+const HmacAlgorithm *HmacAlgorithm::find(unsigned int algorithm)
+{
+    // The table is in HMACKEY_ALG_* order, so the algorithm is the index.
+    if ((algorithm >= HMACALGORITHM_COUNT) || (HMACALGORITHM_REGISTRY[algorithm].algorithm != algorithm)) {
+        return nullptr;
+    }
+
+    return &HMACALGORITHM_REGISTRY[algorithm];
+}
+
+/**
+ * @brief HmacAlgorithm::at - Get a descriptor by its position in the registry.
+ *
+ * @param index - A value of 0..(count() - 1).
+ *
+ * @return HmacAlgorithm pointer to the descriptor.  nullptr if the index is out of range.
+ */
+const HmacAlgorithm *HmacAlgorithm::at(size_t index)
+{
+    if (index >= HMACALGORITHM_COUNT) {
+        return nullptr;
+    }
+
+    return &HMACALGORITHM_REGISTRY[index];
+}
+
+/**
+ * @brief HmacAlgorithm::count - Get the number of algorithms in the registry.
+ *
+ * @return size_t containing the number of algorithms.
+ */
+size_t HmacAlgorithm::count()
+{
+    return HMACALGORITHM_COUNT;
+}
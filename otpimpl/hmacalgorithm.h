@@ -0,0 +1,33 @@
+#ifndef HMACALGORITHM_H
+#define HMACALGORITHM_H
+
+#include <cstdlib>
+
+#include "hmackey.h"
+
+/**
+ * @brief The HmacAlgorithm struct describes one of the hash algorithms that can be used for an
+ *      HMAC : its sizes, and the functions that run it on an HmacKey::HashState.
+ *
+ *      There is one constant descriptor per HMACKEY_ALG_* value, built at compile time from the
+ *      hash policies.  They are never changed, and hold no state of their own, so looking one up
+ *      doesn't allocate anything, and they can be used from any number of threads at once.
+ */
+struct HmacAlgorithm
+{
+    unsigned int algorithm;         // The matching HMACKEY_ALG_* value.
+    const char *name;
+    size_t blockLength;
+    size_t resultLength;
+
+    void (*init)(HmacKey::HashState &state);
+    void (*update)(HmacKey::HashState &state, const unsigned char *data, size_t dataLength);
+    void (*final)(HmacKey::HashState &state, unsigned char *result);
+    void (*digest)(const unsigned char *data, size_t dataLength, unsigned char *result);
+
+    static const HmacAlgorithm *find(unsigned int algorithm);
+    static const HmacAlgorithm *at(size_t index);
+    static size_t count();
+};
+
+#endif // HMACALGORITHM_H
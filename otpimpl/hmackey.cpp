@@ -0,0 +1,599 @@
+#include "hmackey.h"
+
+#include <cstring>
+#include <new>
+#include "../logger.h"
+#include "../container/securearena.h"
+#include "hmacalgorithm.h"
+#include "sha1multibuffer.h"
+#include "sha512multibuffer.h"
+
+/**
+ * @brief storeBigEndian - Write a 32 bit value to a byte buffer in big endian order.
+ *
+ * @param value - The value to write.
+ * @param data[OUT] - A pointer to the 4 bytes to write to.
+ */
+static inline void storeBigEndian(uint32_t value, unsigned char *data)
+{
+    data[0] = static_cast<unsigned char>((value >> 24) & 0xff);
+    data[1] = static_cast<unsigned char>((value >> 16) & 0xff);
+    data[2] = static_cast<unsigned char>((value >> 8) & 0xff);
+    data[3] = static_cast<unsigned char>(value & 0xff);
+}
+
+/**
+ * @brief storeBigEndian64 - Write a 64 bit value to a byte buffer in big endian order.
+ *
+ * @param value - The value to write.
+ * @param data[OUT] - A pointer to the 8 bytes to write to.
+ */
+static inline void storeBigEndian64(uint64_t value, unsigned char *data)
+{
+    storeBigEndian(static_cast<uint32_t>(value >> 32), &data[0]);
+    storeBigEndian(static_cast<uint32_t>(value & 0xffffffff), &data[4]);
+}
+
+/**
+ * @brief buildSha1FinalBlock - Build the last SHA1 block for a message that fits in a single
+ *      block after one block has already been hashed.
+ *
+ * @param data - The message bytes.
+ * @param dataLength - The length of the message.  Must be 55 bytes or less.
+ * @param block[OUT] - The 64 byte block to write to.
+ */
+static inline void buildSha1FinalBlock(const unsigned char *data, size_t dataLength, unsigned char block[64])
+{
+    // The pad block has already been hashed, so it counts toward the length.
+    uint64_t bitLength = (64 + static_cast<uint64_t>(dataLength)) * 8;
+
+    memset(block, 0x00, 64);
+    if (dataLength > 0) {
+        memcpy(block, data, dataLength);
+    }
+
+    block[dataLength] = 0x80;
+    storeBigEndian64(bitLength, &block[56]);
+}
+
+/**
+ * @brief buildSha512FinalBlock - Build the last SHA512 block for a message that fits in a
+ *      single block after one block has already been hashed.
+ *
+ * @param data - The message bytes.
+ * @param dataLength - The length of the message.  Must be 111 bytes or less.
+ * @param block[OUT] - The 128 byte block to write to.
+ */
+static inline void buildSha512FinalBlock(const unsigned char *data, size_t dataLength, unsigned char block[128])
+{
+    // The pad block has already been hashed, so it counts toward the length.  (The length is
+    // 128 bits, but the top half will always be 0 for us.)
+    uint64_t bitLength = (128 + static_cast<uint64_t>(dataLength)) * 8;
+
+    memset(block, 0x00, 128);
+    if (dataLength > 0) {
+        memcpy(block, data, dataLength);
+    }
+
+    block[dataLength] = 0x80;
+    storeBigEndian64(bitLength, &block[120]);
+}
+
+HmacKey::HmacKey()
+{
+    mStates = nullptr;
+    mSecureStates = false;
+    mHash = nullptr;
+    mAlgorithm = HMACKEY_ALG_SHA1;
+    mValid = false;
+}
+
+HmacKey::HmacKey(const HmacKey &toCopy)
+{
+    mStates = nullptr;
+    mSecureStates = false;
+    mHash = nullptr;
+    mAlgorithm = HMACKEY_ALG_SHA1;
+    mValid = false;
+
+    *this = toCopy;
+}
+
+HmacKey::~HmacKey()
+{
+    // The pad states are derived from the secret, so don't leave them laying around.
+    freeStates();
+}
+
+HmacKey &HmacKey::operator=(const HmacKey &toCopy)
+{
+    if (this == &toCopy) {
+        return *this;
+    }
+
+    clear();
+
+    mAlgorithm = toCopy.mAlgorithm;
+
+    if (!toCopy.mValid) {
+        return *this;
+    }
+
+    if (!allocateStates()) {
+        LOG_ERROR("Unable to allocate memory to copy the HMAC pad states in to!");
+        return *this;
+    }
+
+    *mStates = *toCopy.mStates;
+    mHash = toCopy.mHash;
+    mValid = true;
+
+    return *this;
+}
+
+/**
+ * @brief HmacKey::setKey - Calculate the inner and outer pad states for the provided key.
+ *
+ * @param algorithm - One of the HMACKEY_ALG_* values that indicates the hash algorithm to
+ *      use with the key.
+ * @param key - The DECODED key to calculate the pad states for.
+ *
+ * @return true if the pad states were calculated.  false on error.
+ */
+bool HmacKey::setKey(unsigned int algorithm, const ByteArray &key)
+{
+    return setKey(algorithm, key.toUCharArrayPtr(), key.size());
+}
+
+/**
+ * @brief HmacKey::setKey - Calculate the inner and outer pad states for the provided key.
+ *
+ * @param algorithm - One of the HMACKEY_ALG_* values that indicates the hash algorithm to
+ *      use with the key.
+ * @param key - A pointer to the DECODED key to calculate the pad states for.
+ * @param keyLength - The length of the data pointed to by \c key.
+ *
+ * @return true if the pad states were calculated.  false on error.
+ */
+bool HmacKey::setKey(unsigned int algorithm, const unsigned char *key, size_t keyLength)
+{
+    unsigned char padBlock[HMACKEY_MAX_BLOCK_LENGTH];
+    const HmacAlgorithm *hash;
+    size_t blockLength;
+
+    // Get rid of any existing state.
+    clear();
+
+    if ((nullptr == key) || (0 == keyLength)) {
+        LOG_ERROR("No key was provided to calculate the HMAC pad states from!");
+        return false;
+    }
+
+    hash = HmacAlgorithm::find(algorithm);
+    if (nullptr == hash) {
+        LOG_ERROR("Unknown hash algorithm identifier of " + QString::number(algorithm) + " while setting an HMAC key!");
+        return false;
+    }
+
+    if (!allocateStates()) {
+        LOG_ERROR("Unable to allocate memory for the HMAC pad states!");
+        return false;
+    }
+
+    blockLength = hash->blockLength;
+
+    memset(&padBlock, 0x00, sizeof(padBlock));
+
+    // If the key length is larger than one block, the hash of the key is used as the key.
+    if (keyLength > blockLength) {
+        hash->digest(key, keyLength, padBlock);
+    } else {
+        memcpy(&padBlock, key, keyLength);
+    }
+
+    // Hash the key XOR ipad block.
+    for (size_t i = 0; i < blockLength; i++) {
+        padBlock[i] ^= 0x36;
+    }
+
+    hash->init(mStates->inner);
+    hash->update(mStates->inner, padBlock, blockLength);
+
+    // Then, the key XOR opad block.  (Undo the ipad XOR, and apply the opad one.)
+    for (size_t i = 0; i < blockLength; i++) {
+        padBlock[i] ^= (0x36 ^ 0x5c);
+    }
+
+    hash->init(mStates->outer);
+    hash->update(mStates->outer, padBlock, blockLength);
+
+    // Don't leave the key material on the stack.
+    memset(&padBlock, 0x00, sizeof(padBlock));
+
+    mHash = hash;
+    mAlgorithm = algorithm;
+    mValid = true;
+
+    return true;
+}
+
+/**
+ * @brief HmacKey::clear - Zero the pad states, and mark this object as invalid.  The memory for
+ *      the states is kept, so setting another key doesn't need to allocate.
+ */
+void HmacKey::clear()
+{
+    if (nullptr != mStates) {
+        memset(mStates, 0x00, sizeof(PadStates));
+    }
+
+    mHash = nullptr;
+    mValid = false;
+}
+
+/**
+ * @brief HmacKey::valid - Check to see if a key has been set in this object.
+ *
+ * @return true if the pad states have been calculated.  false otherwise.
+ */
+bool HmacKey::valid() const
+{
+    return mValid;
+}
+
+/**
+ * @brief HmacKey::usingSecureBuffer - Check if the pad states are stored in the SecureArena.
+ *
+ * @return true if the pad states are in locked memory.  false if they are on the heap, or no
+ *      key has been set.
+ */
+bool HmacKey::usingSecureBuffer() const
+{
+    return ((nullptr != mStates) && (mSecureStates));
+}
+
+/**
+ * @brief HmacKey::algorithm - Return the hash algorithm the pad states were calculated with.
+ *
+ * @return unsigned int containing one of the HMACKEY_ALG_* values.
+ */
+unsigned int HmacKey::algorithm() const
+{
+    return mAlgorithm;
+}
+
+/**
+ * @brief HmacKey::resultLength - Return the length of an HMAC calculated with this key.
+ *
+ * @return size_t containing the length of the HMAC result.  If no key is set, 0 is returned.
+ */
+size_t HmacKey::resultLength() const
+{
+    if (!mValid) {
+        return 0;
+    }
+
+    return mHash->resultLength;
+}
+
+/**
+ * @brief HmacKey::calculate - Calculate the HMAC of the provided data using the key set in
+ *      this object.
+ *
+ * @param data - The data that we want to get the HMAC for.
+ *
+ * @return ByteArray containing the HMAC value.  On error, the ByteArray will be empty.
+ */
+ByteArray HmacKey::calculate(const ByteArray &data) const
+{
+    unsigned char hmacResult[HMACKEY_MAX_RESULT_LENGTH];
+    ByteArray result;
+
+    if (!calculate(data.toUCharArrayPtr(), data.size(), hmacResult, sizeof(hmacResult))) {
+        // Already logged the error.
+        return ByteArray();
+    }
+
+    result.fromUCharArray(hmacResult, resultLength());
+
+    return result;
+}
+
+/**
+ * @brief HmacKey::calculate - Calculate the HMAC of the provided data using the key set in
+ *      this object.  Since the pad blocks have already been hashed, this only needs to hash
+ *      the data and the inner hash result.
+ *
+ * @param data - A pointer to the data that we want to get the HMAC for.
+ * @param dataLength - The length of the data pointed to by \c data.
+ * @param result[OUT] - If this method returns true, this buffer will contain the HMAC value.
+ * @param resultSize - The size of the buffer pointed to by \c result.  It must be at least
+ *      resultLength() bytes long.
+ *
+ * @return true if the HMAC was calculated.  false on error.
+ */
+bool HmacKey::calculate(const unsigned char *data, size_t dataLength, unsigned char *result, size_t resultSize) const
+{
+    HashState state;
+    unsigned char innerHash[HMACKEY_MAX_RESULT_LENGTH];
+
+    if (!mValid) {
+        LOG_ERROR("Attempted to calculate an HMAC without setting a key!");
+        return false;
+    }
+
+    if ((nullptr == result) || (resultSize < mHash->resultLength)) {
+        LOG_ERROR("The buffer provided for the HMAC result is too small!");
+        return false;
+    }
+
+    if ((nullptr == data) && (0 != dataLength)) {
+        LOG_ERROR("No data was provided to calculate the HMAC for!");
+        return false;
+    }
+
+    // Calculate Hash(key XOR opad, Hash(key XOR ipad, data)), starting each hash from
+    // the stored pad state.
+    state = mStates->inner;
+    mHash->update(state, data, dataLength);
+    mHash->final(state, innerHash);
+
+    state = mStates->outer;
+    mHash->update(state, innerHash, mHash->resultLength);
+    mHash->final(state, result);
+
+    // Clean up the intermediate values.
+    memset(&state, 0x00, sizeof(state));
+    memset(&innerHash, 0x00, sizeof(innerHash));
+
+    return true;
+}
+
+/**
+ * @brief HmacKey::calculateMany - Calculate the HMACs of several equal length messages, each
+ *      with its own key.  SHA1 and SHA512 keys with messages that fit in a single block are run
+ *      through the multi-buffer hash code several at a time.  Anything else is calculated one at
+ *      a time.
+ *
+ * @param keys - The keys to use.  One for each message.
+ * @param data - The messages to calculate the HMACs for.
+ * @param dataLength - The length of each message.
+ * @param count - The number of keys, messages, and results.
+ * @param results[OUT] - If this method returns true, each buffer will contain the HMAC of the
+ *      matching message.  Each buffer must be at least resultLength() bytes long for its key.
+ *
+ * @return true if all of the HMACs were calculated.  false on error.
+ */
+bool HmacKey::calculateMany(const HmacKey *const keys[], const unsigned char *const data[], size_t dataLength, size_t count, unsigned char *const results[])
+{
+    size_t sha1Indexes[SHA1MULTIBUFFER_MAX_LANES];
+    size_t sha512Indexes[SHA512MULTIBUFFER_MAX_LANES];
+    size_t sha1Pending = 0;
+    size_t sha512Pending = 0;
+
+    if ((nullptr == keys) || (nullptr == data) || (nullptr == results)) {
+        LOG_ERROR("Invalid parameters provided to calculate a batch of HMACs!");
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if ((nullptr == keys[i]) || (!keys[i]->valid()) || (nullptr == results[i]) || ((nullptr == data[i]) && (0 != dataLength))) {
+            LOG_ERROR("Invalid key, data, or result buffer provided to calculate a batch of HMACs!");
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        // Queue up the ones that can be done in parallel, and run the lanes once we have enough
+        // to fill them.
+        if ((HMACKEY_ALG_SHA1 == keys[i]->mAlgorithm) && (dataLength <= HMACKEY_SHA1_MULTIBUFFER_MAX_DATA_LENGTH)) {
+            sha1Indexes[sha1Pending] = i;
+            sha1Pending++;
+
+            if (SHA1MULTIBUFFER_MAX_LANES == sha1Pending) {
+                calculateSha1Lanes(keys, data, dataLength, sha1Indexes, sha1Pending, results);
+                sha1Pending = 0;
+            }
+        } else if ((HMACKEY_ALG_SHA512 == keys[i]->mAlgorithm) && (dataLength <= HMACKEY_SHA512_MULTIBUFFER_MAX_DATA_LENGTH)) {
+            sha512Indexes[sha512Pending] = i;
+            sha512Pending++;
+
+            if (SHA512MULTIBUFFER_MAX_LANES == sha512Pending) {
+                calculateSha512Lanes(keys, data, dataLength, sha512Indexes, sha512Pending, results);
+                sha512Pending = 0;
+            }
+        } else if (!keys[i]->calculate(data[i], dataLength, results[i], keys[i]->resultLength())) {
+            // Can't be done in parallel, and doing it the normal way failed.  (Already logged.)
+            return false;
+        }
+    }
+
+    if (sha1Pending > 0) {
+        calculateSha1Lanes(keys, data, dataLength, sha1Indexes, sha1Pending, results);
+    }
+
+    if (sha512Pending > 0) {
+        calculateSha512Lanes(keys, data, dataLength, sha512Indexes, sha512Pending, results);
+    }
+
+    return true;
+}
+
+/**
+ * @brief HmacKey::calculateSha1Lanes - Calculate up to SHA1MULTIBUFFER_MAX_LANES SHA1 HMACs in
+ *      parallel.  Since the pad states are already calculated, and the messages fit in a single
+ *      block, each HMAC is one inner, and one outer, compression.
+ *
+ * @param keys - The keys to use.  They must all be valid SHA1 keys.
+ * @param data - The messages to calculate the HMACs for.
+ * @param dataLength - The length of each message.  Must be 55 bytes or less.
+ * @param indexes - The indexes in to \c keys, \c data, and \c results to calculate.
+ * @param count - The number of entries in \c indexes.
+ * @param results[OUT] - The HMAC results.
+ */
+void HmacKey::calculateSha1Lanes(const HmacKey *const keys[], const unsigned char *const data[], size_t dataLength, const size_t indexes[], size_t count, unsigned char *const results[])
+{
+    uint32_t states[SHA1MULTIBUFFER_MAX_LANES][5];
+    unsigned char blocks[SHA1MULTIBUFFER_MAX_LANES][64];
+    uint32_t *statePtrs[SHA1MULTIBUFFER_MAX_LANES];
+    const unsigned char *blockPtrs[SHA1MULTIBUFFER_MAX_LANES];
+    unsigned char innerHash[20];
+    size_t index;
+
+    for (size_t lane = 0; lane < SHA1MULTIBUFFER_MAX_LANES; lane++) {
+        statePtrs[lane] = states[lane];
+        blockPtrs[lane] = blocks[lane];
+    }
+
+    // Run the messages through, starting from the inner pad state.
+    for (size_t lane = 0; lane < count; lane++) {
+        index = indexes[lane];
+
+        memcpy(&states[lane], keys[index]->mStates->inner.sha1.state, sizeof(states[lane]));
+        buildSha1FinalBlock(data[index], dataLength, blocks[lane]);
+    }
+
+    Sha1MultiBuffer::transform(statePtrs, blockPtrs, count);
+
+    // Then the inner hash results, starting from the outer pad state.
+    for (size_t lane = 0; lane < count; lane++) {
+        index = indexes[lane];
+
+        for (size_t i = 0; i < 5; i++) {
+            storeBigEndian(states[lane][i], &innerHash[i * 4]);
+        }
+        buildSha1FinalBlock(innerHash, sizeof(innerHash), blocks[lane]);
+
+        memcpy(&states[lane], keys[index]->mStates->outer.sha1.state, sizeof(states[lane]));
+    }
+
+    Sha1MultiBuffer::transform(statePtrs, blockPtrs, count);
+
+    for (size_t lane = 0; lane < count; lane++) {
+        for (size_t i = 0; i < 5; i++) {
+            storeBigEndian(states[lane][i], &results[indexes[lane]][i * 4]);
+        }
+    }
+
+    // Clean up the intermediate values.
+    memset(&states, 0x00, sizeof(states));
+    memset(&blocks, 0x00, sizeof(blocks));
+    memset(&innerHash, 0x00, sizeof(innerHash));
+}
+
+/**
+ * @brief HmacKey::calculateSha512Lanes - Calculate up to SHA512MULTIBUFFER_MAX_LANES SHA512
+ *      HMACs in parallel.  Since the pad states are already calculated, and the messages fit in
+ *      a single block, each HMAC is one inner, and one outer, compression.
+ *
+ * @param keys - The keys to use.  They must all be valid SHA512 keys.
+ * @param data - The messages to calculate the HMACs for.
+ * @param dataLength - The length of each message.  Must be 111 bytes or less.
+ * @param indexes - The indexes in to \c keys, \c data, and \c results to calculate.
+ * @param count - The number of entries in \c indexes.
+ * @param results[OUT] - The HMAC results.
+ */
+void HmacKey::calculateSha512Lanes(const HmacKey *const keys[], const unsigned char *const data[], size_t dataLength, const size_t indexes[], size_t count, unsigned char *const results[])
+{
+    uint64_t states[SHA512MULTIBUFFER_MAX_LANES][8];
+    unsigned char blocks[SHA512MULTIBUFFER_MAX_LANES][SHA512_BLOCK_SIZE];
+    uint64_t *statePtrs[SHA512MULTIBUFFER_MAX_LANES];
+    const unsigned char *blockPtrs[SHA512MULTIBUFFER_MAX_LANES];
+    unsigned char innerHash[SHA512_DIGEST_SIZE];
+    size_t index;
+
+    for (size_t lane = 0; lane < SHA512MULTIBUFFER_MAX_LANES; lane++) {
+        statePtrs[lane] = states[lane];
+        blockPtrs[lane] = blocks[lane];
+    }
+
+    // Run the messages through, starting from the inner pad state.
+    for (size_t lane = 0; lane < count; lane++) {
+        index = indexes[lane];
+
+        for (size_t i = 0; i < 8; i++) {
+            states[lane][i] = keys[index]->mStates->inner.sha512.h[i];
+        }
+        buildSha512FinalBlock(data[index], dataLength, blocks[lane]);
+    }
+
+    Sha512MultiBuffer::transform(statePtrs, blockPtrs, count);
+
+    // Then the inner hash results, starting from the outer pad state.
+    for (size_t lane = 0; lane < count; lane++) {
+        index = indexes[lane];
+
+        for (size_t i = 0; i < 8; i++) {
+            storeBigEndian64(states[lane][i], &innerHash[i * 8]);
+        }
+        buildSha512FinalBlock(innerHash, sizeof(innerHash), blocks[lane]);
+
+        for (size_t i = 0; i < 8; i++) {
+            states[lane][i] = keys[index]->mStates->outer.sha512.h[i];
+        }
+    }
+
+    Sha512MultiBuffer::transform(statePtrs, blockPtrs, count);
+
+    for (size_t lane = 0; lane < count; lane++) {
+        for (size_t i = 0; i < 8; i++) {
+            storeBigEndian64(states[lane][i], &results[indexes[lane]][i * 8]);
+        }
+    }
+
+    // Clean up the intermediate values.
+    memset(&states, 0x00, sizeof(states));
+    memset(&blocks, 0x00, sizeof(blocks));
+    memset(&innerHash, 0x00, sizeof(innerHash));
+}
+
+/**
+ * @brief HmacKey::allocateStates - Make sure there is memory for the pad states.  It comes from
+ *      the SecureArena if possible, and the heap if the arena is out of memory.
+ *
+ * @return true if mStates points to memory for the pad states.  false on error.
+ */
+bool HmacKey::allocateStates()
+{
+    if (nullptr != mStates) {
+        // Already have it.
+        return true;
+    }
+
+    mStates = static_cast<PadStates *>(SecureArena::getInstance()->allocate(sizeof(PadStates)));
+    if (nullptr != mStates) {
+        mSecureStates = true;
+    } else {
+        mStates = new (std::nothrow) PadStates;
+        mSecureStates = false;
+    }
+
+    if (nullptr == mStates) {
+        return false;
+    }
+
+    memset(mStates, 0x00, sizeof(PadStates));
+
+    return true;
+}
+
+/**
+ * @brief HmacKey::freeStates - Zero, and free, the memory for the pad states.
+ */
+void HmacKey::freeStates()
+{
+    clear();
+
+    if (nullptr == mStates) {
+        return;
+    }
+
+    if (mSecureStates) {
+        SecureArena::getInstance()->release(mStates);
+    } else {
+        delete mStates;
+    }
+
+    mStates = nullptr;
+    mSecureStates = false;
+}
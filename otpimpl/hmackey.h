@@ -0,0 +1,87 @@
+#ifndef HMACKEY_H
+#define HMACKEY_H
+
+#include <cstdlib>
+#include "container/bytearray.h"
+
+extern "C" {
+#include "sha1impl.h"                   //NOSONAR
+#include "sha2.h"                       //NOSONAR
+}
+
+const unsigned int HMACKEY_ALG_SHA1=0;
+const unsigned int HMACKEY_ALG_SHA256=1;
+const unsigned int HMACKEY_ALG_SHA512=2;
+
+const size_t HMACKEY_MAX_BLOCK_LENGTH=128;     // The largest block size of the supported hashes. (SHA512)
+const size_t HMACKEY_MAX_RESULT_LENGTH=64;     // The largest result size of the supported hashes. (SHA512)
+const size_t HMACKEY_SHA1_MULTIBUFFER_MAX_DATA_LENGTH=55;     // The most data that fits in the final SHA1 block with the padding.
+const size_t HMACKEY_SHA512_MULTIBUFFER_MAX_DATA_LENGTH=111;  // The most data that fits in the final SHA512 block with the padding.
+
+struct HmacAlgorithm;
+
+/**
+ * @brief The HmacKey class holds the hash states that result from running the key XOR ipad, and
+ *      key XOR opad blocks through the compression function.  Since those states never change for
+ *      a given key, they can be calculated once and reused for every HMAC calculated with the key.
+ *
+ *      The states are enough to calculate any code for the key, so they are kept in the
+ *      SecureArena, rather than in the object itself.
+ */
+class HmacKey
+{
+public:
+    HmacKey();
+    HmacKey(const HmacKey &toCopy);
+    ~HmacKey();
+
+    HmacKey &operator=(const HmacKey &toCopy);
+
+    bool setKey(unsigned int algorithm, const ByteArray &key);
+    bool setKey(unsigned int algorithm, const unsigned char *key, size_t keyLength);
+
+    void clear();
+    bool valid() const;
+    bool usingSecureBuffer() const;
+
+    unsigned int algorithm() const;
+    size_t resultLength() const;
+
+    ByteArray calculate(const ByteArray &data) const;
+    bool calculate(const unsigned char *data, size_t dataLength, unsigned char *result, size_t resultSize) const;
+
+    static bool calculateMany(const HmacKey *const keys[], const unsigned char *const data[], size_t dataLength, size_t count, unsigned char *const results[]);
+
+    // The hash state after the key pad block has been hashed.
+    union HashState {
+        SHA1_CTX sha1;
+        sha256_ctx sha256;
+        sha512_ctx sha512;
+    };
+
+private:
+    // The compile time HMAC code reads the pad states directly.
+    template <typename HashPolicy> friend class HmacT;
+
+    struct PadStates {
+        HashState inner;
+        HashState outer;
+    };
+
+    bool allocateStates();
+    void freeStates();
+
+    const HashState &innerState() const { return mStates->inner; }
+    const HashState &outerState() const { return mStates->outer; }
+
+    static void calculateSha1Lanes(const HmacKey *const keys[], const unsigned char *const data[], size_t dataLength, const size_t indexes[], size_t count, unsigned char *const results[]);
+    static void calculateSha512Lanes(const HmacKey *const keys[], const unsigned char *const data[], size_t dataLength, const size_t indexes[], size_t count, unsigned char *const results[]);
+
+    PadStates *mStates;                 // Allocated the first time a key is set.
+    bool mSecureStates;                 // true if mStates came from the SecureArena.
+    const HmacAlgorithm *mHash;         // The descriptor for mAlgorithm.  (Set when the key is valid.)
+    unsigned int mAlgorithm;
+    bool mValid;
+};
+
+#endif // HMACKEY_H
@@ -0,0 +1,191 @@
+#ifndef HMACT_H
+#define HMACT_H
+
+#include <cstdlib>
+#include <cstring>
+
+#include "hashpolicies.h"
+#include "hmackey.h"
+
+/**
+ * @brief The HmacT class is a compile time version of HmacKey for a single hash.  The block
+ *      and digest sizes are constants, and the hash functions are called directly, so the
+ *      whole HMAC can be inlined and unrolled by the compiler.
+ *
+ *      Like HmacKey, the key pad states are calculated once in setKey(), and reused for each
+ *      HMAC.  The static calculate() can also use the pad states already cached in an HmacKey.
+ */
+template <typename HashPolicy>
+class HmacT
+{
+public:
+    typedef typename HashPolicy::Context Context;
+
+    HmacT()
+    {
+        clear();
+    }
+
+    ~HmacT()
+    {
+        clear();
+    }
+
+    /**
+     * @brief HmacT::setKey - Calculate the pad states for the provided key.
+     *
+     * @param key - The (decoded) key to use.
+     * @param keyLength - The length of \c key.
+     *
+     * @return true if the key was set.  false on error.
+     */
+    bool setKey(const unsigned char *key, size_t keyLength)
+    {
+        unsigned char padBlock[HashPolicy::BLOCK_LENGTH];
+        Context ctx;
+
+        clear();
+
+        if ((nullptr == key) || (0 == keyLength)) {
+            return false;
+        }
+
+        memset(&padBlock, 0x00, sizeof(padBlock));
+
+        // If the key length is larger than one block, the hash of the key is used as the key.
+        if (keyLength > HashPolicy::BLOCK_LENGTH) {
+            HashPolicy::init(ctx);
+            HashPolicy::update(ctx, key, keyLength);
+            HashPolicy::final(ctx, padBlock);
+        } else {
+            memcpy(&padBlock, key, keyLength);
+        }
+
+        for (size_t i = 0; i < HashPolicy::BLOCK_LENGTH; i++) {
+            padBlock[i] ^= 0x36;
+        }
+
+        HashPolicy::init(mInnerState);
+        HashPolicy::update(mInnerState, padBlock, HashPolicy::BLOCK_LENGTH);
+
+        // Undo the ipad XOR, and apply the opad one.
+        for (size_t i = 0; i < HashPolicy::BLOCK_LENGTH; i++) {
+            padBlock[i] ^= (0x36 ^ 0x5c);
+        }
+
+        HashPolicy::init(mOuterState);
+        HashPolicy::update(mOuterState, padBlock, HashPolicy::BLOCK_LENGTH);
+
+        // Don't leave the key material on the stack.
+        memset(&padBlock, 0x00, sizeof(padBlock));
+        memset(&ctx, 0x00, sizeof(ctx));
+
+        mValid = true;
+        return true;
+    }
+
+    /**
+     * @brief HmacT::setKey - Copy the pad states from an HmacKey that uses the same hash.
+     *
+     * @param key - The HmacKey to copy the pad states from.
+     *
+     * @return true if the key was set.  false if the key isn't valid, or uses another hash.
+     */
+    bool setKey(const HmacKey &key)
+    {
+        clear();
+
+        if ((!key.valid()) || (HashPolicy::ALGORITHM != key.algorithm())) {
+            return false;
+        }
+
+        mInnerState = HashPolicy::padState(key.innerState());
+        mOuterState = HashPolicy::padState(key.outerState());
+        mValid = true;
+
+        return true;
+    }
+
+    /**
+     * @brief HmacT::clear - Zero the pad states, and mark this object as invalid.
+     */
+    void clear()
+    {
+        memset(&mInnerState, 0x00, sizeof(mInnerState));
+        memset(&mOuterState, 0x00, sizeof(mOuterState));
+        mValid = false;
+    }
+
+    bool valid() const
+    {
+        return mValid;
+    }
+
+    /**
+     * @brief HmacT::calculate - Calculate the HMAC of the provided data.
+     *
+     * @param data - The data to calculate the HMAC of.
+     * @param dataLength - The length of \c data.
+     * @param result[OUT] - If this method returns true, the HMAC.
+     *
+     * @return true if the HMAC was calculated.  false on error.
+     */
+    bool calculate(const unsigned char *data, size_t dataLength, unsigned char result[HashPolicy::DIGEST_LENGTH]) const
+    {
+        if ((!mValid) || (nullptr == result) || ((nullptr == data) && (0 != dataLength))) {
+            return false;
+        }
+
+        calculateFromStates(mInnerState, mOuterState, data, dataLength, result);
+        return true;
+    }
+
+    /**
+     * @brief HmacT::calculate - Calculate the HMAC of the provided data, using the pad states
+     *      cached in an HmacKey.  Nothing is copied out of the key.
+     *
+     * @param key - The HmacKey to use.  It must use the same hash as this class.
+     * @param data - The data to calculate the HMAC of.
+     * @param dataLength - The length of \c data.
+     * @param result[OUT] - If this method returns true, the HMAC.
+     *
+     * @return true if the HMAC was calculated.  false on error.
+     */
+    static bool calculate(const HmacKey &key, const unsigned char *data, size_t dataLength, unsigned char result[HashPolicy::DIGEST_LENGTH])
+    {
+        if ((!key.valid()) || (HashPolicy::ALGORITHM != key.algorithm()) || (nullptr == result) || ((nullptr == data) && (0 != dataLength))) {
+            return false;
+        }
+
+        calculateFromStates(HashPolicy::padState(key.innerState()), HashPolicy::padState(key.outerState()), data, dataLength, result);
+        return true;
+    }
+
+private:
+    /**
+     * @brief HmacT::calculateFromStates - Calculate Hash(key XOR opad, Hash(key XOR ipad, data)),
+     *      starting each hash from the provided pad state.
+     */
+    static inline void calculateFromStates(const Context &innerState, const Context &outerState, const unsigned char *data, size_t dataLength, unsigned char result[HashPolicy::DIGEST_LENGTH])
+    {
+        unsigned char innerHash[HashPolicy::DIGEST_LENGTH];
+        Context ctx = innerState;
+
+        HashPolicy::update(ctx, data, dataLength);
+        HashPolicy::final(ctx, innerHash);
+
+        ctx = outerState;
+        HashPolicy::update(ctx, innerHash, HashPolicy::DIGEST_LENGTH);
+        HashPolicy::final(ctx, result);
+
+        // Clean up the intermediate values.
+        memset(&ctx, 0x00, sizeof(ctx));
+        memset(&innerHash, 0x00, sizeof(innerHash));
+    }
+
+    Context mInnerState;
+    Context mOuterState;
+    bool mValid;
+};
+
+#endif // HMACT_H
@@ -1,6 +1,7 @@
 #include "hotp.h"
 
 #include "hmac.h"
+#include "otpcode.h"
 #include "sha1hash.h"
 #include "../logger.h"
 
@@ -9,7 +10,7 @@ Hotp::Hotp()
     mHmacToUse = nullptr;
 }
 
-Hotp::Hotp(std::shared_ptr<Hmac> &hmacToUse) :
+Hotp::Hotp(const std::shared_ptr<Hmac> &hmacToUse) :
     mHmacToUse(hmacToUse)
 {
 }
@@ -22,7 +23,7 @@ Hotp::Hotp(std::shared_ptr<Hmac> &hmacToUse) :
  *      will delete it in the dtor.  If false, the caller is responsible for freeing the
  *      HMAC object when it knows it is no longer in use.
  */
-void Hotp::setHmac(std::shared_ptr<Hmac> &hmacToUse)
+void Hotp::setHmac(const std::shared_ptr<Hmac> &hmacToUse)
 {
     // Set the new values to use.
     mHmacToUse = hmacToUse;
@@ -46,7 +47,6 @@ std::string Hotp::calculate(const ByteArray &key, uint64_t counter, size_t digit
 {
     unsigned char number[8];
     ByteArray baNumber;
-    unsigned char inverse;
     std::shared_ptr<ByteArray> calcResult;
 
     // Validate inputs.
@@ -67,12 +67,7 @@ std::string Hotp::calculate(const ByteArray &key, uint64_t counter, size_t digit
         return "";
     }
 
-    // Convert the value of the counter to an unsigned char *, without worrying about endianness.
-    inverse = 7;
-    for (size_t i = 0; i < 8; i++) {        // A 64 bit number is 8 bytes.
-        number[i] = ((counter >> (inverse * 8)) & 0xff);
-        inverse--;
-    }
+    OtpCode::counterToBytes(counter, number);
 
     baNumber.fromCharArray(reinterpret_cast<char *>(number), sizeof(number));
 
@@ -86,6 +81,56 @@ std::string Hotp::calculate(const ByteArray &key, uint64_t counter, size_t digit
     return calculateHotpFromHmac((*calcResult.get()), digits, addChecksum, truncationOffset);
 }
 
+/**
+ * @brief Hotp::calculate - Calculate and return an HOTP value using a key whose HMAC pad states
+ *      have already been calculated.
+ *
+ * @param key - The HmacKey to use.  (Its hash algorithm is used instead of the HMAC object
+ *      set on this object.)
+ * @param counter - The counter value to use.
+ * @param digits - The number of digits to calculate.
+ * @param addChecksum - true to include a checksum in the HOTP calculation.
+ *      false otherwise.
+ * @param truncationOffset - The offset in to the HOTP that we should truncate to
+ *      come up with the HOTP value.
+ *
+ * @return std::string containing the HOTP value.  On error, this string will be
+ *      empty.
+ */
+std::string Hotp::calculate(const HmacKey &key, uint64_t counter, size_t digits, bool addChecksum, int truncationOffset)
+{
+    char code[OTPCODE_BUFFER_SIZE];
+    unsigned char number[8];
+    ByteArray calcResult;
+
+    if (!addChecksum) {
+        // Use the allocation free calculation.
+        if (!OtpCode::hotp(key, counter, digits, code, truncationOffset)) {
+            // Already logged the error.
+            return "";
+        }
+
+        return std::string(code);
+    }
+
+    // Validate inputs.
+    if (!key.valid()) {
+        LOG_ERROR("An HMAC key without a secret was provided for the HOTP calculation!");
+        return "";
+    }
+
+    OtpCode::counterToBytes(counter, number);
+
+    // Calculate the HMAC of the counter.
+    calcResult = key.calculate(ByteArray(reinterpret_cast<char *>(number), sizeof(number)));
+    if (calcResult.empty()) {
+        LOG_ERROR("Failed to caculate HMAC portion of the HOTP!");
+        return "";
+    }
+
+    return calculateHotpFromHmac(calcResult, digits, addChecksum, truncationOffset);
+}
+
 /**
  * @brief Hotp::calculateHotpFromHmac - Calculate the HOTP from the HMAC that was calculated against the
  *      key and counter that were originally passed in.
@@ -101,6 +146,7 @@ std::string Hotp::calculate(const ByteArray &key, uint64_t counter, size_t digit
 std::string Hotp::calculateHotpFromHmac(const ByteArray &hmac, size_t digits, bool addChecksum, int truncationOffset)
 {
     int64_t DIGITS_POWER[9] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+    char code[OTPCODE_BUFFER_SIZE];
     ByteArray truncValue;
     size_t calcDigits;
     int32_t truncData;
@@ -118,6 +164,16 @@ std::string Hotp::calculateHotpFromHmac(const ByteArray &hmac, size_t digits, bo
         return "";
     }
 
+    if (!addChecksum) {
+        // Use the allocation free calculation.
+        if (!OtpCode::codeFromHmac(hmac.toUCharArrayPtr(), hmac.size(), digits, truncationOffset, code)) {
+            // Already logged the error.
+            return "";
+        }
+
+        return std::string(code);
+    }
+
     // Figure out how many digits to calculate.
     calcDigits = addChecksum ? (digits + 1) : digits;
 
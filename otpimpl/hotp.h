@@ -6,16 +6,18 @@
 #include <cstdint>
 
 #include "hmac.h"
+#include "hmackey.h"
 
 class Hotp
 {
 public:
     Hotp();
-    explicit Hotp(std::shared_ptr<Hmac> &hmacToUse);
+    explicit Hotp(const std::shared_ptr<Hmac> &hmacToUse);
 
-    void setHmac(std::shared_ptr<Hmac> &hmacToUse);
+    void setHmac(const std::shared_ptr<Hmac> &hmacToUse);
 
     std::string calculate(const ByteArray &key, uint64_t counter, size_t digits, bool addChecksum = false, int truncationOffset = -1);
+    std::string calculate(const HmacKey &key, uint64_t counter, size_t digits, bool addChecksum = false, int truncationOffset = -1);
 
 private:
     std::string calculateSha1Hotp(unsigned char *key, size_t keyLength, uint64_t counter, size_t digits, bool addChecksum, int truncationOffset);
@@ -0,0 +1,217 @@
+#include "hotpresync.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "otpcode.h"
+#include "totpverifier.h"
+#include "../logger.h"
+
+/**
+ * @brief HotpResync::search - Search for the first counter in [startCounter, startCounter +
+ *      window] that generates the provided code(s).
+ *
+ * @param key - The HmacKey for the token's secret.
+ * @param digits - The number of digits in the codes.  (6, 7, or 8)
+ * @param codes - The null terminated codes from the token, in the order they were generated.
+ *      With two codes, both have to match consecutive counters, which makes a false match
+ *      much less likely over a large window.
+ * @param codeCount - The number of codes.  (1 or 2)
+ * @param startCounter - The first counter to check.  (Normally the stored HOTP counter.)
+ * @param window - The number of counters past \c startCounter to check.
+ * @param matchedCounter[OUT] - If this method returns true, the counter that generated the first
+ *      code.  The token's next counter is (matchedCounter + codeCount).
+ * @param threads - The number of worker threads to use.  0 uses one per CPU core.
+ *
+ * @return true if a matching counter was found.  false if it wasn't, or on error.
+ */
+bool HotpResync::search(const HmacKey &key, size_t digits, const char *const codes[], size_t codeCount, uint64_t startCounter, uint64_t window, uint64_t &matchedCounter, size_t threads)
+{
+    std::atomic<uint64_t> nextChunk(0);
+    std::atomic<uint64_t> bestOffset(UINT64_MAX);
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> workers;
+    uint64_t chunkCount;
+
+    if ((!key.valid()) || (nullptr == codes) || (0 == codeCount) || (codeCount > HOTPRESYNC_MAX_CODES)) {
+        LOG_ERROR("Invalid parameters provided to resync an HOTP counter!");
+        return false;
+    }
+
+    if ((digits < 6) || (digits > 8)) {
+        LOG_ERROR("An invalid number of digits was requested!  It must be 6, 7, or 8!");
+        return false;
+    }
+
+    if (window > HOTPRESYNC_MAX_WINDOW) {
+        LOG_ERROR("The HOTP resync window can't be larger than " + QString::number(HOTPRESYNC_MAX_WINDOW) + "!");
+        return false;
+    }
+
+    if ((UINT64_MAX - startCounter) < (window + codeCount)) {
+        LOG_ERROR("The HOTP resync window runs past the end of the counter!");
+        return false;
+    }
+
+    for (size_t i = 0; i < codeCount; i++) {
+        if ((nullptr == codes[i]) || (strlen(codes[i]) != digits)) {
+            LOG_ERROR("The codes to resync the HOTP counter with must have " + QString::number(digits) + " digits!");
+            return false;
+        }
+    }
+
+    if (0 == threads) {
+        threads = defaultThreadCount();
+    }
+
+    // There is no point in having more threads than chunks.
+    chunkCount = ((window + 1) + (HOTPRESYNC_CHUNK_SIZE - 1)) / HOTPRESYNC_CHUNK_SIZE;
+    if (threads > chunkCount) {
+        threads = static_cast<size_t>(chunkCount);
+    }
+
+    // The calling thread does a share of the work too.
+    for (size_t i = 1; i < threads; i++) {
+        workers.push_back(std::thread(searchWorker, &key, digits, codes, codeCount, startCounter, window, &nextChunk, &bestOffset, &failed));
+    }
+
+    searchWorker(&key, digits, codes, codeCount, startCounter, window, &nextChunk, &bestOffset, &failed);
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+
+    if (failed) {
+        LOG_ERROR("Unable to calculate the HOTP codes to resync the counter!");
+        return false;
+    }
+
+    if (UINT64_MAX == bestOffset) {
+        return false;
+    }
+
+    matchedCounter = startCounter + bestOffset;
+    return true;
+}
+
+/**
+ * @brief HotpResync::defaultThreadCount - Get the number of threads to use when none is
+ *      specified.
+ *
+ * @return size_t containing the number of CPU cores.  (At least 1.)
+ */
+size_t HotpResync::defaultThreadCount()
+{
+    unsigned int cores = std::thread::hardware_concurrency();
+
+    return (0 == cores) ? 1 : cores;
+}
+
+/**
+ * @brief HotpResync::searchWorker - Take chunks of counters, in order, until the window is used
+ *      up, a match is found below the next chunk, or something fails.
+ *
+ * @param key - The HmacKey for the token's secret.
+ * @param digits - The number of digits in the codes.
+ * @param codes - The codes from the token.
+ * @param codeCount - The number of codes.
+ * @param startCounter - The first counter in the window.
+ * @param window - The number of counters past \c startCounter to check.
+ * @param nextChunk - The index of the next chunk that hasn't been taken by a worker.
+ * @param bestOffset - The lowest offset (from \c startCounter) that matched so far.
+ * @param failed - Set to true if any worker fails.
+ */
+void HotpResync::searchWorker(const HmacKey *key, size_t digits, const char *const *codes, size_t codeCount, uint64_t startCounter, uint64_t window, std::atomic<uint64_t> *nextChunk, std::atomic<uint64_t> *bestOffset, std::atomic<bool> *failed)
+{
+    const HmacKey *keys[HOTPRESYNC_CHUNK_SIZE];
+    uint64_t counters[HOTPRESYNC_CHUNK_SIZE];
+    char results[HOTPRESYNC_CHUNK_SIZE][OTPCODE_BUFFER_SIZE];
+    char *resultPtrs[HOTPRESYNC_CHUNK_SIZE];
+    uint64_t first;
+    uint64_t current;
+    size_t count;
+    bool matched;
+
+    for (size_t i = 0; i < HOTPRESYNC_CHUNK_SIZE; i++) {
+        keys[i] = key;
+        resultPtrs[i] = results[i];
+    }
+
+    while (!failed->load()) {
+        first = nextChunk->fetch_add(1) * HOTPRESYNC_CHUNK_SIZE;
+
+        // Chunks are taken in order, so once we pass the end of the window, or a match that has
+        // already been found, there is nothing left to do.
+        if ((first > window) || (first > bestOffset->load())) {
+            break;
+        }
+
+        count = ((window - first) < HOTPRESYNC_CHUNK_SIZE) ? static_cast<size_t>((window - first) + 1) : HOTPRESYNC_CHUNK_SIZE;
+
+        for (size_t i = 0; i < count; i++) {
+            counters[i] = startCounter + first + i;
+        }
+
+        if (!OtpCode::hotpMany(keys, counters, count, digits, resultPtrs)) {
+            failed->store(true);
+            break;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (!TotpVerifier::constantTimeEquals(results[i], codes[0], digits)) {
+                continue;
+            }
+
+            if (!followingCodesMatch(*key, digits, codes, codeCount, counters[i], matched)) {
+                failed->store(true);
+                break;
+            }
+
+            if (!matched) {
+                continue;
+            }
+
+            // Keep the lowest match.
+            current = bestOffset->load();
+            while (((first + i) < current) && (!bestOffset->compare_exchange_weak(current, first + i))) {
+                // current was updated by compare_exchange_weak(), so just check again.
+            }
+            break;
+        }
+    }
+
+    // Clean up.
+    memset(&results, 0x00, sizeof(results));
+}
+
+/**
+ * @brief HotpResync::followingCodesMatch - Check the codes after the first one against the
+ *      counters that follow the one that matched.
+ *
+ * @param key - The HmacKey for the token's secret.
+ * @param digits - The number of digits in the codes.
+ * @param codes - The codes from the token.
+ * @param codeCount - The number of codes.
+ * @param counter - The counter that matched the first code.
+ * @param matched[OUT] - If this method returns true, whether all of the following codes matched.
+ *
+ * @return true if the codes were checked.  false on error.
+ */
+bool HotpResync::followingCodesMatch(const HmacKey &key, size_t digits, const char *const codes[], size_t codeCount, uint64_t counter, bool &matched)
+{
+    char code[OTPCODE_BUFFER_SIZE];
+
+    matched = true;
+
+    for (size_t i = 1; (matched) && (i < codeCount); i++) {
+        if (!OtpCode::hotp(key, counter + i, digits, code)) {
+            return false;
+        }
+
+        matched = TotpVerifier::constantTimeEquals(code, codes[i], digits);
+    }
+
+    memset(&code, 0x00, sizeof(code));
+
+    return true;
+}
@@ -0,0 +1,36 @@
+#ifndef HOTPRESYNC_H
+#define HOTPRESYNC_H
+
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+
+#include "hmackey.h"
+
+const uint64_t HOTPRESYNC_MAX_WINDOW=100000;        // The largest number of counters we will search past the current one.
+const size_t HOTPRESYNC_MAX_CODES=2;                // The most consecutive codes that can be provided.
+const size_t HOTPRESYNC_CHUNK_SIZE=64;              // The number of counters each worker calculates per batch.
+
+/**
+ * @brief The HotpResync class finds where an HOTP token's counter has drifted to, when the user
+ *      has generated codes without using them.  Given one (or better, two consecutive) codes from
+ *      the token, it searches the counters from the last known value up to a look-ahead window
+ *      for the first counter that produces them.
+ *
+ *      Every counter is calculated from the cached HmacKey pad states, in batches that go through
+ *      the multi-buffer HMAC code, and the range is split across worker threads.  The chunks are
+ *      handed out in counter order, so the search can stop as soon as the lowest match is known.
+ */
+class HotpResync
+{
+public:
+    static bool search(const HmacKey &key, size_t digits, const char *const codes[], size_t codeCount, uint64_t startCounter, uint64_t window, uint64_t &matchedCounter, size_t threads = 0);
+
+    static size_t defaultThreadCount();
+
+private:
+    static void searchWorker(const HmacKey *key, size_t digits, const char *const *codes, size_t codeCount, uint64_t startCounter, uint64_t window, std::atomic<uint64_t> *nextChunk, std::atomic<uint64_t> *bestOffset, std::atomic<bool> *failed);
+    static bool followingCodesMatch(const HmacKey &key, size_t digits, const char *const codes[], size_t codeCount, uint64_t counter, bool &matched);
+};
+
+#endif // HOTPRESYNC_H
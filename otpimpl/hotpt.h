@@ -0,0 +1,127 @@
+#ifndef HOTPT_H
+#define HOTPT_H
+
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+
+#include "hmact.h"
+#include "otpcode.h"
+
+/**
+ * @brief otpModulus - 10^digits, worked out at compile time.
+ */
+constexpr uint32_t otpModulus(size_t digits)
+{
+    return (0 == digits) ? 1 : (10 * otpModulus(digits - 1));
+}
+
+/**
+ * @brief The HotpT class calculates HOTP (RFC 4226) and TOTP (RFC 6238) codes for a single
+ *      hash, and digit count, that are known at compile time.  Pick the specialization once
+ *      per key, and everything below it is direct calls.
+ */
+template <typename HashPolicy, size_t Digits>
+class HotpT
+{
+    static_assert((Digits >= 6) && (Digits <= 8), "HOTP codes must be 6, 7, or 8 digits long.");
+    static_assert(HashPolicy::DIGEST_LENGTH >= 20, "The hash digest is too short for the dynamic truncation.");
+
+public:
+    /**
+     * @brief HotpT::calculate - Calculate an HOTP code using the pad states cached in an HmacKey.
+     *
+     * @param key - The HmacKey to use.  It must use the hash for this class.
+     * @param counter - The counter value to calculate the code for.
+     * @param result[OUT] - If this method returns true, the null terminated code.
+     *
+     * @return true if the code was calculated.  false on error.
+     */
+    static bool calculate(const HmacKey &key, uint64_t counter, char result[OTPCODE_BUFFER_SIZE])
+    {
+        unsigned char number[8];
+        unsigned char hmac[HashPolicy::DIGEST_LENGTH];
+
+        if (nullptr == result) {
+            return false;
+        }
+
+        OtpCode::counterToBytes(counter, number);
+        if (!HmacT<HashPolicy>::calculate(key, number, sizeof(number), hmac)) {
+            return false;
+        }
+
+        codeFromHmac(hmac, result);
+        return true;
+    }
+
+    /**
+     * @brief HotpT::calculate - Calculate an HOTP code using an HmacT key.
+     *
+     * @param key - The HmacT key to use.
+     * @param counter - The counter value to calculate the code for.
+     * @param result[OUT] - If this method returns true, the null terminated code.
+     *
+     * @return true if the code was calculated.  false on error.
+     */
+    static bool calculate(const HmacT<HashPolicy> &key, uint64_t counter, char result[OTPCODE_BUFFER_SIZE])
+    {
+        unsigned char number[8];
+        unsigned char hmac[HashPolicy::DIGEST_LENGTH];
+
+        if (nullptr == result) {
+            return false;
+        }
+
+        OtpCode::counterToBytes(counter, number);
+        if (!key.calculate(number, sizeof(number), hmac)) {
+            return false;
+        }
+
+        codeFromHmac(hmac, result);
+        return true;
+    }
+
+    /**
+     * @brief HotpT::totp - Calculate a TOTP code using the pad states cached in an HmacKey.
+     *
+     * @param key - The HmacKey to use.  It must use the hash for this class.
+     * @param utcTime - The time to calculate the code for.
+     * @param timeStep - The length of time that each code is valid for.
+     * @param result[OUT] - If this method returns true, the null terminated code.
+     * @param initialCounter - The time to start counting time steps from.
+     *
+     * @return true if the code was calculated.  false on error.
+     */
+    static bool totp(const HmacKey &key, time_t utcTime, size_t timeStep, char result[OTPCODE_BUFFER_SIZE], uint64_t initialCounter = 0)
+    {
+        if (0 == timeStep) {
+            return false;
+        }
+
+        return calculate(key, OtpCode::timeToCounter(utcTime, timeStep, initialCounter), result);
+    }
+
+private:
+    /**
+     * @brief HotpT::codeFromHmac - Dynamically truncate the HMAC, and convert it to the code.
+     */
+    static inline void codeFromHmac(const unsigned char hmac[HashPolicy::DIGEST_LENGTH], char result[OTPCODE_BUFFER_SIZE])
+    {
+        size_t offset = (hmac[HashPolicy::DIGEST_LENGTH - 1] & 0x0f);
+        uint32_t otp;
+
+        otp = ((static_cast<uint32_t>(hmac[offset] & 0x7f) << 24) | (static_cast<uint32_t>(hmac[offset + 1]) << 16) |
+               (static_cast<uint32_t>(hmac[offset + 2]) << 8) | static_cast<uint32_t>(hmac[offset + 3]));
+        otp %= otpModulus(Digits);
+
+        // Write the digits from right to left, which also takes care of the leading 0s.
+        result[Digits] = 0x00;
+        for (size_t i = Digits; i > 0; i--) {
+            result[i - 1] = static_cast<char>('0' + (otp % 10));
+            otp /= 10;
+        }
+    }
+};
+
+#endif // HOTPT_H
@@ -0,0 +1,261 @@
+#include "otpcode.h"
+
+#include <cstring>
+#include "../logger.h"
+
+// The number of codes hotpMany() calculates per call to HmacKey::calculateMany().
+const size_t OTPCODE_BATCH_CHUNK_SIZE = 8;
+
+/**
+ * @brief OtpCode::hotp - Calculate an HOTP code using a key whose HMAC pad states have already
+ *      been calculated.
+ *
+ * @param key - The HmacKey to use.
+ * @param counter - The counter value to use.
+ * @param digits - The number of digits to calculate.  (6, 7, or 8)
+ * @param result[OUT] - If this method returns true, this buffer will contain the null terminated
+ *      HOTP code.
+ * @param truncationOffset - A value of 0..(hmacSize - 4) that indicates the truncation offset to
+ *      use.  Any other value will cause dynamic truncation to be used.
+ *
+ * @return true if the code was calculated.  false on error.
+ */
+bool OtpCode::hotp(const HmacKey &key, uint64_t counter, size_t digits, char result[OTPCODE_BUFFER_SIZE], int truncationOffset)
+{
+    unsigned char number[8];
+    unsigned char hmac[HMACKEY_MAX_RESULT_LENGTH];
+    bool success;
+
+    if (!key.valid()) {
+        LOG_ERROR("An HMAC key without a secret was provided for the HOTP calculation!");
+        return false;
+    }
+
+    counterToBytes(counter, number);
+
+    // Calculate the HMAC of the counter.
+    if (!key.calculate(number, sizeof(number), hmac, sizeof(hmac))) {
+        LOG_ERROR("Failed to caculate HMAC portion of the HOTP!");
+        return false;
+    }
+
+    success = codeFromHmac(hmac, key.resultLength(), digits, truncationOffset, result);
+
+    // Clean up.
+    memset(&hmac, 0x00, sizeof(hmac));
+
+    return success;
+}
+
+/**
+ * @brief OtpCode::hotp - Calculate an HOTP code using a raw key.
+ *
+ * @param algorithm - One of the HMACKEY_ALG_* values.
+ * @param key - A pointer to the DECODED key.
+ * @param keyLength - The length of the data pointed to by \c key.
+ * @param counter - The counter value to use.
+ * @param digits - The number of digits to calculate.  (6, 7, or 8)
+ * @param result[OUT] - If this method returns true, this buffer will contain the null terminated
+ *      HOTP code.
+ *
+ * @return true if the code was calculated.  false on error.
+ */
+bool OtpCode::hotp(unsigned int algorithm, const unsigned char *key, size_t keyLength, uint64_t counter, size_t digits, char result[OTPCODE_BUFFER_SIZE])
+{
+    HmacKey hmacKey;
+
+    if (!hmacKey.setKey(algorithm, key, keyLength)) {
+        // Already logged the error.
+        return false;
+    }
+
+    return hotp(hmacKey, counter, digits, result);
+}
+
+/**
+ * @brief OtpCode::totp - Calculate a TOTP code using a key whose HMAC pad states have already
+ *      been calculated.
+ *
+ * @param key - The HmacKey to use.
+ * @param utcTime - The current time in the UTC time zone.
+ * @param timeStep - The length of time that the TOTP should be valid for.
+ * @param digits - The number of digits to calculate.  (6, 7, or 8)
+ * @param result[OUT] - If this method returns true, this buffer will contain the null terminated
+ *      TOTP code.
+ * @param initialCounter - An offset to apply to the UTC time when calculating the TOTP value.
+ *
+ * @return true if the code was calculated.  false on error.
+ */
+bool OtpCode::totp(const HmacKey &key, time_t utcTime, size_t timeStep, size_t digits, char result[OTPCODE_BUFFER_SIZE], uint64_t initialCounter)
+{
+    if (0 == timeStep) {
+        LOG_ERROR("Unable to calculate the TOTP!  The time step can't be 0!");
+        return false;
+    }
+
+    return hotp(key, timeToCounter(utcTime, timeStep, initialCounter), digits, result);
+}
+
+/**
+ * @brief OtpCode::totp - Calculate a TOTP code using a raw key.
+ *
+ * @param algorithm - One of the HMACKEY_ALG_* values.
+ * @param key - A pointer to the DECODED key.
+ * @param keyLength - The length of the data pointed to by \c key.
+ * @param utcTime - The current time in the UTC time zone.
+ * @param timeStep - The length of time that the TOTP should be valid for.
+ * @param digits - The number of digits to calculate.  (6, 7, or 8)
+ * @param result[OUT] - If this method returns true, this buffer will contain the null terminated
+ *      TOTP code.
+ *
+ * @return true if the code was calculated.  false on error.
+ */
+bool OtpCode::totp(unsigned int algorithm, const unsigned char *key, size_t keyLength, time_t utcTime, size_t timeStep, size_t digits, char result[OTPCODE_BUFFER_SIZE])
+{
+    HmacKey hmacKey;
+
+    if (!hmacKey.setKey(algorithm, key, keyLength)) {
+        // Already logged the error.
+        return false;
+    }
+
+    return totp(hmacKey, utcTime, timeStep, digits, result);
+}
+
+/**
+ * @brief OtpCode::hotpMany - Calculate a batch of HOTP codes that all have the same number of
+ *      digits.  The HMACs are calculated together, so that they can be run through the
+ *      multi-buffer hash code where possible.
+ *
+ * @param keys - The HmacKey to use for each code.
+ * @param counters - The counter value to use for each code.
+ * @param count - The number of keys, counters, and results.
+ * @param digits - The number of digits to calculate.  (6, 7, or 8)
+ * @param results[OUT] - If this method returns true, each buffer will contain the null
+ *      terminated HOTP code for the matching key and counter.  Each buffer must be at least
+ *      OTPCODE_BUFFER_SIZE bytes long.
+ *
+ * @return true if all of the codes were calculated.  false on error.
+ */
+bool OtpCode::hotpMany(const HmacKey *const keys[], const uint64_t counters[], size_t count, size_t digits, char *const results[])
+{
+    unsigned char numbers[OTPCODE_BATCH_CHUNK_SIZE][8];
+    unsigned char hmacs[OTPCODE_BATCH_CHUNK_SIZE][HMACKEY_MAX_RESULT_LENGTH];
+    const unsigned char *numberPtrs[OTPCODE_BATCH_CHUNK_SIZE];
+    unsigned char *hmacPtrs[OTPCODE_BATCH_CHUNK_SIZE];
+    size_t chunk;
+    bool success = true;
+
+    if ((nullptr == keys) || (nullptr == counters) || (nullptr == results)) {
+        LOG_ERROR("Invalid parameters provided to calculate a batch of HOTP codes!");
+        return false;
+    }
+
+    for (size_t i = 0; i < OTPCODE_BATCH_CHUNK_SIZE; i++) {
+        numberPtrs[i] = numbers[i];
+        hmacPtrs[i] = hmacs[i];
+    }
+
+    for (size_t i = 0; (success) && (i < count); i += OTPCODE_BATCH_CHUNK_SIZE) {
+        chunk = ((count - i) < OTPCODE_BATCH_CHUNK_SIZE) ? (count - i) : OTPCODE_BATCH_CHUNK_SIZE;
+
+        for (size_t j = 0; j < chunk; j++) {
+            counterToBytes(counters[i + j], numbers[j]);
+        }
+
+        if (!HmacKey::calculateMany(&keys[i], numberPtrs, sizeof(numbers[0]), chunk, hmacPtrs)) {
+            LOG_ERROR("Failed to calculate the HMAC portion of a batch of HOTP codes!");
+            success = false;
+            break;
+        }
+
+        for (size_t j = 0; (success) && (j < chunk); j++) {
+            success = codeFromHmac(hmacs[j], keys[i + j]->resultLength(), digits, -1, results[i + j]);
+        }
+    }
+
+    // Clean up.
+    memset(&hmacs, 0x00, sizeof(hmacs));
+
+    return success;
+}
+
+/**
+ * @brief OtpCode::codeFromHmac - Run the truncation on an HMAC value, and convert the result to
+ *      a string of digits.
+ *
+ * @param hmac - The HMAC that was calculated over the counter.
+ * @param hmacLength - The length of the HMAC pointed to by \c hmac.
+ * @param digits - The number of digits to calculate.  (6, 7, or 8)
+ * @param truncationOffset - A value of 0..(hmacSize - 4) that indicates the truncation offset to
+ *      use.  Any other value will cause dynamic truncation to be used.
+ * @param result[OUT] - If this method returns true, this buffer will contain the null terminated
+ *      code.
+ *
+ * @return true if the code was calculated.  false on error.
+ */
+bool OtpCode::codeFromHmac(const unsigned char *hmac, size_t hmacLength, size_t digits, int truncationOffset, char result[OTPCODE_BUFFER_SIZE])
+{
+    const uint32_t DIGITS_POWER[9] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+    size_t offset;
+    uint32_t otp;
+
+    if ((nullptr == hmac) || (hmacLength < 20) || (nullptr == result)) {
+        LOG_ERROR("No HMAC value was provided to calculate the OTP!");
+        return false;
+    }
+
+    if ((digits < 6) || (digits > 8)) {
+        LOG_ERROR("An invalid number of digits was requested!  It must be 6, 7, or 8!");
+        return false;
+    }
+
+    if ((truncationOffset >= 0) && (static_cast<size_t>(truncationOffset) < (hmacLength - 4))) {
+        // Use the provided truncation value.
+        offset = static_cast<size_t>(truncationOffset);
+    } else {
+        // Get the offset bits from the last byte of the HMAC.
+        offset = (hmac[hmacLength - 1] & 0x0f);
+    }
+
+    // Convert the 4 bytes at the offset to a 31 bit number.
+    otp = (((hmac[offset] & 0x7f) << 24) | ((hmac[offset + 1] & 0xff) << 16) | ((hmac[offset + 2] & 0xff) << 8) | (hmac[offset + 3] & 0xff));
+    otp %= DIGITS_POWER[digits];
+
+    // Write the digits from right to left, which also takes care of the leading 0s.
+    result[digits] = 0x00;
+    for (size_t i = digits; i > 0; i--) {
+        result[i - 1] = static_cast<char>('0' + (otp % 10));
+        otp /= 10;
+    }
+
+    return true;
+}
+
+/**
+ * @brief OtpCode::counterToBytes - Convert the counter to the big endian byte string that is
+ *      fed to the HMAC.
+ *
+ * @param counter - The counter value to convert.
+ * @param number[OUT] - The 8 byte buffer to write the converted counter to.
+ */
+void OtpCode::counterToBytes(uint64_t counter, unsigned char number[8])
+{
+    for (size_t i = 0; i < 8; i++) {        // A 64 bit number is 8 bytes.
+        number[i] = ((counter >> ((7 - i) * 8)) & 0xff);
+    }
+}
+
+/**
+ * @brief OtpCode::timeToCounter - Convert a UTC time to the counter used to calculate a TOTP.
+ *
+ * @param utcTime - The time in the UTC time zone.
+ * @param timeStep - The length of time that the TOTP should be valid for.  Must not be 0.
+ * @param initialCounter - An offset to apply to the UTC time.
+ *
+ * @return uint64_t containing the counter value.
+ */
+uint64_t OtpCode::timeToCounter(time_t utcTime, size_t timeStep, uint64_t initialCounter)
+{
+    return (static_cast<uint64_t>(utcTime) - initialCounter) / timeStep;
+}
@@ -0,0 +1,35 @@
+#ifndef OTPCODE_H
+#define OTPCODE_H
+
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+
+#include "hmackey.h"
+
+const size_t OTPCODE_BUFFER_SIZE=9;         // Up to 8 digits, plus a null terminator.
+
+/**
+ * @brief The OtpCode class calculates HOTP and TOTP codes from raw bytes in to caller provided
+ *      buffers.  None of the calls in this class allocate memory, so they can be used to calculate
+ *      large numbers of codes without touching the heap.  The Hotp and Totp classes are wrappers
+ *      around these calls.
+ */
+class OtpCode
+{
+public:
+    static bool hotp(const HmacKey &key, uint64_t counter, size_t digits, char result[OTPCODE_BUFFER_SIZE], int truncationOffset = -1);
+    static bool hotp(unsigned int algorithm, const unsigned char *key, size_t keyLength, uint64_t counter, size_t digits, char result[OTPCODE_BUFFER_SIZE]);
+
+    static bool totp(const HmacKey &key, time_t utcTime, size_t timeStep, size_t digits, char result[OTPCODE_BUFFER_SIZE], uint64_t initialCounter = 0);
+    static bool totp(unsigned int algorithm, const unsigned char *key, size_t keyLength, time_t utcTime, size_t timeStep, size_t digits, char result[OTPCODE_BUFFER_SIZE]);
+
+    static bool hotpMany(const HmacKey *const keys[], const uint64_t counters[], size_t count, size_t digits, char *const results[]);
+
+    static bool codeFromHmac(const unsigned char *hmac, size_t hmacLength, size_t digits, int truncationOffset, char result[OTPCODE_BUFFER_SIZE]);
+
+    static void counterToBytes(uint64_t counter, unsigned char number[8]);
+    static uint64_t timeToCounter(time_t utcTime, size_t timeStep, uint64_t initialCounter = 0);
+};
+
+#endif // OTPCODE_H
@@ -0,0 +1,353 @@
+#include "replaycache.h"
+
+#include <algorithm>
+#include "../logger.h"
+
+/**
+ * @brief mix64 - The splitmix64 finalizer.  Spreads the bits of a 64 bit value so that similar
+ *      inputs (like consecutive counters) end up far apart.
+ *
+ * @param value - The value to mix.
+ *
+ * @return uint64_t containing the mixed value.
+ */
+static inline uint64_t mix64(uint64_t value)
+{
+    value ^= (value >> 30);
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= (value >> 27);
+    value *= 0x94d049bb133111ebULL;
+    value ^= (value >> 31);
+
+    return value;
+}
+
+ReplayCache::ReplayCache(size_t buckets, size_t capacityPerBucket, size_t stripes)
+{
+    size_t slotCount = 1;
+
+    mNewestStep = 0;
+    mBuckets = (0 == buckets) ? 1 : buckets;
+    mCapacityPerBucket = (0 == capacityPerBucket) ? 1 : capacityPerBucket;
+
+    // Keep the tables no more than half full, so the probes stay short.
+    while (slotCount < (mCapacityPerBucket * 2)) {
+        slotCount <<= 1;
+    }
+    mSlotMask = slotCount - 1;
+
+    if (0 == stripes) {
+        stripes = 1;
+    }
+
+    mStripes.reserve(stripes);
+    for (size_t i = 0; i < stripes; i++) {
+        std::unique_ptr<Stripe> stripe(new Stripe());
+
+        stripe->buckets.resize(mBuckets);
+        for (size_t b = 0; b < mBuckets; b++) {
+            stripe->buckets[b].step = 0;
+            stripe->buckets[b].count = 0;
+            stripe->buckets[b].active = false;
+            stripe->buckets[b].slots.assign(slotCount, 0);
+        }
+
+        mStripes.push_back(std::move(stripe));
+    }
+}
+
+/**
+ * @brief ReplayCache::markUsed - Check if a code has been used, and if it hasn't, record it as
+ *      used.  The check and the update happen under the same lock, so two threads verifying the
+ *      same code at the same time can't both have it accepted.
+ *
+ * @param entryId - An identifier for the secret the code belongs to.  (See entryId().)
+ * @param counter - The counter the code was calculated from.  For TOTP this is the time step
+ *      that matched, for HOTP it is the HOTP counter.
+ * @param currentStep - The time step the code is being used in.  This picks the bucket the code
+ *      is recorded in, and so how long it is remembered for.
+ *
+ * @return REPLAYCACHE_ACCEPTED if the code can be used.  Any other REPLAYCACHE_* value means that
+ *      the code must be rejected.
+ */
+unsigned int ReplayCache::markUsed(uint64_t entryId, uint64_t counter, uint64_t currentStep)
+{
+    uint64_t print = fingerprint(entryId, counter);
+    Stripe &stripe = *mStripes[(print >> 32) % mStripes.size()];
+    Bucket *bucket;
+    size_t slot;
+
+    // Each stripe has its own ring, so make sure a stripe that hasn't been used lately doesn't
+    // accept a time step the rest of the cache has already expired.
+    if (!updateNewestStep(currentStep)) {
+        return REPLAYCACHE_EXPIRED;
+    }
+
+    std::lock_guard<std::mutex> guard(stripe.lock);
+
+    bucket = bucketForStep(stripe, currentStep, true);
+    if (nullptr == bucket) {
+        // The ring has already moved past this time step.
+        return REPLAYCACHE_EXPIRED;
+    }
+
+    if (stripeContains(stripe, print, currentStep)) {
+        return REPLAYCACHE_REPLAYED;
+    }
+
+    if (bucket->count >= mCapacityPerBucket) {
+        LOG_ERROR("The replay cache is full for time step " + QString::number(currentStep) + "!");
+        return REPLAYCACHE_FULL;
+    }
+
+    slot = static_cast<size_t>(print) & mSlotMask;
+    while (0 != bucket->slots[slot]) {
+        slot = (slot + 1) & mSlotMask;
+    }
+
+    bucket->slots[slot] = print;
+    bucket->count++;
+
+    return REPLAYCACHE_ACCEPTED;
+}
+
+/**
+ * @brief ReplayCache::used - Check if a code has been used, without recording it.
+ *
+ * @param entryId - An identifier for the secret the code belongs to.
+ * @param counter - The counter the code was calculated from.
+ * @param currentStep - The current time step.
+ *
+ * @return true if the code has been used in one of the time steps the cache still covers.
+ *      false otherwise.
+ */
+bool ReplayCache::used(uint64_t entryId, uint64_t counter, uint64_t currentStep)
+{
+    uint64_t print = fingerprint(entryId, counter);
+    Stripe &stripe = *mStripes[(print >> 32) % mStripes.size()];
+
+    std::lock_guard<std::mutex> guard(stripe.lock);
+
+    return stripeContains(stripe, print, currentStep);
+}
+
+/**
+ * @brief ReplayCache::clear - Forget every code that has been used.
+ */
+void ReplayCache::clear()
+{
+    for (size_t i = 0; i < mStripes.size(); i++) {
+        std::lock_guard<std::mutex> guard(mStripes[i]->lock);
+
+        for (size_t b = 0; b < mBuckets; b++) {
+            Bucket &bucket = mStripes[i]->buckets[b];
+
+            std::fill(bucket.slots.begin(), bucket.slots.end(), 0);
+            bucket.step = 0;
+            bucket.count = 0;
+            bucket.active = false;
+        }
+    }
+
+    mNewestStep = 0;
+}
+
+/**
+ * @brief ReplayCache::size - Get the number of codes recorded in the cache.  Buckets for time
+ *      steps that have passed are counted until they are reused.
+ *
+ * @return size_t containing the number of recorded codes.
+ */
+size_t ReplayCache::size()
+{
+    size_t result = 0;
+
+    for (size_t i = 0; i < mStripes.size(); i++) {
+        std::lock_guard<std::mutex> guard(mStripes[i]->lock);
+
+        for (size_t b = 0; b < mBuckets; b++) {
+            if (mStripes[i]->buckets[b].active) {
+                result += mStripes[i]->buckets[b].count;
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief ReplayCache::buckets - Get the number of time steps the cache remembers codes for.
+ *
+ * @return size_t containing the number of buckets in each stripe.
+ */
+size_t ReplayCache::buckets() const
+{
+    return mBuckets;
+}
+
+/**
+ * @brief ReplayCache::capacityPerBucket - Get the number of codes each bucket in each stripe
+ *      can hold.
+ *
+ * @return size_t containing the capacity.
+ */
+size_t ReplayCache::capacityPerBucket() const
+{
+    return mCapacityPerBucket;
+}
+
+/**
+ * @brief ReplayCache::stripes - Get the number of independently locked stripes.
+ *
+ * @return size_t containing the number of stripes.
+ */
+size_t ReplayCache::stripes() const
+{
+    return mStripes.size();
+}
+
+/**
+ * @brief ReplayCache::entryId - Convert a key identifier to the value used to identify it in
+ *      the cache.  (64 bit FNV-1a.)
+ *
+ * @param identifier - The identifier of the key entry.
+ *
+ * @return uint64_t containing the entry ID.
+ */
+uint64_t ReplayCache::entryId(const std::string &identifier)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < identifier.size(); i++) {
+        hash ^= static_cast<unsigned char>(identifier[i]);
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief ReplayCache::fingerprint - Combine the entry ID and counter in to the value stored in
+ *      the cache.  Two different codes can only be confused if their 64 bit fingerprints
+ *      collide, in which case the second one is (safely) rejected.
+ *
+ * @param entryId - The entry ID.
+ * @param counter - The counter.
+ *
+ * @return uint64_t containing the fingerprint.  Never 0.
+ */
+uint64_t ReplayCache::fingerprint(uint64_t entryId, uint64_t counter)
+{
+    uint64_t print = mix64(mix64(entryId) ^ (counter * 0x9e3779b97f4a7c15ULL));
+
+    return (0 == print) ? 1 : print;
+}
+
+/**
+ * @brief ReplayCache::updateNewestStep - Track the newest time step that has been used, and
+ *      check that a time step hasn't fallen out of the ring.
+ *
+ * @param currentStep - The time step being used.
+ *
+ * @return true if the time step is still covered by the cache.  false if it has expired.
+ */
+bool ReplayCache::updateNewestStep(uint64_t currentStep)
+{
+    uint64_t newest = mNewestStep.load();
+
+    while (currentStep > newest) {
+        if (mNewestStep.compare_exchange_weak(newest, currentStep)) {
+            return true;
+        }
+    }
+
+    return ((currentStep + mBuckets) > newest);
+}
+
+/**
+ * @brief ReplayCache::bucketForStep - Find the bucket for a time step, emptying it first if it
+ *      was last used for an older time step.
+ *
+ * @param stripe - The stripe to look in.  The caller must hold the stripe lock.
+ * @param currentStep - The time step to find the bucket for.
+ * @param create - true if a stale bucket should be taken over for the time step.
+ *
+ * @return Bucket pointer for the time step.  nullptr if the bucket is in use by a newer time
+ *      step, or if it isn't in use and \c create is false.
+ */
+ReplayCache::Bucket *ReplayCache::bucketForStep(Stripe &stripe, uint64_t currentStep, bool create)
+{
+    Bucket &bucket = stripe.buckets[currentStep % mBuckets];
+
+    if ((bucket.active) && (bucket.step == currentStep)) {
+        return &bucket;
+    }
+
+    if ((bucket.active) && (bucket.step > currentStep)) {
+        return nullptr;
+    }
+
+    if (!create) {
+        return nullptr;
+    }
+
+    // The step rolled over, so expire everything in the bucket.
+    std::fill(bucket.slots.begin(), bucket.slots.end(), 0);
+    bucket.step = currentStep;
+    bucket.count = 0;
+    bucket.active = true;
+
+    return &bucket;
+}
+
+/**
+ * @brief ReplayCache::bucketContains - Look for a fingerprint in a bucket.
+ *
+ * @param bucket - The bucket to look in.
+ * @param print - The fingerprint to look for.
+ *
+ * @return true if the fingerprint is in the bucket.  false otherwise.
+ */
+bool ReplayCache::bucketContains(const Bucket &bucket, uint64_t print) const
+{
+    size_t slot = static_cast<size_t>(print) & mSlotMask;
+
+    while (0 != bucket.slots[slot]) {
+        if (print == bucket.slots[slot]) {
+            return true;
+        }
+
+        slot = (slot + 1) & mSlotMask;
+    }
+
+    return false;
+}
+
+/**
+ * @brief ReplayCache::stripeContains - Look for a fingerprint in every bucket of a stripe that
+ *      hasn't expired yet.
+ *
+ * @param stripe - The stripe to look in.  The caller must hold the stripe lock.
+ * @param print - The fingerprint to look for.
+ * @param currentStep - The current time step.
+ *
+ * @return true if the fingerprint was found.  false otherwise.
+ */
+bool ReplayCache::stripeContains(Stripe &stripe, uint64_t print, uint64_t currentStep) const
+{
+    for (size_t b = 0; b < mBuckets; b++) {
+        const Bucket &bucket = stripe.buckets[b];
+
+        // Buckets that have fallen out of the ring are waiting to be reused, and don't count.
+        // (Buckets for newer steps do, in case another caller's clock is slightly ahead.)
+        if ((!bucket.active) || ((bucket.step + mBuckets) <= currentStep)) {
+            continue;
+        }
+
+        if (bucketContains(bucket, print)) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,77 @@
+#ifndef REPLAYCACHE_H
+#define REPLAYCACHE_H
+
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+const unsigned int REPLAYCACHE_ACCEPTED=0;         // The code hadn't been used, and is now marked as used.
+const unsigned int REPLAYCACHE_REPLAYED=1;         // The code was already used.
+const unsigned int REPLAYCACHE_FULL=2;             // There was no room to record the code, so it must be rejected.
+const unsigned int REPLAYCACHE_EXPIRED=3;          // The time step is older than the cache covers, so it must be rejected.
+
+/**
+ * @brief The ReplayCache class remembers which codes have already been accepted, so that a code
+ *      can't be used a second time while it is still valid.
+ *
+ *      Each used code is recorded as a 64 bit fingerprint of (entry, counter) in the bucket for
+ *      the time step it was used in.  The buckets form a ring, so when the time step rolls over
+ *      the oldest bucket is emptied in one go, rather than expiring entries one at a time.  The
+ *      number of buckets should be at least the number of time steps a code is valid for (for a
+ *      TotpVerifier, (window * 2) + 1).
+ *
+ *      The cache is split in to stripes, each with its own lock and buckets, so concurrent
+ *      verifications only contend when they land in the same stripe.  All of the memory is
+ *      allocated up front, so it never grows no matter how many codes are verified.
+ */
+class ReplayCache
+{
+public:
+    explicit ReplayCache(size_t buckets = 4, size_t capacityPerBucket = 1024, size_t stripes = 16);
+    ~ReplayCache() = default;
+
+    unsigned int markUsed(uint64_t entryId, uint64_t counter, uint64_t currentStep);
+    bool used(uint64_t entryId, uint64_t counter, uint64_t currentStep);
+
+    void clear();
+    size_t size();
+
+    size_t buckets() const;
+    size_t capacityPerBucket() const;
+    size_t stripes() const;
+
+    static uint64_t entryId(const std::string &identifier);
+
+private:
+    struct Bucket {
+        uint64_t step;
+        size_t count;
+        bool active;
+        std::vector<uint64_t> slots;           // Open addressed.  0 marks an empty slot.
+    };
+
+    struct Stripe {
+        std::mutex lock;
+        std::vector<Bucket> buckets;
+    };
+
+    static uint64_t fingerprint(uint64_t entryId, uint64_t counter);
+
+    bool updateNewestStep(uint64_t currentStep);
+
+    Bucket *bucketForStep(Stripe &stripe, uint64_t currentStep, bool create);
+    bool bucketContains(const Bucket &bucket, uint64_t print) const;
+    bool stripeContains(Stripe &stripe, uint64_t print, uint64_t currentStep) const;
+
+    size_t mBuckets;
+    size_t mCapacityPerBucket;
+    size_t mSlotMask;
+    std::atomic<uint64_t> mNewestStep;          // The newest time step seen by any stripe.
+    std::vector<std::unique_ptr<Stripe>> mStripes;
+};
+
+#endif // REPLAYCACHE_H
@@ -1,6 +1,7 @@
 #include "sha1hash.h"
 
 #include <cstring>
+#include "hashcontext.h"
 
 extern "C" {
 #include "sha1impl.h"                   //NOSONAR
@@ -31,6 +32,16 @@ ByteArray Sha1Hash::hash(const ByteArray &toHash)
     return result;
 }
 
+/**
+ * @brief Sha1Hash::begin - Start calculating a SHA1 hash a piece at a time.
+ *
+ * @return std::unique_ptr containing the new hash context.
+ */
+std::unique_ptr<HashContextBase> Sha1Hash::begin()
+{
+    return std::unique_ptr<HashContextBase>(new HashContextT<Sha1Policy>());
+}
+
 /**
  * @brief Sha1Hash::hashResultLength - Return the length of the result from the hash.
  *
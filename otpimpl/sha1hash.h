@@ -14,6 +14,7 @@ public:
     ~Sha1Hash() = default;
 
     ByteArray hash(const ByteArray &toHash);
+    std::unique_ptr<HashContextBase> begin();
     size_t hashResultLength();
     size_t hashBlockLength();
 };
@@ -24,6 +24,7 @@ A million repetitions of "a"
 #include <stdint.h>
 
 #include "sha1impl.h"
+#include "shaext.h"
 
 #define rol(value, bits) (((value) << (bits)) | ((value) >> (32 - (bits))))
 
@@ -50,7 +51,7 @@ A million repetitions of "a"
 
 /* Hash a single 512-bit block. This is the core of the algorithm. */
 
-void SHA1Transform(
+static void SHA1TransformPortable(
     uint32_t state[5],
     const unsigned char buffer[64]
 )
@@ -180,6 +181,22 @@ void SHA1Transform(
 }
 
 
+/* Hash a single 512-bit block, using the CPU's SHA instructions if it has them. */
+
+void SHA1Transform(
+    uint32_t state[5],
+    const unsigned char buffer[64]
+)
+{
+    if (sha_ext_sha1_available()) {
+        sha_ext_sha1_transform(state, buffer, 1);
+        return;
+    }
+
+    SHA1TransformPortable(state, buffer);
+}
+
+
 /* SHA1Init - Initialize new context */
 
 void SHA1Init(
@@ -218,6 +235,12 @@ void SHA1Update(
         i = 64 - j;
         memcpy(&context->buffer[j], data, i);
         SHA1Transform(context->state, context->buffer);
+        if (sha_ext_sha1_available() && (i + 63 < len))
+        {
+            /* Hand all of the whole blocks to the SHA instructions at once. */
+            sha_ext_sha1_transform(context->state, &data[i], (len - i) / 64);
+            i += ((len - i) / 64) * 64;
+        }
         for (; i + 63 < len; i += 64)
         {
             SHA1Transform(context->state, &data[i]);
@@ -241,7 +264,9 @@ void SHA1Final(
 
     unsigned char finalcount[8];
 
-    unsigned char c;
+    static const unsigned char padding[64] = { 0200 };
+
+    uint32_t used;
 
 #if 0    /* untested "improvement" by DHR */
     /* Convert context->count to a sequence of bytes
@@ -265,13 +290,10 @@ void SHA1Final(
         finalcount[i] = (unsigned char) ((context->count[i >= 4 ? 0 : 1] >> ((3 - (i & 3)) * 8)) & 255);      /* Endian independent */
     }
 #endif
-    c = 0200;
-    SHA1Update(context, &c, 1);
-    while ((context->count[0] & 504) != 448)
-    {
-        c = 0000;
-        SHA1Update(context, &c, 1);
-    }
+    /* Pad with a 1 bit, and then 0s, until we are 8 bytes short of a block.  (Done in one
+     * update, rather than a byte at a time.) */
+    used = (context->count[0] >> 3) & 63;
+    SHA1Update(context, padding, (used < 56) ? (56 - used) : (120 - used));
     SHA1Update(context, finalcount, 8); /* Should cause a SHA1Transform() */
     for (i = 0; i < 20; i++)
     {
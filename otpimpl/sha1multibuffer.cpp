@@ -0,0 +1,377 @@
+#include "sha1multibuffer.h"
+
+#include <cstring>
+
+extern "C" {
+#include "sha1impl.h"                   //NOSONAR
+#include "shaext.h"                     //NOSONAR
+}
+
+// The SIMD backends are only built for x86 with a compiler that understands the target
+// attribute, so that the rest of the program doesn't need to be built with -mavx2.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA1MULTIBUFFER_X86
+#include <immintrin.h>
+#endif
+
+// The round constants for SHA1.
+const uint32_t SHA1MULTIBUFFER_K0 = 0x5a827999;
+const uint32_t SHA1MULTIBUFFER_K1 = 0x6ed9eba1;
+const uint32_t SHA1MULTIBUFFER_K2 = 0x8f1bbcdc;
+const uint32_t SHA1MULTIBUFFER_K3 = 0xca62c1d6;
+
+/**
+ * @brief loadBigEndian - Read a 32 bit big endian value from a byte buffer.
+ *
+ * @param data - A pointer to the 4 bytes to read.
+ *
+ * @return uint32_t containing the value.
+ */
+static inline uint32_t loadBigEndian(const unsigned char *data)
+{
+    return ((static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]));
+}
+
+/**
+ * @brief transformScalar - Run each block through the portable SHA1 compression function,
+ *      one after another.
+ *
+ * @param states[IN/OUT] - The hash states to update.
+ * @param blocks - The 64 byte blocks to hash in to the matching state.
+ * @param count - The number of states and blocks.
+ */
+static void transformScalar(uint32_t *const states[], const unsigned char *const blocks[], size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        SHA1Transform(states[i], blocks[i]);
+    }
+}
+
+#ifdef SHA1MULTIBUFFER_X86
+
+#define SHA1MULTIBUFFER_ROL128(x, n) _mm_or_si128(_mm_slli_epi32((x), (n)), _mm_srli_epi32((x), 32 - (n)))
+#define SHA1MULTIBUFFER_ROL256(x, n) _mm256_or_si256(_mm256_slli_epi32((x), (n)), _mm256_srli_epi32((x), 32 - (n)))
+
+/**
+ * @brief transformSse2 - Run up to 4 blocks through the SHA1 compression function at the
+ *      same time, with one block in each 32 bit lane of the SSE2 registers.
+ *
+ * @param states[IN/OUT] - The hash states to update.
+ * @param blocks - The 64 byte blocks to hash in to the matching state.
+ * @param count - The number of states and blocks.  (1..4)
+ */
+__attribute__((target("sse2")))
+static void transformSse2(uint32_t *const states[], const unsigned char *const blocks[], size_t count)
+{
+    alignas(16) uint32_t words[16][4];
+    alignas(16) uint32_t digest[5][4];
+    __m128i w[16];
+    __m128i a, b, c, d, e, f, k, temp;
+    size_t source;
+
+    // Transpose the inputs so that each register holds the same word from each block.  Lanes
+    // that we don't have a block for just duplicate the first one, and are thrown away.
+    for (size_t lane = 0; lane < 4; lane++) {
+        source = (lane < count) ? lane : 0;
+
+        for (size_t t = 0; t < 16; t++) {
+            words[t][lane] = loadBigEndian(blocks[source] + (t * 4));
+        }
+
+        for (size_t i = 0; i < 5; i++) {
+            digest[i][lane] = states[source][i];
+        }
+    }
+
+    for (size_t t = 0; t < 16; t++) {
+        w[t] = _mm_load_si128(reinterpret_cast<const __m128i *>(words[t]));
+    }
+
+    a = _mm_load_si128(reinterpret_cast<const __m128i *>(digest[0]));
+    b = _mm_load_si128(reinterpret_cast<const __m128i *>(digest[1]));
+    c = _mm_load_si128(reinterpret_cast<const __m128i *>(digest[2]));
+    d = _mm_load_si128(reinterpret_cast<const __m128i *>(digest[3]));
+    e = _mm_load_si128(reinterpret_cast<const __m128i *>(digest[4]));
+
+    for (size_t t = 0; t < 80; t++) {
+        // Expand the message schedule in place.
+        if (t >= 16) {
+            temp = _mm_xor_si128(_mm_xor_si128(w[(t - 3) & 15], w[(t - 8) & 15]), _mm_xor_si128(w[(t - 14) & 15], w[t & 15]));
+            w[t & 15] = SHA1MULTIBUFFER_ROL128(temp, 1);
+        }
+
+        if (t < 20) {
+            f = _mm_xor_si128(d, _mm_and_si128(b, _mm_xor_si128(c, d)));
+            k = _mm_set1_epi32(static_cast<int>(SHA1MULTIBUFFER_K0));
+        } else if (t < 40) {
+            f = _mm_xor_si128(_mm_xor_si128(b, c), d);
+            k = _mm_set1_epi32(static_cast<int>(SHA1MULTIBUFFER_K1));
+        } else if (t < 60) {
+            f = _mm_or_si128(_mm_and_si128(b, c), _mm_and_si128(d, _mm_or_si128(b, c)));
+            k = _mm_set1_epi32(static_cast<int>(SHA1MULTIBUFFER_K2));
+        } else {
+            f = _mm_xor_si128(_mm_xor_si128(b, c), d);
+            k = _mm_set1_epi32(static_cast<int>(SHA1MULTIBUFFER_K3));
+        }
+
+        temp = _mm_add_epi32(_mm_add_epi32(SHA1MULTIBUFFER_ROL128(a, 5), f), _mm_add_epi32(_mm_add_epi32(e, k), w[t & 15]));
+        e = d;
+        d = c;
+        c = SHA1MULTIBUFFER_ROL128(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    _mm_store_si128(reinterpret_cast<__m128i *>(digest[0]), _mm_add_epi32(a, _mm_load_si128(reinterpret_cast<const __m128i *>(digest[0]))));
+    _mm_store_si128(reinterpret_cast<__m128i *>(digest[1]), _mm_add_epi32(b, _mm_load_si128(reinterpret_cast<const __m128i *>(digest[1]))));
+    _mm_store_si128(reinterpret_cast<__m128i *>(digest[2]), _mm_add_epi32(c, _mm_load_si128(reinterpret_cast<const __m128i *>(digest[2]))));
+    _mm_store_si128(reinterpret_cast<__m128i *>(digest[3]), _mm_add_epi32(d, _mm_load_si128(reinterpret_cast<const __m128i *>(digest[3]))));
+    _mm_store_si128(reinterpret_cast<__m128i *>(digest[4]), _mm_add_epi32(e, _mm_load_si128(reinterpret_cast<const __m128i *>(digest[4]))));
+
+    for (size_t lane = 0; lane < count; lane++) {
+        for (size_t i = 0; i < 5; i++) {
+            states[lane][i] = digest[i][lane];
+        }
+    }
+
+    // Clean up.
+    memset(&words, 0x00, sizeof(words));
+    memset(&digest, 0x00, sizeof(digest));
+}
+
+/**
+ * @brief transformAvx2 - Run up to 8 blocks through the SHA1 compression function at the
+ *      same time, with one block in each 32 bit lane of the AVX2 registers.
+ *
+ * @param states[IN/OUT] - The hash states to update.
+ * @param blocks - The 64 byte blocks to hash in to the matching state.
+ * @param count - The number of states and blocks.  (1..8)
+ */
+__attribute__((target("avx2")))
+static void transformAvx2(uint32_t *const states[], const unsigned char *const blocks[], size_t count)
+{
+    alignas(32) uint32_t words[16][8];
+    alignas(32) uint32_t digest[5][8];
+    __m256i w[16];
+    __m256i a, b, c, d, e, f, k, temp;
+    size_t source;
+
+    // Transpose the inputs so that each register holds the same word from each block.  Lanes
+    // that we don't have a block for just duplicate the first one, and are thrown away.
+    for (size_t lane = 0; lane < 8; lane++) {
+        source = (lane < count) ? lane : 0;
+
+        for (size_t t = 0; t < 16; t++) {
+            words[t][lane] = loadBigEndian(blocks[source] + (t * 4));
+        }
+
+        for (size_t i = 0; i < 5; i++) {
+            digest[i][lane] = states[source][i];
+        }
+    }
+
+    for (size_t t = 0; t < 16; t++) {
+        w[t] = _mm256_load_si256(reinterpret_cast<const __m256i *>(words[t]));
+    }
+
+    a = _mm256_load_si256(reinterpret_cast<const __m256i *>(digest[0]));
+    b = _mm256_load_si256(reinterpret_cast<const __m256i *>(digest[1]));
+    c = _mm256_load_si256(reinterpret_cast<const __m256i *>(digest[2]));
+    d = _mm256_load_si256(reinterpret_cast<const __m256i *>(digest[3]));
+    e = _mm256_load_si256(reinterpret_cast<const __m256i *>(digest[4]));
+
+    for (size_t t = 0; t < 80; t++) {
+        // Expand the message schedule in place.
+        if (t >= 16) {
+            temp = _mm256_xor_si256(_mm256_xor_si256(w[(t - 3) & 15], w[(t - 8) & 15]), _mm256_xor_si256(w[(t - 14) & 15], w[t & 15]));
+            w[t & 15] = SHA1MULTIBUFFER_ROL256(temp, 1);
+        }
+
+        if (t < 20) {
+            f = _mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d)));
+            k = _mm256_set1_epi32(static_cast<int>(SHA1MULTIBUFFER_K0));
+        } else if (t < 40) {
+            f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+            k = _mm256_set1_epi32(static_cast<int>(SHA1MULTIBUFFER_K1));
+        } else if (t < 60) {
+            f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c)));
+            k = _mm256_set1_epi32(static_cast<int>(SHA1MULTIBUFFER_K2));
+        } else {
+            f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+            k = _mm256_set1_epi32(static_cast<int>(SHA1MULTIBUFFER_K3));
+        }
+
+        temp = _mm256_add_epi32(_mm256_add_epi32(SHA1MULTIBUFFER_ROL256(a, 5), f), _mm256_add_epi32(_mm256_add_epi32(e, k), w[t & 15]));
+        e = d;
+        d = c;
+        c = SHA1MULTIBUFFER_ROL256(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    _mm256_store_si256(reinterpret_cast<__m256i *>(digest[0]), _mm256_add_epi32(a, _mm256_load_si256(reinterpret_cast<const __m256i *>(digest[0]))));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(digest[1]), _mm256_add_epi32(b, _mm256_load_si256(reinterpret_cast<const __m256i *>(digest[1]))));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(digest[2]), _mm256_add_epi32(c, _mm256_load_si256(reinterpret_cast<const __m256i *>(digest[2]))));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(digest[3]), _mm256_add_epi32(d, _mm256_load_si256(reinterpret_cast<const __m256i *>(digest[3]))));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(digest[4]), _mm256_add_epi32(e, _mm256_load_si256(reinterpret_cast<const __m256i *>(digest[4]))));
+
+    for (size_t lane = 0; lane < count; lane++) {
+        for (size_t i = 0; i < 5; i++) {
+            states[lane][i] = digest[i][lane];
+        }
+    }
+
+    // Clean up.
+    memset(&words, 0x00, sizeof(words));
+    memset(&digest, 0x00, sizeof(digest));
+}
+
+#endif // SHA1MULTIBUFFER_X86
+
+/**
+ * @brief Sha1MultiBuffer::transform - Run each block through the SHA1 compression function,
+ *      updating the matching state, using the best backend the CPU supports.
+ *
+ * @param states[IN/OUT] - The hash states to update.  Each points to 5 words.
+ * @param blocks - The 64 byte blocks to hash in to the matching state.
+ * @param count - The number of states and blocks.
+ */
+void Sha1MultiBuffer::transform(uint32_t *const states[], const unsigned char *const blocks[], size_t count)
+{
+    // The best backend is always supported, so this can't fail.
+    transform(bestBackend(), states, blocks, count);
+}
+
+/**
+ * @brief Sha1MultiBuffer::transform - Run each block through the SHA1 compression function,
+ *      updating the matching state, using the requested backend.
+ *
+ * @param backend - One of the SHA1MULTIBUFFER_BACKEND_* values.
+ * @param states[IN/OUT] - The hash states to update.  Each points to 5 words.
+ * @param blocks - The 64 byte blocks to hash in to the matching state.
+ * @param count - The number of states and blocks.
+ *
+ * @return true if the blocks were hashed.  false if the backend isn't supported on this CPU.
+ */
+bool Sha1MultiBuffer::transform(unsigned int backend, uint32_t *const states[], const unsigned char *const blocks[], size_t count)
+{
+    size_t laneCount;
+    size_t chunk;
+
+    if (!backendSupported(backend)) {
+        return false;
+    }
+
+    laneCount = lanes(backend);
+
+    for (size_t i = 0; i < count; i += laneCount) {
+        chunk = ((count - i) < laneCount) ? (count - i) : laneCount;
+
+        switch (backend) {
+#ifdef SHA1MULTIBUFFER_X86
+        case SHA1MULTIBUFFER_BACKEND_AVX2:
+            transformAvx2(&states[i], &blocks[i], chunk);
+            break;
+
+        case SHA1MULTIBUFFER_BACKEND_SSE2:
+            transformSse2(&states[i], &blocks[i], chunk);
+            break;
+#endif // SHA1MULTIBUFFER_X86
+
+        default:
+            transformScalar(&states[i], &blocks[i], chunk);
+            break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Sha1MultiBuffer::bestBackend - Return the fastest backend that this CPU supports.
+ *
+ * @return unsigned int containing one of the SHA1MULTIBUFFER_BACKEND_* values.
+ */
+unsigned int Sha1MultiBuffer::bestBackend()
+{
+    // Only check the CPU the first time through.
+    static const unsigned int backend = detectBackend();
+
+    return backend;
+}
+
+/**
+ * @brief Sha1MultiBuffer::backendSupported - Check to see if the CPU we are running on supports
+ *      the requested backend.
+ *
+ * @param backend - One of the SHA1MULTIBUFFER_BACKEND_* values.
+ *
+ * @return true if the backend can be used.  false otherwise.
+ */
+bool Sha1MultiBuffer::backendSupported(unsigned int backend)
+{
+    switch (backend) {
+    case SHA1MULTIBUFFER_BACKEND_SCALAR:
+        return true;
+
+#ifdef SHA1MULTIBUFFER_X86
+    case SHA1MULTIBUFFER_BACKEND_SSE2:
+        __builtin_cpu_init();
+        return (__builtin_cpu_supports("sse2") != 0);
+
+    case SHA1MULTIBUFFER_BACKEND_AVX2:
+        __builtin_cpu_init();
+        return (__builtin_cpu_supports("avx2") != 0);
+#endif // SHA1MULTIBUFFER_X86
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Sha1MultiBuffer::lanes - Return the number of blocks the backend hashes at once.
+ *
+ * @param backend - One of the SHA1MULTIBUFFER_BACKEND_* values.
+ *
+ * @return size_t containing the number of lanes.
+ */
+size_t Sha1MultiBuffer::lanes(unsigned int backend)
+{
+    switch (backend) {
+    case SHA1MULTIBUFFER_BACKEND_SSE2:
+        return 4;
+
+    case SHA1MULTIBUFFER_BACKEND_AVX2:
+        return 8;
+
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Sha1MultiBuffer::detectBackend - Work out which backend is the fastest one the CPU
+ *      supports.
+ *
+ * @return unsigned int containing one of the SHA1MULTIBUFFER_BACKEND_* values.
+ */
+unsigned int Sha1MultiBuffer::detectBackend()
+{
+    // A single stream through the SHA instructions keeps up with eight AVX2 lanes, and beats
+    // the SSE2 lanes, without having to transpose the data.  So, if the CPU has them, use the
+    // scalar path, which goes through SHA1Transform().
+    if (sha_ext_sha1_available()) {
+        return SHA1MULTIBUFFER_BACKEND_SCALAR;
+    }
+
+    if (backendSupported(SHA1MULTIBUFFER_BACKEND_AVX2)) {
+        return SHA1MULTIBUFFER_BACKEND_AVX2;
+    }
+
+    if (backendSupported(SHA1MULTIBUFFER_BACKEND_SSE2)) {
+        return SHA1MULTIBUFFER_BACKEND_SSE2;
+    }
+
+    return SHA1MULTIBUFFER_BACKEND_SCALAR;
+}
@@ -0,0 +1,37 @@
+#ifndef SHA1MULTIBUFFER_H
+#define SHA1MULTIBUFFER_H
+
+#include <cstdlib>
+#include <cstdint>
+
+const unsigned int SHA1MULTIBUFFER_BACKEND_SCALAR=0;      // One block at a time, using SHA1Transform().  (Which may use SHA-NI.)
+const unsigned int SHA1MULTIBUFFER_BACKEND_SSE2=1;        // Four blocks at a time.
+const unsigned int SHA1MULTIBUFFER_BACKEND_AVX2=2;        // Eight blocks at a time.
+
+const size_t SHA1MULTIBUFFER_MAX_LANES=8;                 // The most blocks any backend hashes at once.
+
+/**
+ * @brief The Sha1MultiBuffer class runs the SHA1 compression function over several independent
+ *      (state, block) pairs at the same time, using one SIMD lane per pair.  This doesn't make a
+ *      single hash any faster, but when we need to hash a lot of short messages (like the final
+ *      blocks of a batch of HMACs) it gets through them several times faster than hashing them
+ *      one after another.
+ *
+ *      The best backend the CPU supports is selected the first time it is needed, with the
+ *      scalar code in sha1impl.c used as the fallback.
+ */
+class Sha1MultiBuffer
+{
+public:
+    static void transform(uint32_t *const states[], const unsigned char *const blocks[], size_t count);
+    static bool transform(unsigned int backend, uint32_t *const states[], const unsigned char *const blocks[], size_t count);
+
+    static unsigned int bestBackend();
+    static bool backendSupported(unsigned int backend);
+    static size_t lanes(unsigned int backend);
+
+private:
+    static unsigned int detectBackend();
+};
+
+#endif // SHA1MULTIBUFFER_H
@@ -38,6 +38,8 @@
 #include <string.h>
 
 #include "sha2.h"
+#include "shaext.h"
+#include "sha512avx2.h"
 
 #define SHFR(x, n)    (x >> n)
 #define ROTR(x, n)   ((x >> n) | (x << ((sizeof(x) << 3) - n)))
@@ -209,8 +211,8 @@ uint64 sha512_k[80] =
 
 /* SHA-256 functions */
 
-void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
-                   unsigned int block_nb)
+static void sha256_transf_portable(sha256_ctx *ctx, const unsigned char *message,
+                                   unsigned int block_nb)
 {
     uint32 w[64];
     uint32 wv[8];
@@ -325,6 +327,18 @@ void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
     }
 }
 
+void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
+                   unsigned int block_nb)
+{
+    /* Use the CPU's SHA instructions if it has them. */
+    if (sha_ext_sha256_available()) {
+        sha_ext_sha256_transform((uint32_t *) ctx->h, message, block_nb);
+        return;
+    }
+
+    sha256_transf_portable(ctx, message, block_nb);
+}
+
 void sha256(const unsigned char *message, unsigned int len, unsigned char *digest)
 {
     sha256_ctx ctx;
@@ -428,8 +442,8 @@ void sha256_final(sha256_ctx *ctx, unsigned char *digest)
 
 /* SHA-512 functions */
 
-void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
-                   unsigned int block_nb)
+static void sha512_transf_portable(sha512_ctx *ctx, const unsigned char *message,
+                                   unsigned int block_nb)
 {
     uint64 w[80];
     uint64 wv[8];
@@ -525,6 +539,18 @@ void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
     }
 }
 
+void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
+                   unsigned int block_nb)
+{
+    /* Use the AVX2 message schedule if the CPU supports it. */
+    if (sha512_avx2_available()) {
+        sha512_avx2_transform(ctx->h, message, block_nb);
+        return;
+    }
+
+    sha512_transf_portable(ctx, message, block_nb);
+}
+
 void sha512(const unsigned char *message, unsigned int len,
             unsigned char *digest)
 {
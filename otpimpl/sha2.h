@@ -100,6 +100,15 @@ void sha512_final(sha512_ctx *ctx, unsigned char *digest);
 void sha512(const unsigned char *message, unsigned int len,
             unsigned char *digest);
 
+/* The SHA-512 round constants. */
+extern uint64 sha512_k[80];
+
+/* Run whole blocks through the compression function. */
+void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
+                   unsigned int block_nb);
+void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
+                   unsigned int block_nb);
+
 #ifdef __cplusplus
 }
 #endif
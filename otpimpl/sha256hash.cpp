@@ -1,6 +1,7 @@
 #include "sha256hash.h"
 
 #include <cstring>
+#include "hashcontext.h"
 
 extern "C" {
 #include "otpimpl/sha2.h"                   //NOSONAR
@@ -24,6 +25,11 @@ ByteArray Sha256Hash::hash(const ByteArray &toHash)
     return result;
 }
 
+std::unique_ptr<HashContextBase> Sha256Hash::begin()
+{
+    return std::unique_ptr<HashContextBase>(new HashContextT<Sha256Policy>());
+}
+
 size_t Sha256Hash::hashResultLength()
 {
     return 32;
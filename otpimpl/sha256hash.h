@@ -10,6 +10,7 @@ public:
     ~Sha256Hash() = default;
 
     ByteArray hash(const ByteArray &toHash);
+    std::unique_ptr<HashContextBase> begin();
     size_t hashResultLength();
     size_t hashBlockLength();
 };
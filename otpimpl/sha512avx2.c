@@ -0,0 +1,154 @@
+/*
+ * SHA-512 block function that uses AVX2 for the message schedule.
+ *
+ * The rounds of a single SHA-512 stream depend on each other, so they stay scalar (and fully
+ * unrolled).  The message schedule, and adding the round constants to it, is done two words
+ * at a time in vector registers, and the byte swapping of the input four words at a time.
+ */
+
+#include <string.h>
+
+#include "sha2.h"
+#include "sha512avx2.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA512_AVX2_X86
+#include <immintrin.h>
+#endif
+
+/* -1 until the CPU has been checked, then 0 or 1.  Checking more than once is harmless. */
+static int sha512_avx2_support = -1;
+
+/* Allows the AVX2 code to be turned off, so the two can be compared. */
+static int sha512_avx2_allowed = 1;
+
+int sha512_avx2_available(void)
+{
+    if (sha512_avx2_support < 0) {
+#if defined(SHA512_AVX2_X86)
+        __builtin_cpu_init();
+        sha512_avx2_support = (__builtin_cpu_supports("avx2") != 0);
+#else
+        sha512_avx2_support = 0;
+#endif
+    }
+
+    return (sha512_avx2_allowed && sha512_avx2_support);
+}
+
+void sha512_avx2_set_enabled(int enabled)
+{
+    sha512_avx2_allowed = (enabled != 0);
+}
+
+int sha512_avx2_enabled(void)
+{
+    return sha512_avx2_allowed;
+}
+
+#if defined(SHA512_AVX2_X86)
+
+#define SHA512_AVX2_ROTR(x, n)   (((x) >> (n)) | ((x) << (64 - (n))))
+#define SHA512_AVX2_S0(x)        (SHA512_AVX2_ROTR(x, 28) ^ SHA512_AVX2_ROTR(x, 34) ^ SHA512_AVX2_ROTR(x, 39))
+#define SHA512_AVX2_S1(x)        (SHA512_AVX2_ROTR(x, 14) ^ SHA512_AVX2_ROTR(x, 18) ^ SHA512_AVX2_ROTR(x, 41))
+#define SHA512_AVX2_CH(x, y, z)  ((z) ^ ((x) & ((y) ^ (z))))
+#define SHA512_AVX2_MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+
+#define SHA512_AVX2_VROTR(x, n)  _mm_or_si128(_mm_srli_epi64((x), (n)), _mm_slli_epi64((x), 64 - (n)))
+
+/* One round, with the working variables passed in rotated order. */
+#define SHA512_AVX2_ROUND(a, b, c, d, e, f, g, h, i)                                \
+{                                                                                   \
+    t1 = h + SHA512_AVX2_S1(e) + SHA512_AVX2_CH(e, f, g) + wk[i];                   \
+    t2 = SHA512_AVX2_S0(a) + SHA512_AVX2_MAJ(a, b, c);                              \
+    d += t1;                                                                        \
+    h = t1 + t2;                                                                    \
+}
+
+__attribute__((target("avx2")))
+void sha512_avx2_transform(unsigned long long state[8], const unsigned char *data, size_t blocks)
+{
+    const __m256i swap = _mm256_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+                                         8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+    uint64_t w[80] __attribute__((aligned(32)));
+    uint64_t wk[80] __attribute__((aligned(32)));
+    uint64_t a, b, c, d, e, f, g, h;
+    uint64_t t1, t2;
+    __m128i x2, x7, x15, x16, s0, s1;
+    int i;
+
+    while (blocks > 0) {
+        /* Load the block, swapping it to big endian four words at a time. */
+        for (i = 0; i < 16; i += 4) {
+            _mm256_store_si256((__m256i *)&w[i], _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(data + (i * 8))), swap));
+        }
+
+        /* Expand the schedule two words at a time.  W[t - 2] and W[t - 1] are both already
+         * known when calculating W[t] and W[t + 1]. */
+        for (i = 16; i < 80; i += 2) {
+            x2 = _mm_load_si128((const __m128i *)&w[i - 2]);
+            x7 = _mm_loadu_si128((const __m128i *)&w[i - 7]);
+            x15 = _mm_loadu_si128((const __m128i *)&w[i - 15]);
+            x16 = _mm_load_si128((const __m128i *)&w[i - 16]);
+
+            s1 = _mm_xor_si128(_mm_xor_si128(SHA512_AVX2_VROTR(x2, 19), SHA512_AVX2_VROTR(x2, 61)), _mm_srli_epi64(x2, 6));
+            s0 = _mm_xor_si128(_mm_xor_si128(SHA512_AVX2_VROTR(x15, 1), SHA512_AVX2_VROTR(x15, 8)), _mm_srli_epi64(x15, 7));
+
+            _mm_store_si128((__m128i *)&w[i], _mm_add_epi64(_mm_add_epi64(s1, x7), _mm_add_epi64(s0, x16)));
+        }
+
+        /* Add the round constants, four at a time. */
+        for (i = 0; i < 80; i += 4) {
+            _mm256_store_si256((__m256i *)&wk[i], _mm256_add_epi64(_mm256_load_si256((const __m256i *)&w[i]),
+                                                                   _mm256_loadu_si256((const __m256i *)&sha512_k[i])));
+        }
+
+        a = state[0];
+        b = state[1];
+        c = state[2];
+        d = state[3];
+        e = state[4];
+        f = state[5];
+        g = state[6];
+        h = state[7];
+
+        for (i = 0; i < 80; i += 8) {
+            SHA512_AVX2_ROUND(a, b, c, d, e, f, g, h, i);
+            SHA512_AVX2_ROUND(h, a, b, c, d, e, f, g, i + 1);
+            SHA512_AVX2_ROUND(g, h, a, b, c, d, e, f, i + 2);
+            SHA512_AVX2_ROUND(f, g, h, a, b, c, d, e, i + 3);
+            SHA512_AVX2_ROUND(e, f, g, h, a, b, c, d, i + 4);
+            SHA512_AVX2_ROUND(d, e, f, g, h, a, b, c, i + 5);
+            SHA512_AVX2_ROUND(c, d, e, f, g, h, a, b, i + 6);
+            SHA512_AVX2_ROUND(b, c, d, e, f, g, h, a, i + 7);
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+
+        data += 128;
+        blocks--;
+    }
+
+    /* Wipe variables */
+    memset(w, 0, sizeof(w));
+    memset(wk, 0, sizeof(wk));
+}
+
+#else
+
+/* Never called, since sha512_avx2_available() always returns 0 on this platform. */
+void sha512_avx2_transform(unsigned long long state[8], const unsigned char *data, size_t blocks)
+{
+    (void)state;
+    (void)data;
+    (void)blocks;
+}
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * SHA-512 block function that uses AVX2 for the message schedule.
+ *
+ * Support is detected at run time, and sha512_transf() in sha2.c only calls in to here when
+ * the CPU supports it.
+ */
+
+#ifndef SHA512AVX2_H
+#define SHA512AVX2_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int sha512_avx2_available(void);
+
+void sha512_avx2_set_enabled(int enabled);
+int sha512_avx2_enabled(void);
+
+void sha512_avx2_transform(unsigned long long state[8], const unsigned char *data, size_t blocks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !SHA512AVX2_H */
@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 #include <cstring>
+#include "hashcontext.h"
 
 extern "C" {
 #include "sha2.h"                   //NOSONAR
@@ -24,6 +25,11 @@ ByteArray Sha512Hash::hash(const ByteArray &toHash)
     return result;
 }
 
+std::unique_ptr<HashContextBase> Sha512Hash::begin()
+{
+    return std::unique_ptr<HashContextBase>(new HashContextT<Sha512Policy>());
+}
+
 size_t Sha512Hash::hashResultLength()
 {
     return 64;
@@ -0,0 +1,273 @@
+#include "sha512multibuffer.h"
+
+#include <cstring>
+
+extern "C" {
+#include "sha2.h"                       //NOSONAR
+}
+
+// The AVX2 backend is only built for x86 with a compiler that understands the target
+// attribute, so that the rest of the program doesn't need to be built with -mavx2.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA512MULTIBUFFER_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief loadBigEndian64 - Read a 64 bit big endian value from a byte buffer.
+ *
+ * @param data - A pointer to the 8 bytes to read.
+ *
+ * @return uint64_t containing the value.
+ */
+static inline uint64_t loadBigEndian64(const unsigned char *data)
+{
+    uint64_t result = 0;
+
+    for (size_t i = 0; i < 8; i++) {
+        result = (result << 8) | static_cast<uint64_t>(data[i]);
+    }
+
+    return result;
+}
+
+/**
+ * @brief transformScalar - Run each block through sha512_transf(), one after another.
+ *
+ * @param states[IN/OUT] - The hash states to update.
+ * @param blocks - The 128 byte blocks to hash in to the matching state.
+ * @param count - The number of states and blocks.
+ */
+static void transformScalar(uint64_t *const states[], const unsigned char *const blocks[], size_t count)
+{
+    sha512_ctx ctx;
+
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = 0; j < 8; j++) {
+            ctx.h[j] = states[i][j];
+        }
+
+        sha512_transf(&ctx, blocks[i], 1);
+
+        for (size_t j = 0; j < 8; j++) {
+            states[i][j] = ctx.h[j];
+        }
+    }
+
+    // Clean up.
+    memset(&ctx, 0x00, sizeof(ctx));
+}
+
+#ifdef SHA512MULTIBUFFER_X86
+
+#define SHA512MULTIBUFFER_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi64((x), (n)), _mm256_slli_epi64((x), 64 - (n)))
+
+/**
+ * @brief transformAvx2 - Run up to 4 blocks through the SHA512 compression function at the
+ *      same time, with one block in each 64 bit lane of the AVX2 registers.
+ *
+ * @param states[IN/OUT] - The hash states to update.
+ * @param blocks - The 128 byte blocks to hash in to the matching state.
+ * @param count - The number of states and blocks.  (1..4)
+ */
+__attribute__((target("avx2")))
+static void transformAvx2(uint64_t *const states[], const unsigned char *const blocks[], size_t count)
+{
+    alignas(32) uint64_t words[16][4];
+    alignas(32) uint64_t digest[8][4];
+    __m256i w[16];
+    __m256i v[8];
+    __m256i s0, s1, ch, maj, t1, t2;
+    size_t source;
+
+    // Transpose the inputs so that each register holds the same word from each block.  Lanes
+    // that we don't have a block for just duplicate the first one, and are thrown away.
+    for (size_t lane = 0; lane < 4; lane++) {
+        source = (lane < count) ? lane : 0;
+
+        for (size_t t = 0; t < 16; t++) {
+            words[t][lane] = loadBigEndian64(blocks[source] + (t * 8));
+        }
+
+        for (size_t i = 0; i < 8; i++) {
+            digest[i][lane] = states[source][i];
+        }
+    }
+
+    for (size_t t = 0; t < 16; t++) {
+        w[t] = _mm256_load_si256(reinterpret_cast<const __m256i *>(words[t]));
+    }
+
+    for (size_t i = 0; i < 8; i++) {
+        v[i] = _mm256_load_si256(reinterpret_cast<const __m256i *>(digest[i]));
+    }
+
+    for (size_t t = 0; t < 80; t++) {
+        // Expand the message schedule in place.
+        if (t >= 16) {
+            s0 = _mm256_xor_si256(_mm256_xor_si256(SHA512MULTIBUFFER_ROTR(w[(t - 15) & 15], 1), SHA512MULTIBUFFER_ROTR(w[(t - 15) & 15], 8)), _mm256_srli_epi64(w[(t - 15) & 15], 7));
+            s1 = _mm256_xor_si256(_mm256_xor_si256(SHA512MULTIBUFFER_ROTR(w[(t - 2) & 15], 19), SHA512MULTIBUFFER_ROTR(w[(t - 2) & 15], 61)), _mm256_srli_epi64(w[(t - 2) & 15], 6));
+            w[t & 15] = _mm256_add_epi64(_mm256_add_epi64(w[t & 15], s0), _mm256_add_epi64(w[(t - 7) & 15], s1));
+        }
+
+        // v[0..7] are a..h.
+        s1 = _mm256_xor_si256(_mm256_xor_si256(SHA512MULTIBUFFER_ROTR(v[4], 14), SHA512MULTIBUFFER_ROTR(v[4], 18)), SHA512MULTIBUFFER_ROTR(v[4], 41));
+        ch = _mm256_xor_si256(v[6], _mm256_and_si256(v[4], _mm256_xor_si256(v[5], v[6])));
+        t1 = _mm256_add_epi64(_mm256_add_epi64(v[7], s1), _mm256_add_epi64(ch, _mm256_add_epi64(w[t & 15], _mm256_set1_epi64x(static_cast<long long>(sha512_k[t])))));
+
+        s0 = _mm256_xor_si256(_mm256_xor_si256(SHA512MULTIBUFFER_ROTR(v[0], 28), SHA512MULTIBUFFER_ROTR(v[0], 34)), SHA512MULTIBUFFER_ROTR(v[0], 39));
+        maj = _mm256_or_si256(_mm256_and_si256(v[0], v[1]), _mm256_and_si256(v[2], _mm256_or_si256(v[0], v[1])));
+        t2 = _mm256_add_epi64(s0, maj);
+
+        v[7] = v[6];
+        v[6] = v[5];
+        v[5] = v[4];
+        v[4] = _mm256_add_epi64(v[3], t1);
+        v[3] = v[2];
+        v[2] = v[1];
+        v[1] = v[0];
+        v[0] = _mm256_add_epi64(t1, t2);
+    }
+
+    for (size_t i = 0; i < 8; i++) {
+        _mm256_store_si256(reinterpret_cast<__m256i *>(digest[i]), _mm256_add_epi64(v[i], _mm256_load_si256(reinterpret_cast<const __m256i *>(digest[i]))));
+    }
+
+    for (size_t lane = 0; lane < count; lane++) {
+        for (size_t i = 0; i < 8; i++) {
+            states[lane][i] = digest[i][lane];
+        }
+    }
+
+    // Clean up.
+    memset(&words, 0x00, sizeof(words));
+    memset(&digest, 0x00, sizeof(digest));
+}
+
+#endif // SHA512MULTIBUFFER_X86
+
+/**
+ * @brief Sha512MultiBuffer::transform - Run each block through the SHA512 compression function,
+ *      updating the matching state, using the best backend the CPU supports.
+ *
+ * @param states[IN/OUT] - The hash states to update.  Each points to 8 words.
+ * @param blocks - The 128 byte blocks to hash in to the matching state.
+ * @param count - The number of states and blocks.
+ */
+void Sha512MultiBuffer::transform(uint64_t *const states[], const unsigned char *const blocks[], size_t count)
+{
+    // The best backend is always supported, so this can't fail.
+    transform(bestBackend(), states, blocks, count);
+}
+
+/**
+ * @brief Sha512MultiBuffer::transform - Run each block through the SHA512 compression function,
+ *      updating the matching state, using the requested backend.
+ *
+ * @param backend - One of the SHA512MULTIBUFFER_BACKEND_* values.
+ * @param states[IN/OUT] - The hash states to update.  Each points to 8 words.
+ * @param blocks - The 128 byte blocks to hash in to the matching state.
+ * @param count - The number of states and blocks.
+ *
+ * @return true if the blocks were hashed.  false if the backend isn't supported on this CPU.
+ */
+bool Sha512MultiBuffer::transform(unsigned int backend, uint64_t *const states[], const unsigned char *const blocks[], size_t count)
+{
+    size_t laneCount;
+    size_t chunk;
+
+    if (!backendSupported(backend)) {
+        return false;
+    }
+
+    laneCount = lanes(backend);
+
+    for (size_t i = 0; i < count; i += laneCount) {
+        chunk = ((count - i) < laneCount) ? (count - i) : laneCount;
+
+        switch (backend) {
+#ifdef SHA512MULTIBUFFER_X86
+        case SHA512MULTIBUFFER_BACKEND_AVX2:
+            transformAvx2(&states[i], &blocks[i], chunk);
+            break;
+#endif // SHA512MULTIBUFFER_X86
+
+        default:
+            transformScalar(&states[i], &blocks[i], chunk);
+            break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Sha512MultiBuffer::bestBackend - Return the fastest backend that this CPU supports.
+ *
+ * @return unsigned int containing one of the SHA512MULTIBUFFER_BACKEND_* values.
+ */
+unsigned int Sha512MultiBuffer::bestBackend()
+{
+    // Only check the CPU the first time through.
+    static const unsigned int backend = detectBackend();
+
+    return backend;
+}
+
+/**
+ * @brief Sha512MultiBuffer::backendSupported - Check to see if the CPU we are running on
+ *      supports the requested backend.
+ *
+ * @param backend - One of the SHA512MULTIBUFFER_BACKEND_* values.
+ *
+ * @return true if the backend can be used.  false otherwise.
+ */
+bool Sha512MultiBuffer::backendSupported(unsigned int backend)
+{
+    switch (backend) {
+    case SHA512MULTIBUFFER_BACKEND_SCALAR:
+        return true;
+
+#ifdef SHA512MULTIBUFFER_X86
+    case SHA512MULTIBUFFER_BACKEND_AVX2:
+        __builtin_cpu_init();
+        return (__builtin_cpu_supports("avx2") != 0);
+#endif // SHA512MULTIBUFFER_X86
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Sha512MultiBuffer::lanes - Return the number of blocks the backend hashes at once.
+ *
+ * @param backend - One of the SHA512MULTIBUFFER_BACKEND_* values.
+ *
+ * @return size_t containing the number of lanes.
+ */
+size_t Sha512MultiBuffer::lanes(unsigned int backend)
+{
+    switch (backend) {
+    case SHA512MULTIBUFFER_BACKEND_AVX2:
+        return 4;
+
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Sha512MultiBuffer::detectBackend - Work out which backend is the fastest one the CPU
+ *      supports.
+ *
+ * @return unsigned int containing one of the SHA512MULTIBUFFER_BACKEND_* values.
+ */
+unsigned int Sha512MultiBuffer::detectBackend()
+{
+    if (backendSupported(SHA512MULTIBUFFER_BACKEND_AVX2)) {
+        return SHA512MULTIBUFFER_BACKEND_AVX2;
+    }
+
+    return SHA512MULTIBUFFER_BACKEND_SCALAR;
+}
@@ -0,0 +1,35 @@
+#ifndef SHA512MULTIBUFFER_H
+#define SHA512MULTIBUFFER_H
+
+#include <cstdlib>
+#include <cstdint>
+
+const unsigned int SHA512MULTIBUFFER_BACKEND_SCALAR=0;    // One block at a time, using sha512_transf().
+const unsigned int SHA512MULTIBUFFER_BACKEND_AVX2=1;      // Four blocks at a time.
+
+const size_t SHA512MULTIBUFFER_MAX_LANES=4;               // The most blocks any backend hashes at once.
+
+/**
+ * @brief The Sha512MultiBuffer class runs the SHA512 compression function over several
+ *      independent (state, block) pairs at the same time, using one 64 bit SIMD lane per pair.
+ *      Like Sha1MultiBuffer, this is meant for hashing a lot of short messages, such as the
+ *      final blocks of a batch of HMACs.
+ *
+ *      The best backend the CPU supports is selected the first time it is needed, with
+ *      sha512_transf() in sha2.c used as the fallback.
+ */
+class Sha512MultiBuffer
+{
+public:
+    static void transform(uint64_t *const states[], const unsigned char *const blocks[], size_t count);
+    static bool transform(unsigned int backend, uint64_t *const states[], const unsigned char *const blocks[], size_t count);
+
+    static unsigned int bestBackend();
+    static bool backendSupported(unsigned int backend);
+    static size_t lanes(unsigned int backend);
+
+private:
+    static unsigned int detectBackend();
+};
+
+#endif // SHA512MULTIBUFFER_H
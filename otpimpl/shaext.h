@@ -0,0 +1,32 @@
+/*
+ * Hardware accelerated SHA1 and SHA256 block functions.
+ *
+ * On x86 these use the SHA extensions (SHA-NI), and on 64 bit ARM Linux they use the ARMv8
+ * cryptography extensions.  Support is detected at run time, and the portable transforms in
+ * sha1impl.c and sha2.c only call in to here when the CPU supports it.
+ */
+
+#ifndef SHAEXT_H
+#define SHAEXT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int sha_ext_sha1_available(void);
+int sha_ext_sha256_available(void);
+
+void sha_ext_set_enabled(int enabled);
+int sha_ext_enabled(void);
+
+void sha_ext_sha1_transform(uint32_t state[5], const unsigned char *data, size_t blocks);
+void sha_ext_sha256_transform(uint32_t state[8], const unsigned char *data, size_t blocks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !SHAEXT_H */
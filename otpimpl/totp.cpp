@@ -1,6 +1,7 @@
 #include "totp.h"
 
 #include "hotp.h"
+#include "otpcode.h"
 #include "logger.h"
 
 Totp::Totp()
@@ -8,7 +9,7 @@ Totp::Totp()
     mHmacToUse = nullptr;
 }
 
-Totp::Totp(std::shared_ptr<Hmac> hmacToUse) :
+Totp::Totp(const std::shared_ptr<Hmac> &hmacToUse) :
     mHmacToUse(hmacToUse)
 {
 }
@@ -19,7 +20,7 @@ Totp::Totp(std::shared_ptr<Hmac> hmacToUse) :
  * @param hmacToUse - A pointer to the HMAC object that should be used when calculating a
  *      TOTP value.
  */
-void Totp::setHmac(std::shared_ptr<Hmac> &hmacToUse)
+void Totp::setHmac(const std::shared_ptr<Hmac> &hmacToUse)
 {
     // Set the new values to use.
     mHmacToUse = hmacToUse;
@@ -53,3 +54,28 @@ std::string Totp::calculate(const ByteArray &decodedSecret, time_t utcTime, size
     // Then, calculate the HOTP using the key, and the calcTime.
     return hotp.calculate(decodedSecret, calcTime, digits);
 }
+
+/**
+ * @brief Totp::calculate - Calculate a TOTP value using a key whose HMAC pad states have
+ *      already been calculated.
+ *
+ * @param key - The HmacKey to use when calculating the TOTP value.
+ * @param utcTime - The current time in the UTC time zone.
+ * @param timeStep - The length of time that the TOTP should be valid for.  (Should usually be
+ *      left at the default of 30.)
+ * @param digits - The number of digits to return for the TOTP.
+ * @param initialCounter - An offset to apply to the UTC time when calculating the TOTP value.
+ *
+ * @return std::string containing the OTP value.  On error, an empty string is returned.
+ */
+std::string Totp::calculate(const HmacKey &key, time_t utcTime, size_t timeStep, size_t digits, uint64_t initialCounter)
+{
+    char code[OTPCODE_BUFFER_SIZE];
+
+    if (!OtpCode::totp(key, utcTime, timeStep, digits, code, initialCounter)) {
+        // Already logged the error.
+        return "";
+    }
+
+    return std::string(code);
+}
@@ -2,6 +2,7 @@
 #define TOTP_H
 
 #include "hmac.h"
+#include "hmackey.h"
 
 #include <string>
 #include <cstdint>
@@ -10,11 +11,12 @@ class Totp
 {
 public:
     Totp();
-    explicit Totp(std::shared_ptr<Hmac> hmacToUse);
+    explicit Totp(const std::shared_ptr<Hmac> &hmacToUse);
 
-    void setHmac(std::shared_ptr<Hmac> &hmacToUse);
+    void setHmac(const std::shared_ptr<Hmac> &hmacToUse);
 
     std::string calculate(const ByteArray &decodedSecret, time_t utcTime, size_t timeStep = 30, size_t digits = 6, uint64_t initialCounter = 0);
+    std::string calculate(const HmacKey &key, time_t utcTime, size_t timeStep = 30, size_t digits = 6, uint64_t initialCounter = 0);
 
 private:
     std::shared_ptr<Hmac> mHmacToUse;
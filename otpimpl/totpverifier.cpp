@@ -0,0 +1,503 @@
+#include "totpverifier.h"
+
+#include <cstring>
+#include "otpcode.h"
+#include "../logger.h"
+
+TotpVerifier::TotpVerifier(size_t window, size_t timeStep, size_t digits, uint64_t initialCounter)
+{
+    mWindow = 1;
+    mTimeStep = 30;
+    mDigits = 6;
+    mInitialCounter = initialCounter;
+
+    // If any of these are invalid, the default stays in place.
+    setWindow(window);
+    setTimeStep(timeStep);
+    setDigits(digits);
+}
+
+/**
+ * @brief TotpVerifier::setWindow - Set the number of time steps on either side of the current
+ *      one that a code will be accepted for.
+ *
+ * @param window - The number of time steps.  0 only accepts the code for the current time step.
+ *
+ * @return true if the window was set.  false if it is larger than TOTPVERIFIER_MAX_WINDOW.
+ */
+bool TotpVerifier::setWindow(size_t window)
+{
+    if (window > TOTPVERIFIER_MAX_WINDOW) {
+        LOG_ERROR("The TOTP verification window can't be larger than " + QString::number(TOTPVERIFIER_MAX_WINDOW) + " steps!");
+        return false;
+    }
+
+    mWindow = window;
+    return true;
+}
+
+/**
+ * @brief TotpVerifier::window - Get the number of time steps on either side of the current one
+ *      that a code will be accepted for.
+ *
+ * @return size_t containing the window.
+ */
+size_t TotpVerifier::window() const
+{
+    return mWindow;
+}
+
+/**
+ * @brief TotpVerifier::setTimeStep - Set the length of each time step.
+ *
+ * @param timeStep - The length of a time step, in seconds.  Must not be 0.
+ *
+ * @return true if the time step was set.  false on error.
+ */
+bool TotpVerifier::setTimeStep(size_t timeStep)
+{
+    if (0 == timeStep) {
+        LOG_ERROR("The TOTP time step can't be 0!");
+        return false;
+    }
+
+    mTimeStep = timeStep;
+    return true;
+}
+
+/**
+ * @brief TotpVerifier::timeStep - Get the length of each time step.
+ *
+ * @return size_t containing the time step, in seconds.
+ */
+size_t TotpVerifier::timeStep() const
+{
+    return mTimeStep;
+}
+
+/**
+ * @brief TotpVerifier::setDigits - Set the number of digits the codes being verified have.
+ *
+ * @param digits - The number of digits.  (6, 7, or 8)
+ *
+ * @return true if the digit count was set.  false on error.
+ */
+bool TotpVerifier::setDigits(size_t digits)
+{
+    if ((digits < 6) || (digits > 8)) {
+        LOG_ERROR("An invalid number of digits was requested!  It must be 6, 7, or 8!");
+        return false;
+    }
+
+    mDigits = digits;
+    return true;
+}
+
+/**
+ * @brief TotpVerifier::digits - Get the number of digits the codes being verified have.
+ *
+ * @return size_t containing the number of digits.
+ */
+size_t TotpVerifier::digits() const
+{
+    return mDigits;
+}
+
+/**
+ * @brief TotpVerifier::setInitialCounter - Set the offset applied to the UTC time.  (T0 in
+ *      RFC 6238.)
+ *
+ * @param initialCounter - The offset to apply.
+ */
+void TotpVerifier::setInitialCounter(uint64_t initialCounter)
+{
+    mInitialCounter = initialCounter;
+}
+
+/**
+ * @brief TotpVerifier::initialCounter - Get the offset applied to the UTC time.
+ *
+ * @return uint64_t containing the offset.
+ */
+uint64_t TotpVerifier::initialCounter() const
+{
+    return mInitialCounter;
+}
+
+/**
+ * @brief TotpVerifier::setReplayCache - Set the cache used to reject codes that have already
+ *      been accepted.
+ *
+ * @param replayCache - The cache to use.  It can be shared between verifiers (and threads).
+ */
+void TotpVerifier::setReplayCache(const std::shared_ptr<ReplayCache> &replayCache)
+{
+    mReplayCache = replayCache;
+}
+
+/**
+ * @brief TotpVerifier::replayCache - Get the cache used to reject codes that have already been
+ *      accepted.
+ *
+ * @return std::shared_ptr containing the cache.  (nullptr if one isn't set.)
+ */
+std::shared_ptr<ReplayCache> TotpVerifier::replayCache() const
+{
+    return mReplayCache;
+}
+
+/**
+ * @brief TotpVerifier::verify - Check a code against the codes for every time step in the
+ *      window.
+ *
+ * @param key - The HmacKey for the secret the code should have been generated from.
+ * @param code - The null terminated code to check.
+ * @param utcTime - The current time in the UTC time zone.
+ * @param matchedOffset[OUT] - If this method returns true, the number of time steps away from
+ *      the current one that the code matched.  (Negative values are in the past.)  If more than
+ *      one step matched, the one closest to the current step is used.
+ *
+ * @return true if the code matched one of the time steps.  false if it didn't, or on error.
+ */
+bool TotpVerifier::verify(const HmacKey &key, const char *code, time_t utcTime, int &matchedOffset) const
+{
+    const HmacKey *keys[TOTPVERIFIER_MAX_STEPS];
+    uint64_t counters[TOTPVERIFIER_MAX_STEPS];
+    char results[TOTPVERIFIER_MAX_STEPS][OTPCODE_BUFFER_SIZE];
+    char *resultPtrs[TOTPVERIFIER_MAX_STEPS];
+    uint64_t baseCounter;
+    bool matched;
+
+    if ((!key.valid()) || (nullptr == code)) {
+        LOG_ERROR("Invalid parameters provided to verify a TOTP code!");
+        return false;
+    }
+
+    if ((utcTime < 0) || (static_cast<uint64_t>(utcTime) < mInitialCounter)) {
+        LOG_ERROR("Unable to verify a TOTP code for a time before the initial counter!");
+        return false;
+    }
+
+    if (!validCandidate(code)) {
+        // Not even the right shape, so it can't match.
+        return false;
+    }
+
+    baseCounter = OtpCode::timeToCounter(utcTime, mTimeStep, mInitialCounter);
+
+    // Calculate the codes for the whole window in one batch, using the same key.
+    for (size_t i = 0; i < stepCount(); i++) {
+        keys[i] = &key;
+        counters[i] = baseCounter + static_cast<uint64_t>(static_cast<int64_t>(stepOffset(i)));
+        resultPtrs[i] = results[i];
+    }
+
+    if (!OtpCode::hotpMany(keys, counters, stepCount(), mDigits, resultPtrs)) {
+        LOG_ERROR("Unable to calculate the TOTP codes to verify against!");
+        memset(&results, 0x00, sizeof(results));
+        return false;
+    }
+
+    matched = pickMatch(resultPtrs, baseCounter, code, matchedOffset);
+
+    // Clean up.
+    memset(&results, 0x00, sizeof(results));
+
+    return matched;
+}
+
+/**
+ * @brief TotpVerifier::verify - Check a code against the codes for every time step in the
+ *      window, and make sure it hasn't been accepted before.  If it is accepted, it is recorded
+ *      in the replay cache so it can't be used again.
+ *
+ * @param key - The HmacKey for the secret the code should have been generated from.
+ * @param entryId - The ID of the secret in the replay cache.  (See ReplayCache::entryId().)
+ * @param code - The null terminated code to check.
+ * @param utcTime - The current time in the UTC time zone.
+ * @param matchedOffset[OUT] - If this method returns true, the number of time steps away from
+ *      the current one that the code matched.
+ *
+ * @return true if the code matched, and hadn't been used before.  false if it didn't match, was
+ *      a replay, or on error.
+ */
+bool TotpVerifier::verify(const HmacKey &key, uint64_t entryId, const char *code, time_t utcTime, int &matchedOffset) const
+{
+    int offset;
+
+    if (nullptr == mReplayCache) {
+        LOG_ERROR("No replay cache was set when verifying a TOTP code with replay protection!");
+        return false;
+    }
+
+    if (!verify(key, code, utcTime, offset)) {
+        return false;
+    }
+
+    if (!markUsed(entryId, utcTime, offset)) {
+        return false;
+    }
+
+    matchedOffset = offset;
+    return true;
+}
+
+/**
+ * @brief TotpVerifier::verifyMany - Check a batch of codes, each against its own key.  The
+ *      codes for every key and time step are calculated in large batches, so this is much
+ *      faster than calling verify() for each code.
+ *
+ * @param keys - The HmacKey for each code.
+ * @param codes - The null terminated codes to check.
+ * @param count - The number of keys, codes, and results.
+ * @param utcTime - The current time in the UTC time zone.
+ * @param matched[OUT] - If this method returns true, each entry will be true if the matching
+ *      code was valid.  Entries with an invalid key are flagged as not matched.
+ * @param matchedOffsets[OUT] - If this method returns true, each entry with a match will be
+ *      set to the number of time steps away from the current one that the code matched.
+ *
+ * @return true if the batch was checked.  false on error.
+ */
+bool TotpVerifier::verifyMany(const HmacKey *const keys[], const char *const codes[], size_t count, time_t utcTime, bool matched[], int matchedOffsets[]) const
+{
+    const HmacKey *chunkKeys[TOTPVERIFIER_BATCH_CHUNK_SIZE];
+    uint64_t counters[TOTPVERIFIER_BATCH_CHUNK_SIZE];
+    char results[TOTPVERIFIER_BATCH_CHUNK_SIZE][OTPCODE_BUFFER_SIZE];
+    char *resultPtrs[TOTPVERIFIER_BATCH_CHUNK_SIZE];
+    size_t owners[TOTPVERIFIER_BATCH_CHUNK_SIZE];
+    size_t keysPerChunk;
+    size_t chunkOwners;
+    size_t next;
+    uint64_t baseCounter;
+    bool success = true;
+
+    if ((nullptr == keys) || (nullptr == codes) || (nullptr == matched) || (nullptr == matchedOffsets)) {
+        LOG_ERROR("Invalid parameters provided to verify a batch of TOTP codes!");
+        return false;
+    }
+
+    if ((utcTime < 0) || (static_cast<uint64_t>(utcTime) < mInitialCounter)) {
+        LOG_ERROR("Unable to verify TOTP codes for a time before the initial counter!");
+        return false;
+    }
+
+    baseCounter = OtpCode::timeToCounter(utcTime, mTimeStep, mInitialCounter);
+
+    // Fit as many whole windows as we can in to each chunk.
+    keysPerChunk = TOTPVERIFIER_BATCH_CHUNK_SIZE / stepCount();
+
+    for (size_t i = 0; i < TOTPVERIFIER_BATCH_CHUNK_SIZE; i++) {
+        resultPtrs[i] = results[i];
+    }
+
+    next = 0;
+    while ((success) && (next < count)) {
+        chunkOwners = 0;
+
+        // Collect the next set of keys that are usable.
+        while ((chunkOwners < keysPerChunk) && (next < count)) {
+            matched[next] = false;
+            matchedOffsets[next] = 0;
+
+            if ((nullptr == keys[next]) || (!keys[next]->valid()) || (nullptr == codes[next])) {
+                LOG_ERROR("Invalid key or code at index " + QString::number(next) + " of a TOTP verification batch!");
+            } else if (validCandidate(codes[next])) {
+                for (size_t s = 0; s < stepCount(); s++) {
+                    chunkKeys[(chunkOwners * stepCount()) + s] = keys[next];
+                    counters[(chunkOwners * stepCount()) + s] = baseCounter + static_cast<uint64_t>(static_cast<int64_t>(stepOffset(s)));
+                }
+
+                owners[chunkOwners] = next;
+                chunkOwners++;
+            }
+
+            next++;
+        }
+
+        if (0 == chunkOwners) {
+            continue;
+        }
+
+        if (!OtpCode::hotpMany(chunkKeys, counters, chunkOwners * stepCount(), mDigits, resultPtrs)) {
+            LOG_ERROR("Unable to calculate the TOTP codes for a verification batch!");
+            success = false;
+            break;
+        }
+
+        for (size_t k = 0; k < chunkOwners; k++) {
+            matched[owners[k]] = pickMatch(&resultPtrs[k * stepCount()], baseCounter, codes[owners[k]], matchedOffsets[owners[k]]);
+        }
+    }
+
+    // Clean up.
+    memset(&results, 0x00, sizeof(results));
+
+    return success;
+}
+
+/**
+ * @brief TotpVerifier::verifyMany - Check a batch of codes, each against its own key, and
+ *      reject any that have already been accepted.  The codes that are accepted are recorded
+ *      in the replay cache.  If the same code shows up more than once in the batch, only the
+ *      first one is accepted.
+ *
+ * @param keys - The HmacKey for each code.
+ * @param entryIds - The ID of each secret in the replay cache.
+ * @param codes - The null terminated codes to check.
+ * @param count - The number of keys, entry IDs, codes, and results.
+ * @param utcTime - The current time in the UTC time zone.
+ * @param matched[OUT] - If this method returns true, each entry will be true if the matching
+ *      code was valid, and hadn't been used before.
+ * @param matchedOffsets[OUT] - If this method returns true, each entry with a match will be
+ *      set to the number of time steps away from the current one that the code matched.
+ *
+ * @return true if the batch was checked.  false on error.
+ */
+bool TotpVerifier::verifyMany(const HmacKey *const keys[], const uint64_t entryIds[], const char *const codes[], size_t count, time_t utcTime, bool matched[], int matchedOffsets[]) const
+{
+    if ((nullptr == mReplayCache) || (nullptr == entryIds)) {
+        LOG_ERROR("No replay cache or entry IDs were provided when verifying TOTP codes with replay protection!");
+        return false;
+    }
+
+    if (!verifyMany(keys, codes, count, utcTime, matched, matchedOffsets)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (matched[i]) {
+            matched[i] = markUsed(entryIds[i], utcTime, matchedOffsets[i]);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief TotpVerifier::constantTimeEquals - Compare two codes without stopping at the first
+ *      difference, so the time taken doesn't leak how much of the code was right.
+ *
+ * @param calculated - The code that was calculated.
+ * @param candidate - The code that was provided.
+ * @param length - The number of characters to compare.
+ *
+ * @return true if the codes are the same.  false otherwise.
+ */
+bool TotpVerifier::constantTimeEquals(const char *calculated, const char *candidate, size_t length)
+{
+    unsigned char diff = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        diff |= static_cast<unsigned char>(calculated[i] ^ candidate[i]);
+    }
+
+    return (0 == diff);
+}
+
+/**
+ * @brief TotpVerifier::stepCount - Get the number of codes calculated for each candidate.
+ *
+ * @return size_t containing the number of time steps in the window.
+ */
+size_t TotpVerifier::stepCount() const
+{
+    return (mWindow * 2) + 1;
+}
+
+/**
+ * @brief TotpVerifier::stepOffset - Get the time step offset that a step index maps to.  The
+ *      steps are ordered by their distance from the current step (0, -1, 1, -2, 2, ...) so the
+ *      closest match is the first one found.
+ *
+ * @param step - The step index.  (0 .. stepCount() - 1)
+ *
+ * @return int containing the offset from the current time step.
+ */
+int TotpVerifier::stepOffset(size_t step) const
+{
+    if (0 == (step % 2)) {
+        return static_cast<int>(step / 2);
+    }
+
+    return -static_cast<int>((step + 1) / 2);
+}
+
+/**
+ * @brief TotpVerifier::validCandidate - Make sure that a provided code is the right length, and
+ *      only contains digits.
+ *
+ * @param code - The null terminated code to check.
+ *
+ * @return true if the code could be a valid code.  false otherwise.
+ */
+bool TotpVerifier::validCandidate(const char *code) const
+{
+    for (size_t i = 0; i < mDigits; i++) {
+        if ((code[i] < '0') || (code[i] > '9')) {
+            return false;
+        }
+    }
+
+    return (0x00 == code[mDigits]);
+}
+
+/**
+ * @brief TotpVerifier::markUsed - Record a code that matched in the replay cache.
+ *
+ * @param entryId - The ID of the secret in the replay cache.
+ * @param utcTime - The current time in the UTC time zone.
+ * @param matchedOffset - The offset of the step the code matched.
+ *
+ * @return true if the code hadn't been used before.  false if it had, or if it couldn't be
+ *      recorded.
+ */
+bool TotpVerifier::markUsed(uint64_t entryId, time_t utcTime, int matchedOffset) const
+{
+    uint64_t currentStep = OtpCode::timeToCounter(utcTime, mTimeStep, mInitialCounter);
+    uint64_t matchedStep = currentStep + static_cast<uint64_t>(static_cast<int64_t>(matchedOffset));
+
+    return (REPLAYCACHE_ACCEPTED == mReplayCache->markUsed(entryId, matchedStep, currentStep));
+}
+
+/**
+ * @brief TotpVerifier::pickMatch - Compare a code against all of the calculated codes for a
+ *      window.  Every code is compared, and the match is picked without branching on the
+ *      result, so the time taken is the same no matter which step (if any) matched.
+ *
+ * @param calculated - The codes calculated for each step of the window.
+ * @param baseCounter - The counter for the current time step.
+ * @param code - The code that was provided.
+ * @param matchedOffset[OUT] - If this method returns true, the offset of the matching step.
+ *
+ * @return true if one of the steps matched.  false otherwise.
+ */
+bool TotpVerifier::pickMatch(const char *const calculated[], uint64_t baseCounter, const char *code, int &matchedOffset) const
+{
+    uint32_t found = 0;
+    uint32_t offset = 0;
+    uint32_t isMatch;
+    uint32_t mask;
+    int stepOff;
+
+    for (size_t s = 0; s < stepCount(); s++) {
+        stepOff = stepOffset(s);
+        isMatch = constantTimeEquals(calculated[s], code, mDigits) ? 1 : 0;
+
+        // Steps before counter 0 don't exist, so they can never match.
+        if ((stepOff < 0) && (baseCounter < static_cast<uint64_t>(-stepOff))) {
+            isMatch = 0;
+        }
+
+        // Only take the first match.
+        mask = 0 - (isMatch & (found ^ 1));
+        offset = (offset & ~mask) | (static_cast<uint32_t>(stepOff) & mask);
+        found |= isMatch;
+    }
+
+    if (0 == found) {
+        return false;
+    }
+
+    matchedOffset = static_cast<int>(offset);
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef TOTPVERIFIER_H
+#define TOTPVERIFIER_H
+
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+
+#include "hmackey.h"
+#include "replaycache.h"
+
+const size_t TOTPVERIFIER_MAX_WINDOW=10;                                    // The most time steps on either side of "now" that can be checked.
+const size_t TOTPVERIFIER_MAX_STEPS=((TOTPVERIFIER_MAX_WINDOW * 2) + 1);   // The most codes calculated for a single candidate.
+const size_t TOTPVERIFIER_BATCH_CHUNK_SIZE=64;                              // The most codes calculated per call to OtpCode::hotpMany().
+
+/**
+ * @brief The TotpVerifier class checks a TOTP code provided by a user against the codes for
+ *      the current time step, and up to 'window' time steps on either side of it, to allow for
+ *      clock drift between the two sides.
+ *
+ *      All of the codes in the window are calculated from the cached HmacKey pad states in one
+ *      batch, and every one of them is compared in constant time, so the time it takes to
+ *      verify a code doesn't depend on whether, or where, it matched.  verifyMany() does the
+ *      same for a large number of (key, code) pairs, feeding the HMACs to the multi-buffer
+ *      hash code several at a time.
+ *
+ *      If a ReplayCache is set, the overloads that take entry IDs also reject codes that have
+ *      already been accepted, and record the ones they accept.
+ */
+class TotpVerifier
+{
+public:
+    TotpVerifier(size_t window = 1, size_t timeStep = 30, size_t digits = 6, uint64_t initialCounter = 0);
+    ~TotpVerifier() = default;
+
+    bool setWindow(size_t window);
+    size_t window() const;
+
+    bool setTimeStep(size_t timeStep);
+    size_t timeStep() const;
+
+    bool setDigits(size_t digits);
+    size_t digits() const;
+
+    void setInitialCounter(uint64_t initialCounter);
+    uint64_t initialCounter() const;
+
+    void setReplayCache(const std::shared_ptr<ReplayCache> &replayCache);
+    std::shared_ptr<ReplayCache> replayCache() const;
+
+    bool verify(const HmacKey &key, const char *code, time_t utcTime, int &matchedOffset) const;
+    bool verify(const HmacKey &key, uint64_t entryId, const char *code, time_t utcTime, int &matchedOffset) const;
+    bool verifyMany(const HmacKey *const keys[], const char *const codes[], size_t count, time_t utcTime, bool matched[], int matchedOffsets[]) const;
+    bool verifyMany(const HmacKey *const keys[], const uint64_t entryIds[], const char *const codes[], size_t count, time_t utcTime, bool matched[], int matchedOffsets[]) const;
+
+    static bool constantTimeEquals(const char *calculated, const char *candidate, size_t length);
+
+private:
+    size_t stepCount() const;
+    int stepOffset(size_t step) const;
+    bool validCandidate(const char *code) const;
+    bool markUsed(uint64_t entryId, time_t utcTime, int matchedOffset) const;
+    bool pickMatch(const char *const calculated[], uint64_t baseCounter, const char *code, int &matchedOffset) const;
+
+    size_t mWindow;
+    size_t mTimeStep;
+    size_t mDigits;
+    uint64_t mInitialCounter;
+    std::shared_ptr<ReplayCache> mReplayCache;
+};
+
+#endif // TOTPVERIFIER_H
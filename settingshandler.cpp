@@ -6,9 +6,11 @@
 
 #include "utils.h"
 #include "keyentriessingleton.h"
+#include "keystorage/database/secretdatabase.h"
 
 const QString DOT_DIRECTORY = ".Rollin";          // The name of the dot directory we will initially use to store the database file.
 const QString DEFAULT_DB_NAME = "keydatabase.db"; // The file name that will be used by default for the database that stores key data.
+const unsigned int DEFAULT_CHECKPOINT_INTERVAL = 300;     // The number of seconds between database checkpoints.
 
 SettingsHandler::~SettingsHandler()
 {
@@ -154,6 +156,136 @@ void SettingsHandler::setLogToFile(bool newvalue)
     Logger::getInstance()->setLogToFile(mLogToFile);
 }
 
+/**
+ * @brief SettingsHandler::maxCalculationThreads - Return the most threads that should be used
+ *      to calculate the OTP codes for all of the key entries.
+ *
+ * @return unsigned int containing the maximum number of threads.  0 means one per CPU core.
+ */
+unsigned int SettingsHandler::maxCalculationThreads()
+{
+    return mMaxCalculationThreads;
+}
+
+/**
+ * @brief SettingsHandler::setMaxCalculationThreads - Change the most threads that should be
+ *      used to calculate the OTP codes for all of the key entries.
+ *
+ * @param newvalue - The maximum number of threads to use.  0 uses one per CPU core.
+ */
+void SettingsHandler::setMaxCalculationThreads(unsigned int newvalue)
+{
+    mMaxCalculationThreads = newvalue;
+
+    mSettingsDatabase->setValue("Settings/maxCalculationThreads", mMaxCalculationThreads);
+
+    // Change the number of threads that are used.
+    KeyEntriesSingleton::getInstance()->setMaxCalculationThreads(mMaxCalculationThreads);
+}
+
+/**
+ * @brief SettingsHandler::databaseWriteAheadLog - Return the setting that indicates if the key
+ *      database should use a write-ahead log, rather than a rollback journal.
+ *
+ * @return true if the database should use a write-ahead log.  false otherwise.
+ */
+bool SettingsHandler::databaseWriteAheadLog()
+{
+    return mDatabaseWriteAheadLog;
+}
+
+/**
+ * @brief SettingsHandler::setDatabaseWriteAheadLog - Change the setting that indicates if the key
+ *      database should use a write-ahead log.  The change is used the next time the database
+ *      is opened.
+ *
+ * @param newvalue - true if the database should use a write-ahead log.  false to use a rollback
+ *      journal.
+ */
+void SettingsHandler::setDatabaseWriteAheadLog(bool newvalue)
+{
+    mDatabaseWriteAheadLog = newvalue;
+
+    mSettingsDatabase->setValue("Settings/databaseWriteAheadLog", mDatabaseWriteAheadLog);
+}
+
+/**
+ * @brief SettingsHandler::databaseCacheSizeKb - Return the size of the page cache used for the
+ *      key database.
+ *
+ * @return unsigned int containing the size of the cache, in KiB.
+ */
+unsigned int SettingsHandler::databaseCacheSizeKb()
+{
+    return mDatabaseCacheSizeKb;
+}
+
+/**
+ * @brief SettingsHandler::setDatabaseCacheSizeKb - Change the size of the page cache used for
+ *      the key database.  The change is used the next time the database is opened.
+ *
+ * @param newvalue - The size of the cache, in KiB.
+ */
+void SettingsHandler::setDatabaseCacheSizeKb(unsigned int newvalue)
+{
+    mDatabaseCacheSizeKb = newvalue;
+
+    mSettingsDatabase->setValue("Settings/databaseCacheSizeKb", mDatabaseCacheSizeKb);
+}
+
+/**
+ * @brief SettingsHandler::databaseMmapSizeKb - Return the most of the key database file that
+ *      should be read through a memory map.
+ *
+ * @return unsigned int containing the size of the memory map, in KiB.  0 means no memory map.
+ */
+unsigned int SettingsHandler::databaseMmapSizeKb()
+{
+    return mDatabaseMmapSizeKb;
+}
+
+/**
+ * @brief SettingsHandler::setDatabaseMmapSizeKb - Change the most of the key database file that
+ *      should be read through a memory map.  The change is used the next time the database is
+ *      opened.
+ *
+ * @param newvalue - The size of the memory map, in KiB.  0 turns the memory map off.
+ */
+void SettingsHandler::setDatabaseMmapSizeKb(unsigned int newvalue)
+{
+    mDatabaseMmapSizeKb = newvalue;
+
+    mSettingsDatabase->setValue("Settings/databaseMmapSizeKb", mDatabaseMmapSizeKb);
+}
+
+/**
+ * @brief SettingsHandler::databaseCheckpointInterval - Return how often the changes in the key
+ *      database's write-ahead log are moved in to the database file.
+ *
+ * @return unsigned int containing the number of seconds between checkpoints.  0 means they are
+ *      left to SQLite.
+ */
+unsigned int SettingsHandler::databaseCheckpointInterval()
+{
+    return mDatabaseCheckpointInterval;
+}
+
+/**
+ * @brief SettingsHandler::setDatabaseCheckpointInterval - Change how often the changes in the
+ *      key database's write-ahead log are moved in to the database file.
+ *
+ * @param newvalue - The number of seconds between checkpoints.  0 leaves them to SQLite.
+ */
+void SettingsHandler::setDatabaseCheckpointInterval(unsigned int newvalue)
+{
+    mDatabaseCheckpointInterval = newvalue;
+
+    mSettingsDatabase->setValue("Settings/databaseCheckpointInterval", mDatabaseCheckpointInterval);
+
+    // Change how often the checkpoints are run.
+    KeyEntriesSingleton::getInstance()->setCheckpointInterval(mDatabaseCheckpointInterval);
+}
+
 /**
  * @brief SettingsHandler::databaseLocation - Return the location that the database file is
  *      written to.
@@ -494,6 +626,11 @@ SettingsHandler::SettingsHandler()
     mShowHotpCounter = false;
     mShowIssuer = false;
     mLogToFile = false;
+    mMaxCalculationThreads = 0;
+    mDatabaseWriteAheadLog = SECRETDATABASE_DEFAULT_WRITE_AHEAD_LOG;
+    mDatabaseCacheSizeKb = SECRETDATABASE_DEFAULT_CACHE_SIZE_KB;
+    mDatabaseMmapSizeKb = SECRETDATABASE_DEFAULT_MMAP_SIZE_KB;
+    mDatabaseCheckpointInterval = DEFAULT_CHECKPOINT_INTERVAL;
     mDatabaseLocation.clear();
     mDatabaseFilename = "keydatabase.db";
 
@@ -515,6 +652,11 @@ SettingsHandler::SettingsHandler()
     mShowHotpCounter = mSettingsDatabase->value("Settings/showHotpCounter", false).toBool();
     mShowAlgorithm = mSettingsDatabase->value("Settings/showHashAlgorithm", false).toBool();
     mLogToFile = mSettingsDatabase->value("Settings/logToFile", false).toBool();
+    mMaxCalculationThreads = mSettingsDatabase->value("Settings/maxCalculationThreads", 0).toUInt();        // 0 will use one thread per CPU core.
+    mDatabaseWriteAheadLog = mSettingsDatabase->value("Settings/databaseWriteAheadLog", SECRETDATABASE_DEFAULT_WRITE_AHEAD_LOG).toBool();
+    mDatabaseCacheSizeKb = mSettingsDatabase->value("Settings/databaseCacheSizeKb", SECRETDATABASE_DEFAULT_CACHE_SIZE_KB).toUInt();
+    mDatabaseMmapSizeKb = mSettingsDatabase->value("Settings/databaseMmapSizeKb", SECRETDATABASE_DEFAULT_MMAP_SIZE_KB).toUInt();
+    mDatabaseCheckpointInterval = mSettingsDatabase->value("Settings/databaseCheckpointInterval", DEFAULT_CHECKPOINT_INTERVAL).toUInt();     // 0 leaves the checkpoints to SQLite.
     mDatabaseLocation = mSettingsDatabase->value("Settings/databasePath", "").toString();               // An empty string will map to the DOT_DIRECTORY value at the top of this file.
     mDatabaseFilename = mSettingsDatabase->value("Settings/databaseFilename", "keydatabase.db").toString();
 
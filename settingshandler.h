@@ -28,6 +28,21 @@ public:
     Q_INVOKABLE bool logToFile();
     Q_INVOKABLE void setLogToFile(bool newvalue);
 
+    Q_INVOKABLE unsigned int maxCalculationThreads();
+    Q_INVOKABLE void setMaxCalculationThreads(unsigned int newvalue);
+
+    Q_INVOKABLE bool databaseWriteAheadLog();
+    Q_INVOKABLE void setDatabaseWriteAheadLog(bool newvalue);
+
+    Q_INVOKABLE unsigned int databaseCacheSizeKb();
+    Q_INVOKABLE void setDatabaseCacheSizeKb(unsigned int newvalue);
+
+    Q_INVOKABLE unsigned int databaseMmapSizeKb();
+    Q_INVOKABLE void setDatabaseMmapSizeKb(unsigned int newvalue);
+
+    Q_INVOKABLE unsigned int databaseCheckpointInterval();
+    Q_INVOKABLE void setDatabaseCheckpointInterval(unsigned int newvalue);
+
     Q_INVOKABLE QString databaseLocation();
     Q_INVOKABLE bool setDatabaseLocation(const QString &newLocation);
     bool databaseDirectoryExistsOrIsCreated();
@@ -52,6 +67,11 @@ private:
     bool mShowIssuer;
     bool mShowAlgorithm;
     bool mLogToFile;
+    unsigned int mMaxCalculationThreads;
+    bool mDatabaseWriteAheadLog;
+    unsigned int mDatabaseCacheSizeKb;
+    unsigned int mDatabaseMmapSizeKb;
+    unsigned int mDatabaseCheckpointInterval;
     QString mDatabaseLocation;
     QString mDatabaseFilename;
 
@@ -1,5 +1,7 @@
 #include <testsuitebase.h>
 
+#include <cstring>
+#include <vector>
 #include "container/bytearray.h"
 
 SIMPLE_TEST_SUITE(ByteArrayTests, ByteArray);
@@ -286,3 +288,250 @@ TEST_F(ByteArrayTests, TruncateTests)
     EXPECT_EQ((size_t)0, testByteArray.size());
     EXPECT_EQ(std::string(""), testByteArray.toString());
 }
+
+TEST_F(ByteArrayTests, InlineBufferTests)
+{
+    std::string longString(200, 'X');
+    ByteArray testByteArray("Short data.");
+
+    // Short data should be stored inline.
+    EXPECT_TRUE(testByteArray.usingInlineBuffer());
+    EXPECT_EQ(std::string("Short data."), testByteArray.toString());
+
+    // Exactly the size of the inline buffer should still be inline.
+    EXPECT_TRUE(testByteArray.fromStdString(std::string(BYTEARRAY_INLINE_SIZE, 'A')));
+    EXPECT_TRUE(testByteArray.usingInlineBuffer());
+    EXPECT_EQ(BYTEARRAY_INLINE_SIZE, testByteArray.size());
+
+    // Appending past the end of the inline buffer should move the data to the heap.
+    EXPECT_TRUE(testByteArray.append('B'));
+    EXPECT_FALSE(testByteArray.usingInlineBuffer());
+    EXPECT_EQ(std::string(BYTEARRAY_INLINE_SIZE, 'A') + "B", testByteArray.toString());
+
+    // Long data should go straight to the heap.
+    EXPECT_TRUE(testByteArray.fromStdString(longString));
+    EXPECT_FALSE(testByteArray.usingInlineBuffer());
+    EXPECT_EQ(longString, testByteArray.toString());
+
+    // And back to inline once it fits again.
+    EXPECT_TRUE(testByteArray.fromStdString("Short again."));
+    EXPECT_TRUE(testByteArray.usingInlineBuffer());
+    EXPECT_EQ(std::string("Short again."), testByteArray.toString());
+
+    // Appending a byte at a time across the boundary should keep all of the data.
+    testByteArray.clear();
+    for (size_t i = 0; i < 150; i++) {
+        EXPECT_TRUE(testByteArray.append(static_cast<char>('a' + (i % 26))));
+    }
+
+    EXPECT_EQ(static_cast<size_t>(150), testByteArray.size());
+    for (size_t i = 0; i < 150; i++) {
+        EXPECT_EQ(static_cast<unsigned char>('a' + (i % 26)), testByteArray.at(i));
+    }
+
+    // Null terminated after the data.
+    EXPECT_EQ(static_cast<size_t>(150), strlen(testByteArray.toCharArrayPtr()));
+
+    // An extra allocation that is bigger than the inline buffer should use the heap.
+    ByteArray extraByteArray(static_cast<size_t>(128));
+
+    EXPECT_TRUE(extraByteArray.append("Some data"));
+    EXPECT_FALSE(extraByteArray.usingInlineBuffer());
+    EXPECT_EQ(std::string("Some data"), extraByteArray.toString());
+}
+
+TEST_F(ByteArrayTests, MoveTests)
+{
+    std::string longString(200, 'Y');
+    ByteArray shortByteArray("Short data.");
+    ByteArray longByteArray(longString, true);
+    const unsigned char *longPtr = longByteArray.toUCharArrayPtr();
+
+    // Moving an inline object copies the data, and leaves the source empty.
+    ByteArray movedShort(std::move(shortByteArray));
+
+    EXPECT_EQ(std::string("Short data."), movedShort.toString());
+    EXPECT_TRUE(movedShort.usingInlineBuffer());
+    EXPECT_TRUE(shortByteArray.empty());                       //NOSONAR
+    EXPECT_EQ(static_cast<size_t>(0), shortByteArray.size());  //NOSONAR
+
+    // Moving a heap object should hand over the buffer without copying it.
+    ByteArray movedLong(std::move(longByteArray));
+
+    EXPECT_EQ(longString, movedLong.toString());
+    EXPECT_EQ(longPtr, movedLong.toUCharArrayPtr());
+    EXPECT_TRUE(longByteArray.empty());                        //NOSONAR
+
+    // Move assignment over an object that already has data.
+    ByteArray target("Existing data that will be replaced.");
+
+    target = std::move(movedLong);
+    EXPECT_EQ(longString, target.toString());
+    EXPECT_EQ(longPtr, target.toUCharArrayPtr());
+    EXPECT_TRUE(movedLong.empty());                            //NOSONAR
+
+    // The target now holds a secret, so the short data is copied in to its secure buffer.
+    target = std::move(movedShort);
+    EXPECT_EQ(std::string("Short data."), target.toString());
+    EXPECT_TRUE(target.usingSecureBuffer());
+    EXPECT_TRUE(movedShort.empty());                           //NOSONAR
+
+    // A moved from object should still be usable.
+    EXPECT_TRUE(movedShort.append("Reused."));
+    EXPECT_EQ(std::string("Reused."), movedShort.toString());
+
+    // Moving an empty object should give an empty object.
+    ByteArray emptyByteArray;
+    ByteArray movedEmpty(std::move(emptyByteArray));
+
+    EXPECT_TRUE(movedEmpty.empty());
+
+    // Returning a local from a function should work, and not lose the data.
+    std::vector<ByteArray> arrays;
+
+    for (size_t i = 0; i < 20; i++) {
+        arrays.push_back(ByteArray(std::string(i * 10, 'Z')));
+    }
+
+    for (size_t i = 0; i < 20; i++) {
+        EXPECT_EQ(std::string(i * 10, 'Z'), arrays.at(i).toString());
+    }
+}
+
+TEST_F(ByteArrayTests, GrowthTests)
+{
+    ByteArray testByteArray;
+    size_t lastCapacity = 0;
+    size_t reallocations = 0;
+
+    // Appending a byte at a time should grow the buffer geometrically, not one byte at a time.
+    for (size_t i = 0; i < 10000; i++) {
+        EXPECT_TRUE(testByteArray.append(static_cast<char>(i & 0xff)));
+
+        if (testByteArray.capacity() != lastCapacity) {
+            EXPECT_GE(testByteArray.capacity(), lastCapacity * 2);
+            lastCapacity = testByteArray.capacity();
+            reallocations++;
+        }
+    }
+
+    EXPECT_EQ(static_cast<size_t>(10000), testByteArray.size());
+    EXPECT_LT(reallocations, static_cast<size_t>(15));
+
+    for (size_t i = 0; i < 10000; i++) {
+        EXPECT_EQ(static_cast<unsigned char>(i & 0xff), testByteArray.at(i));
+    }
+}
+
+TEST_F(ByteArrayTests, ReserveResizeTests)
+{
+    ByteArray testByteArray("Some data.");
+    const unsigned char *dataPtr;
+
+    // Reserving should keep the data, and not change the length.
+    EXPECT_TRUE(testByteArray.reserve(1000));
+    EXPECT_GE(testByteArray.capacity(), static_cast<size_t>(1000));
+    EXPECT_EQ(std::string("Some data."), testByteArray.toString());
+
+    // Appending within the reserved space shouldn't move the buffer.
+    dataPtr = testByteArray.toUCharArrayPtr();
+    EXPECT_TRUE(testByteArray.append(std::string(900, 'x')));
+    EXPECT_EQ(dataPtr, testByteArray.toUCharArrayPtr());
+
+    // Reserving less than we have is a no-op.
+    EXPECT_TRUE(testByteArray.reserve(10));
+    EXPECT_EQ(dataPtr, testByteArray.toUCharArrayPtr());
+
+    // A reserved, but unused, buffer is still empty.
+    ByteArray reserved;
+
+    EXPECT_TRUE(reserved.reserve(200));
+    EXPECT_TRUE(reserved.empty());
+    EXPECT_EQ(static_cast<size_t>(0), reserved.size());
+
+    // Resize up fills with the value provided.
+    ByteArray resized("abc");
+
+    EXPECT_TRUE(resized.resize(6, 'z'));
+    EXPECT_EQ(std::string("abczzz"), resized.toString());
+
+    // Resize down truncates.
+    EXPECT_TRUE(resized.resize(2));
+    EXPECT_EQ(std::string("ab"), resized.toString());
+
+    // Resize up with the default fills with zeros.
+    EXPECT_TRUE(resized.resize(4));
+    EXPECT_EQ(static_cast<size_t>(4), resized.size());
+    EXPECT_EQ(0x00, resized.at(2));
+    EXPECT_EQ(0x00, resized.at(3));
+
+    // Append zeros.
+    EXPECT_TRUE(resized.appendZeros(100));
+    EXPECT_EQ(static_cast<size_t>(104), resized.size());
+    EXPECT_EQ('a', resized.at(0));
+    EXPECT_EQ(0x00, resized.at(103));
+
+    // Fill.
+    resized.fill(0x5c);
+    EXPECT_EQ(static_cast<size_t>(104), resized.size());
+    for (size_t i = 0; i < resized.size(); i++) {
+        EXPECT_EQ(0x5c, resized.at(i));
+    }
+
+    // Resizing an empty object should work.
+    ByteArray emptyByteArray;
+
+    EXPECT_TRUE(emptyByteArray.appendZeros(3));
+    EXPECT_EQ(static_cast<size_t>(3), emptyByteArray.size());
+    EXPECT_FALSE(emptyByteArray.empty());
+}
+
+TEST_F(ByteArrayTests, SecureBufferTests)
+{
+    ByteArray secret("A secret value.", 0, true);
+    ByteArray notSecret("Not a secret.");
+
+    // Secrets never use the inline buffer.
+    EXPECT_TRUE(secret.usingSecureBuffer());
+    EXPECT_FALSE(secret.usingInlineBuffer());
+    EXPECT_EQ(std::string("A secret value."), secret.toString());
+
+    EXPECT_FALSE(notSecret.usingSecureBuffer());
+    EXPECT_TRUE(notSecret.usingInlineBuffer());
+
+    // Growing a secret keeps it in the arena.
+    EXPECT_TRUE(secret.append(std::string(500, 's')));
+    EXPECT_TRUE(secret.usingSecureBuffer());
+    EXPECT_EQ(std::string("A secret value.") + std::string(500, 's'), secret.toString());
+
+    // Turning on zero on free moves existing data in to the arena.
+    notSecret.setZeroOnFree(true);
+    EXPECT_TRUE(notSecret.usingSecureBuffer());
+    EXPECT_EQ(std::string("Not a secret."), notSecret.toString());
+
+    // Copying in to a secret keeps it secret.
+    ByteArray copyTarget(true);
+
+    copyTarget = ByteArray("Copied in.");
+    EXPECT_TRUE(copyTarget.usingSecureBuffer());
+    EXPECT_EQ(std::string("Copied in."), copyTarget.toString());
+
+    copyTarget = std::string("Assigned string.");
+    EXPECT_TRUE(copyTarget.usingSecureBuffer());
+
+    // Moving a normal object in to a secret one copies it in to the arena, and wipes the source.
+    ByteArray moveSource(std::string(300, 'm'));
+
+    copyTarget = std::move(moveSource);
+    EXPECT_TRUE(copyTarget.usingSecureBuffer());
+    EXPECT_EQ(std::string(300, 'm'), copyTarget.toString());
+    EXPECT_TRUE(moveSource.empty());                           //NOSONAR
+
+    // Moving a secret hands over the secure buffer.
+    const unsigned char *securePtr = copyTarget.toUCharArrayPtr();
+    ByteArray moved(std::move(copyTarget));
+
+    EXPECT_TRUE(moved.usingSecureBuffer());
+    EXPECT_EQ(securePtr, moved.toUCharArrayPtr());
+    EXPECT_FALSE(copyTarget.usingSecureBuffer());              //NOSONAR
+}
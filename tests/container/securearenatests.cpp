@@ -0,0 +1,125 @@
+#include <testsuitebase.h>
+
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "container/securearena.h"
+
+#include <QDebug>
+
+EMPTY_TEST_SUITE(SecureArenaTests);
+
+TEST_F(SecureArenaTests, AllocateReleaseTest)
+{
+    SecureArena *arena = SecureArena::getInstance();
+    size_t startBytes = arena->bytesInUse();
+    unsigned char *first;
+    unsigned char *second;
+
+    qDebug("Secure arena pages locked : %d", arena->allLocked());
+
+    first = static_cast<unsigned char *>(arena->allocate(20));
+    second = static_cast<unsigned char *>(arena->allocate(100));
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+
+    // Allocations are aligned, and don't overlap.
+    EXPECT_EQ(static_cast<uintptr_t>(0), reinterpret_cast<uintptr_t>(first) % SECUREARENA_ALIGNMENT);
+    EXPECT_EQ(static_cast<uintptr_t>(0), reinterpret_cast<uintptr_t>(second) % SECUREARENA_ALIGNMENT);
+    EXPECT_GE(second, first + 20);
+
+    EXPECT_TRUE(arena->owns(first));
+    EXPECT_TRUE(arena->owns(second));
+    EXPECT_GT(arena->bytesInUse(), startBytes);
+
+    memset(first, 0xaa, 20);
+    memset(second, 0xbb, 100);
+
+    // Releasing the most recent allocation gives the space back right away, and wipes it.
+    EXPECT_TRUE(arena->release(second));
+    EXPECT_EQ(0x00, second[0]);
+    EXPECT_EQ(0x00, second[99]);
+
+    EXPECT_TRUE(arena->release(first));
+    EXPECT_EQ(startBytes, arena->bytesInUse());
+
+    // Things that aren't ours.
+    int notOurs = 0;
+
+    EXPECT_FALSE(arena->owns(&notOurs));
+    EXPECT_FALSE(arena->release(nullptr));
+}
+
+TEST_F(SecureArenaTests, BulkWipeTest)
+{
+    SecureArena *arena = SecureArena::getInstance();
+    std::vector<unsigned char *> allocations;
+
+    for (size_t i = 0; i < 50; i++) {
+        allocations.push_back(static_cast<unsigned char *>(arena->allocate(64)));
+        ASSERT_NE(nullptr, allocations.back());
+        memset(allocations.back(), 0x5a, 64);
+    }
+
+    // Release them oldest first, so the space can't be handed back until they are all gone.
+    for (size_t i = 0; i < allocations.size(); i++) {
+        EXPECT_TRUE(arena->release(allocations.at(i)));
+    }
+
+    // The whole chunk should have been wiped.  (The first chunk is never unmapped, so this is
+    // safe to read.)
+    EXPECT_EQ(static_cast<size_t>(0), arena->bytesInUse());
+    EXPECT_EQ(static_cast<size_t>(1), arena->chunkCount());
+    for (size_t i = 0; i < allocations.size(); i++) {
+        EXPECT_EQ(0x00, allocations.at(i)[0]);
+        EXPECT_EQ(0x00, allocations.at(i)[63]);
+    }
+}
+
+TEST_F(SecureArenaTests, LargeAllocationTest)
+{
+    SecureArena *arena = SecureArena::getInstance();
+    unsigned char *small;
+    unsigned char *large;
+
+    small = static_cast<unsigned char *>(arena->allocate(16));
+    large = static_cast<unsigned char *>(arena->allocate(SECUREARENA_CHUNK_SIZE * 2));
+    ASSERT_NE(nullptr, small);
+    ASSERT_NE(nullptr, large);
+
+    // The large allocation needs its own chunk.
+    EXPECT_EQ(static_cast<size_t>(2), arena->chunkCount());
+    memset(large, 0x11, SECUREARENA_CHUNK_SIZE * 2);
+
+    // Once it is released, the extra chunk is given back.
+    EXPECT_TRUE(arena->release(large));
+    EXPECT_EQ(static_cast<size_t>(1), arena->chunkCount());
+
+    EXPECT_TRUE(arena->release(small));
+}
+
+TEST_F(SecureArenaTests, ThreadedTest)
+{
+    SecureArena *arena = SecureArena::getInstance();
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < 4; t++) {
+        threads.push_back(std::thread([arena, t]() {
+            for (size_t i = 0; i < 1000; i++) {
+                unsigned char *mem = static_cast<unsigned char *>(arena->allocate(32 + (i % 64)));
+
+                ASSERT_NE(nullptr, mem);
+                memset(mem, static_cast<int>(t), 32);
+                EXPECT_EQ(static_cast<unsigned char>(t), mem[31]);
+                EXPECT_TRUE(arena->release(mem));
+            }
+        }));
+    }
+
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads.at(t).join();
+    }
+
+    EXPECT_EQ(static_cast<size_t>(0), arena->bytesInUse());
+}
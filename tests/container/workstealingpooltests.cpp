@@ -0,0 +1,131 @@
+#include <testsuitebase.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "container/workstealingpool.h"
+
+#include <QDebug>
+
+EMPTY_TEST_SUITE(WorkStealingPoolTests);
+
+TEST_F(WorkStealingPoolTests, ThreadCountTest)
+{
+    WorkStealingPool pool(3);
+
+    EXPECT_EQ(static_cast<size_t>(3), pool.threadCount());
+
+    EXPECT_TRUE(pool.setThreadCount(1));
+    EXPECT_EQ(static_cast<size_t>(1), pool.threadCount());
+
+    // 0 uses one thread per core.
+    EXPECT_TRUE(pool.setThreadCount(0));
+    EXPECT_EQ(WorkStealingPool::defaultThreadCount(), pool.threadCount());
+    EXPECT_GE(WorkStealingPool::defaultThreadCount(), static_cast<size_t>(1));
+
+    qDebug("Default thread count : %zu", WorkStealingPool::defaultThreadCount());
+}
+
+TEST_F(WorkStealingPoolTests, ResizeAfterRunTest)
+{
+    // Enough pieces that dealing them out takes longer than starting the new threads.
+    const size_t count = 20000;
+    std::atomic<size_t> visited(0);
+    auto visit = [&visited](size_t begin, size_t end) {
+        visited += (end - begin);
+    };
+
+    // Workers started after a parallelFor() has run must wait for the next one, rather than
+    // running with the last one's state.
+    for (size_t i = 0; i < 20; i++) {
+        WorkStealingPool pool(2);
+
+        visited = 0;
+        EXPECT_TRUE(pool.parallelFor(count, 1, visit));
+        EXPECT_EQ(count, visited.load());
+
+        EXPECT_TRUE(pool.setThreadCount(4));
+
+        visited = 0;
+        EXPECT_TRUE(pool.parallelFor(count, 1, visit));
+        EXPECT_EQ(count, visited.load());
+
+        // And shrinking again.
+        EXPECT_TRUE(pool.setThreadCount(3));
+
+        visited = 0;
+        EXPECT_TRUE(pool.parallelFor(count, 1, visit));
+        EXPECT_EQ(count, visited.load());
+    }
+}
+
+TEST_F(WorkStealingPoolTests, ParallelForTest)
+{
+    const size_t count = 1000;
+    std::vector<int> hits(count, 0);
+    std::function<void(size_t, size_t)> empty;
+
+    for (size_t threads = 1; threads <= 4; threads++) {
+        WorkStealingPool pool(threads);
+
+        // Every index has to be visited exactly once, whatever the grain.
+        for (size_t grain = 0; grain <= 70; grain += 7) {
+            hits.assign(count, 0);
+
+            EXPECT_TRUE(pool.parallelFor(count, grain, [&hits](size_t begin, size_t end) {
+                EXPECT_LT(begin, end);
+
+                for (size_t i = begin; i < end; i++) {
+                    hits[i]++;
+                }
+            }));
+
+            for (size_t i = 0; i < count; i++) {
+                EXPECT_EQ(1, hits[i]);
+            }
+        }
+
+        // An empty range doesn't call the task.
+        EXPECT_TRUE(pool.parallelFor(0, 1, [](size_t, size_t) { FAIL(); }));
+
+        // A task is required.
+        EXPECT_FALSE(pool.parallelFor(count, 1, empty));
+    }
+}
+
+TEST_F(WorkStealingPoolTests, StealTest)
+{
+    WorkStealingPool pool(4);
+    std::mutex lock;
+    std::set<std::thread::id> ids;
+    std::atomic<size_t> total(0);
+
+    // The first piece is slow, so the other pieces dealt to that thread have to be stolen.
+    EXPECT_TRUE(pool.parallelFor(64, 1, [&](size_t begin, size_t end) {
+        if (0 == begin) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+
+            ids.insert(std::this_thread::get_id());
+        }
+
+        total += (end - begin);
+    }));
+
+    EXPECT_EQ(static_cast<size_t>(64), total.load());
+    EXPECT_GE(ids.size(), static_cast<size_t>(1));
+    EXPECT_LE(ids.size(), static_cast<size_t>(4));
+
+    qDebug("Threads used : %zu", ids.size());
+
+    // The pool can be used again once the last job is done.
+    total = 0;
+    EXPECT_TRUE(pool.parallelFor(10, 3, [&total](size_t begin, size_t end) { total += (end - begin); }));
+    EXPECT_EQ(static_cast<size_t>(10), total.load());
+}
@@ -103,6 +103,11 @@ TEST_F(KeyEntriesSingletonTests, E2ETests)
     EXPECT_TRUE(!KeyEntriesSingleton::getInstance()->incrementHotpCounter(""));
     EXPECT_TRUE(!KeyEntriesSingleton::getInstance()->incrementHotpCounter("Invalid entry"));
 
+    // Attempt to resync an invalid HOTP counter.
+    EXPECT_TRUE(!KeyEntriesSingleton::getInstance()->resyncHotpCounter("", "123456"));
+    EXPECT_TRUE(!KeyEntriesSingleton::getInstance()->resyncHotpCounter("Invalid entry", "123456"));
+    EXPECT_TRUE(!KeyEntriesSingleton::getInstance()->resyncHotpCounter(foundKey->identifier(), ""));
+
     // Update the key entry, but use invalid inputs for each thing along the way.
     EXPECT_TRUE(!KeyEntriesSingleton::getInstance()->updateKeyEntry(nullptr, "", "", -1, -1, -1, -1, -1, -1));
     EXPECT_TRUE(!KeyEntriesSingleton::getInstance()->updateKeyEntry(foundKey, "", "", -1, -1, -1, -1, -1, -1));
@@ -7,6 +7,7 @@
 #include <QFileInfo>
 
 #include <iostream>
+#include <algorithm>
 
 #define TEST_DB "test.db"
 
@@ -171,3 +172,242 @@ TEST_F(SecretDatabaseTests, MiscTests)
     // Assign from a different SecretDatabase to another value.
     copiedDb = (*this);
 }
+
+TEST_F(SecretDatabaseTests, QuotedIdentifierTest)
+{
+    const QString quotedId("O'Brien \"Test\" Account");
+    const QString renamedId("Bobby'); DROP TABLE secretData; --");
+    KeyEntry toWrite;
+    KeyEntry readBack;
+    KeyEntry newEntry;
+    std::vector<KeyEntry> allEntries;
+
+    toWrite.setIdentifier(quotedId);
+    toWrite.setSecret("mysecret5");
+    toWrite.setKeyType(KEYENTRY_KEYTYPE_BASE32);
+    toWrite.setOtpType(KEYENTRY_OTPTYPE_TOTP);
+    toWrite.setOutNumberCount(6);
+
+    EXPECT_TRUE(add(toWrite));
+
+    // Adding it a second time should fail, since it already exists.
+    EXPECT_FALSE(add(toWrite));
+
+    // The statements are reused, so look it up a few times to make sure they are reset
+    // correctly between calls.
+    for (int i = 0; i < 3; i++) {
+        EXPECT_TRUE(getByIdentifier(quotedId, readBack));
+        EXPECT_EQ(readBack.identifier(), quotedId);
+        EXPECT_EQ(readBack.secret().toString(), std::string("mysecret5"));
+
+        EXPECT_FALSE(getByIdentifier("O'Brien", readBack));
+    }
+
+    // Rename it to something that would have broken the SQL if it was pasted in.
+    newEntry = readBack;
+    newEntry.setIdentifier(renamedId);
+
+    EXPECT_TRUE(update(readBack, newEntry));
+    EXPECT_FALSE(getByIdentifier(quotedId, readBack));
+    EXPECT_TRUE(getByIdentifier(renamedId, readBack));
+    EXPECT_EQ(readBack.identifier(), renamedId);
+
+    EXPECT_TRUE(getAll(allEntries));
+    EXPECT_EQ(allEntries.size(), static_cast<size_t>(1));
+
+    // Then delete it.
+    EXPECT_TRUE(deleteByIdentifier(renamedId));
+    EXPECT_FALSE(deleteByIdentifier(renamedId));
+    EXPECT_FALSE(getByIdentifier(renamedId, readBack));
+
+    EXPECT_TRUE(getAll(allEntries));
+    EXPECT_EQ(allEntries.size(), static_cast<size_t>(0));
+}
+
+TEST_F(SecretDatabaseTests, AddManyTest)
+{
+    std::vector<KeyEntry> toWrite;
+    std::vector<KeyEntry> allEntries;
+    std::vector<size_t> failed;
+    KeyEntry entry;
+    KeyEntry readBack;
+
+    // Adding nothing should work, and not fail anything.
+    EXPECT_TRUE(addMany(toWrite, failed));
+    EXPECT_TRUE(failed.empty());
+
+    // Add one the normal way, so we can make sure the bulk add skips it.
+    entry.setIdentifier("bulk2");
+    entry.setSecret("existingsecret");
+    entry.setKeyType(KEYENTRY_KEYTYPE_BASE32);
+    entry.setOtpType(KEYENTRY_OTPTYPE_TOTP);
+    entry.setOutNumberCount(6);
+    EXPECT_TRUE(add(entry));
+
+    for (int i = 0; i < 100; i++) {
+        entry.setIdentifier("bulk" + QString::number(i));
+        entry.setSecret("secret" + std::to_string(i));
+        toWrite.push_back(entry);
+    }
+
+    // An invalid entry, and a duplicate of one that is already in the list.
+    entry.setIdentifier("");
+    toWrite.push_back(entry);
+
+    entry.setIdentifier("bulk50");
+    entry.setSecret("duplicatesecret");
+    toWrite.push_back(entry);
+
+    EXPECT_TRUE(addMany(toWrite, failed));
+
+    ASSERT_EQ(static_cast<size_t>(3), failed.size());
+    EXPECT_EQ(static_cast<size_t>(2), failed.at(0));
+    EXPECT_EQ(static_cast<size_t>(100), failed.at(1));
+    EXPECT_EQ(static_cast<size_t>(101), failed.at(2));
+
+    EXPECT_TRUE(getAll(allEntries));
+    EXPECT_EQ(static_cast<size_t>(100), allEntries.size());
+
+    // The ones that already existed shouldn't have been changed.
+    EXPECT_TRUE(getByIdentifier("bulk2", readBack));
+    EXPECT_EQ(readBack.secret().toString(), std::string("existingsecret"));
+
+    EXPECT_TRUE(getByIdentifier("bulk50", readBack));
+    EXPECT_EQ(readBack.secret().toString(), std::string("secret50"));
+
+    EXPECT_TRUE(getByIdentifier("bulk99", readBack));
+    EXPECT_EQ(readBack.secret().toString(), std::string("secret99"));
+}
+
+TEST_F(SecretDatabaseTests, StorageOptionsTest)
+{
+    KeyEntry toWrite;
+    KeyEntry readBack;
+
+    // The database is opened with a write-ahead log by default.
+    EXPECT_TRUE(writeAheadLogActive());
+    EXPECT_TRUE(checkpoint());
+    EXPECT_TRUE(checkpoint(true));
+
+    // Switch to the rollback journal while the database is open.
+    EXPECT_TRUE(setStorageOptions(false, 1024, 0));
+    EXPECT_FALSE(writeAheadLogActive());
+
+    // There is no log to checkpoint, but that isn't an error.
+    EXPECT_TRUE(checkpoint());
+
+    toWrite.setIdentifier("journal");
+    toWrite.setSecret("journalsecret");
+    toWrite.setKeyType(KEYENTRY_KEYTYPE_BASE32);
+    toWrite.setOtpType(KEYENTRY_OTPTYPE_HOTP);
+    toWrite.setOutNumberCount(6);
+
+    EXPECT_TRUE(add(toWrite));
+
+    // Then switch back, and make sure the data is still there.
+    EXPECT_TRUE(setStorageOptions(true, SECRETDATABASE_DEFAULT_CACHE_SIZE_KB, SECRETDATABASE_DEFAULT_MMAP_SIZE_KB));
+    EXPECT_TRUE(writeAheadLogActive());
+
+    EXPECT_TRUE(getByIdentifier("journal", readBack));
+    EXPECT_EQ(readBack.secret().toString(), std::string("journalsecret"));
+
+    EXPECT_TRUE(deleteByIdentifier("journal"));
+    EXPECT_TRUE(checkpoint());
+}
+
+TEST_F(SecretDatabaseTests, UpsertAndUpdateIfTest)
+{
+    KeyEntry entry;
+    KeyEntry updated;
+    KeyEntry readBack;
+    std::vector<KeyEntry> allEntries;
+
+    // Upserting an invalid entry should fail.
+    EXPECT_FALSE(upsert(entry));
+
+    entry.setIdentifier("upsert");
+    entry.setSecret("upsertsecret");
+    entry.setKeyType(KEYENTRY_KEYTYPE_BASE32);
+    entry.setOtpType(KEYENTRY_OTPTYPE_HOTP);
+    entry.setOutNumberCount(6);
+    entry.setHotpCounter(5);
+
+    // The first upsert adds it, the second replaces it.
+    EXPECT_TRUE(upsert(entry));
+
+    entry.setSecret("upsertsecret2");
+    entry.setOutNumberCount(8);
+    EXPECT_TRUE(upsert(entry));
+
+    EXPECT_TRUE(getAll(allEntries));
+    EXPECT_EQ(static_cast<size_t>(1), allEntries.size());
+
+    EXPECT_TRUE(getByIdentifier("upsert", readBack));
+    EXPECT_EQ(readBack.secret().toString(), std::string("upsertsecret2"));
+    EXPECT_EQ(readBack.outNumberCount(), (unsigned int)8);
+    EXPECT_EQ(readBack.hotpCounter(), (unsigned int)5);
+
+    // Only update the counter if it is still what we expect.
+    updated = readBack;
+    updated.setHotpCounter(6);
+
+    EXPECT_FALSE(updateIf(readBack, updated, 4));
+    EXPECT_TRUE(updateIf(readBack, updated, 5));
+
+    // Doing the same increment again should fail, since the counter has moved on.
+    EXPECT_FALSE(updateIf(readBack, updated, 5));
+
+    EXPECT_TRUE(getByIdentifier("upsert", readBack));
+    EXPECT_EQ(readBack.hotpCounter(), (unsigned int)6);
+
+    // A plain update of an entry that doesn't exist should fail, without adding it.
+    updated.setIdentifier("missing");
+    EXPECT_FALSE(update(updated, updated));
+    EXPECT_FALSE(updateIf(updated, updated, 6));
+    EXPECT_FALSE(getByIdentifier("missing", readBack));
+}
+
+TEST_F(SecretDatabaseTests, ForEachTest)
+{
+    KeyEntry entry;
+    size_t visited = 0;
+    std::vector<std::string> identifiers;
+
+    entry.setSecret("foreachsecret");
+    entry.setKeyType(KEYENTRY_KEYTYPE_BASE32);
+    entry.setOtpType(KEYENTRY_OTPTYPE_TOTP);
+    entry.setOutNumberCount(6);
+    entry.setTimeStep(30);
+
+    for (size_t i = 0; i < 3; i++) {
+        entry.setIdentifier("foreach" + QString::number(i));
+        EXPECT_TRUE(add(entry));
+    }
+
+    // Visit all of them.
+    EXPECT_TRUE(forEach([&identifiers](const KeyEntry &keyEntry) {
+                            identifiers.push_back(keyEntry.identifier().toStdString());
+                            EXPECT_EQ(keyEntry.secret().toString(), std::string("foreachsecret"));
+                            return true;
+                        }));
+
+    EXPECT_EQ(static_cast<size_t>(3), identifiers.size());
+    for (size_t i = 0; i < 3; i++) {
+        EXPECT_TRUE(std::find(identifiers.begin(), identifiers.end(), "foreach" + std::to_string(i)) != identifiers.end());
+    }
+
+    // Stopping early isn't an error.
+    EXPECT_TRUE(forEach([&visited](const KeyEntry &) {
+                            visited++;
+                            return false;
+                        }));
+    EXPECT_EQ(static_cast<size_t>(1), visited);
+
+    // The statement should be reusable after stopping early.
+    visited = 0;
+    EXPECT_TRUE(forEach([&visited](const KeyEntry &) {
+                            visited++;
+                            return true;
+                        }));
+    EXPECT_EQ(static_cast<size_t>(3), visited);
+}
@@ -0,0 +1,221 @@
+#include <testsuitebase.h>
+
+#include <memory>
+#include <vector>
+#include "otp/otpbatchengine.h"
+
+// Test values taken from RFC 4226 and RFC 6238.
+
+EMPTY_TEST_SUITE(OtpBatchEngineTests);
+
+static void setupEntry(KeyEntry &kEntry, const QString &identifier, const char *secret, unsigned int otpType, unsigned int algorithm, unsigned int digits)
+{
+    kEntry.clear();
+    kEntry.setIdentifier(identifier);
+    kEntry.setIssuer("Test Issuer");
+    kEntry.setSecret(secret);
+    kEntry.setKeyType(KEYENTRY_KEYTYPE_HEX);
+    kEntry.setOtpType(otpType);
+    kEntry.setTimeStep(30);
+    kEntry.setAlgorithm(algorithm);
+    kEntry.setCodeValid(false);
+    kEntry.setStartTime(0);
+    kEntry.setTimeOffset(0);
+    kEntry.setHotpCounter(9);
+    kEntry.setOutNumberCount(digits);
+}
+
+TEST_F(OtpBatchEngineTests, CalculateTest)
+{
+    OtpBatchEngine engine;
+    QList<KeyEntry *> entries;
+    KeyEntry sha1Totp;
+    KeyEntry sha1Totp6;
+    KeyEntry sha256Totp;
+    KeyEntry sha512Totp;
+    KeyEntry sha1Hotp;
+    KeyEntry invalidEntry;
+
+    setupEntry(sha1Totp, "SHA1 TOTP", "3132333435363738393031323334353637383930", KEYENTRY_OTPTYPE_TOTP, KEYENTRY_ALG_SHA1, 8);
+    setupEntry(sha1Totp6, "SHA1 TOTP 6", "3132333435363738393031323334353637383930", KEYENTRY_OTPTYPE_TOTP, KEYENTRY_ALG_SHA1, 6);
+    setupEntry(sha256Totp, "SHA256 TOTP", "3132333435363738393031323334353637383930313233343536373839303132", KEYENTRY_OTPTYPE_TOTP, KEYENTRY_ALG_SHA256, 8);
+    setupEntry(sha512Totp, "SHA512 TOTP", "31323334353637383930313233343536373839303132333435363738393031323334353637383930313233343536373839303132333435363738393031323334", KEYENTRY_OTPTYPE_TOTP, KEYENTRY_ALG_SHA512, 7);
+    setupEntry(sha1Hotp, "SHA1 HOTP", "3132333435363738393031323334353637383930", KEYENTRY_OTPTYPE_HOTP, KEYENTRY_ALG_SHA1, 6);
+
+    // An entry without a secret is invalid.
+    invalidEntry.clear();
+    invalidEntry.setIdentifier("Invalid");
+
+    // Mix the order up so that the grouping has some work to do.
+    entries.append(&sha512Totp);
+    entries.append(&sha1Hotp);
+    entries.append(&invalidEntry);
+    entries.append(&sha1Totp);
+    entries.append(&sha256Totp);
+    entries.append(&sha1Totp6);
+
+    EXPECT_TRUE(engine.calculate(entries, 59));
+
+    EXPECT_TRUE(sha1Totp.codeValid());
+    EXPECT_EQ("94287082", sha1Totp.currentCode().toStdString());
+    EXPECT_EQ(29u, sha1Totp.startTime());
+
+    EXPECT_TRUE(sha1Totp6.codeValid());
+    EXPECT_EQ("287082", sha1Totp6.currentCode().toStdString());
+
+    EXPECT_TRUE(sha256Totp.codeValid());
+    EXPECT_EQ("46119246", sha256Totp.currentCode().toStdString());
+
+    EXPECT_TRUE(sha512Totp.codeValid());
+    EXPECT_EQ("0693936", sha512Totp.currentCode().toStdString());
+
+    EXPECT_TRUE(sha1Hotp.codeValid());
+    EXPECT_EQ("520489", sha1Hotp.currentCode().toStdString());
+
+    EXPECT_FALSE(invalidEntry.codeValid());
+    EXPECT_FALSE(invalidEntry.invalidReason().isEmpty());
+
+    // Calculating again at a later time should update the TOTP codes.
+    EXPECT_TRUE(engine.calculate(entries, 1111111109));
+
+    EXPECT_EQ("07081804", sha1Totp.currentCode().toStdString());
+    EXPECT_EQ("68084774", sha256Totp.currentCode().toStdString());
+    EXPECT_EQ("520489", sha1Hotp.currentCode().toStdString());
+
+    // An empty list should be fine.
+    entries.clear();
+    EXPECT_TRUE(engine.calculate(entries, 59));
+}
+
+TEST_F(OtpBatchEngineTests, ThreadedCalculateTest)
+{
+    OtpBatchEngine engine;
+    QList<KeyEntry *> entries;
+    std::vector<std::unique_ptr<KeyEntry> > storage;
+    const size_t entryCount = 300;              // Enough for several chunks in each group.
+
+    for (size_t i = 0; i < entryCount; i++) {
+        storage.push_back(std::unique_ptr<KeyEntry>(new KeyEntry()));
+
+        if (0 == (i % 2)) {
+            setupEntry(*storage.back(), "SHA1 TOTP " + QString::number(i), "3132333435363738393031323334353637383930", KEYENTRY_OTPTYPE_TOTP, KEYENTRY_ALG_SHA1, 8);
+        } else {
+            setupEntry(*storage.back(), "SHA256 TOTP " + QString::number(i), "3132333435363738393031323334353637383930313233343536373839303132", KEYENTRY_OTPTYPE_TOTP, KEYENTRY_ALG_SHA256, 8);
+        }
+
+        entries.append(storage.back().get());
+    }
+
+    // The codes have to be the same no matter how many threads calculate them.
+    for (size_t threads = 1; threads <= 4; threads++) {
+        EXPECT_TRUE(engine.setThreadCount(threads));
+        EXPECT_EQ(threads, engine.threadCount());
+
+        for (size_t i = 0; i < entryCount; i++) {
+            storage[i]->setCodeValid(false);
+        }
+
+        EXPECT_TRUE(engine.calculate(entries, 59));
+
+        for (size_t i = 0; i < entryCount; i++) {
+            EXPECT_TRUE(storage[i]->codeValid());
+            EXPECT_EQ((0 == (i % 2)) ? "94287082" : "46119246", storage[i]->currentCode().toStdString());
+        }
+    }
+
+    // 0 uses one thread per core.
+    EXPECT_TRUE(engine.setThreadCount(0));
+    EXPECT_EQ(WorkStealingPool::defaultThreadCount(), engine.threadCount());
+}
+
+TEST_F(OtpBatchEngineTests, RolloverTest)
+{
+    OtpBatchEngine engine;
+    QList<KeyEntry *> entries;
+    KeyEntry sha1Totp;
+    KeyEntry sha1Hotp;
+    char expected[OTPCODE_BUFFER_SIZE];
+
+    setupEntry(sha1Totp, "SHA1 TOTP", "3132333435363738393031323334353637383930", KEYENTRY_OTPTYPE_TOTP, KEYENTRY_ALG_SHA1, 8);
+    setupEntry(sha1Hotp, "SHA1 HOTP", "3132333435363738393031323334353637383930", KEYENTRY_OTPTYPE_HOTP, KEYENTRY_ALG_SHA1, 6);
+
+    entries.append(&sha1Totp);
+    entries.append(&sha1Hotp);
+
+    // Nothing to swap to until the look-ahead codes have been calculated.
+    EXPECT_TRUE(engine.calculate(entries, 59));
+    EXPECT_EQ("94287082", sha1Totp.currentCode().toStdString());
+    EXPECT_EQ(static_cast<uint64_t>(1), sha1Totp.codeCounter());
+    EXPECT_FALSE(sha1Totp.nextCodeValid());
+    EXPECT_FALSE(engine.rollover(entries, 60));
+
+    EXPECT_TRUE(engine.calculateNext(entries, 59));
+    EXPECT_TRUE(sha1Totp.nextCodeValid());
+    EXPECT_EQ(static_cast<uint64_t>(2), sha1Totp.nextCodeCounter());
+    EXPECT_FALSE(sha1Hotp.nextCodeValid());
+
+    // The current code is untouched by the look-ahead calculation.
+    EXPECT_EQ("94287082", sha1Totp.currentCode().toStdString());
+
+    // A rollover within the same period only updates the start time.
+    EXPECT_TRUE(engine.rollover(entries, 45));
+    EXPECT_EQ("94287082", sha1Totp.currentCode().toStdString());
+    EXPECT_EQ(15u, sha1Totp.startTime());
+    EXPECT_TRUE(sha1Totp.nextCodeValid());
+
+    // At the boundary, the look-ahead code becomes the current code.
+    EXPECT_TRUE(OtpCode::totp(sha1Totp.hmacKey(), 60, 30, 8, expected));
+    EXPECT_TRUE(engine.rollover(entries, 60));
+    EXPECT_EQ(std::string(expected), sha1Totp.currentCode().toStdString());
+    EXPECT_EQ(static_cast<uint64_t>(2), sha1Totp.codeCounter());
+    EXPECT_EQ(0u, sha1Totp.startTime());
+    EXPECT_FALSE(sha1Totp.nextCodeValid());
+    EXPECT_EQ("520489", sha1Hotp.currentCode().toStdString());
+
+    // Skipping a period can't be covered by the look-ahead code.
+    EXPECT_TRUE(engine.calculateNext(entries, 60));
+    EXPECT_FALSE(engine.rollover(entries, 120));
+    EXPECT_TRUE(engine.calculate(entries, 120));
+    EXPECT_TRUE(engine.rollover(entries, 120));
+
+    // Changing the time step throws away the look-ahead code.
+    EXPECT_TRUE(engine.calculateNext(entries, 120));
+    EXPECT_TRUE(sha1Totp.nextCodeValid());
+    sha1Totp.setTimeStep(60);
+    EXPECT_FALSE(sha1Totp.nextCodeValid());
+}
+
+TEST_F(OtpBatchEngineTests, CopyLookAheadTest)
+{
+    OtpBatchEngine engine;
+    QList<KeyEntry *> entries;
+    KeyEntry sha1Totp;
+
+    setupEntry(sha1Totp, "SHA1 TOTP", "3132333435363738393031323334353637383930", KEYENTRY_OTPTYPE_TOTP, KEYENTRY_ALG_SHA1, 8);
+    entries.append(&sha1Totp);
+
+    EXPECT_TRUE(engine.calculate(entries, 59));
+    EXPECT_TRUE(engine.calculateNext(entries, 59));
+    EXPECT_TRUE(sha1Totp.nextCodeValid());
+
+    // A copy keeps the look-ahead code, and can roll over to it.
+    KeyEntry copied(sha1Totp);
+    QList<KeyEntry *> copiedEntries;
+
+    EXPECT_TRUE(copied.nextCodeValid());
+    EXPECT_EQ(static_cast<uint64_t>(2), copied.nextCodeCounter());
+    EXPECT_EQ(sha1Totp.nextCode().toStdString(), copied.nextCode().toStdString());
+    EXPECT_EQ(static_cast<uint64_t>(1), copied.codeCounter());
+    EXPECT_EQ("94287082", copied.currentCode().toStdString());
+
+    copiedEntries.append(&copied);
+    EXPECT_TRUE(engine.rollover(copiedEntries, 60));
+    EXPECT_EQ(sha1Totp.nextCode().toStdString(), copied.currentCode().toStdString());
+    EXPECT_FALSE(copied.nextCodeValid());
+
+    // Copying an entry without a look-ahead code doesn't make one up.
+    KeyEntry noLookAhead(copied);
+
+    EXPECT_FALSE(noLookAhead.nextCodeValid());
+    EXPECT_EQ(static_cast<uint64_t>(0), noLookAhead.nextCodeCounter());
+}
@@ -4,6 +4,7 @@
 
 #include "testutils.h"
 
+#include <cctype>
 #include <vector>
 #include <iostream>
 #include <QDebug>
@@ -102,6 +103,98 @@ TEST_F(Base32CoderTests, NegativeTests)
     EXPECT_TRUE(!decode8Chars(ByteArray("MZXW6YT1"), 0, result));
 }
 
+TEST_F(Base32CoderTests, RelaxedDecodeTests)
+{
+    std::vector<ByteArray> clearText;
+    std::vector<ByteArray> encodedText;
+    std::string relaxed;
+
+    clearText = getClearTextTests();
+    encodedText = getEncodedTextTests();
+
+    // Lower case characters, and missing padding, are both accepted.
+    for (size_t i = 1; i < clearText.size(); i++) {
+        relaxed = encodedText.at(i).toString();
+
+        for (size_t j = 0; j < relaxed.size(); j++) {
+            relaxed[j] = static_cast<char>(tolower(relaxed[j]));
+        }
+
+        EXPECT_TRUE(clearText.at(i) == decode(relaxed));
+
+        while ((!relaxed.empty()) && ('=' == relaxed.back())) {
+            relaxed.pop_back();
+        }
+
+        EXPECT_TRUE(clearText.at(i) == decode(relaxed));
+    }
+
+    EXPECT_EQ(0x1f, decodeChar('7'));
+    EXPECT_EQ(0x19, decodeChar('z'));
+    EXPECT_EQ(0xff, decodeChar('='));
+    EXPECT_EQ(0xff, decodeChar(0xc1));
+
+    // A final block of 1, 3, or 6 characters isn't valid.
+    EXPECT_TRUE(decode("MZXW6YTBM").empty());
+    EXPECT_TRUE(decode("MZX").empty());
+    EXPECT_TRUE(decode("MZXW6Y==").empty());
+
+    // Padding is only allowed at the end.
+    EXPECT_TRUE(decode("MY======MY======").empty());
+    EXPECT_TRUE(decode("========").empty());
+
+    // The strict check still wants upper case, and full blocks.
+    EXPECT_TRUE(!Base32Coder::isBase32Encoded("mzxw6ytb"));
+    EXPECT_TRUE(!Base32Coder::isBase32Encoded("MZXW6"));
+}
+
+TEST_F(Base32CoderTests, BackendTests)
+{
+    const unsigned int allBackends[3] = { BASE32CODER_BACKEND_SCALAR, BASE32CODER_BACKEND_SSSE3, BASE32CODER_BACKEND_AVX2 };
+    ByteArray clear;
+    ByteArray encoded;
+    ByteArray decoded;
+    std::string broken;
+
+    EXPECT_TRUE(Base32Coder::backendSupported(BASE32CODER_BACKEND_SCALAR));
+    EXPECT_TRUE(Base32Coder::backendSupported(Base32Coder::bestBackend()));
+    EXPECT_FALSE(Base32Coder::backendSupported(42));
+    EXPECT_TRUE(decode("MZXW6YTB", 42).empty());
+
+    qDebug("Best base32 backend : %u", Base32Coder::bestBackend());
+
+    // Use lengths that leave the SIMD code with partial registers, and a chunk boundary.
+    for (size_t length = 1; length <= 700; length += 23) {
+        clear.clear();
+        for (size_t i = 0; i < length; i++) {
+            EXPECT_TRUE(clear.append(static_cast<char>((i * 73) + (length * 11))));
+        }
+
+        encoded = encode(clear);
+        EXPECT_EQ(getBlocksFromSize(length) * 8, encoded.size());
+
+        for (size_t b = 0; b < 3; b++) {
+            if (!Base32Coder::backendSupported(allBackends[b])) {
+                continue;
+            }
+
+            decoded = decode(encoded, allBackends[b]);
+            EXPECT_TRUE(clear == decoded);
+
+            // An invalid character anywhere has to be caught, whichever code path sees it.
+            for (size_t i = 0; i < encoded.size(); i += 7) {
+                broken = encoded.toString();
+                if ('=' == broken[i]) {
+                    break;
+                }
+
+                broken[i] = ((i % 2) == 0) ? '1' : static_cast<char>(0xc1);
+                EXPECT_TRUE(decode(broken, allBackends[b]).empty());
+            }
+        }
+    }
+}
+
 std::vector<ByteArray> getClearTextTests()
 {
     std::vector<ByteArray> result;
@@ -0,0 +1,127 @@
+#include <testsuitebase.h>
+
+#include <memory>
+#include "otpimpl/sha1hash.h"
+#include "otpimpl/sha256hash.h"
+#include "otpimpl/sha512hash.h"
+#include "testutils.h"
+
+#include <QDebug>
+
+EMPTY_TEST_SUITE(HashContextTests);
+
+// Hash the data a few bytes at a time, and make sure it matches hashing it in one go.
+static void checkStreaming(HashTypeBase &hashObj)
+{
+    ByteArray data;
+    ByteArray expected;
+    ByteArray result;
+    std::unique_ptr<HashContextBase> ctx;
+
+    for (size_t i = 0; i < 1000; i++) {
+        data.append(static_cast<char>((i * 7) & 0xff));
+    }
+
+    expected = hashObj.hash(data);
+    EXPECT_EQ(hashObj.hashResultLength(), expected.size());
+
+    // Use uneven chunk sizes so that the updates don't line up with the block boundaries.
+    for (size_t chunk = 1; chunk < 200; chunk += 37) {
+        ctx = hashObj.begin();
+        ASSERT_NE(nullptr, ctx);
+
+        for (size_t i = 0; i < data.size(); i += chunk) {
+            size_t toAdd = ((data.size() - i) < chunk) ? (data.size() - i) : chunk;
+
+            EXPECT_TRUE(ctx->update(data.toUCharArrayPtr() + i, toAdd));
+        }
+
+        EXPECT_TRUE(ctx->finish(result));
+        EXPECT_TRUE(expected == result);
+    }
+}
+
+TEST_F(HashContextTests, StreamingTest)
+{
+    Sha1Hash sha1;
+    Sha256Hash sha256;
+    Sha512Hash sha512;
+
+    checkStreaming(sha1);
+    checkStreaming(sha256);
+    checkStreaming(sha512);
+}
+
+TEST_F(HashContextTests, KnownVectorTest)
+{
+    // FIPS 180-2 "abc" test vector, fed in one byte at a time.
+    unsigned char expected[32] = { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad };
+    Sha256Hash sha256;
+    std::unique_ptr<HashContextBase> ctx;
+    ByteArray result;
+
+    ctx = sha256.begin();
+    EXPECT_TRUE(ctx->update(reinterpret_cast<const unsigned char *>("a"), 1));
+    EXPECT_TRUE(ctx->update(reinterpret_cast<const unsigned char *>("b"), 1));
+    EXPECT_TRUE(ctx->update(ByteArray("c")));
+    EXPECT_TRUE(ctx->finish(result));
+
+    qDebug("Calculated : %s", TestUtils::binaryToString(result.toUCharArrayPtr(), result.size()).c_str());
+
+    EXPECT_TRUE(ByteArray(reinterpret_cast<char *>(expected), 32) == result);
+}
+
+TEST_F(HashContextTests, CloneTest)
+{
+    Sha512Hash sha512;
+    std::unique_ptr<HashContextBase> ctx;
+    std::unique_ptr<HashContextBase> copy;
+    ByteArray prefix("This is the common prefix.");
+    ByteArray first;
+    ByteArray second;
+    ByteArray expected;
+
+    // Hash the prefix once, then finish two different messages from the midstate.
+    ctx = sha512.begin();
+    EXPECT_TRUE(ctx->update(prefix));
+
+    copy = ctx->clone();
+    ASSERT_NE(nullptr, copy);
+
+    EXPECT_TRUE(ctx->update(ByteArray("first")));
+    EXPECT_TRUE(ctx->finish(first));
+
+    EXPECT_TRUE(copy->update(ByteArray("second")));
+    EXPECT_TRUE(copy->finish(second));
+
+    expected = prefix;
+    expected.append(ByteArray("first"));
+    EXPECT_TRUE(sha512.hash(expected) == first);
+
+    expected = prefix;
+    expected.append(ByteArray("second"));
+    EXPECT_TRUE(sha512.hash(expected) == second);
+}
+
+TEST_F(HashContextTests, FinishedTest)
+{
+    Sha1Hash sha1;
+    std::unique_ptr<HashContextBase> ctx;
+    std::unique_ptr<HashContextBase> copy;
+    ByteArray result;
+
+    ctx = sha1.begin();
+
+    // Empty updates are fine, but a null pointer with data isn't.
+    EXPECT_TRUE(ctx->update(nullptr, 0));
+    EXPECT_FALSE(ctx->update(nullptr, 10));
+
+    EXPECT_TRUE(ctx->finish(result));
+    EXPECT_EQ(static_cast<size_t>(20), result.size());
+
+    // Once finished, the context can't be used again.  (Or through a copy of it.)
+    copy = ctx->clone();
+    EXPECT_FALSE(ctx->update(ByteArray("more")));
+    EXPECT_FALSE(ctx->finish(result));
+    EXPECT_FALSE(copy->finish(result));
+}
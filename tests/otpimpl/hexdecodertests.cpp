@@ -104,8 +104,83 @@ TEST_F(HexDecoderTests, DecodeInvalidTextTest)
     EXPECT_TRUE(result.empty());
 }
 
+TEST_F(HexDecoderTests, BackendTest)
+{
+    const unsigned int allBackends[3] = { HEXDECODER_BACKEND_SCALAR, HEXDECODER_BACKEND_SSSE3, HEXDECODER_BACKEND_AVX2 };
+    const char digits[] = "0123456789abcdefABCDEF";
+    ByteArray expected;
+    std::string plain;
+    std::string separated;
+    std::string broken;
+
+    EXPECT_TRUE(HexDecoder::backendSupported(HEXDECODER_BACKEND_SCALAR));
+    EXPECT_TRUE(HexDecoder::backendSupported(HexDecoder::bestBackend()));
+    EXPECT_FALSE(HexDecoder::backendSupported(42));
+    EXPECT_TRUE(decode(ByteArray("0102"), 42).empty());
+
+    qDebug("Best hex decoder backend : %u", HexDecoder::bestBackend());
+
+    // Use lengths that leave the SIMD code with partial registers, and cross the stack buffer.
+    for (size_t length = 1; length <= 600; length += 37) {
+        expected.clear();
+        plain.clear();
+        separated.clear();
+
+        for (size_t i = 0; i < length; i++) {
+            unsigned char value = static_cast<unsigned char>((i * 73) + length);
+
+            EXPECT_TRUE(expected.append(static_cast<char>(value)));
+
+            plain += digits[value >> 4];
+            plain += digits[(value & 0x0f) + (((value & 0x0f) > 9) && ((i % 2) == 0) ? 6 : 0)];
+
+            // Every so often, break up the run with a separator, or a 0x prefix.
+            if ((i % 23) == 22) {
+                separated += ((i % 2) == 0) ? "0x" : " : ";
+            }
+            separated += plain.substr(plain.length() - 2);
+        }
+
+        for (size_t b = 0; b < 3; b++) {
+            if (!HexDecoder::backendSupported(allBackends[b])) {
+                continue;
+            }
+
+            EXPECT_TRUE(expected == decode(ByteArray(plain), allBackends[b]));
+            EXPECT_TRUE(expected == decode(ByteArray(separated), allBackends[b]));
+
+            // An invalid character anywhere has to be caught, whichever code path sees it.
+            for (size_t i = 0; i < plain.length(); i += 11) {
+                broken = plain;
+                broken[i] = ((i % 2) == 0) ? 'g' : static_cast<char>(0xb0);
+                EXPECT_TRUE(decode(ByteArray(broken), allBackends[b]).empty());
+            }
+
+            // So does a missing character.
+            EXPECT_TRUE(decode(ByteArray(plain.substr(1)), allBackends[b]).empty());
+        }
+    }
+
+    // A 0x prefix straight after a full SIMD register.
+    plain = "00112233445566778899aabbccddeeff0x00112233445566778899aabbccddeeff";
+    expected = decode(ByteArray("00112233445566778899aabbccddeeff00112233445566778899aabbccddeeff"), HEXDECODER_BACKEND_SCALAR);
+    EXPECT_EQ(static_cast<size_t>(32), expected.size());
+
+    for (size_t b = 0; b < 3; b++) {
+        if (HexDecoder::backendSupported(allBackends[b])) {
+            EXPECT_TRUE(expected == decode(ByteArray(plain), allBackends[b]));
+        }
+    }
+}
+
 TEST_F(HexDecoderTests, NegativeTests)
 {
     EXPECT_EQ((unsigned char)0x00, decodeOneByte("a"));
     EXPECT_EQ((unsigned char)0xff, decodeOneNibble('z'));
+    EXPECT_EQ((unsigned char)0xff, decodeOneNibble(':'));
+    EXPECT_EQ((unsigned char)0x0b, decodeOneNibble('b'));
+
+    // An invalid character in the middle of the string is an error, not a garbage octet.
+    EXPECT_TRUE(decode(ByteArray("01zz02")).empty());
+    EXPECT_TRUE(decode(ByteArray("0X01")).empty());
 }
@@ -0,0 +1,103 @@
+#include <testsuitebase.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "otpimpl/hmacalgorithm.h"
+#include "otpimpl/otpcode.h"
+#include "testutils.h"
+
+#include <QDebug>
+
+// Hash test vectors taken from FIPS 180-2, and HOTP values from RFC 4226 and RFC 6238.
+
+EMPTY_TEST_SUITE(HmacAlgorithmTests);
+
+TEST_F(HmacAlgorithmTests, RegistryTest)
+{
+    const unsigned int algorithms[3] = { HMACKEY_ALG_SHA1, HMACKEY_ALG_SHA256, HMACKEY_ALG_SHA512 };
+    const size_t blockLengths[3] = { 64, 64, 128 };
+    const size_t resultLengths[3] = { 20, 32, 64 };
+    const char *names[3] = { "SHA1", "SHA256", "SHA512" };
+    const HmacAlgorithm *hash;
+
+    EXPECT_EQ(static_cast<size_t>(3), HmacAlgorithm::count());
+
+    for (size_t i = 0; i < 3; i++) {
+        hash = HmacAlgorithm::find(algorithms[i]);
+        ASSERT_NE(nullptr, hash);
+
+        EXPECT_EQ(hash, HmacAlgorithm::at(i));
+        EXPECT_EQ(algorithms[i], hash->algorithm);
+        EXPECT_STREQ(names[i], hash->name);
+        EXPECT_EQ(blockLengths[i], hash->blockLength);
+        EXPECT_EQ(resultLengths[i], hash->resultLength);
+        EXPECT_LE(hash->blockLength, HMACKEY_MAX_BLOCK_LENGTH);
+        EXPECT_LE(hash->resultLength, HMACKEY_MAX_RESULT_LENGTH);
+    }
+
+    EXPECT_EQ(nullptr, HmacAlgorithm::find(42));
+    EXPECT_EQ(nullptr, HmacAlgorithm::at(3));
+}
+
+TEST_F(HmacAlgorithmTests, DigestTest)
+{
+    const unsigned char expected[3][20] = {
+        { 0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e, 0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d },
+        { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3 },
+        { 0xdd, 0xaf, 0x35, 0xa1, 0x93, 0x61, 0x7a, 0xba, 0xcc, 0x41, 0x73, 0x49, 0xae, 0x20, 0x41, 0x31, 0x12, 0xe6, 0xfa, 0x4e }
+    };
+    unsigned char oneShot[HMACKEY_MAX_RESULT_LENGTH];
+    unsigned char streamed[HMACKEY_MAX_RESULT_LENGTH];
+    HmacKey::HashState state;
+    const HmacAlgorithm *hash;
+
+    for (size_t i = 0; i < HmacAlgorithm::count(); i++) {
+        hash = HmacAlgorithm::at(i);
+        ASSERT_NE(nullptr, hash);
+
+        // The one shot digest, and the streaming functions, have to agree.
+        hash->digest(reinterpret_cast<const unsigned char *>("abc"), 3, oneShot);
+
+        hash->init(state);
+        hash->update(state, reinterpret_cast<const unsigned char *>("a"), 1);
+        hash->update(state, reinterpret_cast<const unsigned char *>("bc"), 2);
+        hash->final(state, streamed);
+
+        qDebug("%s(\"abc\") : %s", hash->name, TestUtils::binaryToString(oneShot, hash->resultLength).c_str());
+
+        // (Only the first 20 bytes are checked.)
+        EXPECT_TRUE(memcmp(oneShot, expected[i], 20) == 0);
+        EXPECT_TRUE(memcmp(oneShot, streamed, hash->resultLength) == 0);
+    }
+}
+
+TEST_F(HmacAlgorithmTests, ConcurrentTest)
+{
+    const unsigned char key[20] = { '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '0' };
+    const char *expected[4] = { "755224", "287082", "359152", "969429" };
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+
+    // Set up keys from the raw secret on several threads at once.  Nothing is shared but the
+    // descriptors.
+    for (size_t t = 0; t < failures.size(); t++) {
+        threads.push_back(std::thread([&, t]() {
+            char code[OTPCODE_BUFFER_SIZE];
+
+            for (size_t i = 0; i < 200; i++) {
+                if ((!OtpCode::hotp(HMACKEY_ALG_SHA1, key, sizeof(key), t, 6, code)) || (strcmp(code, expected[t]) != 0)) {
+                    failures[t]++;
+                }
+            }
+        }));
+    }
+
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    for (size_t t = 0; t < failures.size(); t++) {
+        EXPECT_EQ(0, failures[t]);
+    }
+}
@@ -0,0 +1,240 @@
+#include <testsuitebase.h>
+
+#include "otpimpl/hmackey.h"
+#include "otpimpl/hotp.h"
+#include "otpimpl/totp.h"
+#include "testutils.h"
+
+#include <QDebug>
+
+// Test vectors taken from RFC 2202 at https://tools.ietf.org/html/rfc2202 and
+// RFC 4231 at https://tools.ietf.org/html/rfc4231
+
+EMPTY_TEST_SUITE(HmacKeyTests);
+
+TEST_F(HmacKeyTests, InvalidKeyTest)
+{
+    HmacKey hmacKey;
+    ByteArray key("Jefe");
+    ByteArray data("what do ya want for nothing?");
+    unsigned char result[HMACKEY_MAX_RESULT_LENGTH];
+
+    // A new object doesn't have a key.
+    EXPECT_FALSE(hmacKey.valid());
+    EXPECT_EQ(static_cast<size_t>(0), hmacKey.resultLength());
+    EXPECT_TRUE(hmacKey.calculate(data).empty());
+
+    // Empty keys, and unknown algorithms should fail.
+    EXPECT_FALSE(hmacKey.setKey(HMACKEY_ALG_SHA1, ByteArray()));
+    EXPECT_FALSE(hmacKey.setKey(42, key));
+    EXPECT_FALSE(hmacKey.valid());
+
+    // The result buffer must be big enough to hold the result.
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA256, key));
+    EXPECT_FALSE(hmacKey.calculate(data.toUCharArrayPtr(), data.size(), result, 20));
+    EXPECT_TRUE(hmacKey.calculate(data.toUCharArrayPtr(), data.size(), result, sizeof(result)));
+
+    // Clearing the key should invalidate it.
+    hmacKey.clear();
+    EXPECT_FALSE(hmacKey.valid());
+    EXPECT_FALSE(hmacKey.calculate(data.toUCharArrayPtr(), data.size(), result, sizeof(result)));
+}
+
+TEST_F(HmacKeyTests, SecureCopyTest)
+{
+    HmacKey hmacKey;
+    HmacKey assigned;
+    ByteArray key("Jefe");
+    ByteArray data("what do ya want for nothing?");
+    ByteArray expected;
+
+    // Nothing is allocated until a key is set.
+    EXPECT_FALSE(hmacKey.usingSecureBuffer());
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, key));
+    EXPECT_TRUE(hmacKey.usingSecureBuffer());
+    expected = hmacKey.calculate(data);
+
+    // Copies get their own pad states, in the arena.
+    HmacKey copied(hmacKey);
+    assigned = hmacKey;
+
+    EXPECT_TRUE(copied.valid());
+    EXPECT_TRUE(copied.usingSecureBuffer());
+    EXPECT_TRUE(assigned.valid());
+    EXPECT_TRUE(assigned.usingSecureBuffer());
+
+    // And keep working after the original is cleared.
+    hmacKey.clear();
+    EXPECT_TRUE(copied.calculate(data) == expected);
+    EXPECT_TRUE(assigned.calculate(data) == expected);
+
+    // Copying an invalid key makes the target invalid.
+    assigned = hmacKey;
+    EXPECT_FALSE(assigned.valid());
+}
+
+TEST_F(HmacKeyTests, ShortKeyTest)
+{
+    unsigned char expectedSha1[20] = { 0xef, 0xfc, 0xdf, 0x6a, 0xe5, 0xeb, 0x2f, 0xa2, 0xd2, 0x74, 0x16, 0xd5, 0xf1, 0x84, 0xdf, 0x9c, 0x25, 0x9a, 0x7c, 0x79 };
+    unsigned char expectedSha256[32] = { 0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83, 0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43 };
+    unsigned char expectedSha512[64] = { 0x16, 0x4b, 0x7a, 0x7b, 0xfc, 0xf8, 0x19, 0xe2, 0xe3, 0x95, 0xfb, 0xe7, 0x3b, 0x56, 0xe0, 0xa3, 0x87, 0xbd, 0x64, 0x22, 0x2e, 0x83, 0x1f, 0xd6, 0x10, 0x27, 0x0c, 0xd7, 0xea, 0x25, 0x05, 0x54, 0x97, 0x58, 0xbf, 0x75, 0xc0, 0x5a, 0x99, 0x4a, 0x6d, 0x03, 0x4f, 0x65, 0xf8, 0xf0, 0xe6, 0xfd, 0xca, 0xea, 0xb1, 0xa3, 0x4d, 0x4a, 0x6b, 0x4b, 0x63, 0x6e, 0x07, 0x0a, 0x38, 0xbc, 0xe7, 0x37 };
+    ByteArray key("Jefe");
+    ByteArray data("what do ya want for nothing?");
+    HmacKey hmacKey;
+    ByteArray result;
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, key));
+    result = hmacKey.calculate(data);
+    EXPECT_EQ(static_cast<size_t>(20), result.size());
+    qDebug("Got      : %s", TestUtils::binaryToString(result).c_str());
+    EXPECT_TRUE(memcmp(result.toUCharArrayPtr(), expectedSha1, 20) == 0);
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA256, key));
+    result = hmacKey.calculate(data);
+    EXPECT_EQ(static_cast<size_t>(32), result.size());
+    qDebug("Got      : %s", TestUtils::binaryToString(result).c_str());
+    EXPECT_TRUE(memcmp(result.toUCharArrayPtr(), expectedSha256, 32) == 0);
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA512, key));
+    result = hmacKey.calculate(data);
+    EXPECT_EQ(static_cast<size_t>(64), result.size());
+    qDebug("Got      : %s", TestUtils::binaryToString(result).c_str());
+    EXPECT_TRUE(memcmp(result.toUCharArrayPtr(), expectedSha512, 64) == 0);
+
+    // Calculating a second time with the same key should give the same result.
+    result = hmacKey.calculate(data);
+    EXPECT_TRUE(memcmp(result.toUCharArrayPtr(), expectedSha512, 64) == 0);
+}
+
+TEST_F(HmacKeyTests, LargerThanBlockKeyTest)
+{
+    unsigned char expectedSha1[20] = { 0x90, 0xd0, 0xda, 0xce, 0x1c, 0x1b, 0xdc, 0x95, 0x73, 0x39, 0x30, 0x78, 0x03, 0x16, 0x03, 0x35, 0xbd, 0xe6, 0xdf, 0x2b };
+    unsigned char expectedSha256[32] = { 0x60, 0xe4, 0x31, 0x59, 0x1e, 0xe0, 0xb6, 0x7f, 0x0d, 0x8a, 0x26, 0xaa, 0xcb, 0xf5, 0xb7, 0x7f, 0x8e, 0x0b, 0xc6, 0x21, 0x37, 0x28, 0xc5, 0x14, 0x05, 0x46, 0x04, 0x0f, 0x0e, 0xe3, 0x7f, 0x54 };
+    unsigned char expectedSha512[64] = { 0x80, 0xb2, 0x42, 0x63, 0xc7, 0xc1, 0xa3, 0xeb, 0xb7, 0x14, 0x93, 0xc1, 0xdd, 0x7b, 0xe8, 0xb4, 0x9b, 0x46, 0xd1, 0xf4, 0x1b, 0x4a, 0xee, 0xc1, 0x12, 0x1b, 0x01, 0x37, 0x83, 0xf8, 0xf3, 0x52, 0x6b, 0x56, 0xd0, 0x37, 0xe0, 0x5f, 0x25, 0x98, 0xbd, 0x0f, 0xd2, 0x21, 0x5d, 0x6a, 0x1e, 0x52, 0x95, 0xe6, 0x4f, 0x73, 0xf6, 0x3f, 0x0a, 0xec, 0x8b, 0x91, 0x5a, 0x98, 0x5d, 0x78, 0x65, 0x98 };
+    ByteArray data("Test Using Larger Than Block-Size Key - Hash Key First");
+    ByteArray key;
+    HmacKey hmacKey;
+    ByteArray result;
+
+    // Build a 131 byte key.
+    for (size_t i = 0; i < 131; i++) {
+        key.append(static_cast<char>(0xaa));
+    }
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, key));
+    result = hmacKey.calculate(data);
+    EXPECT_TRUE(memcmp(result.toUCharArrayPtr(), expectedSha1, 20) == 0);
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA256, key));
+    result = hmacKey.calculate(data);
+    EXPECT_TRUE(memcmp(result.toUCharArrayPtr(), expectedSha256, 32) == 0);
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA512, key));
+    result = hmacKey.calculate(data);
+    EXPECT_TRUE(memcmp(result.toUCharArrayPtr(), expectedSha512, 64) == 0);
+}
+
+TEST_F(HmacKeyTests, HotpAndTotpTest)
+{
+    ByteArray secret("12345678901234567890");
+    HmacKey hmacKey;
+    Hotp hotp;
+    Totp totp;
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, secret));
+
+    // Values from RFC 4226.
+    EXPECT_EQ("755224", hotp.calculate(hmacKey, 0, 6));
+    EXPECT_EQ("287082", hotp.calculate(hmacKey, 1, 6));
+    EXPECT_EQ("520489", hotp.calculate(hmacKey, 9, 6));
+
+    // Value from RFC 6238.
+    EXPECT_EQ("94287082", totp.calculate(hmacKey, 59, 30, 8));
+
+    // An invalid key should fail.
+    hmacKey.clear();
+    EXPECT_TRUE(hotp.calculate(hmacKey, 0, 6).empty());
+    EXPECT_TRUE(totp.calculate(hmacKey, 59, 30, 8).empty());
+}
+
+TEST_F(HmacKeyTests, CalculateManyTest)
+{
+    unsigned char expectedSha1[20] = { 0xef, 0xfc, 0xdf, 0x6a, 0xe5, 0xeb, 0x2f, 0xa2, 0xd2, 0x74, 0x16, 0xd5, 0xf1, 0x84, 0xdf, 0x9c, 0x25, 0x9a, 0x7c, 0x79 };
+    unsigned char expectedSha256[32] = { 0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83, 0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43 };
+    const size_t count = 11;                    // More than one full set of lanes.
+    ByteArray key("Jefe");
+    ByteArray data("what do ya want for nothing?");
+    HmacKey sha1Key;
+    HmacKey sha256Key;
+    const HmacKey *keys[count];
+    const unsigned char *dataPtrs[count];
+    unsigned char results[count][HMACKEY_MAX_RESULT_LENGTH];
+    unsigned char *resultPtrs[count];
+
+    EXPECT_TRUE(sha1Key.setKey(HMACKEY_ALG_SHA1, key));
+    EXPECT_TRUE(sha256Key.setKey(HMACKEY_ALG_SHA256, key));
+
+    // Mix in a SHA256 key, which has to be calculated the normal way.
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = (i == 5) ? &sha256Key : &sha1Key;
+        dataPtrs[i] = data.toUCharArrayPtr();
+        resultPtrs[i] = results[i];
+    }
+
+    memset(&results, 0x00, sizeof(results));
+    EXPECT_TRUE(HmacKey::calculateMany(keys, dataPtrs, data.size(), count, resultPtrs));
+
+    for (size_t i = 0; i < count; i++) {
+        if (i == 5) {
+            EXPECT_TRUE(memcmp(results[i], expectedSha256, 32) == 0);
+        } else {
+            qDebug("Got      : %s", TestUtils::binaryToString(results[i], 20).c_str());
+            EXPECT_TRUE(memcmp(results[i], expectedSha1, 20) == 0);
+        }
+    }
+
+    // Data that doesn't fit in a single block should still work.
+    ByteArray longData("Test Using Larger Than Block-Size Key and Larger Than One Block-Size Data");
+    unsigned char expected[HMACKEY_MAX_RESULT_LENGTH];
+
+    EXPECT_TRUE(sha1Key.calculate(longData.toUCharArrayPtr(), longData.size(), expected, sizeof(expected)));
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = &sha1Key;
+        dataPtrs[i] = longData.toUCharArrayPtr();
+    }
+
+    EXPECT_TRUE(HmacKey::calculateMany(keys, dataPtrs, longData.size(), count, resultPtrs));
+    EXPECT_TRUE(memcmp(results[count - 1], expected, 20) == 0);
+
+    // An invalid key anywhere in the batch should fail.
+    HmacKey invalidKey;
+
+    keys[3] = &invalidKey;
+    EXPECT_FALSE(HmacKey::calculateMany(keys, dataPtrs, data.size(), count, resultPtrs));
+    EXPECT_FALSE(HmacKey::calculateMany(nullptr, dataPtrs, data.size(), count, resultPtrs));
+
+    // SHA512 keys get their own lanes.  Mix them with SHA1 keys so both sets of lanes are used.
+    unsigned char expectedSha512[64] = { 0x16, 0x4b, 0x7a, 0x7b, 0xfc, 0xf8, 0x19, 0xe2, 0xe3, 0x95, 0xfb, 0xe7, 0x3b, 0x56, 0xe0, 0xa3,
+                                         0x87, 0xbd, 0x64, 0x22, 0x2e, 0x83, 0x1f, 0xd6, 0x10, 0x27, 0x0c, 0xd7, 0xea, 0x25, 0x05, 0x54,
+                                         0x97, 0x58, 0xbf, 0x75, 0xc0, 0x5a, 0x99, 0x4a, 0x6d, 0x03, 0x4f, 0x65, 0xf8, 0xf0, 0xe6, 0xfd,
+                                         0xca, 0xea, 0xb1, 0xa3, 0x4d, 0x4a, 0x6b, 0x4b, 0x63, 0x6e, 0x07, 0x0a, 0x38, 0xbc, 0xe7, 0x37 };
+    HmacKey sha512Key;
+
+    EXPECT_TRUE(sha512Key.setKey(HMACKEY_ALG_SHA512, key));
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = ((i % 3) == 0) ? &sha1Key : &sha512Key;
+        dataPtrs[i] = data.toUCharArrayPtr();
+    }
+
+    memset(&results, 0x00, sizeof(results));
+    EXPECT_TRUE(HmacKey::calculateMany(keys, dataPtrs, data.size(), count, resultPtrs));
+
+    for (size_t i = 0; i < count; i++) {
+        if ((i % 3) == 0) {
+            EXPECT_TRUE(memcmp(results[i], expectedSha1, 20) == 0);
+        } else {
+            EXPECT_TRUE(memcmp(results[i], expectedSha512, 64) == 0);
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#include <testsuitebase.h>
+
+#include <cstring>
+#include "otpimpl/hmact.h"
+#include "testutils.h"
+
+#include <QDebug>
+
+// Test vectors taken from RFC 2202 at https://tools.ietf.org/html/rfc2202 and
+// RFC 4231 at https://tools.ietf.org/html/rfc4231
+
+EMPTY_TEST_SUITE(HmacTTests);
+
+TEST_F(HmacTTests, SizesTest)
+{
+    EXPECT_EQ(static_cast<size_t>(64), static_cast<size_t>(Sha1Policy::BLOCK_LENGTH));
+    EXPECT_EQ(static_cast<size_t>(20), static_cast<size_t>(Sha1Policy::DIGEST_LENGTH));
+    EXPECT_EQ(static_cast<size_t>(64), static_cast<size_t>(Sha256Policy::BLOCK_LENGTH));
+    EXPECT_EQ(static_cast<size_t>(32), static_cast<size_t>(Sha256Policy::DIGEST_LENGTH));
+    EXPECT_EQ(static_cast<size_t>(128), static_cast<size_t>(Sha512Policy::BLOCK_LENGTH));
+    EXPECT_EQ(static_cast<size_t>(64), static_cast<size_t>(Sha512Policy::DIGEST_LENGTH));
+}
+
+TEST_F(HmacTTests, ShortKeyTest)
+{
+    unsigned char expectedSha1[20] = { 0xef, 0xfc, 0xdf, 0x6a, 0xe5, 0xeb, 0x2f, 0xa2, 0xd2, 0x74, 0x16, 0xd5, 0xf1, 0x84, 0xdf, 0x9c, 0x25, 0x9a, 0x7c, 0x79 };
+    unsigned char expectedSha256[32] = { 0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83, 0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43 };
+    unsigned char expectedSha512[64] = { 0x16, 0x4b, 0x7a, 0x7b, 0xfc, 0xf8, 0x19, 0xe2, 0xe3, 0x95, 0xfb, 0xe7, 0x3b, 0x56, 0xe0, 0xa3, 0x87, 0xbd, 0x64, 0x22, 0x2e, 0x83, 0x1f, 0xd6, 0x10, 0x27, 0x0c, 0xd7, 0xea, 0x25, 0x05, 0x54, 0x97, 0x58, 0xbf, 0x75, 0xc0, 0x5a, 0x99, 0x4a, 0x6d, 0x03, 0x4f, 0x65, 0xf8, 0xf0, 0xe6, 0xfd, 0xca, 0xea, 0xb1, 0xa3, 0x4d, 0x4a, 0x6b, 0x4b, 0x63, 0x6e, 0x07, 0x0a, 0x38, 0xbc, 0xe7, 0x37 };
+    const unsigned char key[] = "Jefe";
+    const unsigned char data[] = "what do ya want for nothing?";
+    unsigned char result[64];
+    HmacT<Sha1Policy> sha1Hmac;
+    HmacT<Sha256Policy> sha256Hmac;
+    HmacT<Sha512Policy> sha512Hmac;
+
+    EXPECT_TRUE(sha1Hmac.setKey(key, 4));
+    EXPECT_TRUE(sha1Hmac.calculate(data, 28, result));
+    qDebug("Got      : %s", TestUtils::binaryToString(result, 20).c_str());
+    EXPECT_TRUE(memcmp(result, expectedSha1, 20) == 0);
+
+    EXPECT_TRUE(sha256Hmac.setKey(key, 4));
+    EXPECT_TRUE(sha256Hmac.calculate(data, 28, result));
+    EXPECT_TRUE(memcmp(result, expectedSha256, 32) == 0);
+
+    EXPECT_TRUE(sha512Hmac.setKey(key, 4));
+    EXPECT_TRUE(sha512Hmac.calculate(data, 28, result));
+    EXPECT_TRUE(memcmp(result, expectedSha512, 64) == 0);
+}
+
+TEST_F(HmacTTests, LongKeyTest)
+{
+    // RFC 4231 test case 6.  (A key longer than the block size.)
+    unsigned char expectedSha256[32] = { 0x60, 0xe4, 0x31, 0x59, 0x1e, 0xe0, 0xb6, 0x7f, 0x0d, 0x8a, 0x26, 0xaa, 0xcb, 0xf5, 0xb7, 0x7f, 0x8e, 0x0b, 0xc6, 0x21, 0x37, 0x28, 0xc5, 0x14, 0x05, 0x46, 0x04, 0x0f, 0x0e, 0xe3, 0x7f, 0x54 };
+    const unsigned char data[] = "Test Using Larger Than Block-Size Key - Hash Key First";
+    unsigned char key[131];
+    unsigned char result[32];
+    HmacT<Sha256Policy> sha256Hmac;
+
+    memset(&key, 0xaa, sizeof(key));
+
+    EXPECT_TRUE(sha256Hmac.setKey(key, sizeof(key)));
+    EXPECT_TRUE(sha256Hmac.calculate(data, 54, result));
+    EXPECT_TRUE(memcmp(result, expectedSha256, 32) == 0);
+}
+
+TEST_F(HmacTTests, MatchesHmacKeyTest)
+{
+    ByteArray key("12345678901234567890123456789012");
+    unsigned char data[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    unsigned char expected[HMACKEY_MAX_RESULT_LENGTH];
+    unsigned char result[HMACKEY_MAX_RESULT_LENGTH];
+    HmacKey hmacKey;
+    HmacT<Sha512Policy> sha512Hmac;
+
+    // Using the pad states from an HmacKey should give the same answer as the HmacKey.
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA512, key));
+    EXPECT_TRUE(hmacKey.calculate(data, sizeof(data), expected, sizeof(expected)));
+
+    memset(&result, 0x00, sizeof(result));
+    EXPECT_TRUE(HmacT<Sha512Policy>::calculate(hmacKey, data, sizeof(data), result));
+    EXPECT_TRUE(memcmp(result, expected, 64) == 0);
+
+    memset(&result, 0x00, sizeof(result));
+    EXPECT_TRUE(sha512Hmac.setKey(hmacKey));
+    EXPECT_TRUE(sha512Hmac.calculate(data, sizeof(data), result));
+    EXPECT_TRUE(memcmp(result, expected, 64) == 0);
+
+    // An HmacKey for another hash can't be used.
+    EXPECT_FALSE(HmacT<Sha1Policy>::calculate(hmacKey, data, sizeof(data), result));
+
+    HmacT<Sha1Policy> sha1Hmac;
+
+    EXPECT_FALSE(sha1Hmac.setKey(hmacKey));
+    EXPECT_FALSE(sha1Hmac.valid());
+}
+
+TEST_F(HmacTTests, InvalidKeyTest)
+{
+    unsigned char data[8] = { 0 };
+    unsigned char result[20];
+    HmacT<Sha1Policy> sha1Hmac;
+    HmacKey invalidKey;
+
+    EXPECT_FALSE(sha1Hmac.valid());
+    EXPECT_FALSE(sha1Hmac.calculate(data, sizeof(data), result));
+    EXPECT_FALSE(sha1Hmac.setKey(nullptr, 10));
+    EXPECT_FALSE(HmacT<Sha1Policy>::calculate(invalidKey, data, sizeof(data), result));
+
+    // Clearing a valid key makes it invalid.
+    EXPECT_TRUE(sha1Hmac.setKey(data, sizeof(data)));
+    EXPECT_TRUE(sha1Hmac.valid());
+    sha1Hmac.clear();
+    EXPECT_FALSE(sha1Hmac.calculate(data, sizeof(data), result));
+}
@@ -0,0 +1,91 @@
+#include <testsuitebase.h>
+
+#include "otpimpl/hotpresync.h"
+#include "otpimpl/otpcode.h"
+
+// Test values taken from RFC 4226.
+
+EMPTY_TEST_SUITE(HotpResyncTests);
+
+TEST_F(HotpResyncTests, Rfc4226Test)
+{
+    ByteArray key("12345678901234567890");
+    const char *codes[2] = { "399871", "520489" };      // Counters 8 and 9.
+    HmacKey hmacKey;
+    uint64_t matched;
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, key));
+
+    // One code, and two consecutive codes, with one thread and several.
+    for (size_t threads = 1; threads <= 4; threads++) {
+        matched = 0;
+        EXPECT_TRUE(HotpResync::search(hmacKey, 6, codes, 1, 0, 100, matched, threads));
+        EXPECT_EQ(static_cast<uint64_t>(8), matched);
+
+        matched = 0;
+        EXPECT_TRUE(HotpResync::search(hmacKey, 6, codes, 2, 0, 100, matched, threads));
+        EXPECT_EQ(static_cast<uint64_t>(8), matched);
+    }
+
+    // The window includes both ends.
+    EXPECT_TRUE(HotpResync::search(hmacKey, 6, codes, 1, 8, 0, matched, 2));
+    EXPECT_EQ(static_cast<uint64_t>(8), matched);
+    EXPECT_FALSE(HotpResync::search(hmacKey, 6, codes, 1, 0, 7, matched, 2));
+
+    // Already past the counter.
+    EXPECT_FALSE(HotpResync::search(hmacKey, 6, codes, 1, 9, 100, matched, 2));
+
+    // The codes have to be consecutive.
+    const char *swapped[2] = { "520489", "399871" };
+
+    EXPECT_FALSE(HotpResync::search(hmacKey, 6, swapped, 2, 0, 100, matched, 2));
+}
+
+TEST_F(HotpResyncTests, LargeWindowTest)
+{
+    unsigned char keyData[32] = { 0 };
+    char first[OTPCODE_BUFFER_SIZE];
+    char second[OTPCODE_BUFFER_SIZE];
+    const char *codes[2] = { first, second };
+    const uint64_t start = 5000;
+    const uint64_t target = start + 87654;
+    HmacKey hmacKey;
+    uint64_t matched;
+
+    for (size_t i = 0; i < sizeof(keyData); i++) {
+        keyData[i] = static_cast<unsigned char>(i * 3);
+    }
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA256, keyData, sizeof(keyData)));
+    EXPECT_TRUE(OtpCode::hotp(hmacKey, target, 8, first));
+    EXPECT_TRUE(OtpCode::hotp(hmacKey, target + 1, 8, second));
+
+    matched = 0;
+    EXPECT_TRUE(HotpResync::search(hmacKey, 8, codes, 2, start, HOTPRESYNC_MAX_WINDOW, matched));
+    EXPECT_EQ(target, matched);
+}
+
+TEST_F(HotpResyncTests, InvalidTest)
+{
+    ByteArray key("12345678901234567890");
+    const char *codes[3] = { "399871", "520489", "123456" };
+    const char *shortCode[1] = { "39987" };
+    const char *nullCode[1] = { nullptr };
+    HmacKey hmacKey;
+    HmacKey invalidKey;
+    uint64_t matched;
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, key));
+
+    EXPECT_FALSE(HotpResync::search(invalidKey, 6, codes, 1, 0, 100, matched));
+    EXPECT_FALSE(HotpResync::search(hmacKey, 6, nullptr, 1, 0, 100, matched));
+    EXPECT_FALSE(HotpResync::search(hmacKey, 6, codes, 0, 0, 100, matched));
+    EXPECT_FALSE(HotpResync::search(hmacKey, 6, codes, 3, 0, 100, matched));
+    EXPECT_FALSE(HotpResync::search(hmacKey, 5, codes, 1, 0, 100, matched));
+    EXPECT_FALSE(HotpResync::search(hmacKey, 6, shortCode, 1, 0, 100, matched));
+    EXPECT_FALSE(HotpResync::search(hmacKey, 6, nullCode, 1, 0, 100, matched));
+    EXPECT_FALSE(HotpResync::search(hmacKey, 6, codes, 1, 0, HOTPRESYNC_MAX_WINDOW + 1, matched));
+    EXPECT_FALSE(HotpResync::search(hmacKey, 6, codes, 1, UINT64_MAX - 10, 100, matched));
+
+    EXPECT_GE(HotpResync::defaultThreadCount(), static_cast<size_t>(1));
+}
@@ -0,0 +1,84 @@
+#include <testsuitebase.h>
+
+#include <string>
+#include "otpimpl/hotpt.h"
+
+// Test vectors taken from RFC 4226 and RFC 6238.
+
+EMPTY_TEST_SUITE(HotpTTests);
+
+TEST_F(HotpTTests, Rfc4226Test)
+{
+    const char *expected[10] = { "755224", "287082", "359152", "969429", "338314", "254676", "287922", "162583", "399871", "520489" };
+    ByteArray key("12345678901234567890");
+    char result[OTPCODE_BUFFER_SIZE];
+    HmacKey hmacKey;
+    HmacT<Sha1Policy> hmacT;
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, key));
+    EXPECT_TRUE(hmacT.setKey(key.toUCharArrayPtr(), key.size()));
+
+    for (uint64_t i = 0; i < 10; i++) {
+        EXPECT_TRUE((HotpT<Sha1Policy, 6>::calculate(hmacKey, i, result)));
+        EXPECT_EQ(std::string(expected[i]), std::string(result));
+
+        EXPECT_TRUE((HotpT<Sha1Policy, 6>::calculate(hmacT, i, result)));
+        EXPECT_EQ(std::string(expected[i]), std::string(result));
+    }
+}
+
+TEST_F(HotpTTests, Rfc6238Test)
+{
+    ByteArray sha1Key("12345678901234567890");
+    ByteArray sha256Key("12345678901234567890123456789012");
+    ByteArray sha512Key("1234567890123456789012345678901234567890123456789012345678901234");
+    char result[OTPCODE_BUFFER_SIZE];
+    HmacKey sha1HmacKey;
+    HmacKey sha256HmacKey;
+    HmacKey sha512HmacKey;
+
+    EXPECT_TRUE(sha1HmacKey.setKey(HMACKEY_ALG_SHA1, sha1Key));
+    EXPECT_TRUE(sha256HmacKey.setKey(HMACKEY_ALG_SHA256, sha256Key));
+    EXPECT_TRUE(sha512HmacKey.setKey(HMACKEY_ALG_SHA512, sha512Key));
+
+    EXPECT_TRUE((HotpT<Sha1Policy, 8>::totp(sha1HmacKey, 59, 30, result)));
+    EXPECT_EQ(std::string("94287082"), std::string(result));
+
+    EXPECT_TRUE((HotpT<Sha256Policy, 8>::totp(sha256HmacKey, 59, 30, result)));
+    EXPECT_EQ(std::string("46119246"), std::string(result));
+
+    EXPECT_TRUE((HotpT<Sha512Policy, 8>::totp(sha512HmacKey, 59, 30, result)));
+    EXPECT_EQ(std::string("90693936"), std::string(result));
+
+    EXPECT_TRUE((HotpT<Sha1Policy, 8>::totp(sha1HmacKey, 1111111109, 30, result)));
+    EXPECT_EQ(std::string("07081804"), std::string(result));
+
+    EXPECT_TRUE((HotpT<Sha256Policy, 8>::totp(sha256HmacKey, 20000000000, 30, result)));
+    EXPECT_EQ(std::string("77737706"), std::string(result));
+
+    EXPECT_TRUE((HotpT<Sha512Policy, 8>::totp(sha512HmacKey, 2000000000, 30, result)));
+    EXPECT_EQ(std::string("38618901"), std::string(result));
+
+    // Fewer digits are the low digits of the same code.
+    EXPECT_TRUE((HotpT<Sha512Policy, 7>::totp(sha512HmacKey, 59, 30, result)));
+    EXPECT_EQ(std::string("0693936"), std::string(result));
+
+    EXPECT_TRUE((HotpT<Sha1Policy, 6>::totp(sha1HmacKey, 1111111109, 30, result)));
+    EXPECT_EQ(std::string("081804"), std::string(result));
+}
+
+TEST_F(HotpTTests, InvalidTest)
+{
+    ByteArray key("12345678901234567890");
+    char result[OTPCODE_BUFFER_SIZE];
+    HmacKey hmacKey;
+    HmacKey invalidKey;
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, key));
+
+    // Wrong hash for the key, an invalid key, and a 0 time step.
+    EXPECT_FALSE((HotpT<Sha256Policy, 6>::calculate(hmacKey, 0, result)));
+    EXPECT_FALSE((HotpT<Sha1Policy, 6>::calculate(invalidKey, 0, result)));
+    EXPECT_FALSE((HotpT<Sha1Policy, 6>::totp(hmacKey, 59, 0, result)));
+    EXPECT_FALSE((HotpT<Sha1Policy, 6>::calculate(hmacKey, 0, nullptr)));
+}
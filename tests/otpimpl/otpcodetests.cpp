@@ -0,0 +1,229 @@
+#include <testsuitebase.h>
+
+#include "otpimpl/otpcode.h"
+
+#include <QDebug>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Count every allocation made through operator new, so that we can prove the OtpCode
+// calls don't touch the heap.  This file is linked in to the same binary as all of the other
+// test suites, so the whole family of operators is replaced.  Otherwise memory from one of the
+// forms we didn't replace would be handed to our free().  (Which the asan build rightly
+// complains about.)
+static std::atomic<size_t> gAllocationCount(0);
+
+static void *countedAllocation(size_t size) noexcept
+{
+    gAllocationCount++;
+
+    return malloc((size == 0) ? 1 : size);
+}
+
+void *operator new(size_t size)
+{
+    void *result = countedAllocation(size);
+
+    if (nullptr == result) {
+        throw std::bad_alloc();
+    }
+
+    return result;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAllocation(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAllocation(size);
+}
+
+void operator delete(void *toFree) noexcept
+{
+    free(toFree);
+}
+
+void operator delete[](void *toFree) noexcept
+{
+    free(toFree);
+}
+
+void operator delete(void *toFree, size_t) noexcept
+{
+    free(toFree);
+}
+
+void operator delete[](void *toFree, size_t) noexcept
+{
+    free(toFree);
+}
+
+void operator delete(void *toFree, const std::nothrow_t &) noexcept
+{
+    free(toFree);
+}
+
+void operator delete[](void *toFree, const std::nothrow_t &) noexcept
+{
+    free(toFree);
+}
+
+// Test values taken from RFC 4226 and RFC 6238.
+
+EMPTY_TEST_SUITE(OtpCodeTests);
+
+TEST_F(OtpCodeTests, HotpTest)
+{
+    const char *expected[10] = { "755224", "287082", "359152", "969429", "338314", "254676", "287922", "162583", "399871", "520489" };
+    const unsigned char secret[] = "12345678901234567890";
+    char code[OTPCODE_BUFFER_SIZE];
+    HmacKey hmacKey;
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, secret, 20));
+
+    for (uint64_t i = 0; i < 10; i++) {
+        EXPECT_TRUE(OtpCode::hotp(hmacKey, i, 6, code));
+        qDebug("Expected : %s    Got : %s", expected[i], code);
+        EXPECT_STREQ(expected[i], code);
+
+        // The raw key version should give the same result.
+        memset(&code, 0x00, sizeof(code));
+        EXPECT_TRUE(OtpCode::hotp(HMACKEY_ALG_SHA1, secret, 20, i, 6, code));
+        EXPECT_STREQ(expected[i], code);
+    }
+}
+
+TEST_F(OtpCodeTests, TotpTest)
+{
+    const unsigned char sha1Secret[] = "12345678901234567890";
+    const unsigned char sha256Secret[] = "12345678901234567890123456789012";
+    const unsigned char sha512Secret[] = "1234567890123456789012345678901234567890123456789012345678901234";
+    char code[OTPCODE_BUFFER_SIZE];
+
+    EXPECT_TRUE(OtpCode::totp(HMACKEY_ALG_SHA1, sha1Secret, 20, 59, 30, 8, code));
+    EXPECT_STREQ("94287082", code);
+
+    EXPECT_TRUE(OtpCode::totp(HMACKEY_ALG_SHA256, sha256Secret, 32, 59, 30, 8, code));
+    EXPECT_STREQ("46119246", code);
+
+    EXPECT_TRUE(OtpCode::totp(HMACKEY_ALG_SHA512, sha512Secret, 64, 59, 30, 8, code));
+    EXPECT_STREQ("90693936", code);
+
+    EXPECT_TRUE(OtpCode::totp(HMACKEY_ALG_SHA1, sha1Secret, 20, 20000000000, 30, 8, code));
+    EXPECT_STREQ("65353130", code);
+}
+
+TEST_F(OtpCodeTests, HotpManyTest)
+{
+    const char *expected[10] = { "755224", "287082", "359152", "969429", "338314", "254676", "287922", "162583", "399871", "520489" };
+    const unsigned char secret[] = "12345678901234567890";
+    const HmacKey *keys[10];
+    uint64_t counters[10];
+    char codes[10][OTPCODE_BUFFER_SIZE];
+    char *codePtrs[10];
+    HmacKey hmacKey;
+    HmacKey invalidKey;
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, secret, 20));
+
+    for (size_t i = 0; i < 10; i++) {
+        keys[i] = &hmacKey;
+        counters[i] = i;
+        codePtrs[i] = codes[i];
+    }
+
+    EXPECT_TRUE(OtpCode::hotpMany(keys, counters, 10, 6, codePtrs));
+    for (size_t i = 0; i < 10; i++) {
+        EXPECT_STREQ(expected[i], codes[i]);
+    }
+
+    // An invalid key, or digit count, should fail the batch.
+    EXPECT_FALSE(OtpCode::hotpMany(keys, counters, 10, 9, codePtrs));
+
+    keys[7] = &invalidKey;
+    EXPECT_FALSE(OtpCode::hotpMany(keys, counters, 10, 6, codePtrs));
+}
+
+TEST_F(OtpCodeTests, InvalidInputTest)
+{
+    const unsigned char secret[] = "12345678901234567890";
+    unsigned char hmac[20];
+    char code[OTPCODE_BUFFER_SIZE];
+    HmacKey hmacKey;
+
+    // No key set.
+    EXPECT_FALSE(OtpCode::hotp(hmacKey, 0, 6, code));
+
+    // Invalid digit counts.
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, secret, 20));
+    EXPECT_FALSE(OtpCode::hotp(hmacKey, 0, 5, code));
+    EXPECT_FALSE(OtpCode::hotp(hmacKey, 0, 9, code));
+
+    // Time step of 0.
+    EXPECT_FALSE(OtpCode::totp(hmacKey, 59, 0, 6, code));
+
+    // HMAC that is too short.
+    memset(&hmac, 0x00, sizeof(hmac));
+    EXPECT_FALSE(OtpCode::codeFromHmac(hmac, 10, 6, -1, code));
+    EXPECT_FALSE(OtpCode::codeFromHmac(nullptr, 20, 6, -1, code));
+
+    // A zeroed HMAC should result in all 0s.
+    EXPECT_TRUE(OtpCode::codeFromHmac(hmac, sizeof(hmac), 8, -1, code));
+    EXPECT_STREQ("00000000", code);
+}
+
+TEST_F(OtpCodeTests, NoAllocationTest)
+{
+    const unsigned char secret[] = "1234567890123456789012345678901234567890123456789012345678901234";
+    char code[OTPCODE_BUFFER_SIZE];
+    HmacKey sha1Key;
+    HmacKey sha256Key;
+    HmacKey sha512Key;
+    size_t allocationsBefore;
+    size_t allocationsAfter;
+    bool success = true;
+
+    allocationsBefore = gAllocationCount;
+
+    // Setting up the keys shouldn't allocate either.
+    success &= sha1Key.setKey(HMACKEY_ALG_SHA1, secret, 20);
+    success &= sha256Key.setKey(HMACKEY_ALG_SHA256, secret, 32);
+    success &= sha512Key.setKey(HMACKEY_ALG_SHA512, secret, 64);
+
+    for (uint64_t i = 0; i < 1000; i++) {
+        success &= OtpCode::hotp(sha1Key, i, 6, code);
+        success &= OtpCode::hotp(sha256Key, i, 7, code);
+        success &= OtpCode::totp(sha512Key, static_cast<time_t>(i * 30), 30, 8, code);
+        success &= OtpCode::hotp(HMACKEY_ALG_SHA1, secret, 20, i, 6, code);
+    }
+
+    // The batch call shouldn't allocate either.
+    const HmacKey *keys[10];
+    uint64_t counters[10];
+    char codes[10][OTPCODE_BUFFER_SIZE];
+    char *codePtrs[10];
+
+    for (size_t i = 0; i < 10; i++) {
+        keys[i] = ((i % 2) == 0) ? &sha1Key : &sha256Key;
+        counters[i] = i;
+        codePtrs[i] = codes[i];
+    }
+
+    success &= OtpCode::hotpMany(keys, counters, 10, 6, codePtrs);
+
+    allocationsAfter = gAllocationCount;
+
+    EXPECT_TRUE(success);
+    EXPECT_EQ(allocationsBefore, allocationsAfter);
+}
@@ -0,0 +1,100 @@
+#include <testsuitebase.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "otpimpl/replaycache.h"
+
+EMPTY_TEST_SUITE(ReplayCacheTests);
+
+TEST_F(ReplayCacheTests, SettingsTest)
+{
+    ReplayCache cache(3, 100, 8);
+    ReplayCache clamped(0, 0, 0);
+
+    EXPECT_EQ(static_cast<size_t>(3), cache.buckets());
+    EXPECT_EQ(static_cast<size_t>(100), cache.capacityPerBucket());
+    EXPECT_EQ(static_cast<size_t>(8), cache.stripes());
+
+    EXPECT_EQ(static_cast<size_t>(1), clamped.buckets());
+    EXPECT_EQ(static_cast<size_t>(1), clamped.capacityPerBucket());
+    EXPECT_EQ(static_cast<size_t>(1), clamped.stripes());
+
+    // The entry ID should be stable, and depend on the identifier.
+    EXPECT_EQ(ReplayCache::entryId("test@example.com"), ReplayCache::entryId("test@example.com"));
+    EXPECT_NE(ReplayCache::entryId("test@example.com"), ReplayCache::entryId("test@example.org"));
+}
+
+TEST_F(ReplayCacheTests, ReplayTest)
+{
+    ReplayCache cache(3);
+    uint64_t alice = ReplayCache::entryId("alice");
+    uint64_t bob = ReplayCache::entryId("bob");
+
+    EXPECT_FALSE(cache.used(alice, 100, 100));
+    EXPECT_EQ(REPLAYCACHE_ACCEPTED, cache.markUsed(alice, 100, 100));
+    EXPECT_TRUE(cache.used(alice, 100, 100));
+    EXPECT_EQ(REPLAYCACHE_REPLAYED, cache.markUsed(alice, 100, 100));
+
+    // Other counters, and other entries, are unaffected.
+    EXPECT_EQ(REPLAYCACHE_ACCEPTED, cache.markUsed(alice, 99, 100));
+    EXPECT_EQ(REPLAYCACHE_ACCEPTED, cache.markUsed(bob, 100, 100));
+    EXPECT_EQ(static_cast<size_t>(3), cache.size());
+
+    // The code is remembered in the following steps, while it could still be valid.
+    EXPECT_EQ(REPLAYCACHE_REPLAYED, cache.markUsed(alice, 100, 101));
+    EXPECT_EQ(REPLAYCACHE_REPLAYED, cache.markUsed(alice, 100, 102));
+
+    // Once the ring wraps, the bucket for step 100 is expired.
+    EXPECT_FALSE(cache.used(alice, 100, 103));
+    EXPECT_EQ(REPLAYCACHE_ACCEPTED, cache.markUsed(alice, 100, 103));
+
+    // And step 100 itself is now too old to record anything for.
+    EXPECT_EQ(REPLAYCACHE_EXPIRED, cache.markUsed(bob, 42, 100));
+
+    cache.clear();
+    EXPECT_EQ(static_cast<size_t>(0), cache.size());
+    EXPECT_FALSE(cache.used(alice, 100, 103));
+}
+
+TEST_F(ReplayCacheTests, FullTest)
+{
+    ReplayCache cache(2, 10, 1);
+
+    for (uint64_t i = 0; i < 10; i++) {
+        EXPECT_EQ(REPLAYCACHE_ACCEPTED, cache.markUsed(i, 5, 5));
+    }
+
+    // No room for more in this step, but the next step has its own bucket.
+    EXPECT_EQ(REPLAYCACHE_FULL, cache.markUsed(10, 5, 5));
+    EXPECT_EQ(REPLAYCACHE_REPLAYED, cache.markUsed(3, 5, 5));
+    EXPECT_EQ(REPLAYCACHE_ACCEPTED, cache.markUsed(10, 5, 6));
+    EXPECT_EQ(static_cast<size_t>(11), cache.size());
+}
+
+TEST_F(ReplayCacheTests, ConcurrentTest)
+{
+    const size_t threadCount = 8;
+    const uint64_t entries = 500;
+    ReplayCache cache(4, 1024, 16);
+    std::atomic<size_t> accepted(0);
+    std::vector<std::thread> threads;
+
+    // Every thread tries to use every code.  Each code must be accepted exactly once.
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.push_back(std::thread([&cache, &accepted, entries]() {
+            for (uint64_t i = 0; i < entries; i++) {
+                if (REPLAYCACHE_ACCEPTED == cache.markUsed(i, 1000, 1000)) {
+                    accepted++;
+                }
+            }
+        }));
+    }
+
+    for (size_t t = 0; t < threadCount; t++) {
+        threads[t].join();
+    }
+
+    EXPECT_EQ(static_cast<size_t>(entries), accepted.load());
+    EXPECT_EQ(static_cast<size_t>(entries), cache.size());
+}
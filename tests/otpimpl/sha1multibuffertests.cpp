@@ -0,0 +1,163 @@
+#include <testsuitebase.h>
+
+#include <cstring>
+#include "otpimpl/sha1multibuffer.h"
+#include "testutils.h"
+
+extern "C" {
+#include "otpimpl/sha1impl.h"           //NOSONAR
+}
+
+#include <QDebug>
+
+EMPTY_TEST_SUITE(Sha1MultiBufferTests);
+
+// Test vectors taken from FIPS 180-2, and the ones used in sha1tests.cpp.
+
+static const unsigned int allBackends[3] = { SHA1MULTIBUFFER_BACKEND_SCALAR, SHA1MULTIBUFFER_BACKEND_SSE2, SHA1MULTIBUFFER_BACKEND_AVX2 };
+
+// Pad a message in to one or two SHA1 blocks.  Returns the number of blocks.
+static size_t padMessage(const char *message, unsigned char blocks[128])
+{
+    size_t length = strlen(message);
+    size_t blockCount = (length > 55) ? 2 : 1;
+    uint64_t bitLength = static_cast<uint64_t>(length) * 8;
+
+    memset(blocks, 0x00, 128);
+    memcpy(blocks, message, length);
+    blocks[length] = 0x80;
+
+    for (size_t i = 0; i < 8; i++) {
+        blocks[(blockCount * 64) - 1 - i] = static_cast<unsigned char>((bitLength >> (i * 8)) & 0xff);
+    }
+
+    return blockCount;
+}
+
+static void initState(uint32_t state[5])
+{
+    state[0] = 0x67452301;
+    state[1] = 0xefcdab89;
+    state[2] = 0x98badcfe;
+    state[3] = 0x10325476;
+    state[4] = 0xc3d2e1f0;
+}
+
+static void stateToDigest(const uint32_t state[5], unsigned char digest[20])
+{
+    for (size_t i = 0; i < 5; i++) {
+        digest[(i * 4)] = static_cast<unsigned char>((state[i] >> 24) & 0xff);
+        digest[(i * 4) + 1] = static_cast<unsigned char>((state[i] >> 16) & 0xff);
+        digest[(i * 4) + 2] = static_cast<unsigned char>((state[i] >> 8) & 0xff);
+        digest[(i * 4) + 3] = static_cast<unsigned char>(state[i] & 0xff);
+    }
+}
+
+TEST_F(Sha1MultiBufferTests, BackendTest)
+{
+    // The scalar backend is always available, and the best backend must be supported.
+    EXPECT_TRUE(Sha1MultiBuffer::backendSupported(SHA1MULTIBUFFER_BACKEND_SCALAR));
+    EXPECT_TRUE(Sha1MultiBuffer::backendSupported(Sha1MultiBuffer::bestBackend()));
+    EXPECT_FALSE(Sha1MultiBuffer::backendSupported(42));
+
+    EXPECT_EQ(static_cast<size_t>(1), Sha1MultiBuffer::lanes(SHA1MULTIBUFFER_BACKEND_SCALAR));
+    EXPECT_EQ(static_cast<size_t>(4), Sha1MultiBuffer::lanes(SHA1MULTIBUFFER_BACKEND_SSE2));
+    EXPECT_EQ(static_cast<size_t>(8), Sha1MultiBuffer::lanes(SHA1MULTIBUFFER_BACKEND_AVX2));
+
+    qDebug("Best SHA1 multi-buffer backend : %u", Sha1MultiBuffer::bestBackend());
+}
+
+TEST_F(Sha1MultiBufferTests, KnownVectorTest)
+{
+    const char *messages[3] = { "", "abc", "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu" };
+    const unsigned char expected[3][20] = {
+        { 0xda, 0x39, 0xa3, 0xee, 0x5e, 0x6b, 0x4b, 0x0d, 0x32, 0x55, 0xbf, 0xef, 0x95, 0x60, 0x18, 0x90, 0xaf, 0xd8, 0x07, 0x09 },
+        { 0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e, 0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d },
+        { 0xa4, 0x9b, 0x24, 0x46, 0xa0, 0x2c, 0x64, 0x5b, 0xf4, 0x19, 0xf9, 0x95, 0xb6, 0x70, 0x91, 0x25, 0x3a, 0x04, 0xa2, 0x59 }
+    };
+    unsigned char blocks[3][128];
+    size_t blockCounts[3];
+    uint32_t states[3][5];
+    uint32_t *statePtrs[3];
+    const unsigned char *blockPtrs[3];
+    unsigned char digest[20];
+
+    for (size_t b = 0; b < 3; b++) {
+        for (size_t i = 0; i < 3; i++) {
+            blockCounts[i] = padMessage(messages[i], blocks[i]);
+            initState(states[i]);
+            statePtrs[i] = states[i];
+            blockPtrs[i] = blocks[i];
+        }
+
+        if (!Sha1MultiBuffer::backendSupported(allBackends[b])) {
+            EXPECT_FALSE(Sha1MultiBuffer::transform(allBackends[b], statePtrs, blockPtrs, 3));
+            continue;
+        }
+
+        // Hash the first block of all three messages together.
+        EXPECT_TRUE(Sha1MultiBuffer::transform(allBackends[b], statePtrs, blockPtrs, 3));
+
+        // Then the second block of the long message by itself.
+        EXPECT_EQ(static_cast<size_t>(2), blockCounts[2]);
+        blockPtrs[0] = &blocks[2][64];
+        EXPECT_TRUE(Sha1MultiBuffer::transform(allBackends[b], &statePtrs[2], blockPtrs, 1));
+
+        for (size_t i = 0; i < 3; i++) {
+            stateToDigest(states[i], digest);
+            qDebug("Backend %u, message %zu : %s", allBackends[b], i, TestUtils::binaryToString(digest, 20).c_str());
+            EXPECT_TRUE(memcmp(digest, expected[i], 20) == 0);
+        }
+    }
+}
+
+TEST_F(Sha1MultiBufferTests, MatchesScalarTest)
+{
+    const size_t maxCount = 19;                 // Enough for two full AVX2 passes, and a partial one.
+    uint32_t expected[maxCount][5];
+    uint32_t states[maxCount][5];
+    unsigned char blocks[maxCount][64];
+    uint32_t *statePtrs[maxCount];
+    const unsigned char *blockPtrs[maxCount];
+
+    // Fill the states and blocks with something that isn't the same for every lane.
+    for (size_t i = 0; i < maxCount; i++) {
+        for (size_t j = 0; j < 5; j++) {
+            expected[i][j] = static_cast<uint32_t>((i * 0x9e3779b9) ^ (j * 0x7f4a7c15));
+        }
+
+        for (size_t j = 0; j < 64; j++) {
+            blocks[i][j] = static_cast<unsigned char>((i * 31) + (j * 7));
+        }
+
+        blockPtrs[i] = blocks[i];
+    }
+
+    for (size_t b = 0; b < 3; b++) {
+        if (!Sha1MultiBuffer::backendSupported(allBackends[b])) {
+            continue;
+        }
+
+        for (size_t count = 1; count <= maxCount; count++) {
+            memcpy(&states, &expected, sizeof(states));
+
+            for (size_t i = 0; i < count; i++) {
+                statePtrs[i] = states[i];
+            }
+
+            EXPECT_TRUE(Sha1MultiBuffer::transform(allBackends[b], statePtrs, blockPtrs, count));
+
+            for (size_t i = 0; i < maxCount; i++) {
+                uint32_t reference[5];
+
+                memcpy(&reference, &expected[i], sizeof(reference));
+                if (i < count) {
+                    SHA1Transform(reference, blocks[i]);
+                }
+
+                // Lanes past the count must not be touched.
+                EXPECT_TRUE(memcmp(&reference, &states[i], sizeof(reference)) == 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,166 @@
+#include <testsuitebase.h>
+
+#include <cstring>
+#include "otpimpl/sha512multibuffer.h"
+#include "otpimpl/sha512hash.h"
+#include "testutils.h"
+
+extern "C" {
+#include "otpimpl/sha2.h"               //NOSONAR
+#include "otpimpl/sha512avx2.h"         //NOSONAR
+}
+
+#include <QDebug>
+
+EMPTY_TEST_SUITE(Sha512MultiBufferTests);
+
+// Test vectors taken from FIPS 180-2.
+
+static const unsigned int allBackends[2] = { SHA512MULTIBUFFER_BACKEND_SCALAR, SHA512MULTIBUFFER_BACKEND_AVX2 };
+
+static void initState(uint64_t state[8])
+{
+    state[0] = 0x6a09e667f3bcc908ULL;
+    state[1] = 0xbb67ae8584caa73bULL;
+    state[2] = 0x3c6ef372fe94f82bULL;
+    state[3] = 0xa54ff53a5f1d36f1ULL;
+    state[4] = 0x510e527fade682d1ULL;
+    state[5] = 0x9b05688c2b3e6c1fULL;
+    state[6] = 0x1f83d9abfb41bd6bULL;
+    state[7] = 0x5be0cd19137e2179ULL;
+}
+
+TEST_F(Sha512MultiBufferTests, BackendTest)
+{
+    // The scalar backend is always available, and the best backend must be supported.
+    EXPECT_TRUE(Sha512MultiBuffer::backendSupported(SHA512MULTIBUFFER_BACKEND_SCALAR));
+    EXPECT_TRUE(Sha512MultiBuffer::backendSupported(Sha512MultiBuffer::bestBackend()));
+    EXPECT_FALSE(Sha512MultiBuffer::backendSupported(42));
+
+    EXPECT_EQ(static_cast<size_t>(1), Sha512MultiBuffer::lanes(SHA512MULTIBUFFER_BACKEND_SCALAR));
+    EXPECT_EQ(static_cast<size_t>(4), Sha512MultiBuffer::lanes(SHA512MULTIBUFFER_BACKEND_AVX2));
+
+    qDebug("Best SHA512 multi-buffer backend : %u", Sha512MultiBuffer::bestBackend());
+}
+
+TEST_F(Sha512MultiBufferTests, KnownVectorTest)
+{
+    const unsigned char expected[64] = { 0xdd, 0xaf, 0x35, 0xa1, 0x93, 0x61, 0x7a, 0xba, 0xcc, 0x41, 0x73, 0x49, 0xae, 0x20, 0x41, 0x31,
+                                         0x12, 0xe6, 0xfa, 0x4e, 0x89, 0xa9, 0x7e, 0xa2, 0x0a, 0x9e, 0xee, 0xe6, 0x4b, 0x55, 0xd3, 0x9a,
+                                         0x21, 0x92, 0x99, 0x2a, 0x27, 0x4f, 0xc1, 0xa8, 0x36, 0xba, 0x3c, 0x23, 0xa3, 0xfe, 0xeb, 0xbd,
+                                         0x45, 0x4d, 0x44, 0x23, 0x64, 0x3c, 0xe8, 0x0e, 0x2a, 0x9a, 0xc9, 0x4f, 0xa5, 0x4c, 0xa4, 0x9f };
+    unsigned char block[128];
+    uint64_t states[3][8];
+    uint64_t *statePtrs[3];
+    const unsigned char *blockPtrs[3];
+    unsigned char digest[64];
+
+    // "abc", padded in to a single block.
+    memset(block, 0x00, sizeof(block));
+    memcpy(block, "abc", 3);
+    block[3] = 0x80;
+    block[127] = 24;
+
+    for (size_t b = 0; b < 2; b++) {
+        for (size_t i = 0; i < 3; i++) {
+            initState(states[i]);
+            statePtrs[i] = states[i];
+            blockPtrs[i] = block;
+        }
+
+        if (!Sha512MultiBuffer::backendSupported(allBackends[b])) {
+            EXPECT_FALSE(Sha512MultiBuffer::transform(allBackends[b], statePtrs, blockPtrs, 3));
+            continue;
+        }
+
+        EXPECT_TRUE(Sha512MultiBuffer::transform(allBackends[b], statePtrs, blockPtrs, 3));
+
+        for (size_t i = 0; i < 3; i++) {
+            for (size_t j = 0; j < 64; j++) {
+                digest[j] = static_cast<unsigned char>((states[i][j / 8] >> (56 - ((j % 8) * 8))) & 0xff);
+            }
+
+            qDebug("Backend %u, lane %zu : %s", allBackends[b], i, TestUtils::binaryToString(digest, 64).c_str());
+            EXPECT_TRUE(memcmp(digest, expected, 64) == 0);
+        }
+    }
+}
+
+TEST_F(Sha512MultiBufferTests, MatchesScalarTest)
+{
+    const size_t maxCount = 11;                 // Enough for two full AVX2 passes, and a partial one.
+    uint64_t expected[maxCount][8];
+    uint64_t states[maxCount][8];
+    unsigned char blocks[maxCount][128];
+    uint64_t *statePtrs[maxCount];
+    const unsigned char *blockPtrs[maxCount];
+    sha512_ctx ctx;
+
+    // Fill the states and blocks with something that isn't the same for every lane.
+    for (size_t i = 0; i < maxCount; i++) {
+        for (size_t j = 0; j < 8; j++) {
+            expected[i][j] = (static_cast<uint64_t>(i) * 0x9e3779b97f4a7c15ULL) ^ (static_cast<uint64_t>(j) * 0xbf58476d1ce4e5b9ULL);
+        }
+
+        for (size_t j = 0; j < 128; j++) {
+            blocks[i][j] = static_cast<unsigned char>((i * 31) + (j * 7));
+        }
+
+        blockPtrs[i] = blocks[i];
+    }
+
+    for (size_t b = 0; b < 2; b++) {
+        if (!Sha512MultiBuffer::backendSupported(allBackends[b])) {
+            continue;
+        }
+
+        for (size_t count = 1; count <= maxCount; count++) {
+            memcpy(&states, &expected, sizeof(states));
+
+            for (size_t i = 0; i < count; i++) {
+                statePtrs[i] = states[i];
+            }
+
+            EXPECT_TRUE(Sha512MultiBuffer::transform(allBackends[b], statePtrs, blockPtrs, count));
+
+            for (size_t i = 0; i < maxCount; i++) {
+                for (size_t j = 0; j < 8; j++) {
+                    ctx.h[j] = expected[i][j];
+                }
+
+                if (i < count) {
+                    sha512_transf(&ctx, blocks[i], 1);
+                }
+
+                // Lanes past the count must not be touched.
+                for (size_t j = 0; j < 8; j++) {
+                    EXPECT_EQ(static_cast<uint64_t>(ctx.h[j]), states[i][j]);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(Sha512MultiBufferTests, Avx2MatchesPortableTest)
+{
+    Sha512Hash hashObj;
+    ByteArray toHash;
+    ByteArray portable;
+    ByteArray avx2;
+
+    qDebug("SHA512 AVX2 transform available : %d", sha512_avx2_available());
+
+    // Cover the lengths around the block and padding boundaries, and a few multi-block ones.
+    for (size_t length = 0; length < 300; length++) {
+        sha512_avx2_set_enabled(0);
+        portable = hashObj.hash(toHash);
+
+        sha512_avx2_set_enabled(1);
+        avx2 = hashObj.hash(toHash);
+
+        EXPECT_EQ(static_cast<size_t>(64), avx2.size());
+        EXPECT_TRUE(portable == avx2);
+
+        toHash.append(static_cast<char>((length * 13) & 0xff));
+    }
+}
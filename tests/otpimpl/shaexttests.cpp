@@ -0,0 +1,80 @@
+#include <testsuitebase.h>
+
+#include <cstring>
+#include "otpimpl/sha1hash.h"
+#include "otpimpl/sha256hash.h"
+#include "testutils.h"
+
+extern "C" {
+#include "otpimpl/shaext.h"             //NOSONAR
+}
+
+#include <QDebug>
+
+EMPTY_TEST_SUITE(ShaExtTests);
+
+// Hash the data with the hardware code turned off, and then with it turned back on.
+static void hashBothWays(HashTypeBase &hashObj, const ByteArray &toHash, ByteArray &portable, ByteArray &hardware)
+{
+    sha_ext_set_enabled(0);
+    portable = hashObj.hash(toHash);
+
+    sha_ext_set_enabled(1);
+    hardware = hashObj.hash(toHash);
+}
+
+TEST_F(ShaExtTests, EnableTest)
+{
+    qDebug("SHA1 extensions available   : %d", sha_ext_sha1_available());
+    qDebug("SHA256 extensions available : %d", sha_ext_sha256_available());
+
+    // Turning the extensions off should make them unavailable.
+    sha_ext_set_enabled(0);
+    EXPECT_EQ(0, sha_ext_enabled());
+    EXPECT_EQ(0, sha_ext_sha1_available());
+    EXPECT_EQ(0, sha_ext_sha256_available());
+
+    sha_ext_set_enabled(1);
+    EXPECT_EQ(1, sha_ext_enabled());
+}
+
+TEST_F(ShaExtTests, Sha1MatchesPortableTest)
+{
+    Sha1Hash hashObj;
+    ByteArray toHash;
+    ByteArray portable;
+    ByteArray hardware;
+
+    // Cover the lengths around the block and padding boundaries, and a few multi-block ones.
+    for (size_t length = 0; length < 300; length++) {
+        hashBothWays(hashObj, toHash, portable, hardware);
+
+        EXPECT_EQ(static_cast<size_t>(20), hardware.size());
+        EXPECT_TRUE(portable == hardware);
+
+        toHash.append(static_cast<char>((length * 13) & 0xff));
+    }
+}
+
+TEST_F(ShaExtTests, Sha256MatchesPortableTest)
+{
+    unsigned char abcResult[32] = { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad };
+    Sha256Hash hashObj;
+    ByteArray toHash;
+    ByteArray portable;
+    ByteArray hardware;
+
+    // Check a known vector first.
+    hashBothWays(hashObj, ByteArray("abc"), portable, hardware);
+    EXPECT_TRUE(memcmp(hardware.toUCharArrayPtr(), abcResult, 32) == 0);
+    EXPECT_TRUE(memcmp(portable.toUCharArrayPtr(), abcResult, 32) == 0);
+
+    for (size_t length = 0; length < 300; length++) {
+        hashBothWays(hashObj, toHash, portable, hardware);
+
+        EXPECT_EQ(static_cast<size_t>(32), hardware.size());
+        EXPECT_TRUE(portable == hardware);
+
+        toHash.append(static_cast<char>((length * 13) & 0xff));
+    }
+}
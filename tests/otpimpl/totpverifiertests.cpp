@@ -0,0 +1,230 @@
+#include <testsuitebase.h>
+
+#include <string>
+#include <vector>
+#include "otpimpl/totpverifier.h"
+#include "otpimpl/otpcode.h"
+
+// Test values taken from RFC 6238.
+
+EMPTY_TEST_SUITE(TotpVerifierTests);
+
+TEST_F(TotpVerifierTests, SettingsTest)
+{
+    TotpVerifier verifier;
+
+    EXPECT_EQ(static_cast<size_t>(1), verifier.window());
+    EXPECT_EQ(static_cast<size_t>(30), verifier.timeStep());
+    EXPECT_EQ(static_cast<size_t>(6), verifier.digits());
+    EXPECT_EQ(static_cast<uint64_t>(0), verifier.initialCounter());
+
+    EXPECT_TRUE(verifier.setWindow(TOTPVERIFIER_MAX_WINDOW));
+    EXPECT_FALSE(verifier.setWindow(TOTPVERIFIER_MAX_WINDOW + 1));
+    EXPECT_EQ(TOTPVERIFIER_MAX_WINDOW, verifier.window());
+
+    EXPECT_FALSE(verifier.setTimeStep(0));
+    EXPECT_EQ(static_cast<size_t>(30), verifier.timeStep());
+
+    EXPECT_FALSE(verifier.setDigits(5));
+    EXPECT_FALSE(verifier.setDigits(9));
+    EXPECT_TRUE(verifier.setDigits(8));
+    EXPECT_EQ(static_cast<size_t>(8), verifier.digits());
+
+    // Invalid values in the ctor leave the defaults in place.
+    TotpVerifier defaulted(100, 0, 4);
+
+    EXPECT_EQ(static_cast<size_t>(1), defaulted.window());
+    EXPECT_EQ(static_cast<size_t>(30), defaulted.timeStep());
+    EXPECT_EQ(static_cast<size_t>(6), defaulted.digits());
+}
+
+TEST_F(TotpVerifierTests, ConstantTimeEqualsTest)
+{
+    EXPECT_TRUE(TotpVerifier::constantTimeEquals("123456", "123456", 6));
+    EXPECT_FALSE(TotpVerifier::constantTimeEquals("123456", "123457", 6));
+    EXPECT_FALSE(TotpVerifier::constantTimeEquals("123456", "023456", 6));
+    EXPECT_TRUE(TotpVerifier::constantTimeEquals("", "", 0));
+}
+
+TEST_F(TotpVerifierTests, WindowTest)
+{
+    ByteArray key("12345678901234567890");
+    TotpVerifier verifier(1, 30, 8);
+    HmacKey hmacKey;
+    int offset;
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, key));
+
+    // 94287082 is the code for time step 1.
+    offset = 42;
+    EXPECT_TRUE(verifier.verify(hmacKey, "94287082", 59, offset));
+    EXPECT_EQ(0, offset);
+
+    EXPECT_TRUE(verifier.verify(hmacKey, "94287082", 89, offset));
+    EXPECT_EQ(-1, offset);
+
+    EXPECT_TRUE(verifier.verify(hmacKey, "94287082", 29, offset));
+    EXPECT_EQ(1, offset);
+
+    // Outside of the window.
+    EXPECT_FALSE(verifier.verify(hmacKey, "94287082", 119, offset));
+
+    EXPECT_TRUE(verifier.setWindow(2));
+    EXPECT_TRUE(verifier.verify(hmacKey, "94287082", 119, offset));
+    EXPECT_EQ(-2, offset);
+
+    EXPECT_TRUE(verifier.setWindow(0));
+    EXPECT_FALSE(verifier.verify(hmacKey, "94287082", 89, offset));
+    EXPECT_TRUE(verifier.verify(hmacKey, "94287082", 59, offset));
+    EXPECT_EQ(0, offset);
+
+    // Wrong codes, and codes that aren't the right shape.
+    EXPECT_TRUE(verifier.setWindow(1));
+    EXPECT_FALSE(verifier.verify(hmacKey, "94287083", 59, offset));
+    EXPECT_FALSE(verifier.verify(hmacKey, "9428708", 59, offset));
+    EXPECT_FALSE(verifier.verify(hmacKey, "942870821", 59, offset));
+    EXPECT_FALSE(verifier.verify(hmacKey, "9428708a", 59, offset));
+    EXPECT_FALSE(verifier.verify(hmacKey, "", 59, offset));
+    EXPECT_FALSE(verifier.verify(hmacKey, nullptr, 59, offset));
+
+    // The shorter codes are the low digits of the same value.
+    EXPECT_TRUE(verifier.setDigits(6));
+    EXPECT_TRUE(verifier.verify(hmacKey, "287082", 59, offset));
+    EXPECT_EQ(0, offset);
+}
+
+TEST_F(TotpVerifierTests, InitialCounterTest)
+{
+    ByteArray key("12345678901234567890");
+    TotpVerifier verifier(1, 30, 8, 1000);
+    HmacKey hmacKey;
+    HmacKey invalidKey;
+    int offset;
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, key));
+
+    EXPECT_TRUE(verifier.verify(hmacKey, "94287082", 1059, offset));
+    EXPECT_EQ(0, offset);
+
+    // Times before the initial counter, and invalid keys, are errors.
+    EXPECT_FALSE(verifier.verify(hmacKey, "94287082", 999, offset));
+    EXPECT_FALSE(verifier.verify(invalidKey, "94287082", 1059, offset));
+}
+
+TEST_F(TotpVerifierTests, VerifyManyTest)
+{
+    const size_t count = 100;
+    std::vector<HmacKey> keys(count);
+    std::vector<const HmacKey *> keyPtrs(count);
+    std::vector<std::string> codes(count);
+    std::vector<const char *> codePtrs(count);
+    bool matched[count];
+    int offsets[count];
+    char code[OTPCODE_BUFFER_SIZE];
+    unsigned char keyData[32];
+    TotpVerifier verifier(2, 30, 6);
+    time_t now = 1111111109;
+    int offset;
+
+    for (size_t i = 0; i < count; i++) {
+        int drift = static_cast<int>(i % 7) - 3;        // -3 .. 3, so some are outside of the window.
+
+        for (size_t j = 0; j < sizeof(keyData); j++) {
+            keyData[j] = static_cast<unsigned char>((i * 13) + j);
+        }
+
+        EXPECT_TRUE(keys[i].setKey(static_cast<unsigned int>(i % 3), keyData, 20 + (i % 12)));
+        EXPECT_TRUE(OtpCode::totp(keys[i], now + (drift * 30), 30, 6, code));
+
+        codes[i] = code;
+        keyPtrs[i] = &keys[i];
+        codePtrs[i] = codes[i].c_str();
+    }
+
+    // A few entries that can't be checked.
+    keyPtrs[10] = nullptr;
+    codePtrs[20] = "12345";
+
+    EXPECT_TRUE(verifier.verifyMany(keyPtrs.data(), codePtrs.data(), count, now, matched, offsets));
+
+    for (size_t i = 0; i < count; i++) {
+        int drift = static_cast<int>(i % 7) - 3;
+
+        if ((10 == i) || (20 == i)) {
+            EXPECT_FALSE(matched[i]);
+            continue;
+        }
+
+        // The batch must agree with checking the codes one at a time.
+        EXPECT_EQ(verifier.verify(keys[i], codePtrs[i], now, offset), matched[i]);
+
+        if ((drift >= -2) && (drift <= 2)) {
+            EXPECT_TRUE(matched[i]);
+            EXPECT_EQ(drift, offsets[i]);
+            EXPECT_EQ(drift, offset);
+        }
+    }
+
+    // Bad parameters.
+    EXPECT_FALSE(verifier.verifyMany(nullptr, codePtrs.data(), count, now, matched, offsets));
+    EXPECT_FALSE(verifier.verifyMany(keyPtrs.data(), codePtrs.data(), count, now, nullptr, offsets));
+
+    // An empty batch is fine.
+    EXPECT_TRUE(verifier.verifyMany(keyPtrs.data(), codePtrs.data(), 0, now, matched, offsets));
+}
+
+TEST_F(TotpVerifierTests, ReplayTest)
+{
+    ByteArray key("12345678901234567890");
+    TotpVerifier verifier(1, 30, 8);
+    uint64_t entryId = ReplayCache::entryId("replay");
+    HmacKey hmacKey;
+    int offset;
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, key));
+
+    // Without a cache, replay protection can't be provided.
+    EXPECT_FALSE(verifier.verify(hmacKey, entryId, "94287082", 59, offset));
+
+    verifier.setReplayCache(std::shared_ptr<ReplayCache>(new ReplayCache()));
+    EXPECT_NE(nullptr, verifier.replayCache());
+
+    EXPECT_TRUE(verifier.verify(hmacKey, entryId, "94287082", 59, offset));
+    EXPECT_EQ(0, offset);
+
+    // The same code can't be used again, even in the next time step.
+    EXPECT_FALSE(verifier.verify(hmacKey, entryId, "94287082", 59, offset));
+    EXPECT_FALSE(verifier.verify(hmacKey, entryId, "94287082", 89, offset));
+
+    // But the plain verify doesn't care.
+    EXPECT_TRUE(verifier.verify(hmacKey, "94287082", 89, offset));
+
+    // The same code for another entry is fine.
+    EXPECT_TRUE(verifier.verify(hmacKey, ReplayCache::entryId("other"), "94287082", 89, offset));
+    EXPECT_EQ(-1, offset);
+}
+
+TEST_F(TotpVerifierTests, VerifyManyReplayTest)
+{
+    ByteArray key("12345678901234567890");
+    TotpVerifier verifier(1, 30, 8);
+    HmacKey hmacKey;
+    const HmacKey *keys[3] = { &hmacKey, &hmacKey, &hmacKey };
+    const char *codes[3] = { "94287082", "94287082", "00000000" };
+    uint64_t entryIds[3] = { 1, 1, 1 };
+    bool matched[3];
+    int offsets[3];
+
+    EXPECT_TRUE(hmacKey.setKey(HMACKEY_ALG_SHA1, key));
+
+    EXPECT_FALSE(verifier.verifyMany(keys, entryIds, codes, 3, 59, matched, offsets));
+
+    verifier.setReplayCache(std::shared_ptr<ReplayCache>(new ReplayCache()));
+    EXPECT_FALSE(verifier.verifyMany(keys, nullptr, codes, 3, 59, matched, offsets));
+    EXPECT_TRUE(verifier.verifyMany(keys, entryIds, codes, 3, 59, matched, offsets));
+
+    // Only the first copy of the code is accepted.
+    EXPECT_TRUE(matched[0]);
+    EXPECT_FALSE(matched[1]);
+    EXPECT_FALSE(matched[2]);
+}
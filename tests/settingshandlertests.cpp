@@ -52,6 +52,52 @@ TEST_F(SettingsHandlerTests, GetSetSettingsTests)
     EXPECT_TRUE(!SettingsHandler::getInstance()->databaseLocation().contains("dbtest"));
 }
 
+TEST_F(SettingsHandlerTests, MaxCalculationThreadsTests)
+{
+    unsigned int oldValue = SettingsHandler::getInstance()->maxCalculationThreads();
+
+    SettingsHandler::getInstance()->setMaxCalculationThreads(2);
+    EXPECT_EQ(2u, SettingsHandler::getInstance()->maxCalculationThreads());
+
+    // 0 means one thread per core.
+    SettingsHandler::getInstance()->setMaxCalculationThreads(0);
+    EXPECT_EQ(0u, SettingsHandler::getInstance()->maxCalculationThreads());
+
+    SettingsHandler::getInstance()->setMaxCalculationThreads(oldValue);
+    EXPECT_EQ(oldValue, SettingsHandler::getInstance()->maxCalculationThreads());
+}
+
+TEST_F(SettingsHandlerTests, DatabaseStorageOptionsTests)
+{
+    bool oldWriteAheadLog = SettingsHandler::getInstance()->databaseWriteAheadLog();
+    unsigned int oldCacheSize = SettingsHandler::getInstance()->databaseCacheSizeKb();
+    unsigned int oldMmapSize = SettingsHandler::getInstance()->databaseMmapSizeKb();
+    unsigned int oldInterval = SettingsHandler::getInstance()->databaseCheckpointInterval();
+
+    SettingsHandler::getInstance()->setDatabaseWriteAheadLog(!oldWriteAheadLog);
+    EXPECT_EQ(!oldWriteAheadLog, SettingsHandler::getInstance()->databaseWriteAheadLog());
+
+    SettingsHandler::getInstance()->setDatabaseCacheSizeKb(512);
+    EXPECT_EQ(512u, SettingsHandler::getInstance()->databaseCacheSizeKb());
+
+    SettingsHandler::getInstance()->setDatabaseMmapSizeKb(0);
+    EXPECT_EQ(0u, SettingsHandler::getInstance()->databaseMmapSizeKb());
+
+    SettingsHandler::getInstance()->setDatabaseCheckpointInterval(60);
+    EXPECT_EQ(60u, SettingsHandler::getInstance()->databaseCheckpointInterval());
+
+    // Put them all back.
+    SettingsHandler::getInstance()->setDatabaseWriteAheadLog(oldWriteAheadLog);
+    SettingsHandler::getInstance()->setDatabaseCacheSizeKb(oldCacheSize);
+    SettingsHandler::getInstance()->setDatabaseMmapSizeKb(oldMmapSize);
+    SettingsHandler::getInstance()->setDatabaseCheckpointInterval(oldInterval);
+
+    EXPECT_EQ(oldWriteAheadLog, SettingsHandler::getInstance()->databaseWriteAheadLog());
+    EXPECT_EQ(oldCacheSize, SettingsHandler::getInstance()->databaseCacheSizeKb());
+    EXPECT_EQ(oldMmapSize, SettingsHandler::getInstance()->databaseMmapSizeKb());
+    EXPECT_EQ(oldInterval, SettingsHandler::getInstance()->databaseCheckpointInterval());
+}
+
 TEST_F(SettingsHandlerTests, DatabasePathLocationTests)
 {
     QString oldLocation;
@@ -12,23 +12,38 @@ HEADERS += \
 
 SOURCES += \
     $$PWD/container/bytearraytests.cpp \
+    $$PWD/container/securearenatests.cpp \
+    $$PWD/container/workstealingpooltests.cpp \
     $$PWD/generalinfosingletontests.cpp \
     $$PWD/keyentriessingletontests.cpp \
     $$PWD/keystorage/database/databasekeystoragetests.cpp \
     $$PWD/keystorage/database/secretdatabasetests.cpp \
     $$PWD/keystorage/keystoragetests.cpp \
     $$PWD/loggertests.cpp \
+    $$PWD/otp/otpbatchenginetests.cpp \
     $$PWD/otp/otphandlertests.cpp \
     $$PWD/otpimpl/base32codertests.cpp \
+    $$PWD/otpimpl/hashcontexttests.cpp \
     $$PWD/otpimpl/hexdecodertests.cpp \
+    $$PWD/otpimpl/hmacalgorithmtests.cpp \
+    $$PWD/otpimpl/hmackeytests.cpp \
     $$PWD/otpimpl/hmacsha1tests.cpp \
     $$PWD/otpimpl/hmacsha256tests.cpp \
     $$PWD/otpimpl/hmacsha512tests.cpp \
+    $$PWD/otpimpl/hmacttests.cpp \
+    $$PWD/otpimpl/hotpresynctests.cpp \
     $$PWD/otpimpl/hotptests.cpp \
+    $$PWD/otpimpl/hotpttests.cpp \
+    $$PWD/otpimpl/otpcodetests.cpp \
+    $$PWD/otpimpl/replaycachetests.cpp \
+    $$PWD/otpimpl/sha1multibuffertests.cpp \
     $$PWD/otpimpl/sha1tests.cpp \
     $$PWD/otpimpl/sha256tests.cpp \
+    $$PWD/otpimpl/sha512multibuffertests.cpp \
     $$PWD/otpimpl/sha512tests.cpp \
+    $$PWD/otpimpl/shaexttests.cpp \
     $$PWD/otpimpl/totptests.cpp \
+    $$PWD/otpimpl/totpverifiertests.cpp \
     $$PWD/settingshandlertests.cpp \
     $$PWD/testhelpers/testsuitebase.cpp \
     $$PWD/testhelpers/testutils.cpp \